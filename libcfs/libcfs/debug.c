@@ -102,6 +102,46 @@ module_param_call(libcfs_debug_mb, libcfs_param_debug_mb_set, param_get_uint,
 #endif
 MODULE_PARM_DESC(libcfs_debug_mb, "Total debug buffer size.");
 
+static int libcfs_param_trace_binary_set(const char *val,
+					 cfs_kernel_param_arg_t *kp)
+{
+	unsigned int num;
+	int rc;
+
+	rc = kstrtouint(val, 0, &num);
+	if (rc < 0)
+		return rc;
+
+	if (num) {
+		rc = cfs_trace_bin_enable();
+		if (rc < 0)
+			return rc;
+	}
+
+	*((unsigned int *)kp->arg) = !!num;
+
+	return 0;
+}
+
+/* the binary trace buffers are allocated when the mode is first enabled */
+static const struct kernel_param_ops param_ops_trace_binary = {
+	.set = libcfs_param_trace_binary_set,
+	.get = param_get_uint,
+};
+
+#define param_check_trace_binary(name, p) \
+		__param_check(name, p, unsigned int)
+
+unsigned int libcfs_trace_binary;
+#ifdef HAVE_KERNEL_PARAM_OPS
+module_param(libcfs_trace_binary, trace_binary, 0644);
+#else
+module_param_call(libcfs_trace_binary, libcfs_param_trace_binary_set,
+		  param_get_uint, &param_ops_trace_binary, 0644);
+#endif
+MODULE_PARM_DESC(libcfs_trace_binary,
+		 "Record debug messages in binary form, formatted when dumped");
+
 unsigned int libcfs_printk = D_CANTMASK;
 module_param(libcfs_printk, uint, 0644);
 MODULE_PARM_DESC(libcfs_printk, "Lustre kernel debug console mask");
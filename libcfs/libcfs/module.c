@@ -630,6 +630,13 @@ static struct ctl_table lnet_table[] = {
 		.mode		= 0444,
 		.proc_handler	= &debugfs_dou64,
 	},
+	{
+		.procname	= "trace_binary_records",
+		.data		= &cfs_trace_bin_formatted,
+		.maxlen		= sizeof(u64),
+		.mode		= 0444,
+		.proc_handler	= &debugfs_dou64,
+	},
 	{
 		.procname	= "catastrophe",
 		.data		= &libcfs_catastrophe,
@@ -701,6 +708,8 @@ static const struct lnet_debugfs_symlink_def lnet_debugfs_symlinks[] = {
 	  .target	= "../../../module/libcfs/parameters/libcfs_console_backoff" },
 	{ .name		= "debug_mb",
 	  .target	= "../../../module/libcfs/parameters/libcfs_debug_mb" },
+	{ .name		= "trace_binary",
+	  .target	= "../../../module/libcfs/parameters/libcfs_trace_binary" },
 	{ .name		= "console_min_delay_centisecs",
 	  .target	= "../../../module/libcfs/parameters/libcfs_console_min_delay" },
 	{ .name		= "console_max_delay_centisecs",
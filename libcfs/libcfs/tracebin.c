@@ -0,0 +1,773 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * libcfs/libcfs/tracebin.c
+ *
+ * Binary debug trace records.
+ *
+ * With libcfs_trace_binary set, a debug message which is not printed on
+ * the console is not formatted when it is logged. The format pointer,
+ * the location of the message and the raw arguments are copied into a
+ * fixed size slot of a per-CPU ring instead. A slot is reserved with a
+ * local atomic increment, so no lock is taken and interrupts nesting on
+ * the same CPU simply get the next slot. When the ring wraps, the oldest
+ * records are overwritten. Once half of a ring is waiting to be formatted,
+ * a work item formats it into the trace pages, so how much history is kept
+ * is bounded by debug_mb as for text records, not by the size of the ring.
+ *
+ * The records are formatted into ordinary text records when the trace
+ * pages are collected, i.e. by "lctl debug_kernel", the debug daemon and
+ * on panic, so the dump format does not change. They are also formatted
+ * before any module is unloaded, as the format, file and function
+ * pointers of a record refer to the memory of the module which logged it.
+ *
+ * Only the integer, character, string and plain pointer conversions are
+ * recorded, and %pV, whose format and arguments are recorded in its place
+ * as DEBUG_REQ() and LDLM_DEBUG() use it. Messages using anything else,
+ * e.g. the %p extensions which dereference their argument, are formatted
+ * right away as before. A string which does not fit in the slot is cut,
+ * and "[...]" follows it in the formatted record.
+ */
+
+#define DEBUG_SUBSYSTEM S_LNET
+#include "tracefile.h"
+
+#include <linux/ctype.h>
+#include <linux/module.h>
+#include <linux/mutex.h>
+#include <linux/vmalloc.h>
+#include <linux/workqueue.h>
+#include <asm/local.h>
+
+/* number of slots of each per-CPU ring, must be a power of two */
+#define CFS_TRACE_BIN_SLOTS	1024
+/* large enough for the arguments of DEBUG_REQ() and LDLM_DEBUG() */
+#define CFS_TRACE_BIN_SIZE	640
+/* records waiting in a ring before they are formatted by the work item */
+#define CFS_TRACE_BIN_DRAIN	(CFS_TRACE_BIN_SLOTS / 2)
+/* longest conversion specification which is reformatted */
+#define CFS_TRACE_BIN_SPEC_MAX	24
+/* %pV nesting which is recorded */
+#define CFS_TRACE_BIN_DEPTH_MAX	2
+/* appended to a string cut to fit in the slot */
+#define CFS_TRACE_BIN_TRUNC_MARK "[...]"
+
+/* tbr_flags */
+#define CFS_TRACE_BIN_TRUNC	0x01
+
+struct cfs_trace_bin_rec {
+	/* slot index + 1 once the record is complete, 0 while written */
+	u64			 tbr_seq;
+	const char		*tbr_format;
+	const char		*tbr_file;
+	const char		*tbr_fn;
+	u64			 tbr_ns;
+	u32			 tbr_subsys;
+	u32			 tbr_mask;
+	u32			 tbr_line;
+	u32			 tbr_pid;
+	u32			 tbr_stack;
+	u8			 tbr_type;
+	u8			 tbr_flags;
+	u16			 tbr_args_len;
+	/* arguments in format order, 8 bytes each, strings are copied
+	 * with their NUL and padded to 8 bytes, %pV is its format
+	 * followed by its own arguments
+	 */
+	char			 tbr_args[];
+};
+
+#define CFS_TRACE_BIN_ARGS \
+	(CFS_TRACE_BIN_SIZE - sizeof(struct cfs_trace_bin_rec))
+
+struct cfs_trace_bin_ring {
+	/* next slot to reserve */
+	local_t			 tbr_head;
+	/* next slot to format, changed under cfs_trace_bin_mutex */
+	unsigned long		 tbr_tail;
+	char			*tbr_slots;
+};
+
+static struct cfs_trace_bin_ring __percpu *cfs_trace_bin_rings;
+/* serialises enabling and formatting, protects the buffers below */
+static DEFINE_MUTEX(cfs_trace_bin_mutex);
+static char cfs_trace_bin_text[PAGE_SIZE];
+static char cfs_trace_bin_copy[CFS_TRACE_BIN_SIZE] __aligned(8);
+/* binary records formatted into the trace pages */
+u64 cfs_trace_bin_formatted;
+
+static void cfs_trace_bin_drain(struct work_struct *work);
+static DECLARE_WORK(cfs_trace_bin_drain_work, cfs_trace_bin_drain);
+
+static inline struct cfs_trace_bin_rec *
+cfs_trace_bin_slot(struct cfs_trace_bin_ring *ring, unsigned long idx)
+{
+	return (struct cfs_trace_bin_rec *)(ring->tbr_slots +
+		(idx & (CFS_TRACE_BIN_SLOTS - 1)) * CFS_TRACE_BIN_SIZE);
+}
+
+struct cfs_trace_bin_spec {
+	/* number of '*' width and precision arguments, 0 to 2 */
+	int	tbs_nstar;
+	/* precision is a '*' argument, the last one */
+	bool	tbs_prec_star;
+	/* precision given in the format, -1 if none or '*' */
+	int	tbs_prec;
+	/* length modifier: 'H' for hh, 'h', 'l', 'L' for ll, 'z', 't',
+	 * 'j' or 0
+	 */
+	char	tbs_length;
+	char	tbs_conv;
+};
+
+/*
+ * Parse the conversion specification starting at the '%' in @p.
+ * Return a pointer to the character following it, or NULL if the
+ * conversion is not one which can be recorded.
+ */
+static const char *cfs_trace_bin_spec_parse(const char *p,
+					    struct cfs_trace_bin_spec *spec)
+{
+	spec->tbs_nstar = 0;
+	spec->tbs_prec_star = false;
+	spec->tbs_prec = -1;
+	spec->tbs_length = 0;
+
+	p++;
+	while (*p == '-' || *p == '+' || *p == ' ' || *p == '#' || *p == '0')
+		p++;
+	if (*p == '*') {
+		spec->tbs_nstar++;
+		p++;
+	} else {
+		while (isdigit(*p))
+			p++;
+	}
+	if (*p == '.') {
+		p++;
+		if (*p == '*') {
+			spec->tbs_nstar++;
+			spec->tbs_prec_star = true;
+			p++;
+		} else {
+			spec->tbs_prec = 0;
+			while (isdigit(*p)) {
+				if (spec->tbs_prec < INT_MAX / 10)
+					spec->tbs_prec = spec->tbs_prec * 10 +
+							 *p - '0';
+				p++;
+			}
+		}
+	}
+
+	switch (*p) {
+	case 'h':
+		spec->tbs_length = 'h';
+		if (*++p == 'h') {
+			spec->tbs_length = 'H';
+			p++;
+		}
+		break;
+	case 'l':
+		spec->tbs_length = 'l';
+		if (*++p == 'l') {
+			spec->tbs_length = 'L';
+			p++;
+		}
+		break;
+	case 'L':
+	case 'q':
+		spec->tbs_length = 'L';
+		p++;
+		break;
+	case 'z':
+	case 'Z':
+		spec->tbs_length = 'z';
+		p++;
+		break;
+	case 't':
+	case 'j':
+		spec->tbs_length = *p++;
+		break;
+	}
+
+	spec->tbs_conv = *p;
+	switch (*p) {
+	case 'd':
+	case 'i':
+	case 'o':
+	case 'u':
+	case 'x':
+	case 'X':
+	case 'c':
+	case 's':
+		return p + 1;
+	case 'p':
+		/* the arguments of %pV are recorded, but %pI4, %pK...
+		 * dereference or hide theirs. A width is not used by %pV.
+		 */
+		if (p[1] == 'V' && !spec->tbs_nstar) {
+			spec->tbs_conv = 'V';
+			return p + 2;
+		}
+		if (isalnum(p[1]))
+			return NULL;
+		return p + 1;
+	default:
+		return NULL;
+	}
+}
+
+static u64 cfs_trace_bin_get_int(struct cfs_trace_bin_spec *spec,
+				 va_list *ap)
+{
+	bool sign = spec->tbs_conv == 'd' || spec->tbs_conv == 'i';
+
+	switch (spec->tbs_length) {
+	case 'L':
+		return va_arg(*ap, unsigned long long);
+	case 'l':
+		return sign ? (u64)va_arg(*ap, long) :
+			      (u64)va_arg(*ap, unsigned long);
+	case 'z':
+		return sign ? (u64)va_arg(*ap, ssize_t) :
+			      (u64)va_arg(*ap, size_t);
+	case 't':
+		return (u64)va_arg(*ap, ptrdiff_t);
+	case 'j':
+		return (u64)va_arg(*ap, intmax_t);
+	default:
+		return sign ? (u64)va_arg(*ap, int) :
+			      (u64)va_arg(*ap, unsigned int);
+	}
+}
+
+/*
+ * Whether every conversion of @format can be recorded and reformatted by
+ * cfs_trace_bin_print_spec(). Checked before any argument is taken.
+ */
+static bool cfs_trace_bin_format_ok(const char *format)
+{
+	struct cfs_trace_bin_spec spec;
+	const char *start;
+	const char *p = format;
+
+	while ((p = strchr(p, '%')) != NULL) {
+		if (p[1] == '%') {
+			p += 2;
+			continue;
+		}
+		start = p;
+		p = cfs_trace_bin_spec_parse(p, &spec);
+		if (!p || p - start > CFS_TRACE_BIN_SPEC_MAX)
+			return false;
+	}
+
+	return true;
+}
+
+/*
+ * Copy the arguments of @format into @buf, those of a %pV after its
+ * format. Set @trunc if the last string is cut. Return the number of
+ * bytes used or a negative error if they cannot be recorded.
+ */
+static int cfs_trace_bin_pack(char *buf, int size, const char *format,
+			      va_list *ap, int depth, bool *trunc)
+{
+	struct cfs_trace_bin_spec spec;
+	struct va_format *vaf;
+	const char *p = format;
+	const char *s;
+	va_list nested;
+	int used = 0;
+	int prec;
+	int len;
+	int rc;
+	u64 v;
+
+	if (!cfs_trace_bin_format_ok(format))
+		return -EINVAL;
+
+	while ((p = strchr(p, '%')) != NULL) {
+		if (p[1] == '%') {
+			p += 2;
+			continue;
+		}
+		p = cfs_trace_bin_spec_parse(p, &spec);
+
+		prec = spec.tbs_prec;
+		while (spec.tbs_nstar-- > 0) {
+			if (used + sizeof(v) > size)
+				return -E2BIG;
+			v = (s64)va_arg(*ap, int);
+			memcpy(buf + used, &v, sizeof(v));
+			used += sizeof(v);
+			/* a negative precision is taken as omitted */
+			if (!spec.tbs_nstar && spec.tbs_prec_star)
+				prec = (int)v < 0 ? -1 : (int)v;
+		}
+
+		if (spec.tbs_conv == 's') {
+			s = va_arg(*ap, const char *);
+			if (!s)
+				s = "(null)";
+			if (size - used < sizeof(v))
+				return -E2BIG;
+			/* no more than the precision may be read, the string
+			 * need not be terminated; long strings are truncated
+			 * to what is left
+			 */
+			len = size - used - 1;
+			if (prec >= 0 && prec <= len) {
+				len = strnlen(s, prec);
+			} else {
+				len = strnlen(s, len);
+				if (s[len] != '\0')
+					*trunc = true;
+			}
+			memcpy(buf + used, s, len);
+			buf[used + len] = '\0';
+			used += ALIGN(len + 1, sizeof(v));
+			continue;
+		}
+
+		if (spec.tbs_conv == 'V') {
+			vaf = va_arg(*ap, struct va_format *);
+			if (depth + 1 >= CFS_TRACE_BIN_DEPTH_MAX)
+				return -EINVAL;
+			if (used + sizeof(v) > size)
+				return -E2BIG;
+			v = (unsigned long)vaf->fmt;
+			memcpy(buf + used, &v, sizeof(v));
+			used += sizeof(v);
+
+			va_copy(nested, *vaf->va);
+			rc = cfs_trace_bin_pack(buf + used, size - used,
+						vaf->fmt, &nested, depth + 1,
+						trunc);
+			va_end(nested);
+			if (rc < 0)
+				return rc;
+			used += rc;
+			continue;
+		}
+
+		if (used + sizeof(v) > size)
+			return -E2BIG;
+		if (spec.tbs_conv == 'p')
+			v = (unsigned long)va_arg(*ap, void *);
+		else
+			v = cfs_trace_bin_get_int(&spec, ap);
+		memcpy(buf + used, &v, sizeof(v));
+		used += sizeof(v);
+	}
+
+	return used;
+}
+
+/*
+ * Format one conversion of @spec, found at @start and ending before
+ * @end, with the packed arguments at @args. Return the number of bytes
+ * of @args consumed.
+ */
+static int cfs_trace_bin_print_spec(char *out, int size, int *nob,
+				    const char *start, const char *end,
+				    struct cfs_trace_bin_spec *spec,
+				    const char *args, int args_len)
+{
+	char sfmt[CFS_TRACE_BIN_SPEC_MAX + 2 * 12];
+	const char *p;
+	int used = 0;
+	int n = 0;
+	u64 v;
+
+	if (end - start > CFS_TRACE_BIN_SPEC_MAX)
+		return -EINVAL;
+
+	/* substitute the recorded '*' values */
+	for (p = start; p < end; p++) {
+		if (*p != '*') {
+			sfmt[n++] = *p;
+			continue;
+		}
+		if (used + sizeof(v) > args_len)
+			return -EINVAL;
+		memcpy(&v, args + used, sizeof(v));
+		used += sizeof(v);
+		n += scnprintf(sfmt + n, sizeof(sfmt) - n, "%d", (int)v);
+	}
+	sfmt[n] = '\0';
+
+	if (spec->tbs_conv == 's') {
+		if (used >= args_len)
+			return -EINVAL;
+		*nob += scnprintf(out + *nob, size - *nob, sfmt, args + used);
+		return used + ALIGN(strlen(args + used) + 1, sizeof(v));
+	}
+
+	if (used + sizeof(v) > args_len)
+		return -EINVAL;
+	memcpy(&v, args + used, sizeof(v));
+	used += sizeof(v);
+
+	if (spec->tbs_conv == 'p') {
+		*nob += scnprintf(out + *nob, size - *nob, sfmt,
+				  (void *)(unsigned long)v);
+		return used;
+	}
+
+	switch (spec->tbs_length) {
+	case 'L':
+		*nob += scnprintf(out + *nob, size - *nob, sfmt,
+				  (unsigned long long)v);
+		break;
+	case 'l':
+		*nob += scnprintf(out + *nob, size - *nob, sfmt,
+				  (unsigned long)v);
+		break;
+	case 'z':
+		*nob += scnprintf(out + *nob, size - *nob, sfmt, (size_t)v);
+		break;
+	case 't':
+		*nob += scnprintf(out + *nob, size - *nob, sfmt, (ptrdiff_t)v);
+		break;
+	case 'j':
+		*nob += scnprintf(out + *nob, size - *nob, sfmt, (intmax_t)v);
+		break;
+	default:
+		*nob += scnprintf(out + *nob, size - *nob, sfmt,
+				  (unsigned int)v);
+		break;
+	}
+
+	return used;
+}
+
+/*
+ * Format @format with the packed arguments at @args into @out, adding
+ * the length of the text to @nob. The string using the last bytes of
+ * @args is marked as cut if @trunc is set. Return the number of bytes of
+ * @args consumed.
+ */
+static int cfs_trace_bin_format_args(char *out, int size, int *nob,
+				     const char *format, const char *args,
+				     int args_len, bool trunc, int depth)
+{
+	struct cfs_trace_bin_spec spec;
+	int total = args_len;
+	const char *p = format;
+	const char *next;
+	u64 v;
+	int rc;
+
+	while ((next = strchr(p, '%')) != NULL) {
+		*nob += scnprintf(out + *nob, size - *nob, "%.*s",
+				  (int)(next - p), p);
+		if (next[1] == '%') {
+			*nob += scnprintf(out + *nob, size - *nob, "%%");
+			p = next + 2;
+			continue;
+		}
+
+		p = cfs_trace_bin_spec_parse(next, &spec);
+		if (!p)
+			return total - args_len;
+
+		if (spec.tbs_conv != 'V') {
+			rc = cfs_trace_bin_print_spec(out, size, nob, next, p,
+						      &spec, args, args_len);
+		} else if (depth + 1 >= CFS_TRACE_BIN_DEPTH_MAX ||
+			   args_len < sizeof(v)) {
+			rc = -EINVAL;
+		} else {
+			memcpy(&v, args, sizeof(v));
+			rc = sizeof(v);
+			rc += cfs_trace_bin_format_args(out, size, nob,
+					(const char *)(unsigned long)v,
+					args + rc, args_len - rc, trunc,
+					depth + 1);
+		}
+		if (rc < 0) {
+			*nob += scnprintf(out + *nob, size - *nob, "%.*s",
+					  (int)(p - next), next);
+			continue;
+		}
+		args += rc;
+		args_len -= rc;
+
+		if (spec.tbs_conv == 's' && trunc && !args_len)
+			*nob += scnprintf(out + *nob, size - *nob, "%s",
+					  CFS_TRACE_BIN_TRUNC_MARK);
+	}
+	*nob += scnprintf(out + *nob, size - *nob, "%s", p);
+
+	return total - args_len;
+}
+
+/* Format @rec into @out, return the length of the text */
+static int cfs_trace_bin_format(char *out, int size,
+				struct cfs_trace_bin_rec *rec)
+{
+	int nob = 0;
+
+	cfs_trace_bin_format_args(out, size, &nob, rec->tbr_format,
+				  rec->tbr_args, rec->tbr_args_len,
+				  rec->tbr_flags & CFS_TRACE_BIN_TRUNC, 0);
+
+	return nob;
+}
+
+bool cfs_trace_bin_vrecord(struct libcfs_debug_msg_data *msgdata,
+			   const char *file, const char *format, va_list ap)
+{
+	struct cfs_trace_bin_ring *rings = READ_ONCE(cfs_trace_bin_rings);
+	struct cfs_trace_bin_ring *ring;
+	struct cfs_trace_bin_rec *rec;
+	unsigned long idx;
+	bool trunc = false;
+	va_list args;
+	int rc;
+
+	if (!rings)
+		return false;
+
+	ring = get_cpu_ptr(rings);
+	idx = local_inc_return(&ring->tbr_head) - 1;
+	rec = cfs_trace_bin_slot(ring, idx);
+
+	WRITE_ONCE(rec->tbr_seq, 0);
+	smp_wmb();
+
+	va_copy(args, ap);
+	rc = cfs_trace_bin_pack(rec->tbr_args, CFS_TRACE_BIN_ARGS, format,
+				&args, 0, &trunc);
+	va_end(args);
+	if (rc < 0) {
+		/* the slot stays empty, format this one as text */
+		put_cpu_ptr(rings);
+		return false;
+	}
+
+	rec->tbr_args_len = rc;
+	rec->tbr_format = format;
+	rec->tbr_file = file;
+	rec->tbr_fn = msgdata->msg_fn;
+	rec->tbr_ns = ktime_get_real_ns();
+	rec->tbr_subsys = msgdata->msg_subsys;
+	rec->tbr_mask = msgdata->msg_mask;
+	rec->tbr_line = msgdata->msg_line;
+	rec->tbr_pid = current->pid;
+	rec->tbr_stack = CDEBUG_STACK();
+	rec->tbr_type = cfs_trace_buf_idx_get();
+	rec->tbr_flags = trunc ? CFS_TRACE_BIN_TRUNC : 0;
+
+	smp_wmb();
+	WRITE_ONCE(rec->tbr_seq, (u64)idx + 1);
+
+	/* format the records before the ring wraps over them */
+	if (idx + 1 - READ_ONCE(ring->tbr_tail) >= CFS_TRACE_BIN_DRAIN)
+		schedule_work(&cfs_trace_bin_drain_work);
+	put_cpu_ptr(rings);
+
+	return true;
+}
+
+static void cfs_trace_bin_flush_ring(struct cfs_trace_bin_ring *ring,
+				     int cpu, bool panic)
+{
+	struct cfs_trace_bin_rec *copy = (void *)cfs_trace_bin_copy;
+	struct ptldebug_header hdr;
+	struct cfs_trace_bin_rec *rec;
+	unsigned long head;
+	unsigned long idx;
+	u32 usec;
+	int len;
+
+	head = local_read(&ring->tbr_head);
+	idx = ring->tbr_tail;
+	if (head - idx > CFS_TRACE_BIN_SLOTS)
+		idx = head - CFS_TRACE_BIN_SLOTS;
+
+	for (; idx != head; idx++) {
+		rec = cfs_trace_bin_slot(ring, idx);
+
+		/* skip the records being written or already overwritten,
+		 * and those which changed while they were copied
+		 */
+		if (READ_ONCE(rec->tbr_seq) != (u64)idx + 1)
+			continue;
+		smp_rmb();
+		memcpy(copy, rec, CFS_TRACE_BIN_SIZE);
+		smp_rmb();
+		if (READ_ONCE(rec->tbr_seq) != (u64)idx + 1)
+			continue;
+
+		len = cfs_trace_bin_format(cfs_trace_bin_text,
+					   sizeof(cfs_trace_bin_text), copy);
+
+		memset(&hdr, 0, sizeof(hdr));
+		hdr.ph_subsys = copy->tbr_subsys;
+		hdr.ph_mask = copy->tbr_mask;
+		hdr.ph_cpu_id = cpu;
+		hdr.ph_type = copy->tbr_type;
+		hdr.ph_sec = (u32)div_u64_rem(copy->tbr_ns, NSEC_PER_SEC,
+					      &usec);
+		hdr.ph_usec = usec / NSEC_PER_USEC;
+		hdr.ph_stack = copy->tbr_stack;
+		hdr.ph_pid = copy->tbr_pid;
+		hdr.ph_line_num = copy->tbr_line;
+
+		if (!cfs_trace_append_record(&hdr, copy->tbr_file,
+					     copy->tbr_fn, cfs_trace_bin_text,
+					     len, panic))
+			cfs_trace_bin_formatted++;
+	}
+	WRITE_ONCE(ring->tbr_tail, head);
+}
+
+/*
+ * Format the binary records logged since the last call into the trace
+ * pages of their CPU.
+ */
+void cfs_trace_bin_flush(bool panic)
+{
+	struct cfs_trace_bin_ring *rings = READ_ONCE(cfs_trace_bin_rings);
+	int cpu;
+
+	if (!rings)
+		return;
+
+	/* the other CPUs are stopped during a panic */
+	if (!panic)
+		mutex_lock(&cfs_trace_bin_mutex);
+
+	for_each_possible_cpu(cpu)
+		cfs_trace_bin_flush_ring(per_cpu_ptr(rings, cpu), cpu, panic);
+
+	if (!panic)
+		mutex_unlock(&cfs_trace_bin_mutex);
+}
+
+static void cfs_trace_bin_drain(struct work_struct *work)
+{
+	cfs_trace_bin_flush(false);
+}
+
+/* Drop the binary records not formatted yet */
+void cfs_trace_bin_clear(void)
+{
+	struct cfs_trace_bin_ring *rings = READ_ONCE(cfs_trace_bin_rings);
+	struct cfs_trace_bin_ring *ring;
+	int cpu;
+
+	if (!rings)
+		return;
+
+	mutex_lock(&cfs_trace_bin_mutex);
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(rings, cpu);
+		WRITE_ONCE(ring->tbr_tail, local_read(&ring->tbr_head));
+	}
+	mutex_unlock(&cfs_trace_bin_mutex);
+}
+
+static void cfs_trace_bin_free(struct cfs_trace_bin_ring __percpu *rings)
+{
+	int cpu;
+
+	for_each_possible_cpu(cpu)
+		vfree(per_cpu_ptr(rings, cpu)->tbr_slots);
+	free_percpu(rings);
+}
+
+/*
+ * Allocate the rings the first time binary tracing is enabled. They are
+ * kept until libcfs is unloaded, so a writer never sees them go away.
+ */
+int cfs_trace_bin_enable(void)
+{
+	struct cfs_trace_bin_ring __percpu *rings;
+	struct cfs_trace_bin_ring *ring;
+	int rc = 0;
+	int cpu;
+
+	BUILD_BUG_ON(sizeof(struct cfs_trace_bin_rec) % 8 != 0);
+	BUILD_BUG_ON(CFS_TRACE_BIN_SLOTS & (CFS_TRACE_BIN_SLOTS - 1));
+
+	mutex_lock(&cfs_trace_bin_mutex);
+	if (cfs_trace_bin_rings)
+		goto out;
+
+	rings = alloc_percpu(struct cfs_trace_bin_ring);
+	if (!rings)
+		GOTO(out, rc = -ENOMEM);
+
+	for_each_possible_cpu(cpu) {
+		ring = per_cpu_ptr(rings, cpu);
+		local_set(&ring->tbr_head, 0);
+		ring->tbr_tail = 0;
+		ring->tbr_slots = vzalloc_node(CFS_TRACE_BIN_SLOTS *
+					       CFS_TRACE_BIN_SIZE,
+					       cpu_to_node(cpu));
+		if (!ring->tbr_slots) {
+			cfs_trace_bin_free(rings);
+			GOTO(out, rc = -ENOMEM);
+		}
+	}
+
+	smp_store_release(&cfs_trace_bin_rings, rings);
+out:
+	mutex_unlock(&cfs_trace_bin_mutex);
+	return rc;
+}
+
+static int cfs_trace_bin_module_notify(struct notifier_block *nb,
+				       unsigned long state, void *data)
+{
+	/* the records may point into the module which is going away */
+	if (state == MODULE_STATE_GOING)
+		cfs_trace_bin_flush(false);
+
+	return NOTIFY_DONE;
+}
+
+static struct notifier_block cfs_trace_bin_module_nb = {
+	.notifier_call	= cfs_trace_bin_module_notify,
+};
+
+int cfs_trace_bin_init(void)
+{
+	return register_module_notifier(&cfs_trace_bin_module_nb);
+}
+
+void cfs_trace_bin_fini(void)
+{
+	unregister_module_notifier(&cfs_trace_bin_module_nb);
+	cancel_work_sync(&cfs_trace_bin_drain_work);
+
+	if (cfs_trace_bin_rings) {
+		cfs_trace_bin_free(cfs_trace_bin_rings);
+		cfs_trace_bin_rings = NULL;
+	}
+}
@@ -47,13 +47,6 @@
 #include <libcfs/libcfs.h>
 
 
-enum cfs_trace_buf_type {
-	CFS_TCD_TYPE_PROC = 0,
-	CFS_TCD_TYPE_SOFTIRQ,
-	CFS_TCD_TYPE_IRQ,
-	CFS_TCD_TYPE_CNT
-};
-
 union cfs_trace_data_union (*cfs_trace_data[CFS_TCD_TYPE_CNT])[NR_CPUS] __cacheline_aligned;
 
 /* Pages containing records already processed by daemon.
@@ -229,7 +222,7 @@ cfs_trace_get_tage_try(struct cfs_trace_cpu_data *tcd, unsigned long len)
 		}
 
 		tage->used = 0;
-		tage->cpu = smp_processor_id();
+		tage->cpu = tcd->tcd_cpu;
 		tage->type = tcd->tcd_type;
 		list_add_tail(&tage->linkage, &tcd->tcd_pages);
 		tcd->tcd_cur_pages++;
@@ -397,6 +390,19 @@ int libcfs_debug_msg(struct libcfs_debug_msg_data *msgdata,
 	if (strchr(file, '/'))
 		file = strrchr(file, '/') + 1;
 
+	/* Messages which do not go to the console can be recorded as a
+	 * format and its raw arguments, and formatted when dumped.
+	 */
+	if (libcfs_trace_binary && !(mask & libcfs_printk)) {
+		bool recorded;
+
+		va_start(ap, format);
+		recorded = cfs_trace_bin_vrecord(msgdata, file, format, ap);
+		va_end(ap);
+		if (recorded)
+			return 1;
+	}
+
 	tcd = cfs_trace_get_tcd();
 
 	/* cfs_trace_get_tcd() grabs a lock, which disables preemption and
@@ -563,6 +569,75 @@ console:
 }
 EXPORT_SYMBOL(libcfs_debug_msg);
 
+/*
+ * Add a text record built outside of libcfs_debug_msg(), e.g. from a
+ * binary trace record, to the pages of the CPU and context given in
+ * @hdr. During a panic the other CPUs are stopped and the tcd locks may
+ * be held by them, so they are not taken.
+ */
+int cfs_trace_append_record(struct ptldebug_header *hdr, const char *file,
+			    const char *fn, const char *text, int len,
+			    bool panic)
+{
+	struct cfs_trace_cpu_data *tcd;
+	struct cfs_trace_page *tage;
+	char *debug_buf;
+	int known_size;
+	int rc = 0;
+
+	if (hdr->ph_cpu_id >= nr_cpu_ids ||
+	    hdr->ph_type >= CFS_TCD_TYPE_CNT || !cfs_trace_data[hdr->ph_type])
+		return -EINVAL;
+
+	tcd = &(*cfs_trace_data[hdr->ph_type])[hdr->ph_cpu_id].tcd;
+	if (!panic)
+		cfs_trace_lock_tcd(tcd, 1);
+
+	if (tcd->tcd_shutting_down) {
+		rc = -ESHUTDOWN;
+		goto out;
+	}
+
+	if (tcd->tcd_cur_pages == 0)
+		hdr->ph_flags |= PH_FLAG_FIRST_RECORD;
+
+	known_size = strlen(file) + 1;
+	if (fn)
+		known_size += strlen(fn) + 1;
+	if (libcfs_debug_binary)
+		known_size += sizeof(*hdr);
+	if (known_size + len > PAGE_SIZE)
+		len = PAGE_SIZE - known_size;
+
+	tage = cfs_trace_get_tage(tcd, known_size + len);
+	if (!tage) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	hdr->ph_len = known_size + len;
+	debug_buf = (char *)page_address(tage->page) + tage->used;
+
+	if (libcfs_debug_binary) {
+		memcpy(debug_buf, hdr, sizeof(*hdr));
+		debug_buf += sizeof(*hdr);
+	}
+	strcpy(debug_buf, file);
+	debug_buf += strlen(file) + 1;
+	if (fn) {
+		strcpy(debug_buf, fn);
+		debug_buf += strlen(fn) + 1;
+	}
+	memcpy(debug_buf, text, len);
+
+	tage->used += known_size + len;
+	__LASSERT(tage->used <= PAGE_SIZE);
+out:
+	if (!panic)
+		cfs_trace_unlock_tcd(tcd, 1);
+	return rc;
+}
+
 void
 cfs_trace_assertion_failed(const char *str,
 			   struct libcfs_debug_msg_data *msgdata)
@@ -618,6 +693,9 @@ static void collect_pages(struct page_collection *pc)
 {
 	INIT_LIST_HEAD(&pc->pc_pages);
 
+	/* format the binary records so they are dumped with the others */
+	cfs_trace_bin_flush(libcfs_panic_in_progress);
+
 	if (libcfs_panic_in_progress)
 		panic_collect_pages(pc);
 	else
@@ -799,6 +877,7 @@ void cfs_trace_flush_pages(void)
 	struct cfs_trace_page *tage;
 	struct page *page;
 
+	cfs_trace_bin_clear();
 	collect_pages(&pc);
 	while (!list_empty(&pc.pc_pages)) {
 		tage = list_first_entry(&pc.pc_pages,
@@ -1122,6 +1201,7 @@ static unsigned int pages_factor[CFS_TCD_TYPE_CNT] = {
 int cfs_tracefile_init(int max_pages)
 {
 	struct cfs_trace_cpu_data *tcd;
+	int rc;
 	int i;
 	int j;
 
@@ -1155,6 +1235,10 @@ int cfs_tracefile_init(int max_pages)
 	}
 	daemon_pages_max = max_pages;
 
+	rc = cfs_trace_bin_init();
+	if (rc)
+		goto out_trace_data;
+
 	return 0;
 
 out_trace_data:
@@ -1211,6 +1295,8 @@ static void cfs_trace_cleanup(void)
 void cfs_tracefile_exit(void)
 {
 	cfs_trace_stop_thread();
+	libcfs_trace_binary = 0;
 	cfs_trace_flush_pages();
 	cfs_trace_cleanup();
+	cfs_trace_bin_fini();
 }
@@ -34,6 +34,13 @@
 
 #include <libcfs/libcfs.h>
 
+enum cfs_trace_buf_type {
+	CFS_TCD_TYPE_PROC = 0,
+	CFS_TCD_TYPE_SOFTIRQ,
+	CFS_TCD_TYPE_IRQ,
+	CFS_TCD_TYPE_CNT
+};
+
 #define TRACEFILE_NAME_SIZE 1024
 extern char      cfs_tracefile[TRACEFILE_NAME_SIZE];
 extern long long cfs_tracefile_size;
@@ -60,6 +67,21 @@ int cfs_trace_daemon_command(char *str);
 int cfs_trace_daemon_command_usrstr(void __user *usr_str, int usr_str_nob);
 int cfs_trace_set_debug_mb(int mb);
 int cfs_trace_get_debug_mb(void);
+enum cfs_trace_buf_type cfs_trace_buf_idx_get(void);
+int cfs_trace_append_record(struct ptldebug_header *hdr, const char *file,
+			    const char *fn, const char *text, int len,
+			    bool panic);
+
+/* binary trace records, see tracebin.c */
+extern unsigned int libcfs_trace_binary;
+extern u64 cfs_trace_bin_formatted;
+int cfs_trace_bin_enable(void);
+bool cfs_trace_bin_vrecord(struct libcfs_debug_msg_data *msgdata,
+			   const char *file, const char *format, va_list ap);
+void cfs_trace_bin_flush(bool panic);
+void cfs_trace_bin_clear(void);
+int cfs_trace_bin_init(void);
+void cfs_trace_bin_fini(void);
 
 extern int  libcfs_panic_in_progress;
 
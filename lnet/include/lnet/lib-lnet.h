@@ -609,6 +609,8 @@ extern unsigned int lnet_health_sensitivity;
 extern unsigned int lnet_recovery_interval;
 extern unsigned int lnet_recovery_limit;
 extern unsigned int lnet_peer_discovery_disabled;
+extern unsigned int lnet_max_discovery_inflight;
+extern unsigned int lnet_select_timing;
 extern unsigned int lnet_drop_asym_route;
 extern unsigned int lnet_max_recovery_ping_interval;
 extern unsigned int lnet_max_recovery_ping_count;
@@ -819,6 +821,8 @@ bool lnet_delay_rule_match_locked(struct lnet_hdr *hdr, struct lnet_msg *msg);
 void lnet_counters_get_common(struct lnet_counters_common *common);
 int lnet_counters_get(struct lnet_counters *counters);
 void lnet_counters_reset(void);
+void lnet_select_stats_get(struct lnet_select_stats *stats);
+void lnet_select_stats_reset(void);
 static inline void
 lnet_ni_set_sel_priority_locked(struct lnet_ni *ni, __u32 priority)
 {
@@ -1005,6 +1009,8 @@ struct lnet_peer_net *lnet_peer_get_net_locked(struct lnet_peer *peer,
 					       __u32 net_id);
 bool lnet_peer_is_pref_nid_locked(struct lnet_peer_ni *lpni,
 				  struct lnet_nid *nid);
+bool lnet_peer_is_pref_ni_locked(struct lnet_peer_ni *lpni,
+				 struct lnet_ni *ni);
 int lnet_peer_add_pref_nid(struct lnet_peer_ni *lpni, struct lnet_nid *nid);
 void lnet_peer_clr_pref_nids(struct lnet_peer_ni *lpni);
 bool lnet_peer_is_pref_rtr_locked(struct lnet_peer_ni *lpni,
@@ -1015,6 +1021,16 @@ int lnet_peer_ni_set_non_mr_pref_nid(struct lnet_peer_ni *lpni,
 				     struct lnet_nid *nid);
 int lnet_add_peer_ni(lnet_nid_t key_nid, lnet_nid_t nid, bool mr, bool temp);
 int lnet_del_peer_ni(lnet_nid_t key_nid, lnet_nid_t nid);
+int lnet_peer_set_warm(lnet_nid_t prim_nid);
+bool lnet_peer_nid_configured(lnet_nid_t nid4);
+
+/* the set of local NIs changed, recompile the preferred NI masks */
+static inline void lnet_ni_sel_gen_bump(void)
+{
+	atomic_inc(&the_lnet.ln_sel_gen);
+}
+void lnet_discovery_stats_get(struct lnet_ioctl_discovery_stats *stats);
+void lnet_discovery_stats_reset(void);
 int lnet_get_peer_info(struct lnet_ioctl_peer_cfg *cfg, void __user *bulk);
 int lnet_get_peer_ni_info(__u32 peer_index, __u64 *nid,
 			  char alivness[LNET_MAX_STR_LEN],
@@ -542,6 +542,9 @@ struct lnet_ni {
 	/* the relative selection priority of this NI */
 	__u32			ni_sel_priority;
 
+	/* bit of this NI in lpni_pref_ni_mask, or -1 if none was free */
+	int			ni_sel_idx;
+
 	/*
 	 * equivalent interface to use
 	 */
@@ -572,6 +575,16 @@ struct lnet_ping_buffer {
 #define LNET_PING_INFO_TO_BUFFER(PINFO)	\
 	container_of((PINFO), struct lnet_ping_buffer, pb_info)
 
+/* number of local NIs which can be tracked in lpni_pref_ni_mask */
+#define LNET_SEL_NI_MAX		64
+
+/* lnet_select_pathway() timing, see lnet_select_timing */
+struct lnet_select_stats {
+	__u64			lss_count;
+	__u64			lss_total_ns;
+	__u64			lss_max_ns;
+};
+
 struct lnet_nid_list {
 	struct list_head nl_list;
 	struct lnet_nid nl_nid;
@@ -650,6 +663,11 @@ struct lnet_peer_ni {
 	__u32			lpni_sel_priority;
 	/* number of preferred NIDs in lnpi_pref_nids */
 	__u32			lpni_pref_nnids;
+	/* lpni_pref.nids compiled to a mask of ni_sel_idx bits. Only
+	 * valid while lpni_pref_gen matches ln_sel_gen
+	 */
+	__u64			lpni_pref_ni_mask;
+	__u32			lpni_pref_gen;
 };
 
 /* Preferred path added due to traffic on non-MR peer_ni */
@@ -748,6 +766,9 @@ struct lnet_peer {
 	/* time it was put on the ln_dc_working queue */
 	time64_t		lp_last_queued;
 
+	/* time it was queued for discovery, for latency stats */
+	ktime_t			lp_dc_start;
+
 	/* link on discovery-related lists */
 	struct list_head	lp_dc_list;
 
@@ -829,6 +850,10 @@ struct lnet_peer {
  * which is also configured by Lustre as the primary NID.
  */
 #define LNET_PEER_BAD_CONFIG		BIT(21)
+/* NIDs were restored from a peer snapshot and are used without waiting
+ * for discovery, which revalidates them on first use.
+ */
+#define LNET_PEER_WARM			BIT(22)
 
 struct lnet_peer_net {
 	/* chain on lp_peer_nets */
@@ -1217,6 +1242,22 @@ struct lnet {
 	wait_queue_head_t		ln_dc_waitq;
 	/* discovery startup/shutdown state */
 	int				ln_dc_state;
+	/* pings/pushes sent by discovery and not answered yet */
+	atomic_t			ln_dc_inflight;
+	/* request queue processing stopped on ln_dc_inflight limit */
+	bool				ln_dc_throttled;
+	/* discovery statistics, protected by lnet_net_lock/EX */
+	struct lnet_ioctl_discovery_stats ln_dc_stats;
+
+	/* ni_sel_idx allocation bitmap */
+	DECLARE_BITMAP(ln_sel_ni_map, LNET_SEL_NI_MAX);
+	/* bumped whenever an ni_sel_idx is allocated or released, or an NI
+	 * is published on a net_ni_list, which invalidates all the compiled
+	 * lpni_pref_ni_mask
+	 */
+	atomic_t			ln_sel_gen;
+	/* per-cpt cost of lnet_select_pathway() */
+	struct lnet_select_stats	**ln_select_stats;
 
 	/* monitor thread startup/shutdown state */
 	int				ln_mt_state;
@@ -269,6 +269,15 @@ struct lnet_ioctl_peer {
 	} pr_lnd_u;
 };
 
+/* prcfg_state flag for IOC_LIBCFS_ADD_PEER_NI: add the peer NIDs from a
+ * peer snapshot, usable right away and revalidated by discovery on first use
+ */
+#define LNET_PEER_CFG_WARM	0x1
+/* prcfg_state bit returned by IOC_LIBCFS_GET_PEER_NI for a peer configured
+ * through DLC
+ */
+#define LNET_PEER_STATE_CONFIGURED	0x8
+
 struct lnet_ioctl_peer_cfg {
 	struct libcfs_ioctl_hdr prcfg_hdr;
 	lnet_nid_t prcfg_prim_nid;
@@ -307,9 +316,26 @@ struct lnet_ioctl_set_value {
 	__u32 sv_value;
 };
 
+/* peer discovery latency buckets: <1ms, <10ms, <100ms, <1s, <10s, more */
+#define LNET_DC_LATENCY_BUCKETS	6
+
+struct lnet_ioctl_discovery_stats {
+	__u64 ds_completed;		/* discoveries completed */
+	__u64 ds_failed;		/* discoveries completed with error */
+	__u64 ds_latency_total_us;	/* from queueing to completion */
+	__u64 ds_latency_max_us;
+	__u64 ds_latency_hist[LNET_DC_LATENCY_BUCKETS];
+	__u32 ds_inflight;		/* pings/pushes awaiting an answer */
+	__u32 ds_throttled;		/* batches cut short by the limit */
+	__u32 ds_warm_peers;		/* peers added from a peer snapshot */
+	__u32 ds_padding;
+};
+
 struct lnet_ioctl_lnet_stats {
 	struct libcfs_ioctl_hdr st_hdr;
 	struct lnet_counters st_cntrs;
+	/* only filled if ioc_len covers it */
+	struct lnet_ioctl_discovery_stats st_discovery;
 };
 
 /* An IP, numeric NID or a Net number is composed of 1 or more of these
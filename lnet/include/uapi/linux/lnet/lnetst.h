@@ -40,9 +40,11 @@
 
 #define LST_FEAT_NONE		(0)
 #define LST_FEAT_BULK_LEN	(1 << 0)	/* enable variable page size */
+#define LST_FEAT_LATENCY	(1 << 1)	/* latency stats, fixed rate */
 
 #define LST_FEATS_EMPTY		(LST_FEAT_NONE)
-#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN)
+#define LST_FEATS_MASK		(LST_FEAT_NONE | LST_FEAT_BULK_LEN | \
+				 LST_FEAT_LATENCY)
 
 #define LST_NAME_SIZE		32		/* max name buffer length */
 
@@ -65,6 +67,7 @@
 #define LSTIO_TEST_ADD		0xC26		/* add test (to batch) */
 #define LSTIO_BATCH_QUERY	0xC27		/* query batch status */
 #define LSTIO_STAT_QUERY	0xC30		/* get stats */
+#define LSTIO_STAT_LAT_QUERY	0xC31		/* get latency histograms */
 
 /*
  * sparse kernel source annotations
@@ -505,6 +508,7 @@ struct lst_test_bulk_param {
 	int blk_flags;		/* reserved flags */
 	int blk_cli_off;	/* bulk offset on client */
 	int blk_srv_off;	/* reserved: bulk offset on server */
+	int blk_rate;		/* RPCs/sec per client, 0: closed loop */
 };
 
 struct lst_test_ping_param {
@@ -512,6 +516,7 @@ struct lst_test_ping_param {
 	int png_time;		/* time */
 	int png_loop;		/* loop */
 	int png_flags;		/* reserved flags */
+	int png_rate;		/* RPCs/sec per client, 0: closed loop */
 };
 
 /* Both struct srpc_counters and struct sfw_counters are sent over the wire */
@@ -534,4 +539,13 @@ struct sfw_counters {
 	__u32 ping_errors;
 } __attribute__((packed));
 
+/* RPC latency histogram, bucket i counts RPCs which completed in
+ * [2^i, 2^(i+1)) microseconds, the last bucket also counts anything
+ * slower. Sent over the wire with LST_FEAT_LATENCY. */
+#define LST_LAT_BUCKETS		29
+
+struct sfw_lat_counters {
+	__u32 lat_hist[LST_LAT_BUCKETS];
+} __attribute__((packed));
+
 #endif
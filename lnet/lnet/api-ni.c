@@ -128,6 +128,16 @@ module_param(lnet_recovery_limit, uint, 0644);
 MODULE_PARM_DESC(lnet_recovery_limit,
 		 "How long to attempt recovery of unhealthy peer interfaces in seconds. Set to 0 to allow indefinite recovery");
 
+unsigned int lnet_max_discovery_inflight = 1024;
+module_param(lnet_max_discovery_inflight, uint, 0644);
+MODULE_PARM_DESC(lnet_max_discovery_inflight,
+		 "Maximum number of discovery pings and pushes awaiting an answer. Set to 0 for no limit");
+
+unsigned int lnet_select_timing;
+module_param(lnet_select_timing, uint, 0644);
+MODULE_PARM_DESC(lnet_select_timing,
+		 "Measure the cost of path selection for each message sent, reported in the select_stats debugfs file");
+
 unsigned int lnet_max_recovery_ping_interval = 900;
 unsigned int lnet_max_recovery_ping_count = 9;
 static int max_recovery_ping_interval_set(const char *val,
@@ -1123,6 +1133,41 @@ avoid_reset:
 	lnet_net_unlock(LNET_LOCK_EX);
 }
 
+void
+lnet_select_stats_get(struct lnet_select_stats *stats)
+{
+	struct lnet_select_stats *lss;
+	int i;
+
+	memset(stats, 0, sizeof(*stats));
+
+	lnet_net_lock(LNET_LOCK_EX);
+	if (the_lnet.ln_state != LNET_STATE_RUNNING)
+		goto out_unlock;
+
+	cfs_percpt_for_each(lss, i, the_lnet.ln_select_stats) {
+		stats->lss_count += lss->lss_count;
+		stats->lss_total_ns += lss->lss_total_ns;
+		stats->lss_max_ns = max(stats->lss_max_ns, lss->lss_max_ns);
+	}
+out_unlock:
+	lnet_net_unlock(LNET_LOCK_EX);
+}
+
+void
+lnet_select_stats_reset(void)
+{
+	struct lnet_select_stats *lss;
+	int i;
+
+	lnet_net_lock(LNET_LOCK_EX);
+	if (the_lnet.ln_state == LNET_STATE_RUNNING) {
+		cfs_percpt_for_each(lss, i, the_lnet.ln_select_stats)
+			memset(lss, 0, sizeof(*lss));
+	}
+	lnet_net_unlock(LNET_LOCK_EX);
+}
+
 static char *
 lnet_res_type2str(int type)
 {
@@ -1334,6 +1379,9 @@ lnet_prepare(lnet_pid_t requested_pid)
 	INIT_LIST_HEAD(&the_lnet.ln_dc_request);
 	INIT_LIST_HEAD(&the_lnet.ln_dc_working);
 	INIT_LIST_HEAD(&the_lnet.ln_dc_expired);
+	atomic_set(&the_lnet.ln_dc_inflight, 0);
+	the_lnet.ln_dc_throttled = false;
+	memset(&the_lnet.ln_dc_stats, 0, sizeof(the_lnet.ln_dc_stats));
 	INIT_LIST_HEAD(&the_lnet.ln_mt_localNIRecovq);
 	INIT_LIST_HEAD(&the_lnet.ln_mt_peerNIRecovq);
 	INIT_LIST_HEAD(&the_lnet.ln_udsp_list);
@@ -1363,6 +1411,14 @@ lnet_prepare(lnet_pid_t requested_pid)
 		goto failed;
 	}
 
+	the_lnet.ln_select_stats = cfs_percpt_alloc(lnet_cpt_table(),
+					sizeof(struct lnet_select_stats));
+	if (the_lnet.ln_select_stats == NULL) {
+		CERROR("Failed to allocate selection stats for LNet\n");
+		rc = -ENOMEM;
+		goto failed;
+	}
+
 	rc = lnet_peer_tables_create();
 	if (rc != 0)
 		goto failed;
@@ -1442,6 +1498,10 @@ lnet_unprepare(void)
 		cfs_percpt_free(the_lnet.ln_counters);
 		the_lnet.ln_counters = NULL;
 	}
+	if (the_lnet.ln_select_stats != NULL) {
+		cfs_percpt_free(the_lnet.ln_select_stats);
+		the_lnet.ln_select_stats = NULL;
+	}
 	lnet_destroy_remote_nets_table();
 	lnet_udsp_destroy(true);
 	lnet_slab_cleanup();
@@ -2691,6 +2751,8 @@ lnet_startup_lndnet(struct lnet_net *net, struct lnet_lnd_tunables *tun)
 	lnet_net_lock(LNET_LOCK_EX);
 	list_splice_tail(&local_ni_list, &net_l->net_ni_list);
 	lnet_incr_dlc_seq();
+	/* a mask compiled before the NIs were visible lacks their bits */
+	lnet_ni_sel_gen_bump();
 	lnet_net_unlock(LNET_LOCK_EX);
 
 	/* if the network is not unique then we don't want to keep
@@ -2716,6 +2778,7 @@ lnet_startup_lndnet(struct lnet_net *net, struct lnet_lnd_tunables *tun)
 
 		lnet_net_lock(LNET_LOCK_EX);
 		list_add_tail(&net->net_list, &the_lnet.ln_nets);
+		lnet_ni_sel_gen_bump();
 		lnet_net_unlock(LNET_LOCK_EX);
 	}
 
@@ -4143,11 +4206,15 @@ LNetCtl(unsigned int cmd, void *arg)
 	{
 		struct lnet_ioctl_lnet_stats *lnet_stats = arg;
 
-		if (lnet_stats->st_hdr.ioc_len < sizeof(*lnet_stats))
+		/* older tools do not know about the discovery stats */
+		if (lnet_stats->st_hdr.ioc_len <
+		    offsetof(struct lnet_ioctl_lnet_stats, st_discovery))
 			return -EINVAL;
 
 		mutex_lock(&the_lnet.ln_api_mutex);
 		rc = lnet_counters_get(&lnet_stats->st_cntrs);
+		if (!rc && lnet_stats->st_hdr.ioc_len >= sizeof(*lnet_stats))
+			lnet_discovery_stats_get(&lnet_stats->st_discovery);
 		mutex_unlock(&the_lnet.ln_api_mutex);
 		return rc;
 	}
@@ -4156,6 +4223,7 @@ LNetCtl(unsigned int cmd, void *arg)
 	{
 		mutex_lock(&the_lnet.ln_api_mutex);
 		lnet_counters_reset();
+		lnet_discovery_stats_reset();
 		mutex_unlock(&the_lnet.ln_api_mutex);
 		return 0;
 	}
@@ -4263,9 +4331,24 @@ LNetCtl(unsigned int cmd, void *arg)
 			return -EINVAL;
 
 		mutex_lock(&the_lnet.ln_api_mutex);
-		rc = lnet_add_peer_ni(cfg->prcfg_prim_nid,
-				      cfg->prcfg_cfg_nid,
-				      cfg->prcfg_mr, false);
+		if (cfg->prcfg_state & LNET_PEER_CFG_WARM) {
+			/* snapshot peers are not pinned by configuration,
+			 * and leave configured peers alone
+			 */
+			if (lnet_peer_nid_configured(cfg->prcfg_prim_nid) ||
+			    lnet_peer_nid_configured(cfg->prcfg_cfg_nid))
+				rc = -EEXIST;
+			else
+				rc = lnet_add_peer_ni(cfg->prcfg_prim_nid,
+						      cfg->prcfg_cfg_nid,
+						      cfg->prcfg_mr, true);
+			if (!rc)
+				rc = lnet_peer_set_warm(cfg->prcfg_prim_nid);
+		} else {
+			rc = lnet_add_peer_ni(cfg->prcfg_prim_nid,
+					      cfg->prcfg_cfg_nid,
+					      cfg->prcfg_mr, false);
+		}
 		mutex_unlock(&the_lnet.ln_api_mutex);
 		return rc;
 	}
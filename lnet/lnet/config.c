@@ -278,9 +278,47 @@ lnet_net_remove_cpts(__u32 *cpts, __u32 ncpts, struct lnet_net *net)
 	}
 }
 
+/*
+ * Give the NI a bit in the preferred NI masks of the peer NIs, so the
+ * selection algorithm can test a preference without walking the list of
+ * preferred NIDs. NIs beyond LNET_SEL_NI_MAX keep using the list.
+ */
+static void
+lnet_ni_sel_idx_get(struct lnet_ni *ni)
+{
+	int idx;
+
+	do {
+		idx = find_first_zero_bit(the_lnet.ln_sel_ni_map,
+					  LNET_SEL_NI_MAX);
+		if (idx >= LNET_SEL_NI_MAX)
+			return;
+	} while (test_and_set_bit(idx, the_lnet.ln_sel_ni_map));
+
+	ni->ni_sel_idx = idx;
+	lnet_ni_sel_gen_bump();
+}
+
+static void
+lnet_ni_sel_idx_put(struct lnet_ni *ni)
+{
+	if (ni->ni_sel_idx < 0)
+		return;
+
+	/* invalidate the masks which may still have this bit set before
+	 * the bit can be handed to another NI
+	 */
+	lnet_ni_sel_gen_bump();
+	smp_mb__before_atomic();
+	clear_bit(ni->ni_sel_idx, the_lnet.ln_sel_ni_map);
+	ni->ni_sel_idx = -1;
+}
+
 void
 lnet_ni_free(struct lnet_ni *ni)
 {
+	lnet_ni_sel_idx_put(ni);
+
 	lnet_net_remove_cpts(ni->ni_cpts, ni->ni_ncpts, ni->ni_net);
 
 	if (ni->ni_refs != NULL)
@@ -434,6 +472,7 @@ lnet_ni_alloc_common(struct lnet_net *net, char *iface)
 	spin_lock_init(&ni->ni_lock);
 	INIT_LIST_HEAD(&ni->ni_netlist);
 	INIT_LIST_HEAD(&ni->ni_recovery);
+	ni->ni_sel_idx = -1;
 	LNetInvalidateMDHandle(&ni->ni_ping_mdh);
 	ni->ni_refs = cfs_percpt_alloc(lnet_cpt_table(),
 				       sizeof(*ni->ni_refs[0]));
@@ -461,6 +500,7 @@ lnet_ni_alloc_common(struct lnet_net *net, char *iface)
 
 	ni->ni_state = LNET_NI_STATE_INIT;
 	ni->ni_sel_priority = LNET_MAX_SELECTION_PRIORITY;
+	lnet_ni_sel_idx_get(ni);
 	list_add_tail(&ni->ni_netlist, &net->net_ni_added);
 
 	/*
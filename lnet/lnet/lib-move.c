@@ -1325,8 +1325,8 @@ lnet_select_peer_ni(struct lnet_ni *best_ni, lnet_nid_t dst_nid,
 		 * preferred, then let's use it
 		 */
 		if (best_ni) {
-			lpni_is_preferred = lnet_peer_is_pref_nid_locked(
-				lpni, &best_ni->ni_nid);
+			lpni_is_preferred = lnet_peer_is_pref_ni_locked(
+				lpni, best_ni);
 			CDEBUG(D_NET, "%s lpni_is_preferred = %d\n",
 			       libcfs_nidstr(&best_ni->ni_nid),
 			       lpni_is_preferred);
@@ -2084,6 +2084,7 @@ lnet_initiate_peer_discovery(struct lnet_peer_ni *lpni, struct lnet_msg *msg,
 {
 	struct lnet_peer *peer;
 	struct lnet_peer_ni *new_lpni;
+	unsigned int warm;
 	int rc;
 
 	lnet_peer_ni_addref_locked(lpni);
@@ -2095,6 +2096,21 @@ lnet_initiate_peer_discovery(struct lnet_peer_ni *lpni, struct lnet_msg *msg,
 		return 0;
 	}
 
+	/* The NIDs of a peer restored from a peer snapshot are used as they
+	 * are. Discovery is only kicked off, and revalidates the peer in the
+	 * background.
+	 */
+	spin_lock(&peer->lp_lock);
+	warm = (peer->lp_state & (LNET_PEER_WARM | LNET_PEER_DISCOVERING));
+	spin_unlock(&peer->lp_lock);
+	if (warm & LNET_PEER_WARM) {
+		/* a discovery failure must not fail this message */
+		if (!(warm & LNET_PEER_DISCOVERING) && lnet_msg_discovery(msg))
+			lnet_discover_peer_locked(lpni, cpt, false);
+		lnet_peer_ni_decref_locked(lpni);
+		return 0;
+	}
+
 	if (!lnet_msg_discovery(msg) || lnet_peer_is_uptodate(peer)) {
 		lnet_peer_ni_decref_locked(lpni);
 		return 0;
@@ -2907,6 +2923,19 @@ lnet_handle_send_case_locked(struct lnet_send_data *sd)
 	}
 }
 
+/* Called with lnet_net_lock held on @cpt */
+static void
+lnet_select_account(ktime_t start, int cpt)
+{
+	struct lnet_select_stats *lss = the_lnet.ln_select_stats[cpt];
+	u64 ns = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	lss->lss_count++;
+	lss->lss_total_ns += ns;
+	if (ns > lss->lss_max_ns)
+		lss->lss_max_ns = ns;
+}
+
 static int
 lnet_select_pathway(struct lnet_nid *src_nid,
 		    struct lnet_nid *dst_nid,
@@ -2921,6 +2950,7 @@ lnet_select_pathway(struct lnet_nid *src_nid,
 	__u32 send_case = 0;
 	bool final_hop;
 	bool mr_forwarding_allowed;
+	ktime_t start = lnet_select_timing ? ktime_get() : 0;
 
 	memset(&send_data, 0, sizeof(send_data));
 
@@ -3097,6 +3127,9 @@ again:
 	if (rc == REPEAT_SEND)
 		goto again;
 
+	if (start)
+		lnet_select_account(start, cpt);
+
 	lnet_net_unlock(cpt);
 
 	return rc;
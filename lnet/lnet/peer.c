@@ -1108,6 +1108,73 @@ lnet_peer_is_pref_nid_locked(struct lnet_peer_ni *lpni, struct lnet_nid *nid)
 	return false;
 }
 
+/* Must be called with lnet_net_lock/EX held */
+static inline void
+lnet_peer_pref_ni_mask_invalidate(struct lnet_peer_ni *lpni)
+{
+	lpni->lpni_pref_gen = atomic_read(&the_lnet.ln_sel_gen) - 1;
+}
+
+/*
+ * Compile lpni_pref.nids into a mask of the ni_sel_idx of the local NIs
+ * it names. Callers may race on different CPTs, but they compute the
+ * same mask from a list which cannot change while they hold the net
+ * lock. The mask is published before the generation which validates it.
+ */
+static __u64
+lnet_peer_pref_ni_mask_compile(struct lnet_peer_ni *lpni, __u32 gen)
+{
+	struct lnet_nid_list *ne;
+	struct lnet_net *net;
+	struct lnet_ni *ni;
+	__u64 mask = 0;
+
+	list_for_each_entry(net, &the_lnet.ln_nets, net_list) {
+		list_for_each_entry(ni, &net->net_ni_list, ni_netlist) {
+			if (ni->ni_sel_idx < 0)
+				continue;
+			list_for_each_entry(ne, &lpni->lpni_pref.nids,
+					    nl_list) {
+				if (nid_same(&ne->nl_nid, &ni->ni_nid)) {
+					mask |= BIT_ULL(ni->ni_sel_idx);
+					break;
+				}
+			}
+		}
+	}
+
+	WRITE_ONCE(lpni->lpni_pref_ni_mask, mask);
+	smp_wmb();
+	WRITE_ONCE(lpni->lpni_pref_gen, gen);
+
+	return mask;
+}
+
+/*
+ * Same as lnet_peer_is_pref_nid_locked(), but for a local NI. A peer NI
+ * with many preferred NIDs is tested against its compiled mask rather
+ * than by walking the list for every message. Call with lnet_net_lock
+ * in shared mode.
+ */
+bool
+lnet_peer_is_pref_ni_locked(struct lnet_peer_ni *lpni, struct lnet_ni *ni)
+{
+	__u32 gen = atomic_read(&the_lnet.ln_sel_gen);
+	__u64 mask;
+
+	if (lpni->lpni_pref_nnids <= 1 || ni->ni_sel_idx < 0)
+		return lnet_peer_is_pref_nid_locked(lpni, &ni->ni_nid);
+
+	if (READ_ONCE(lpni->lpni_pref_gen) == gen) {
+		smp_rmb();
+		mask = READ_ONCE(lpni->lpni_pref_ni_mask);
+	} else {
+		mask = lnet_peer_pref_ni_mask_compile(lpni, gen);
+	}
+
+	return !!(mask & BIT_ULL(ni->ni_sel_idx));
+}
+
 /*
  * Set a single ni as preferred, provided no preferred ni is already
  * defined. Only to be used for non-multi-rail peer_ni.
@@ -1254,6 +1321,7 @@ lnet_peer_add_pref_nid(struct lnet_peer_ni *lpni, struct lnet_nid *nid)
 		list_add_tail(&ne1->nl_list, &lpni->lpni_pref.nids);
 	}
 	lpni->lpni_pref_nnids++;
+	lnet_peer_pref_ni_mask_invalidate(lpni);
 	lpni->lpni_state &= ~LNET_PEER_NI_NON_MR_PREF;
 	spin_unlock(&lpni->lpni_lock);
 	lnet_net_unlock(LNET_LOCK_EX);
@@ -1316,6 +1384,7 @@ remove_nid_entry:
 		}
 	}
 	lpni->lpni_pref_nnids--;
+	lnet_peer_pref_ni_mask_invalidate(lpni);
 	lpni->lpni_state &= ~LNET_PEER_NI_NON_MR_PREF;
 	spin_unlock(&lpni->lpni_lock);
 	lnet_net_unlock(LNET_LOCK_EX);
@@ -1343,6 +1412,7 @@ lnet_peer_clr_pref_nids(struct lnet_peer_ni *lpni)
 	else if (lpni->lpni_pref_nnids > 1)
 		list_splice_init(&lpni->lpni_pref.nids, &zombies);
 	lpni->lpni_pref_nnids = 0;
+	lnet_peer_pref_ni_mask_invalidate(lpni);
 	lnet_net_unlock(LNET_LOCK_EX);
 
 	list_for_each_entry_safe(ne, tmp, &zombies, nl_list) {
@@ -1973,6 +2043,63 @@ lnet_add_peer_ni(lnet_nid_t prim_nid, lnet_nid_t nid, bool mr, bool temp)
 	return lnet_peer_add_nid(lp, nid, flags);
 }
 
+/*
+ * Whether @nid4 belongs to a peer configured through DLC. A peer snapshot
+ * never changes those.
+ *
+ * The caller must hold ln_api_mutex.
+ */
+bool
+lnet_peer_nid_configured(lnet_nid_t nid4)
+{
+	struct lnet_peer_ni *lpni;
+	bool configured;
+
+	if (nid4 == LNET_NID_ANY)
+		return false;
+
+	lpni = lnet_find_peer_ni_locked(nid4);
+	if (!lpni)
+		return false;
+	configured = lpni->lpni_peer_net->lpn_peer->lp_state &
+		     LNET_PEER_CONFIGURED;
+	lnet_peer_ni_decref_locked(lpni);
+
+	return configured;
+}
+
+/*
+ * Mark a peer added from a peer snapshot with LNET_PEER_WARM, so that its
+ * NIDs are used right away while discovery revalidates them. Peers that
+ * were discovered or configured in the meantime are left alone.
+ *
+ * The caller must hold ln_api_mutex.
+ */
+int
+lnet_peer_set_warm(lnet_nid_t prim_nid)
+{
+	struct lnet_peer_ni *lpni;
+	struct lnet_peer *lp;
+
+	lpni = lnet_find_peer_ni_locked(prim_nid);
+	if (!lpni)
+		return -ENOENT;
+	lnet_peer_ni_decref_locked(lpni);
+	lp = lpni->lpni_peer_net->lpn_peer;
+
+	lnet_net_lock(LNET_LOCK_EX);
+	spin_lock(&lp->lp_lock);
+	if (!(lp->lp_state & (LNET_PEER_CONFIGURED | LNET_PEER_DISCOVERED |
+			      LNET_PEER_DISCOVERING | LNET_PEER_WARM))) {
+		lp->lp_state |= LNET_PEER_WARM;
+		the_lnet.ln_dc_stats.ds_warm_peers++;
+	}
+	spin_unlock(&lp->lp_lock);
+	lnet_net_unlock(LNET_LOCK_EX);
+
+	return 0;
+}
+
 /*
  * Implementation of IOC_LIBCFS_DEL_PEER_NI.
  *
@@ -2242,6 +2369,85 @@ lnet_peer_queue_message(struct lnet_peer *lp, struct lnet_msg *msg)
 	lnet_net_unlock(LNET_LOCK_EX);
 }
 
+/*
+ * PING_SENT and PUSH_SENT are only changed through these helpers, under
+ * lp_lock, so ln_dc_inflight counts the discovery pings and pushes that
+ * are awaiting an answer. It bounds how many the discovery thread starts.
+ */
+static void lnet_peer_set_sent(struct lnet_peer *lp, unsigned int flag)
+__must_hold(&lp->lp_lock)
+{
+	if (!(lp->lp_state & flag)) {
+		lp->lp_state |= flag;
+		atomic_inc(&the_lnet.ln_dc_inflight);
+	}
+}
+
+static void lnet_peer_clear_sent(struct lnet_peer *lp, unsigned int flag)
+__must_hold(&lp->lp_lock)
+{
+	if (lp->lp_state & flag) {
+		lp->lp_state &= ~flag;
+		atomic_dec(&the_lnet.ln_dc_inflight);
+		if (READ_ONCE(the_lnet.ln_dc_throttled))
+			wake_up(&the_lnet.ln_dc_waitq);
+	}
+}
+
+static bool lnet_peer_discovery_throttled(void)
+{
+	unsigned int max = READ_ONCE(lnet_max_discovery_inflight);
+
+	return max && atomic_read(&the_lnet.ln_dc_inflight) >= max;
+}
+
+/* Account the latency of a discovery. Call with lnet_net_lock/EX held. */
+static void lnet_peer_discovery_account(struct lnet_peer *lp, int dc_error)
+{
+	struct lnet_ioctl_discovery_stats *stats = &the_lnet.ln_dc_stats;
+	u64 latency;
+	u64 limit = USEC_PER_MSEC;
+	int i;
+
+	if (!ktime_to_ns(lp->lp_dc_start))
+		return;
+
+	latency = ktime_us_delta(ktime_get(), lp->lp_dc_start);
+	lp->lp_dc_start = ktime_set(0, 0);
+
+	stats->ds_completed++;
+	if (dc_error)
+		stats->ds_failed++;
+	stats->ds_latency_total_us += latency;
+	if (latency > stats->ds_latency_max_us)
+		stats->ds_latency_max_us = latency;
+	for (i = 0; i < LNET_DC_LATENCY_BUCKETS - 1; i++, limit *= 10) {
+		if (latency < limit)
+			break;
+	}
+	stats->ds_latency_hist[i]++;
+}
+
+void lnet_discovery_stats_get(struct lnet_ioctl_discovery_stats *stats)
+{
+	lnet_net_lock(LNET_LOCK_EX);
+	*stats = the_lnet.ln_dc_stats;
+	lnet_net_unlock(LNET_LOCK_EX);
+	stats->ds_inflight = atomic_read(&the_lnet.ln_dc_inflight);
+}
+
+void lnet_discovery_stats_reset(void)
+{
+	u32 warm;
+
+	lnet_net_lock(LNET_LOCK_EX);
+	/* the number of snapshot peers is not a rate, keep it */
+	warm = the_lnet.ln_dc_stats.ds_warm_peers;
+	memset(&the_lnet.ln_dc_stats, 0, sizeof(the_lnet.ln_dc_stats));
+	the_lnet.ln_dc_stats.ds_warm_peers = warm;
+	lnet_net_unlock(LNET_LOCK_EX);
+}
+
 /*
  * Queue a peer for the attention of the discovery thread.  Call with
  * lnet_net_lock/EX held. Returns 0 if the peer was queued, and
@@ -2257,6 +2463,8 @@ static int lnet_peer_queue_for_discovery(struct lnet_peer *lp)
 	spin_unlock(&lp->lp_lock);
 	if (list_empty(&lp->lp_dc_list)) {
 		lnet_peer_addref_locked(lp);
+		if (!ktime_to_ns(lp->lp_dc_start))
+			lp->lp_dc_start = ktime_get();
 		list_add_tail(&lp->lp_dc_list, &the_lnet.ln_dc_request);
 		wake_up(&the_lnet.ln_dc_waitq);
 		rc = 0;
@@ -2284,12 +2492,15 @@ static void lnet_peer_discovery_complete(struct lnet_peer *lp, int dc_error)
 	       libcfs_nidstr(&lp->lp_primary_nid));
 
 	list_del_init(&lp->lp_dc_list);
+	lnet_peer_discovery_account(lp, dc_error);
 	spin_lock(&lp->lp_lock);
 	if (dc_error) {
 		lp->lp_dc_error = dc_error;
 		lp->lp_state &= ~LNET_PEER_DISCOVERING;
 		lp->lp_state |= LNET_PEER_REDISCOVER;
 	}
+	/* the snapshot NIDs were either confirmed or replaced */
+	lp->lp_state &= ~LNET_PEER_WARM;
 	list_splice_init(&lp->lp_dc_pendq, &pending_msgs);
 	spin_unlock(&lp->lp_lock);
 	wake_up(&lp->lp_dc_waitq);
@@ -2646,7 +2857,7 @@ lnet_discovery_event_ack(struct lnet_peer *lp, struct lnet_event *ev)
 
 	pbuf = LNET_PING_INFO_TO_BUFFER(ev->md_start);
 	spin_lock(&lp->lp_lock);
-	lp->lp_state &= ~LNET_PEER_PUSH_SENT;
+	lnet_peer_clear_sent(lp, LNET_PEER_PUSH_SENT);
 	lp->lp_push_error = ev->status;
 	if (ev->status)
 		lp->lp_state |= LNET_PEER_PUSH_FAILED;
@@ -2825,7 +3036,7 @@ lnet_discovery_event_reply(struct lnet_peer *lp, struct lnet_event *ev)
 	lnet_ping_buffer_addref(pbuf);
 	lp->lp_data = pbuf;
 out:
-	lp->lp_state &= ~LNET_PEER_PING_SENT;
+	lnet_peer_clear_sent(lp, LNET_PEER_PING_SENT);
 	spin_unlock(&lp->lp_lock);
 
 	lnet_net_lock(LNET_LOCK_EX);
@@ -2854,11 +3065,11 @@ lnet_discovery_event_send(struct lnet_peer *lp, struct lnet_event *ev)
 
 	spin_lock(&lp->lp_lock);
 	if (ev->msg_type == LNET_MSG_GET) {
-		lp->lp_state &= ~LNET_PEER_PING_SENT;
+		lnet_peer_clear_sent(lp, LNET_PEER_PING_SENT);
 		lp->lp_state |= LNET_PEER_PING_FAILED;
 		lp->lp_ping_error = ev->status;
 	} else { /* ev->msg_type == LNET_MSG_PUT */
-		lp->lp_state &= ~LNET_PEER_PUSH_SENT;
+		lnet_peer_clear_sent(lp, LNET_PEER_PUSH_SENT);
 		lp->lp_state |= LNET_PEER_PUSH_FAILED;
 		lp->lp_push_error = ev->status;
 	}
@@ -2883,7 +3094,7 @@ lnet_discovery_event_unlink(struct lnet_peer *lp, struct lnet_event *ev)
 	spin_lock(&lp->lp_lock);
 	/* We've passed through LNetGet() */
 	if (lp->lp_state & LNET_PEER_PING_SENT) {
-		lp->lp_state &= ~LNET_PEER_PING_SENT;
+		lnet_peer_clear_sent(lp, LNET_PEER_PING_SENT);
 		lp->lp_state |= LNET_PEER_PING_FAILED;
 		lp->lp_ping_error = -ETIMEDOUT;
 		CDEBUG(D_NET, "Ping Unlink for message to peer %s\n",
@@ -2891,7 +3102,7 @@ lnet_discovery_event_unlink(struct lnet_peer *lp, struct lnet_event *ev)
 	}
 	/* We've passed through LNetPut() */
 	if (lp->lp_state & LNET_PEER_PUSH_SENT) {
-		lp->lp_state &= ~LNET_PEER_PUSH_SENT;
+		lnet_peer_clear_sent(lp, LNET_PEER_PUSH_SENT);
 		lp->lp_state |= LNET_PEER_PUSH_FAILED;
 		lp->lp_push_error = -ETIMEDOUT;
 		CDEBUG(D_NET, "Push Unlink for message to peer %s\n",
@@ -3477,7 +3688,7 @@ __must_hold(&lp->lp_lock)
 	int rc;
 	int cpt;
 
-	lp->lp_state |= LNET_PEER_PING_SENT;
+	lnet_peer_set_sent(lp, LNET_PEER_PING_SENT);
 	lp->lp_state &= ~LNET_PEER_FORCE_PING;
 	spin_unlock(&lp->lp_lock);
 
@@ -3521,7 +3732,8 @@ fail_error:
 	 * have set it if we called LNetMDUnlink() above.
 	 */
 	spin_lock(&lp->lp_lock);
-	lp->lp_state &= ~(LNET_PEER_PING_SENT | LNET_PEER_PING_FAILED);
+	lnet_peer_clear_sent(lp, LNET_PEER_PING_SENT);
+	lp->lp_state &= ~LNET_PEER_PING_FAILED;
 	return rc;
 }
 
@@ -3589,7 +3801,7 @@ __must_hold(&lp->lp_lock)
 		return 0;
 	}
 
-	lp->lp_state |= LNET_PEER_PUSH_SENT;
+	lnet_peer_set_sent(lp, LNET_PEER_PUSH_SENT);
 	lp->lp_state &= ~LNET_PEER_FORCE_PUSH;
 	spin_unlock(&lp->lp_lock);
 
@@ -3659,7 +3871,8 @@ fail_error:
 	 * called LNetMDUnlink() above.
 	 */
 	spin_lock(&lp->lp_lock);
-	lp->lp_state &= ~(LNET_PEER_PUSH_SENT | LNET_PEER_PUSH_FAILED);
+	lnet_peer_clear_sent(lp, LNET_PEER_PUSH_SENT);
+	lp->lp_state &= ~LNET_PEER_PUSH_FAILED;
 	return rc;
 }
 
@@ -3684,7 +3897,9 @@ static int lnet_peer_discovery_wait_for_work(void)
 		if (lnet_push_target_resize_needed() ||
 		    the_lnet.ln_push_target->pb_needs_post)
 			break;
-		if (!list_empty(&the_lnet.ln_dc_request))
+		if (!list_empty(&the_lnet.ln_dc_request) &&
+		    !(the_lnet.ln_dc_throttled &&
+		      lnet_peer_discovery_throttled()))
 			break;
 		if (!list_empty(&the_lnet.ln_msg_resend))
 			break;
@@ -3752,9 +3967,28 @@ static void lnet_resend_msgs(void)
 }
 
 /* The discovery thread. */
+/*
+ * Whether the next discovery step for a peer is to send a Ping or a Push.
+ * This mirrors the action selection in lnet_peer_discovery().
+ */
+static bool lnet_peer_discovery_needs_send(struct lnet_peer *lp)
+__must_hold(&lp->lp_lock)
+{
+	if (lp->lp_state & (LNET_PEER_MARK_DELETION | LNET_PEER_MARK_DELETED |
+			    LNET_PEER_DATA_PRESENT | LNET_PEER_PING_FAILED |
+			    LNET_PEER_PUSH_FAILED))
+		return false;
+	if (lp->lp_state & (LNET_PEER_FORCE_PING | LNET_PEER_FORCE_PUSH))
+		return true;
+	if (!(lp->lp_state & LNET_PEER_NIDS_UPTODATE))
+		return true;
+	return lnet_peer_needs_push(lp);
+}
+
 static int lnet_peer_discovery(void *arg)
 {
 	struct lnet_peer *lp;
+	LIST_HEAD(deferred);
 	int rc;
 
 	wait_for_completion(&the_lnet.ln_started);
@@ -3786,10 +4020,27 @@ static int lnet_peer_discovery(void *arg)
 		 * timestamp keeps track of when the peer was added,
 		 * so we can time out discovery requests that take too
 		 * long.
+		 *
+		 * At most lnet_max_discovery_inflight Pings and Pushes
+		 * are awaiting an answer at any time, so after a mass
+		 * restart the peers are discovered in batches instead
+		 * of all at once. Peers that need to send while at the
+		 * limit are put back at the head of the request queue,
+		 * peers at any other step are processed right away.
 		 */
 		while (!list_empty(&the_lnet.ln_dc_request)) {
 			lp = list_first_entry(&the_lnet.ln_dc_request,
 					      struct lnet_peer, lp_dc_list);
+			if (lnet_peer_discovery_throttled()) {
+				spin_lock(&lp->lp_lock);
+				if (lnet_peer_discovery_needs_send(lp)) {
+					spin_unlock(&lp->lp_lock);
+					list_move_tail(&lp->lp_dc_list,
+						       &deferred);
+					continue;
+				}
+				spin_unlock(&lp->lp_lock);
+			}
 			list_move(&lp->lp_dc_list, &the_lnet.ln_dc_working);
 			/*
 			 * set the time the peer was put on the dc_working
@@ -3862,6 +4113,12 @@ static int lnet_peer_discovery(void *arg)
 
 		}
 
+		the_lnet.ln_dc_throttled = !list_empty(&deferred);
+		if (the_lnet.ln_dc_throttled) {
+			the_lnet.ln_dc_stats.ds_throttled++;
+			list_splice_init(&deferred, &the_lnet.ln_dc_request);
+		}
+
 		lnet_net_unlock(LNET_LOCK_EX);
 	}
 
@@ -4098,6 +4355,7 @@ int lnet_get_peer_info(struct lnet_ioctl_peer_cfg *cfg, void __user *bulk)
 	cfg->prcfg_cfg_nid = lnet_nid_to_nid4(&lp->lp_primary_nid);
 	cfg->prcfg_count = lp->lp_nnis;
 	cfg->prcfg_size = size;
+	BUILD_BUG_ON(LNET_PEER_STATE_CONFIGURED != LNET_PEER_CONFIGURED);
 	cfg->prcfg_state = lp->lp_state;
 
 	/* Allocate helper buffers. */
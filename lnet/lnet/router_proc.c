@@ -91,6 +91,7 @@ static int proc_lnet_stats(struct ctl_table *table, int write,
 
 	if (write) {
 		lnet_counters_reset();
+		lnet_discovery_stats_reset();
 		return 0;
 	}
 
@@ -126,6 +127,35 @@ out_no_ctrs:
 	return rc;
 }
 
+static int proc_lnet_select_stats(struct ctl_table *table, int write,
+				  void __user *buffer, size_t *lenp,
+				  loff_t *ppos)
+{
+	struct lnet_select_stats lss;
+	size_t nob = *lenp;
+	loff_t pos = *ppos;
+	char tmpstr[128]; /* 4 u64 */
+	int len;
+
+	if (write) {
+		lnet_select_stats_reset();
+		return 0;
+	}
+
+	lnet_select_stats_get(&lss);
+
+	len = scnprintf(tmpstr, sizeof(tmpstr), "%llu %llu %llu %llu",
+			lss.lss_count, lss.lss_total_ns,
+			lss.lss_count ? div64_u64(lss.lss_total_ns,
+						  lss.lss_count) : 0,
+			lss.lss_max_ns);
+
+	if (pos >= len)
+		return 0;
+
+	return cfs_trace_copyout_string(buffer, nob, tmpstr + pos, "\n");
+}
+
 static int
 proc_lnet_routes(struct ctl_table *table, int write, void __user *buffer,
 		 size_t *lenp, loff_t *ppos)
@@ -851,6 +881,11 @@ static struct ctl_table lnet_table[] = {
 		.mode		= 0644,
 		.proc_handler	= &proc_lnet_stats,
 	},
+	{
+		.procname	= "select_stats",
+		.mode		= 0644,
+		.proc_handler	= &proc_lnet_select_stats,
+	},
 	{
 		.procname	= "routes",
 		.mode		= 0444,
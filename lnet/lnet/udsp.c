@@ -100,6 +100,11 @@ struct udsp_info {
 	enum lnet_udsp_action_type udi_type;
 	bool udi_local;
 	bool udi_revert;
+	/* local NIs matched by udi_action of a NID pair rule, as a mask of
+	 * ni_sel_idx bits. Valid while ln_sel_gen equals udi_ni_gen.
+	 */
+	__u64 udi_ni_mask;
+	__u32 udi_ni_gen;
 };
 
 typedef int (*udsp_apply_rule)(struct udsp_info *);
@@ -467,11 +472,56 @@ lnet_udsp_apply_rte_list_on_lpni(struct lnet_peer_ni *lpni,
 	return rc;
 }
 
+static inline bool
+lnet_udsp_match_ni(struct lnet_ni *ni, struct lnet_ud_nid_descr *ni_action)
+{
+	return cfs_match_nid_net(&ni->ni_nid,
+				 ni_action->ud_net_id.udn_net_type,
+				 &ni_action->ud_net_id.udn_net_num_range,
+				 &ni_action->ud_addr_range);
+}
+
+/*
+ * The local NIs a NID pair rule prefers do not depend on the peer NI the
+ * rule is applied to. Match them once per rule rather than once per
+ * peer NI.
+ */
+static void
+lnet_udsp_compile_ni_list(struct udsp_info *udi)
+{
+	struct lnet_ud_nid_descr *ni_action = udi->udi_action;
+	struct lnet_net *net;
+	struct lnet_ni *ni;
+
+	udi->udi_ni_gen = atomic_read(&the_lnet.ln_sel_gen);
+	udi->udi_ni_mask = 0;
+
+	list_for_each_entry(net, &the_lnet.ln_nets, net_list) {
+		if (LNET_NETTYP(net->net_id) != ni_action->ud_net_id.udn_net_type)
+			continue;
+		list_for_each_entry(ni, &net->net_ni_list, ni_netlist) {
+			if (ni->ni_sel_idx >= 0 &&
+			    lnet_udsp_match_ni(ni, ni_action))
+				udi->udi_ni_mask |= BIT_ULL(ni->ni_sel_idx);
+		}
+	}
+}
+
+static bool
+lnet_udsp_ni_list_has(struct udsp_info *udi, struct lnet_ni *ni)
+{
+	if (ni->ni_sel_idx >= 0 &&
+	    udi->udi_ni_gen == atomic_read(&the_lnet.ln_sel_gen))
+		return udi->udi_ni_mask & BIT_ULL(ni->ni_sel_idx);
+
+	return lnet_udsp_match_ni(ni, udi->udi_action);
+}
+
 static int
-lnet_udsp_apply_ni_list(struct lnet_peer_ni *lpni,
-			struct lnet_ud_nid_descr *ni_action,
-			bool revert)
+lnet_udsp_apply_ni_list(struct lnet_peer_ni *lpni, struct udsp_info *udi)
 {
+	struct lnet_ud_nid_descr *ni_action = udi->udi_action;
+	bool revert = udi->udi_revert;
 	int rc = 0;
 	struct lnet_ni *ni;
 	struct lnet_net *net;
@@ -481,11 +531,7 @@ lnet_udsp_apply_ni_list(struct lnet_peer_ni *lpni,
 		if (LNET_NETTYP(net->net_id) != ni_action->ud_net_id.udn_net_type)
 			continue;
 		list_for_each_entry(ni, &net->net_ni_list, ni_netlist) {
-			rc = cfs_match_nid_net(
-				&ni->ni_nid,
-				ni_action->ud_net_id.udn_net_type,
-				&ni_action->ud_net_id.udn_net_num_range,
-				&ni_action->ud_addr_range);
+			rc = lnet_udsp_ni_list_has(udi, ni);
 			if (!rc)
 				continue;
 			lnet_net_unlock(LNET_LOCK_EX);
@@ -546,8 +592,7 @@ lnet_udsp_apply_rule_on_lpni(struct udsp_info *udi)
 	}
 
 	if (type == EN_LNET_UDSP_ACTION_PREFERRED_LIST && local) {
-		rc = lnet_udsp_apply_ni_list(lpni, action,
-					     udi->udi_revert);
+		rc = lnet_udsp_apply_ni_list(lpni, udi);
 		if (rc)
 			return rc;
 	} else if (type == EN_LNET_UDSP_ACTION_PREFERRED_LIST &&
@@ -665,6 +710,7 @@ lnet_udsp_apply_single_policy(struct lnet_udsp *udsp, struct udsp_info *udi,
 		udi->udi_action = &udsp->udsp_src;
 		udi->udi_type = EN_LNET_UDSP_ACTION_PREFERRED_LIST;
 		udi->udi_local = true;
+		lnet_udsp_compile_ni_list(udi);
 
 		CDEBUG(D_NET, "applying udsp (%p) dst->src\n",
 			udsp);
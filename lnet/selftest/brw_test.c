@@ -361,6 +361,8 @@ brw_client_done_rpc(struct sfw_test_unit *tsu, struct srpc_client_rpc *rpc)
 		return;
 	}
 
+	sfw_lat_record(sn, rpc);
+
 	if (reqst->brw_rw == LST_BRW_WRITE)
 		return;
 
@@ -223,6 +223,9 @@ lstcon_rpc_trans_name(int transop)
         if (transop == LST_TRANS_STATQRY)
                 return "STATQRY";
 
+	if (transop == LST_TRANS_LATQRY)
+		return "LATQRY";
+
         return "Unknown";
 }
 
@@ -393,7 +396,12 @@ lstcon_rpc_get_reply(struct lstcon_rpc *crpc, struct srpc_msg **msgpp)
 
         *msgpp = &rpc->crpc_replymsg;
         if (!crpc->crp_unpacked) {
-                sfw_unpack_message(*msgpp);
+		if (rpc->crpc_service == SRPC_SERVICE_QUERY_STAT &&
+		    rpc->crpc_reqstmsg.msg_body.stat_reqst.str_type ==
+		    SRPC_STAT_LATENCY)
+			sfw_unpack_lat_reply(*msgpp);
+		else
+			sfw_unpack_message(*msgpp);
                 crpc->crp_unpacked = 1;
         }
 
@@ -676,7 +684,7 @@ lstcon_batrpc_prep(struct lstcon_node *nd, int transop, unsigned int feats,
 }
 
 int
-lstcon_statrpc_prep(struct lstcon_node *nd, unsigned int feats,
+lstcon_statrpc_prep(struct lstcon_node *nd, int transop, unsigned int feats,
 		    struct lstcon_rpc **crpc)
 {
 	struct srpc_stat_reqst *srq;
@@ -689,7 +697,8 @@ lstcon_statrpc_prep(struct lstcon_node *nd, unsigned int feats,
         srq = &(*crpc)->crp_rpc->crpc_reqstmsg.msg_body.stat_reqst;
 
         srq->str_sid  = console_session.ses_id;
-        srq->str_type = 0; /* XXX remove it */
+	srq->str_type = transop == LST_TRANS_LATQRY ? SRPC_STAT_LATENCY :
+						      SRPC_STAT_COUNTERS;
 
         return 0;
 }
@@ -803,6 +812,29 @@ lstcon_bulkrpc_v1_prep(struct lst_test_bulk_param *param, bool is_client,
 	return 0;
 }
 
+/* fixed RPC rate of a test, old tools pass parameters without it */
+static __u32
+lstcon_test_rate(struct lstcon_test *test)
+{
+	struct lst_test_bulk_param *bulk;
+	struct lst_test_ping_param *ping;
+
+	switch (test->tes_type) {
+	case LST_TEST_PING:
+		ping = (struct lst_test_ping_param *)&test->tes_param[0];
+		if (test->tes_paramlen >= offsetofend(typeof(*ping), png_rate))
+			return max(ping->png_rate, 0);
+		break;
+	case LST_TEST_BULK:
+		bulk = (struct lst_test_bulk_param *)&test->tes_param[0];
+		if (test->tes_paramlen >= offsetofend(typeof(*bulk), blk_rate))
+			return max(bulk->blk_rate, 0);
+		break;
+	}
+
+	return 0;
+}
+
 int
 lstcon_testrpc_prep(struct lstcon_node *nd, int transop, unsigned int feats,
 		    struct lstcon_test *test, struct lstcon_rpc **crpc)
@@ -883,6 +915,8 @@ lstcon_testrpc_prep(struct lstcon_node *nd, int transop, unsigned int feats,
         trq->tsr_concur     = test->tes_concur;
         trq->tsr_is_client  = (transop == LST_TRANS_TSBCLIADD) ? 1 : 0;
         trq->tsr_stop_onerr = !!test->tes_stop_onerr;
+	if (trq->tsr_is_client && (feats & LST_FEAT_LATENCY) != 0)
+		trq->tsr_rate = lstcon_test_rate(test);
 
         switch (test->tes_type) {
         case LST_TEST_PING:
@@ -967,6 +1001,7 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
 	struct srpc_batch_reply *bat_rep;
 	struct srpc_test_reply *test_rep;
 	struct srpc_stat_reply *stat_rep;
+	struct srpc_lat_reply *lat_rep;
 	int rc = 0;
 
 	switch (trans->tas_opc) {
@@ -1068,6 +1103,18 @@ lstcon_rpc_stat_reply(struct lstcon_rpc_trans *trans, struct srpc_msg *msg,
                 rc = stat_rep->str_status;
                 break;
 
+	case LST_TRANS_LATQRY:
+		lat_rep = &msg->msg_body.lat_reply;
+
+		if (lat_rep->lat_status == 0) {
+			lstcon_statqry_stat_success(stat, 1);
+			return;
+		}
+
+		lstcon_statqry_stat_failure(stat, 1);
+		rc = lat_rep->lat_status;
+		break;
+
         default:
                 LBUG();
         }
@@ -1137,7 +1184,8 @@ lstcon_rpc_trans_ndlist(struct list_head *ndlist,
 						&rpc);
 			break;
 		case LST_TRANS_STATQRY:
-			rc = lstcon_statrpc_prep(nd, feats, &rpc);
+		case LST_TRANS_LATQRY:
+			rc = lstcon_statrpc_prep(nd, transop, feats, &rpc);
                         break;
                 default:
                         rc = -EINVAL;
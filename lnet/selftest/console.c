@@ -1485,15 +1485,36 @@ lstcon_statrpc_readent(int transop, struct srpc_msg *msg,
 }
 
 static int
-lstcon_ndlist_stat(struct list_head *ndlist,
+lstcon_latrpc_readent(int transop, struct srpc_msg *msg,
+		      struct lstcon_rpc_ent __user *ent_up)
+{
+	struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+
+	if (rep->lat_status != 0)
+		return 0;
+
+	if (copy_to_user(&ent_up->rpe_payload[0], &rep->lat_counters,
+			 sizeof(rep->lat_counters)))
+		return -EFAULT;
+
+	return 0;
+}
+
+static int
+lstcon_ndlist_stat(struct list_head *ndlist, bool lat,
 		   int timeout, struct list_head __user *result_up)
 {
 	LIST_HEAD(head);
 	struct lstcon_rpc_trans *trans;
 	int rc;
 
-        rc = lstcon_rpc_trans_ndlist(ndlist, &head,
-                                     LST_TRANS_STATQRY, NULL, NULL, &trans);
+	/* all nodes of the session share its features */
+	if (lat && (console_session.ses_features & LST_FEAT_LATENCY) == 0)
+		return -EOPNOTSUPP;
+
+	rc = lstcon_rpc_trans_ndlist(ndlist, &head,
+				     lat ? LST_TRANS_LATQRY : LST_TRANS_STATQRY,
+				     NULL, NULL, &trans);
         if (rc != 0) {
                 CERROR("Can't create transaction: %d\n", rc);
                 return rc;
@@ -1501,15 +1522,16 @@ lstcon_ndlist_stat(struct list_head *ndlist,
 
         lstcon_rpc_trans_postwait(trans, LST_VALIDATE_TIMEOUT(timeout));
 
-        rc = lstcon_rpc_trans_interpreter(trans, result_up,
-                                          lstcon_statrpc_readent);
+	rc = lstcon_rpc_trans_interpreter(trans, result_up,
+					  lat ? lstcon_latrpc_readent :
+						lstcon_statrpc_readent);
         lstcon_rpc_trans_destroy(trans);
 
         return rc;
 }
 
 int
-lstcon_group_stat(char *grp_name, int timeout,
+lstcon_group_stat(char *grp_name, bool lat, int timeout,
 		  struct list_head __user *result_up)
 {
 	struct lstcon_group *grp;
@@ -1521,7 +1543,7 @@ lstcon_group_stat(char *grp_name, int timeout,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&grp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&grp->grp_ndl_list, lat, timeout, result_up);
 
 	lstcon_group_decref(grp);
 
@@ -1529,7 +1551,7 @@ lstcon_group_stat(char *grp_name, int timeout,
 }
 
 int
-lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
+lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up, bool lat,
 		  int timeout, struct list_head __user *result_up)
 {
 	struct lstcon_ndlink *ndl;
@@ -1565,7 +1587,7 @@ lstcon_nodes_stat(int count, struct lnet_process_id __user *ids_up,
                 return rc;
         }
 
-        rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, timeout, result_up);
+	rc = lstcon_ndlist_stat(&tmp->grp_ndl_list, lat, timeout, result_up);
 
 	lstcon_group_decref(tmp);
 
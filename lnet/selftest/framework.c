@@ -407,6 +407,51 @@ sfw_get_stats(struct srpc_stat_reqst *request, struct srpc_stat_reply *reply)
 	return 0;
 }
 
+static int
+sfw_get_lat_stats(struct srpc_stat_reqst *request,
+		  struct srpc_lat_reply *reply)
+{
+	struct sfw_session *sn = sfw_data.fw_session;
+	int i;
+
+	reply->lat_sid = (sn == NULL) ? LST_INVALID_SID : sn->sn_id;
+
+	if (request->str_sid.ses_nid == LNET_NID_ANY) {
+		reply->lat_status = EINVAL;
+		return 0;
+	}
+
+	if (sn == NULL || !sfw_sid_equal(request->str_sid, sn->sn_id)) {
+		reply->lat_status = ESRCH;
+		return 0;
+	}
+
+	if ((sn->sn_features & LST_FEAT_LATENCY) == 0) {
+		reply->lat_status = EPROTO;
+		return 0;
+	}
+
+	for (i = 0; i < LST_LAT_BUCKETS; i++)
+		reply->lat_counters.lat_hist[i] =
+			atomic_read(&sn->sn_lat_hist[i]);
+
+	reply->lat_status = 0;
+	return 0;
+}
+
+/* account the round-trip time of a completed test RPC */
+void
+sfw_lat_record(struct sfw_session *sn, struct srpc_client_rpc *rpc)
+{
+	s64 usec = ktime_us_delta(ktime_get(), rpc->crpc_start);
+	int idx = 0;
+
+	if (usec > 1)
+		idx = min_t(int, fls64(usec) - 1, LST_LAT_BUCKETS - 1);
+
+	atomic_inc(&sn->sn_lat_hist[idx]);
+}
+
 int
 sfw_make_session(struct srpc_mksn_reqst *request, struct srpc_mksn_reply *reply)
 {
@@ -633,6 +678,7 @@ sfw_destroy_test_instance(struct sfw_test_instance *tsi)
 		tsu = list_entry(tsi->tsi_units.next,
 				 struct sfw_test_unit, tsu_list);
 		list_del(&tsu->tsu_list);
+		cancel_delayed_work_sync(&tsu->tsu_delay);
 		LIBCFS_FREE(tsu, sizeof(*tsu));
 	}
 
@@ -729,6 +775,15 @@ sfw_unpack_addtest_req(struct srpc_msg *msg)
 	LBUG();
 }
 
+static void
+sfw_test_unit_delayed(struct work_struct *work)
+{
+	struct sfw_test_unit *tsu = container_of(work, struct sfw_test_unit,
+						 tsu_delay.work);
+
+	swi_schedule_workitem(&tsu->tsu_worker);
+}
+
 static int
 sfw_add_test_instance(struct sfw_batch *tsb, struct srpc_server_rpc *rpc)
 {
@@ -808,10 +863,19 @@ sfw_add_test_instance(struct sfw_batch *tsb, struct srpc_server_rpc *rpc)
 			tsu->tsu_dest.pid = id.pid;
 			tsu->tsu_instance = tsi;
 			tsu->tsu_private  = NULL;
+			INIT_DELAYED_WORK(&tsu->tsu_delay,
+					  sfw_test_unit_delayed);
 			list_add_tail(&tsu->tsu_list, &tsi->tsi_units);
 		}
 	}
 
+	/* fixed rate: spread the requested RPC rate over all test units,
+	 * each unit sends one RPC per interval as long as it has no RPC
+	 * outstanding, so concurrency bounds the number of RPCs in flight */
+	if ((msg->msg_ses_feats & LST_FEAT_LATENCY) != 0 && req->tsr_rate > 0)
+		tsi->tsi_interval_ns = div_u64((u64)ndest * tsi->tsi_concur *
+					       NSEC_PER_SEC, req->tsr_rate);
+
 	rc = tsi->tsi_ops->tso_init(tsi);
 	if (rc == 0) {
 		list_add_tail(&tsi->tsi_list, &tsb->bat_tests);
@@ -953,6 +1017,16 @@ sfw_run_test(struct swi_workitem *wi)
 
         LASSERT (wi == &tsu->tsu_worker);
 
+	/* fixed rate: wait until the next RPC of this unit is due */
+	if (tsi->tsi_interval_ns != 0 && !tsi->tsi_stopping &&
+	    ktime_before(ktime_get(), tsu->tsu_next)) {
+		schedule_delayed_work(&tsu->tsu_delay,
+			nsecs_to_jiffies(ktime_to_ns(ktime_sub(tsu->tsu_next,
+							       ktime_get()))) +
+			1);
+		return 0;
+	}
+
         if (tsi->tsi_ops->tso_prep_rpc(tsu, tsu->tsu_dest, &rpc) != 0) {
                 LASSERT (rpc == NULL);
                 goto test_done;
@@ -974,6 +1048,16 @@ sfw_run_test(struct swi_workitem *wi)
 	list_add_tail(&rpc->crpc_list, &tsi->tsi_active_rpcs);
 	spin_unlock(&tsi->tsi_lock);
 
+	/* with fixed rate, latency counts from when the RPC was due so
+	 * that time spent waiting for a slow RPC is not hidden */
+	if (tsi->tsi_interval_ns != 0) {
+		rpc->crpc_start = tsu->tsu_next;
+		tsu->tsu_next = ktime_add_ns(tsu->tsu_next,
+					     tsi->tsi_interval_ns);
+	} else {
+		rpc->crpc_start = ktime_get();
+	}
+
 	spin_lock(&rpc->crpc_lock);
 	rpc->crpc_timeout = rpc_timeout;
 	srpc_post_rpc(rpc);
@@ -999,6 +1083,10 @@ sfw_run_batch(struct sfw_batch *tsb)
 	struct swi_workitem *wi;
 	struct sfw_test_unit *tsu;
 	struct sfw_test_instance *tsi;
+	ktime_t now = ktime_get();
+	u64 step;
+	int nunits;
+	int i;
 
         if (sfw_batch_active(tsb)) {
 		CDEBUG(D_NET, "Batch already active: %llu (%d)\n",
@@ -1015,9 +1103,17 @@ sfw_run_batch(struct sfw_batch *tsb)
 
 		atomic_inc(&tsb->bat_nactive);
 
+		/* stagger the units evenly over one send interval */
+		nunits = 0;
+		list_for_each_entry(tsu, &tsi->tsi_units, tsu_list)
+			nunits++;
+		step = nunits > 0 ? div_u64(tsi->tsi_interval_ns, nunits) : 0;
+
+		i = 0;
 		list_for_each_entry(tsu, &tsi->tsi_units, tsu_list) {
 			atomic_inc(&tsi->tsi_nactive);
 			tsu->tsu_loop = tsi->tsi_loop;
+			tsu->tsu_next = ktime_add_ns(now, step * i++);
 			wi = &tsu->tsu_worker;
 			swi_init_workitem(wi, sfw_run_test,
 					  lst_sched_test[lnet_cpt_of_nid(tsu->tsu_dest.nid, NULL)]);
@@ -1299,8 +1395,12 @@ sfw_handle_server_rpc(struct srpc_server_rpc *rpc)
                 break;
 
         case SRPC_SERVICE_QUERY_STAT:
-                rc = sfw_get_stats(&request->msg_body.stat_reqst,
-                                   &reply->msg_body.stat_reply);
+		if (request->msg_body.stat_reqst.str_type == SRPC_STAT_LATENCY)
+			rc = sfw_get_lat_stats(&request->msg_body.stat_reqst,
+					       &reply->msg_body.lat_reply);
+		else
+			rc = sfw_get_stats(&request->msg_body.stat_reqst,
+					   &reply->msg_body.stat_reply);
                 break;
 
         case SRPC_SERVICE_DEBUG:
@@ -1529,6 +1629,7 @@ sfw_unpack_message(struct srpc_msg *msg)
                 __swab32s(&req->tsr_ndest);
                 __swab32s(&req->tsr_concur);
                 __swab32s(&req->tsr_service);
+		__swab32s(&req->tsr_rate);
                 sfw_unpack_sid(req->tsr_sid);
                 __swab64s(&req->tsr_bid.bat_id);
                 return;
@@ -1562,6 +1663,25 @@ sfw_unpack_message(struct srpc_msg *msg)
         LBUG ();
 }
 
+/*
+ * Replies to SRPC_STAT_LATENCY share SRPC_MSG_STAT_REPLY with counters
+ * replies, so the console has to unpack them itself.
+ */
+void
+sfw_unpack_lat_reply(struct srpc_msg *msg)
+{
+	struct srpc_lat_reply *rep = &msg->msg_body.lat_reply;
+	int i;
+
+	if (msg->msg_magic == SRPC_MSG_MAGIC)
+		return;
+
+	__swab32s(&rep->lat_status);
+	sfw_unpack_sid(rep->lat_sid);
+	for (i = 0; i < LST_LAT_BUCKETS; i++)
+		__swab32s(&rep->lat_counters.lat_hist[i]);
+}
+
 void
 sfw_abort_rpc(struct srpc_client_rpc *rpc)
 {
@@ -156,6 +156,8 @@ ping_client_done_rpc(struct sfw_test_unit *tsu, struct srpc_client_rpc *rpc)
                 return;
         }
 
+	sfw_lat_record(sn, rpc);
+
 	ktime_get_real_ts64(&ts);
 	CDEBUG(D_NET, "%d reply in %llu nsec\n", reply->pnr_seq,
 	       (u64)((ts.tv_sec - reqst->pnr_time_sec) * NSEC_PER_SEC +
@@ -149,6 +149,9 @@ struct srpc_batch_reply {
         __u32                   bar_time;       /* remained time */
 } __packed;
 
+#define SRPC_STAT_COUNTERS	0	/* struct srpc_stat_reply */
+#define SRPC_STAT_LATENCY	1	/* struct srpc_lat_reply */
+
 struct srpc_stat_reqst {
         __u64                   str_rpyid;      /* reply buffer matchbits */
 	struct lst_sid		str_sid;	/* session id */
@@ -163,6 +166,13 @@ struct srpc_stat_reply {
 	struct lnet_counters_common str_lnet;
 } __packed;
 
+/* reply of SRPC_STAT_LATENCY, must not be larger than srpc_stat_reply */
+struct srpc_lat_reply {
+	__u32			lat_status;
+	struct lst_sid		lat_sid;
+	struct sfw_lat_counters	lat_counters;
+} __packed;
+
 struct test_bulk_req {
         __u32                   blk_opc;        /* bulk operation code */
         __u32                   blk_npg;        /* # of pages */
@@ -203,6 +213,8 @@ struct srpc_test_reqst {
 		struct test_bulk_req	bulk_v0;
 		struct test_bulk_req_v1	bulk_v1;
 	} tsr_u;
+	/* RPCs/sec of test client, 0 for closed loop (LST_FEAT_LATENCY) */
+	__u32			tsr_rate;
 } __packed;
 
 struct srpc_test_reply {
@@ -265,6 +277,7 @@ struct srpc_msg {
 		struct srpc_batch_reply		bat_reply;
 		struct srpc_stat_reqst		stat_reqst;
 		struct srpc_stat_reply		stat_reply;
+		struct srpc_lat_reply		lat_reply;
 		struct srpc_test_reqst		tes_reqst;
 		struct srpc_test_reply		tes_reply;
 		struct srpc_join_reqst		join_reqst;
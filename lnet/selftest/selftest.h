@@ -215,6 +215,8 @@ struct srpc_client_rpc {
         /* state flags */
         unsigned int         crpc_aborted:1; /* being given up */
         unsigned int         crpc_closed:1;  /* completed */
+	/* when the RPC was (meant to be) sent, for latency stats */
+	ktime_t			crpc_start;
 
 	/* RPC events */
 	struct srpc_event	crpc_bulkev;	/* bulk event */
@@ -333,6 +335,8 @@ struct sfw_session {
 	atomic_t		sn_brw_errors;
 	atomic_t		sn_ping_errors;
 	ktime_t			sn_started;
+	/* latency histogram of test RPCs sent by this node */
+	atomic_t		sn_lat_hist[LST_LAT_BUCKETS];
 };
 
 #define sfw_sid_equal(sid0, sid1)     ((sid0).ses_nid == (sid1).ses_nid && \
@@ -368,6 +372,8 @@ struct sfw_test_instance {
 	unsigned int		tsi_stoptsu_onerr:1; /* stop tsu on error */
         int                     tsi_concur;          /* concurrency */
         int                     tsi_loop;            /* loop count */
+	/* send interval of each test unit, 0 for closed loop */
+	u64			tsi_interval_ns;
 
 	/* status of test instance */
 	spinlock_t		tsi_lock;	/* serialize */
@@ -398,6 +404,9 @@ struct sfw_test_unit {
 	struct sfw_test_instance *tsu_instance;	/* pointer to test instance */
 	void			*tsu_private;	/* private data */
 	struct swi_workitem	 tsu_worker;	/* workitem of the test unit */
+	/* fixed rate: time the next RPC is due and work to wait for it */
+	ktime_t			 tsu_next;
+	struct delayed_work	 tsu_delay;
 };
 
 struct sfw_test_case {
@@ -416,7 +425,9 @@ int sfw_create_test_rpc(struct sfw_test_unit *tsu,
 void sfw_abort_rpc(struct srpc_client_rpc *rpc);
 void sfw_post_rpc(struct srpc_client_rpc *rpc);
 void sfw_client_rpc_done(struct srpc_client_rpc *rpc);
+void sfw_lat_record(struct sfw_session *sn, struct srpc_client_rpc *rpc);
 void sfw_unpack_message(struct srpc_msg *msg);
+void sfw_unpack_lat_reply(struct srpc_msg *msg);
 void sfw_free_pages(struct srpc_server_rpc *rpc);
 void sfw_add_bulk_page(struct srpc_bulk *bk, struct page *pg, int i);
 int sfw_alloc_pages(struct srpc_server_rpc *rpc, int cpt, int npages, int len,
@@ -630,7 +630,7 @@ int lustre_lnet_discover_nid(char *ping_nids, int force, int seq_no,
 }
 
 static int lustre_lnet_handle_peer_nidlist(lnet_nid_t *nidlist, int num_nids,
-					   bool is_mr, __u32 cmd,
+					   bool is_mr, bool warm, __u32 cmd,
 					   char *cmd_type, char *err_str)
 {
 	struct lnet_ioctl_peer_cfg data;
@@ -645,6 +645,8 @@ static int lustre_lnet_handle_peer_nidlist(lnet_nid_t *nidlist, int num_nids,
 		data.prcfg_mr = is_mr;
 		data.prcfg_prim_nid = nidlist[0];
 		data.prcfg_cfg_nid = LNET_NID_ANY;
+		if (warm)
+			data.prcfg_state = LNET_PEER_CFG_WARM;
 
 		rc = dispatch_peer_ni_cmd(cmd, &data, err_str, cmd_type);
 
@@ -660,6 +662,8 @@ static int lustre_lnet_handle_peer_nidlist(lnet_nid_t *nidlist, int num_nids,
 		data.prcfg_mr = is_mr;
 		data.prcfg_prim_nid = nidlist[0];
 		data.prcfg_cfg_nid = nidlist[nid_idx];
+		if (warm)
+			data.prcfg_state = LNET_PEER_CFG_WARM;
 
 		rc = dispatch_peer_ni_cmd(cmd, &data, err_str, cmd_type);
 
@@ -706,7 +710,7 @@ lustre_lnet_mod_peer_nidlist(lnet_nid_t pnid, lnet_nid_t *lnet_nidlist,
 						(num_nids - 1));
 
 	rc = lustre_lnet_handle_peer_nidlist(lnet_nidlist2,
-					     num_nids, is_mr, ioc_cmd,
+					     num_nids, is_mr, false, ioc_cmd,
 					     cmd_str, err_str);
 out:
 	if (lnet_nidlist2)
@@ -2952,9 +2956,9 @@ out:
 	return rc;
 }
 
-int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
-			  struct cYAML **show_rc, struct cYAML **err_rc,
-			  bool backup)
+static int show_peer(char *knid, int detail, int seq_no,
+		     struct cYAML **show_rc, struct cYAML **err_rc,
+		     bool backup, bool skip_configured)
 {
 	/*
 	 * TODO: This function is changing in a future patch to accommodate
@@ -3074,6 +3078,11 @@ int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
 		}
 		exist = true;
 
+		/* restored by the configuration, not by a peer snapshot */
+		if (skip_configured &&
+		    (peer_info.prcfg_state & LNET_PEER_STATE_CONFIGURED))
+			continue;
+
 		peer = cYAML_create_seq_item(peer_root);
 		if (peer == NULL)
 			goto out;
@@ -3305,6 +3314,18 @@ out:
 	return rc;
 }
 
+int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
+			  struct cYAML **show_rc, struct cYAML **err_rc,
+			  bool backup)
+{
+	return show_peer(knid, detail, seq_no, show_rc, err_rc, backup, false);
+}
+
+int lustre_lnet_save_peers(struct cYAML **show_rc, struct cYAML **err_rc)
+{
+	return show_peer(NULL, 0, -1, show_rc, err_rc, true, true);
+}
+
 int lustre_lnet_list_peer(int seq_no,
 			  struct cYAML **show_rc, struct cYAML **err_rc)
 {
@@ -4106,6 +4127,58 @@ int lustre_lnet_show_numa_range(int seq_no, struct cYAML **show_rc,
 					"numa_range", show_rc, err_rc);
 }
 
+static int
+lustre_lnet_show_discovery_stats(struct cYAML *stats,
+				 struct lnet_ioctl_discovery_stats *ds)
+{
+	static const char * const buckets[LNET_DC_LATENCY_BUCKETS] = {
+		"under_1ms", "under_10ms", "under_100ms", "under_1s",
+		"under_10s", "over_10s" };
+	struct cYAML *discovery, *hist;
+	int i;
+
+	discovery = cYAML_create_object(stats, "discovery");
+	if (!discovery)
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "completed", ds->ds_completed))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "failed", ds->ds_failed))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "inflight", ds->ds_inflight))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "throttled", ds->ds_throttled))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "warm_peers", ds->ds_warm_peers))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "latency_avg_us",
+				 ds->ds_completed ?
+				 ds->ds_latency_total_us / ds->ds_completed :
+				 0))
+		return -ENOMEM;
+
+	if (!cYAML_create_number(discovery, "latency_max_us",
+				 ds->ds_latency_max_us))
+		return -ENOMEM;
+
+	hist = cYAML_create_object(discovery, "latency");
+	if (!hist)
+		return -ENOMEM;
+
+	for (i = 0; i < LNET_DC_LATENCY_BUCKETS; i++) {
+		if (!cYAML_create_number(hist, (char *)buckets[i],
+					 ds->ds_latency_hist[i]))
+			return -ENOMEM;
+	}
+
+	return 0;
+}
+
 int lustre_lnet_show_stats(int seq_no, struct cYAML **show_rc,
 			   struct cYAML **err_rc)
 {
@@ -4237,6 +4310,9 @@ int lustre_lnet_show_stats(int seq_no, struct cYAML **show_rc,
 				 cntrs->lct_common.lcc_drop_length))
 		goto out;
 
+	if (lustre_lnet_show_discovery_stats(stats, &data.st_discovery))
+		goto out;
+
 	if (!show_rc)
 		cYAML_print_tree(root);
 
@@ -4859,6 +4935,69 @@ static int handle_yaml_del_peer(struct cYAML *tree, struct cYAML **show_rc,
 	return handle_yaml_peer_common(tree, show_rc, err_rc, LNETCTL_DEL_CMD);
 }
 
+/*
+ * Restore a peer from a peer snapshot. Only Multi-Rail peers with more
+ * than one NID are worth restoring, and peers that are already known are
+ * left alone.
+ */
+static int handle_yaml_warm_peer(struct cYAML *tree, struct cYAML **show_rc,
+				 struct cYAML **err_rc)
+{
+	char err_str[LNET_MAX_STR_LEN] = "\"success\"";
+	lnet_nid_t nidlist[LNET_MAX_NIDS_PER_PEER + 1];
+	struct cYAML *prim_nid, *mr, *peer_nis;
+	char *nidstr = NULL;
+	int num_nids, rc;
+
+	prim_nid = cYAML_get_object_item(tree, "primary nid");
+	peer_nis = cYAML_get_object_item(tree, "peer ni");
+	mr = cYAML_get_object_item(tree, "Multi-Rail");
+	if (!prim_nid || !prim_nid->cy_valuestring ||
+	    !mr || !mr->cy_valuestring || strcmp(mr->cy_valuestring, "True"))
+		return LUSTRE_CFG_RC_NO_ERR;
+
+	nidlist[0] = libcfs_str2nid(prim_nid->cy_valuestring);
+	if (nidlist[0] == LNET_NID_ANY) {
+		rc = LUSTRE_CFG_RC_BAD_PARAM;
+		snprintf(err_str, LNET_MAX_STR_LEN,
+			 "badly formatted primary NID: %s",
+			 prim_nid->cy_valuestring);
+		goto out;
+	}
+
+	rc = yaml_nids2nidstr(peer_nis, &nidstr, prim_nid->cy_valuestring,
+			      LNETCTL_ADD_CMD);
+	if (rc != LUSTRE_CFG_RC_NO_ERR) {
+		snprintf(err_str, LNET_MAX_STR_LEN, "out of memory");
+		goto out;
+	}
+	/* only the primary NID, nothing to gain */
+	if (!nidstr)
+		return LUSTRE_CFG_RC_NO_ERR;
+
+	num_nids = lustre_lnet_parse_nidstr(nidstr, &nidlist[1],
+					    LNET_MAX_NIDS_PER_PEER, err_str);
+	free(nidstr);
+	if (num_nids < 0) {
+		rc = num_nids;
+		goto out;
+	}
+
+	rc = lustre_lnet_handle_peer_nidlist(nidlist, num_nids + 1, true,
+					     true, IOC_LIBCFS_ADD_PEER_NI,
+					     ADD_CMD, err_str);
+	/* the peer was discovered or configured since the snapshot, older
+	 * modules return -EPERM for a peer configured by lnet.conf
+	 */
+	if (rc == -EEXIST || rc == -EPERM)
+		rc = LUSTRE_CFG_RC_NO_ERR;
+out:
+	if (rc != LUSTRE_CFG_RC_NO_ERR)
+		cYAML_build_error(rc, -1, "peer", "load", err_str, err_rc);
+
+	return rc;
+}
+
 static int handle_yaml_config_buffers(struct cYAML *tree,
 				      struct cYAML **show_rc,
 				      struct cYAML **err_rc)
@@ -5382,6 +5521,10 @@ static struct lookup_cmd_hdlr_tbl lookup_del_tbl[] = {
 	{ .name = "udsp",	.cb = handle_yaml_del_udsp },
 	{ .name = NULL } };
 
+static struct lookup_cmd_hdlr_tbl lookup_warm_tbl[] = {
+	{ .name = "peer",	.cb = handle_yaml_warm_peer },
+	{ .name = NULL } };
+
 static struct lookup_cmd_hdlr_tbl lookup_show_tbl[] = {
 	{ .name = "route",	.cb = handle_yaml_show_route },
 	{ .name = "net",	.cb = handle_yaml_show_net },
@@ -5478,6 +5621,12 @@ int lustre_yaml_config(char *f, struct cYAML **err_rc)
 				     NULL, err_rc);
 }
 
+int lustre_yaml_load_peers(char *f, struct cYAML **err_rc)
+{
+	return lustre_yaml_cb_helper(f, lookup_warm_tbl,
+				     NULL, err_rc);
+}
+
 int lustre_yaml_del(char *f, struct cYAML **err_rc)
 {
 	return lustre_yaml_cb_helper(f, lookup_del_tbl,
@@ -702,6 +702,17 @@ int lustre_lnet_show_peer(char *knid, int detail, int seq_no,
 			  struct cYAML **show_rc, struct cYAML **err_rc,
 			  bool backup);
 
+/*
+ * lustre_lnet_save_peers
+ *   Build a peer snapshot for "lnetctl peer save". It has the same format
+ *   as lustre_lnet_show_peer() with backup set, but leaves out the peers
+ *   configured through DLC, which the configuration itself restores.
+ *
+ *     show_rc - YAML structure of the resultant show
+ *     err_rc - YAML structure of the resultant return code.
+ */
+int lustre_lnet_save_peers(struct cYAML **show_rc, struct cYAML **err_rc);
+
 /*
  * lustre_lnet_list_peer
  *   List the known peers.
@@ -751,6 +762,17 @@ int lustre_lnet_discover_nid(char *pnid, int force, int seq_no,
  */
 int lustre_yaml_config(char *f, struct cYAML **err_rc);
 
+/*
+ * lustre_yaml_load_peers
+ *   Parses a peer snapshot written by "lnetctl peer save" and adds the
+ *   Multi-Rail peers it describes, so they can be used before discovery
+ *   has revalidated them. Peers already known are left untouched.
+ *
+ *   f - YAML file
+ *   err_rc - [OUT] struct cYAML tree describing the error. Freed by caller
+ */
+int lustre_yaml_load_peers(char *f, struct cYAML **err_rc);
+
 /*
  * lustre_yaml_del
  *   Parses the provided YAML file and then calls the specific APIs
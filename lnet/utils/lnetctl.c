@@ -23,6 +23,7 @@
  * Author:
  *   Amir Shehata <amir.shehata@intel.com>
  */
+#include <errno.h>
 #include <getopt.h>
 #include <stdio.h>
 #include <stdlib.h>
@@ -68,6 +69,8 @@ static int jt_set_max_intf(int argc, char **argv);
 static int jt_set_discovery(int argc, char **argv);
 static int jt_set_drop_asym_route(int argc, char **argv);
 static int jt_list_peer(int argc, char **argv);
+static int jt_save_peers(int argc, char **argv);
+static int jt_load_peers(int argc, char **argv);
 static int jt_add_udsp(int argc, char **argv);
 static int jt_del_udsp(int argc, char **argv);
 /*static int jt_show_peer(int argc, char **argv);*/
@@ -273,6 +276,11 @@ command_t peer_cmds[] = {
 	 "\t--verbose: display detailed output per peer."
 		       " Optional argument of '2' outputs more stats\n"},
 	{"list", jt_list_peer, 0, "list all peers\n"},
+	{"save", jt_save_peers, 0, "save a snapshot of the peer table\n"
+	 "\tFILE: file to write the snapshot to\n"},
+	{"load", jt_load_peers, 0, "add the Multi-Rail peers of a snapshot,\n"
+	 "\tto be revalidated by discovery on first use\n"
+	 "\tFILE: snapshot written by \"peer save\"\n"},
 	{"set", jt_set_peer_ni_value, 0, "set peer ni specific parameter\n"
 	 "\t--nid: Peer NI NID to set the\n"
 	 "\t--health: specify health value to set\n"
@@ -2275,6 +2283,60 @@ static int jt_list_peer(int argc, char **argv)
 	return rc;
 }
 
+static int jt_save_peers(int argc, char **argv)
+{
+	struct cYAML *err_rc = NULL, *show_rc = NULL;
+	FILE *f;
+	int rc;
+
+	rc = check_cmd(peer_cmds, "peer", "save", 2, argc, argv);
+	if (rc)
+		return rc;
+
+	rc = lustre_lnet_save_peers(&show_rc, &err_rc);
+	if (rc != LUSTRE_CFG_RC_NO_ERR) {
+		cYAML_print_tree2file(stderr, err_rc);
+		goto out;
+	}
+
+	f = fopen(argv[1], "w");
+	if (!f) {
+		rc = -errno;
+		fprintf(stderr, "cannot open %s: %s\n", argv[1],
+			strerror(errno));
+		goto out;
+	}
+	cYAML_print_tree2file(f, show_rc);
+	if (fclose(f)) {
+		rc = -errno;
+		fprintf(stderr, "cannot write %s: %s\n", argv[1],
+			strerror(errno));
+	}
+out:
+	cYAML_free_tree(err_rc);
+	cYAML_free_tree(show_rc);
+
+	return rc;
+}
+
+static int jt_load_peers(int argc, char **argv)
+{
+	struct cYAML *err_rc = NULL;
+	int rc;
+
+	rc = check_cmd(peer_cmds, "peer", "load", 2, argc, argv);
+	if (rc)
+		return rc;
+
+	rc = lustre_yaml_load_peers(argv[1], &err_rc);
+	if (rc != LUSTRE_CFG_RC_NO_ERR)
+		cYAML_print_tree2file(stderr, err_rc);
+
+	cYAML_free_tree(err_rc);
+
+	return rc;
+}
+
 static int jt_ping(int argc, char **argv)
 {
 	struct cYAML *err_rc = NULL;
@@ -1484,9 +1484,10 @@ jt_lst_list_group(int argc, char **argv)
         return rc;
 }
 
-int
-lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
-	       int timeout, struct list_head *resultp)
+static int
+lst_stat_query_ioctl(unsigned int opc, char *name, int count,
+		     struct lnet_process_id *idsp, int timeout,
+		     struct list_head *resultp)
 {
 	struct lstio_stat_args args = { 0 };
 
@@ -1498,7 +1499,23 @@ lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
 	args.lstio_sta_idsp    = idsp;
 	args.lstio_sta_resultp = resultp;
 
-	return lst_ioctl(LSTIO_STAT_QUERY, &args, sizeof(args));
+	return lst_ioctl(opc, &args, sizeof(args));
+}
+
+int
+lst_stat_ioctl(char *name, int count, struct lnet_process_id *idsp,
+	       int timeout, struct list_head *resultp)
+{
+	return lst_stat_query_ioctl(LSTIO_STAT_QUERY, name, count, idsp,
+				    timeout, resultp);
+}
+
+int
+lst_stat_lat_ioctl(char *name, int count, struct lnet_process_id *idsp,
+		   int timeout, struct list_head *resultp)
+{
+	return lst_stat_query_ioctl(LSTIO_STAT_LAT_QUERY, name, count, idsp,
+				    timeout, resultp);
 }
 
 typedef struct {
@@ -1507,6 +1524,7 @@ typedef struct {
         char                   *srp_name;
 	struct lnet_process_id      *srp_ids;
 	struct list_head              srp_result[2];
+	struct list_head              srp_lat[2];
 } lst_stat_req_param_t;
 
 static void
@@ -1514,8 +1532,10 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 {
         int     i;
 
-        for (i = 0; i < 2; i++)
-                lst_free_rpcent(&srp->srp_result[i]);
+	for (i = 0; i < 2; i++) {
+		lst_free_rpcent(&srp->srp_result[i]);
+		lst_free_rpcent(&srp->srp_lat[i]);
+	}
 
         if (srp->srp_ids != NULL)
                 free(srp->srp_ids);
@@ -1524,7 +1544,8 @@ lst_stat_req_param_free(lst_stat_req_param_t *srp)
 }
 
 static int
-lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
+lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old,
+			 int lat)
 {
         lst_stat_req_param_t *srp = NULL;
         int                   count = save_old ? 2 : 1;
@@ -1538,6 +1559,8 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
         memset(srp, 0, sizeof(*srp));
 	INIT_LIST_HEAD(&srp->srp_result[0]);
 	INIT_LIST_HEAD(&srp->srp_result[1]);
+	INIT_LIST_HEAD(&srp->srp_lat[0]);
+	INIT_LIST_HEAD(&srp->srp_lat[1]);
 
         rc = lst_get_node_count(LST_OPC_GROUP, name,
                                 &srp->srp_count, NULL);
@@ -1562,6 +1585,9 @@ lst_stat_req_param_alloc(char *name, lst_stat_req_param_t **srpp, int save_old)
 				      sizeof(struct sfw_counters)  +
 				      sizeof(struct srpc_counters) +
 				      sizeof(struct lnet_counters_common));
+		if (rc == 0 && lat)
+			rc = lst_alloc_rpcent(&srp->srp_lat[i], srp->srp_count,
+					      sizeof(struct sfw_lat_counters));
 		if (rc != 0) {
 			fprintf(stderr, "Out of memory\n");
 			break;
@@ -1846,6 +1872,77 @@ lst_print_stat(char *name, struct list_head *resultp,
 	lst_print_lnet_stat(name, bwrt, rdwr, type, mbs);
 }
 
+/* estimate the latency at which @pct percent of RPCs completed, assuming
+ * RPCs are spread evenly within each log2 bucket */
+static double
+lst_lat_percentile(__u64 *hist, __u64 total, double pct)
+{
+	double target = total * pct / 100;
+	double lower;
+	__u64 sum = 0;
+	int i;
+
+	for (i = 0; i < LST_LAT_BUCKETS; i++) {
+		if (hist[i] == 0 || sum + hist[i] < target) {
+			sum += hist[i];
+			continue;
+		}
+
+		lower = i == 0 ? 0 : (double)(1ULL << i);
+		return lower + ((1ULL << (i + 1)) - lower) *
+			       (target - sum) / hist[i];
+	}
+
+	return (double)(1ULL << LST_LAT_BUCKETS);
+}
+
+static void
+lst_print_lat(char *name, struct list_head *resultp, int idx)
+{
+	struct lstcon_rpc_ent *new;
+	struct lstcon_rpc_ent *old;
+	struct sfw_lat_counters *lat_new;
+	struct sfw_lat_counters *lat_old;
+	struct list_head *pos = resultp[1 - idx].next;
+	__u64 hist[LST_LAT_BUCKETS] = { 0 };
+	__u64 total = 0;
+	int i;
+
+	/* entries are in the same order in both samples */
+	list_for_each_entry(new, &resultp[idx], rpe_link) {
+		if (pos == &resultp[1 - idx])
+			break;
+		old = list_entry(pos, struct lstcon_rpc_ent, rpe_link);
+		pos = pos->next;
+
+		/* first sample, or node failed to reply */
+		if (new->rpe_peer.nid == LNET_NID_ANY ||
+		    old->rpe_peer.nid != new->rpe_peer.nid ||
+		    new->rpe_rpc_errno != 0 || new->rpe_fwk_errno != 0 ||
+		    old->rpe_rpc_errno != 0 || old->rpe_fwk_errno != 0)
+			continue;
+
+		lat_new = (struct sfw_lat_counters *)&new->rpe_payload[0];
+		lat_old = (struct sfw_lat_counters *)&old->rpe_payload[0];
+		for (i = 0; i < LST_LAT_BUCKETS; i++) {
+			__u32 delta = lat_new->lat_hist[i] -
+				      lat_old->lat_hist[i];
+
+			hist[i] += delta;
+			total += delta;
+		}
+	}
+
+	if (total == 0)
+		return;
+
+	fprintf(stdout,
+		"[LAT] Latency of %-20s RPCs: %-10ju p50: %-10.1f p99: %-10.1f p99.9: %-10.1f (usec)\n",
+		name, (uintmax_t)total, lst_lat_percentile(hist, total, 50),
+		lst_lat_percentile(hist, total, 99),
+		lst_lat_percentile(hist, total, 99.9));
+}
+
 int
 jt_lst_stat(int argc, char **argv)
 {
@@ -1864,6 +1961,7 @@ jt_lst_stat(int argc, char **argv)
 	int		      rc;
 	int		      c;
 	int		      mbs     = 0; /* report as MB/s */
+	int		      lat     = 0; /* report latency percentiles */
 
 	static const struct option stat_opts[] = {
 		{ .name = "timeout", .has_arg = required_argument, .val = 't' },
@@ -1879,6 +1977,7 @@ jt_lst_stat(int argc, char **argv)
 		{ .name = "min",     .has_arg = no_argument,       .val = 'n' },
 		{ .name = "max",     .has_arg = no_argument,       .val = 'x' },
 		{ .name = "mbs",     .has_arg = no_argument,       .val = 'm' },
+		{ .name = "lat",     .has_arg = no_argument,       .val = 'L' },
 		{ .name = NULL } };
 
         if (session_key == 0) {
@@ -1888,7 +1987,7 @@ jt_lst_stat(int argc, char **argv)
         }
 
         while (1) {
-		c = getopt_long(argc, argv, "t:d:lcbarwgnxm", stat_opts,
+		c = getopt_long(argc, argv, "t:d:lcbarwgnxmL", stat_opts,
 				&optidx);
 
                 if (c == -1)
@@ -1946,6 +2045,9 @@ jt_lst_stat(int argc, char **argv)
 		case 'm':
 			mbs = 1;
 			break;
+		case 'L':
+			lat = 1;
+			break;
 
 		default:
 			lst_print_usage(argv[0]);
@@ -1975,7 +2077,7 @@ jt_lst_stat(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 1, lat);
                 if (rc != 0)
                         goto out;
 
@@ -2005,6 +2107,22 @@ jt_lst_stat(int argc, char **argv)
 				       idx, lnet, bwrt, rdwr, type, mbs);
 
 			lst_reset_rpcent(&srp->srp_result[1 - idx]);
+
+			if (!lat)
+				continue;
+
+			rc = lst_stat_lat_ioctl(srp->srp_name, srp->srp_count,
+						srp->srp_ids, timeout,
+						&srp->srp_lat[idx]);
+			if (rc == -1) {
+				lst_print_error("stat",
+						"Failed to get latency of %s: %s\n",
+						srp->srp_name, strerror(errno));
+				goto out;
+			}
+
+			lst_print_lat(srp->srp_name, srp->srp_lat, idx);
+			lst_reset_rpcent(&srp->srp_lat[1 - idx]);
 		}
 
                 idx = 1 - idx;
@@ -2073,7 +2191,7 @@ jt_lst_show_error(int argc, char **argv)
 	INIT_LIST_HEAD(&head);
 
         while (optind < argc) {
-                rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0);
+		rc = lst_stat_req_param_alloc(argv[optind++], &srp, 0, 0);
                 if (rc != 0)
                         goto out;
 
@@ -2950,6 +3068,15 @@ lst_get_bulk_param(int argc, char **argv, struct lst_test_bulk_param *bulk)
                                 return -1;
                         }
 
+		} else if (strcasestr(argv[i], "rate=") == argv[i]) {
+			tok = strchr(argv[i], '=') + 1;
+
+			bulk->blk_rate = strtol(tok, &end, 0);
+			if (bulk->blk_rate < 0 || *end != '\0') {
+				fprintf(stderr, "Invalid rate %s\n", tok);
+				return -1;
+			}
+
 		} else if (strcasestr(argv[i], "off=") == argv[i]) {
 			int	off;
 
@@ -2990,10 +3117,34 @@ lst_get_bulk_param(int argc, char **argv, struct lst_test_bulk_param *bulk)
         return rc;
 }
 
+int
+lst_get_ping_param(int argc, char **argv, struct lst_test_ping_param *ping)
+{
+	char *tok;
+	char *end;
+	int i;
+
+	for (i = 0; i < argc; i++) {
+		/* other parameters have always been ignored for ping */
+		if (strcasestr(argv[i], "rate=") != argv[i])
+			continue;
+
+		tok = strchr(argv[i], '=') + 1;
+		ping->png_rate = strtol(tok, &end, 0);
+		if (ping->png_rate < 0 || *end != '\0') {
+			fprintf(stderr, "Invalid rate %s\n", tok);
+			return -1;
+		}
+	}
+
+	return 0;
+}
+
 int
 lst_get_test_param(char *test, int argc, char **argv, void **param, int *plen)
 {
 	struct lst_test_bulk_param *bulk = NULL;
+	struct lst_test_ping_param *ping = NULL;
         int                    type;
 
         type = lst_test_name2type(test);
@@ -3004,6 +3155,25 @@ lst_get_test_param(char *test, int argc, char **argv, void **param, int *plen)
 
         switch (type) {
         case LST_TEST_PING:
+		if (argc == 0)
+			break;
+
+		ping = malloc(sizeof(*ping));
+		if (ping == NULL) {
+			fprintf(stderr, "Out of memory\n");
+			return -1;
+		}
+
+		memset(ping, 0, sizeof(*ping));
+
+		if (lst_get_ping_param(argc, argv, ping) != 0) {
+			free(ping);
+			return -1;
+		}
+
+		*param = ping;
+		*plen  = sizeof(*ping);
+
                 break;
 
         case LST_TEST_BULK:
@@ -3235,7 +3405,7 @@ static command_t lst_cmdlist[] = {
           "Usage: lst list_group [--active] [--busy] [--down] [--unknown] GROUP ..."    },
 	{"stat",                jt_lst_stat,            NULL,
 	 "Usage: lst stat [--bw] [--rate] [--read] [--write] [--max] [--min] [--avg] "
-	 " [--mbs] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"                 },
+	 " [--mbs] [--lat] [--timeout #] [--delay #] [--count #] GROUP [GROUP]"         },
         {"show_error",          jt_lst_show_error,      NULL,
          "Usage: lst show_error NAME | IDS ..."                                         },
         {"add_batch",           jt_lst_add_batch,       NULL,
@@ -2601,6 +2601,31 @@ user_namespace_argument, [
 EXTRA_KCFLAGS="$tmp_flags"
 ]) # LC_HAVE_USER_NAMESPACE_ARG
 
+#
+# LC_HAVE_MAP_PAGES_VM_FAULT_T
+#
+# kernel 5.12 commit f9ce0be71d1fbb038ada15ced83474b0e63f264d
+# mm: Cleanup faultaround and finish_fault() codepaths
+# vm_operations_struct::map_pages() returns vm_fault_t
+#
+AC_DEFUN([LC_HAVE_MAP_PAGES_VM_FAULT_T], [
+tmp_flags="$EXTRA_KCFLAGS"
+EXTRA_KCFLAGS="-Werror"
+LB_CHECK_COMPILE([if 'map_pages' returns 'vm_fault_t'],
+map_pages_vm_fault_t, [
+	#include <linux/mm.h>
+],[
+	vm_fault_t ret;
+
+	ret = filemap_map_pages(NULL, 0, 0);
+	(void)ret;
+],[
+	AC_DEFINE(HAVE_MAP_PAGES_VM_FAULT_T, 1,
+		['map_pages' returns 'vm_fault_t'])
+])
+EXTRA_KCFLAGS="$tmp_flags"
+]) # LC_HAVE_MAP_PAGES_VM_FAULT_T
+
 #
 # LC_TASK_STRUCT_HAS_NEW_STATE
 #
@@ -2844,6 +2869,7 @@ AC_DEFUN([LC_PROG_LINUX], [
 
 	# 5.12
 	LC_HAVE_USER_NAMESPACE_ARG
+	LC_HAVE_MAP_PAGES_VM_FAULT_T
 
 	# 5.13
 	LC_TASK_STRUCT_HAS_NEW_STATE
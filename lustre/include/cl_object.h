@@ -2301,6 +2301,11 @@ struct cl_client_cache {
 	 * # of LRU entries available
 	 */
 	atomic_long_t		ccc_lru_left;
+	/**
+	 * Per-CPT LRU slots freed by page destruction and not yet returned
+	 * to ccc_lru_left, see cl_cache_lru_put()
+	 */
+	atomic_long_t		**ccc_lru_pending;
 	/**
 	 * List of entities(OSCs) for this LRU cache
 	 */
@@ -2337,6 +2342,8 @@ struct cl_client_cache {
 struct cl_client_cache *cl_cache_init(unsigned long lru_page_max);
 void cl_cache_incref(struct cl_client_cache *cache);
 void cl_cache_decref(struct cl_client_cache *cache);
+void cl_cache_lru_put(struct cl_client_cache *cache, long npages);
+long cl_cache_lru_flush(struct cl_client_cache *cache);
 
 /** @} cl_page */
 
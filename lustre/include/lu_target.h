@@ -200,6 +200,10 @@ struct lu_target {
 	struct dt_object	*lut_reply_data;
 	/** Bitmap of used slots in the reply data file */
 	unsigned long		**lut_reply_bitmap;
+	/** Per-CPU caches of reply data slots reserved in lut_reply_bitmap */
+	struct tgt_reply_slot_cache __percpu *lut_reply_cache;
+	/** Lowest reply data slot which may be free */
+	int			 lut_reply_hint;
 	/** target sync count, used for debug & test */
 	atomic_t		 lut_sync_count;
 
@@ -224,6 +228,28 @@ struct lu_target {
 /* number of slots in reply bitmap */
 #define LUT_REPLY_SLOTS_PER_CHUNK (1<<20)
 #define LUT_REPLY_SLOTS_MAX_CHUNKS 16
+/* number of reply slots reserved at once, and cached, per CPU */
+#define LUT_REPLY_SLOTS_BATCH 32
+
+/**
+ * Per-CPU cache of free reply data slots, so that most modifying RPCs get
+ * a slot without looking at the shared bitmap. The slots are marked used
+ * in lut_reply_bitmap while they are in the cache.
+ */
+struct tgt_reply_slot_cache {
+	int		rsc_count;
+	int		rsc_slots[LUT_REPLY_SLOTS_BATCH];
+	/* slots allocated */
+	__u64		rsc_alloc;
+	/* slots allocated from the cache */
+	__u64		rsc_hit;
+	/* searches in the bitmap */
+	__u64		rsc_search;
+	/* bits looked at by the searches */
+	__u64		rsc_scanned;
+	/* free bits taken by another thread during a search */
+	__u64		rsc_race;
+};
 
 #define TRD_INDEX_MEMORY -1
 
@@ -1218,8 +1218,56 @@ int llapi_mirror_copy(int fd, unsigned int src, unsigned int dst,
 off_t llapi_mirror_data_seek(int fd, unsigned int id, off_t pos, size_t *size);
 int llapi_mirror_punch(int fd, unsigned int id, off_t start, size_t length);
 
+/**
+ * FLR: parallel mirror copy
+ *
+ * Data is copied in batches of chunks, each chunk is read and written by
+ * one of the I/O threads. Progress can be followed either through the
+ * callback, called after each batch, or by reading \a mcp_stats from
+ * another thread while the copy is running.
+ */
+#define LLAPI_MIRROR_COPY_THREADS_DEF	4
+#define LLAPI_MIRROR_COPY_THREADS_MAX	64
+#define LLAPI_MIRROR_COPY_CHUNK_DEF	(4UL << 20)	/* 4MiB */
+
+struct llapi_mirror_copy_stats {
+	uint64_t	mcs_size;		/* bytes in the copy range */
+	uint64_t	mcs_pos;		/* offset copied up to */
+	uint64_t	mcs_read_bytes;		/* bytes read from source */
+	uint64_t	mcs_write_bytes;	/* bytes written, all targets */
+	uint64_t	mcs_hole_bytes;		/* source holes not copied */
+	uint64_t	mcs_elapsed_ms;		/* time since copy start */
+	uint32_t	mcs_threads;		/* I/O threads in use */
+	uint32_t	mcs_targets;		/* targets still being written */
+};
+
+/* return negative errno to abort the copy */
+typedef int (*llapi_mirror_copy_cb)(const struct llapi_mirror_copy_stats *stats,
+				    void *cbdata);
+
+struct llapi_mirror_copy_param {
+	unsigned int			 mcp_threads;	 /* 0 for default */
+	size_t				 mcp_chunk_size; /* 0 for default */
+	struct llapi_mirror_copy_stats	*mcp_stats;	 /* may be NULL */
+	llapi_mirror_copy_cb		 mcp_cb;	 /* may be NULL */
+	void				*mcp_cbdata;
+};
+
+ssize_t llapi_mirror_copy_many_ext(int fd, __u16 src, __u16 *dst, size_t count,
+				   const struct llapi_mirror_copy_param *param);
+int llapi_mirror_copy_ext(int fd, unsigned int src, unsigned int dst,
+			  off_t pos, size_t count,
+			  const struct llapi_mirror_copy_param *param);
+int llapi_mirror_resync_many_ext(int fd, struct llapi_layout *layout,
+				 struct llapi_resync_comp *comp_array,
+				 int comp_size, uint64_t start, uint64_t end,
+				 const struct llapi_mirror_copy_param *param);
+int llapi_file_copy_data(int fd_src, int fd_dst,
+			 const struct llapi_mirror_copy_param *param);
+
 int llapi_heat_get(int fd, struct lu_heat *heat);
 int llapi_heat_set(int fd, __u64 flags);
+int llapi_heat_top_get(int fd, struct lu_heat_top *top);
 
 int llapi_layout_sanity(struct llapi_layout *layout, bool incomplete, bool flr);
 void llapi_layout_sanity_perror(int error);
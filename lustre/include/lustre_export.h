@@ -80,6 +80,11 @@ struct tg_export_data {
 	 */
 	spinlock_t		ted_nodemap_lock;
 	struct lu_nodemap	*ted_nodemap;
+	/* NID and nodemap config generation ted_nodemap was classified with,
+	 * lets a reconnect from the same NID skip the range tree walk
+	 */
+	lnet_nid_t		ted_nodemap_nid;
+	__u32			ted_nodemap_gen;
 	struct list_head	ted_nodemap_member;
 
 	/** last version of nodemap config sent to client */
@@ -38,6 +38,8 @@ struct lmv_oinfo {
 	struct lu_fid	lmo_fid;
 	u32		lmo_mds;
 	struct inode	*lmo_root;
+	/* page advances before the next readdir lookahead of this stripe */
+	unsigned int	lmo_ra_skip;
 };
 
 struct lmv_stripe_md {
@@ -584,6 +584,8 @@ typedef int (*set_producer_func)(struct ptlrpc_request_set *, void *);
  * Provides a way to call "completion callbacks" when all requests in the set
  * returned.
  */
+struct binheap;
+
 struct ptlrpc_request_set {
 	atomic_t		set_refcount;
 	/** number of in queue requests */
@@ -612,9 +614,34 @@ struct ptlrpc_request_set {
 	set_producer_func	set_producer;
 	/** opaq argument passed to the producer callback */
 	void			*set_producer_arg;
-	unsigned int		 set_allow_intr:1;
+	/**
+	 * Lock for \a set_ready manipulations, nests inside imp_lock and
+	 * rq_lock. The timer heap is not protected by it, it is only used
+	 * by the thread processing the set.
+	 */
+	spinlock_t		 set_ready_lock;
+	/**
+	 * Requests which got an event since they were last checked, so
+	 * that ptlrpc_check_set() does not have to walk the whole set
+	 */
+	struct list_head	 set_ready;
+	/** In flight requests of a large set ordered by deadline */
+	struct binheap		*set_timer_heap;
+	/** Last time every request of the set was checked */
+	time64_t		 set_scan_time;
+	unsigned int		 set_allow_intr:1,
+				 /* always walk the whole set */
+				 set_scan_only:1,
+				 /* walk the whole set on next check */
+				 set_scan_all:1;
 };
 
+/**
+ * Sets with fewer requests are walked on every check, event tracking only
+ * pays off above this.
+ */
+#define PTLRPC_SET_EVENT_MIN	64
+
 struct ptlrpc_bulk_desc;
 struct ptlrpc_service_part;
 struct ptlrpc_service;
@@ -808,6 +835,12 @@ struct ptlrpc_cli_req {
 	wait_queue_head_t		 cr_set_waitq;
 	/** Link item for request set lists */
 	struct list_head		 cr_set_chain;
+	/** Link item for ptlrpc_request_set::set_ready */
+	struct list_head		 cr_ready_chain;
+	/** Position in ptlrpc_request_set::set_timer_heap */
+	struct binheap_node		 cr_timer_node;
+	/** Deadline the request is queued with in the timer heap, or 0 */
+	time64_t			 cr_set_deadline;
 	/** link to waited ctx */
 	struct list_head		 cr_ctx_chain;
 
@@ -860,6 +893,9 @@ struct ptlrpc_cli_req {
 #define rq_import_generation	rq_cli.cr_imp_gen
 #define rq_send_state		rq_cli.cr_send_state
 #define rq_set_chain		rq_cli.cr_set_chain
+#define rq_ready_chain		rq_cli.cr_ready_chain
+#define rq_timer_node		rq_cli.cr_timer_node
+#define rq_set_deadline		rq_cli.cr_set_deadline
 #define rq_ctx_chain		rq_cli.cr_ctx_chain
 #define rq_set			rq_cli.cr_set
 #define rq_set_waitq		rq_cli.cr_set_waitq
@@ -2062,6 +2098,9 @@ struct ptlrpc_request_set *ptlrpc_prep_set(void);
 struct ptlrpc_request_set *ptlrpc_prep_fcset(int max, set_producer_func func,
 					     void *arg);
 int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set);
+void ptlrpc_set_req_ready(struct ptlrpc_request_set *set,
+			  struct ptlrpc_request *req);
+time64_t ptlrpc_set_next_timeout(struct ptlrpc_request_set *set);
 int ptlrpc_set_wait(const struct lu_env *env, struct ptlrpc_request_set *);
 void ptlrpc_set_destroy(struct ptlrpc_request_set *);
 void ptlrpc_set_add_req(struct ptlrpc_request_set *, struct ptlrpc_request *);
@@ -2229,6 +2268,7 @@ void ptlrpc_watchdog_touch(struct delayed_work *work, timeout_t timeout);
  */
 int ptlrpc_connect_import(struct obd_import *imp);
 int ptlrpc_connect_import_locked(struct obd_import *imp);
+int ptlrpc_connect_import_lazy(struct obd_import *imp);
 int ptlrpc_init_import(struct obd_import *imp);
 int ptlrpc_disconnect_import(struct obd_import *imp, int noclose);
 int ptlrpc_disconnect_and_idle_import(struct obd_import *imp);
@@ -2470,11 +2510,16 @@ __ptlrpc_cli_wait_unlink(struct ptlrpc_request *req, bool *discard)
 static inline void
 ptlrpc_client_wake_req(struct ptlrpc_request *req)
 {
+	struct ptlrpc_request_set *set;
+
 	smp_mb();
-	if (req->rq_set == NULL)
+	set = READ_ONCE(req->rq_set);
+	if (set == NULL) {
 		wake_up(&req->rq_reply_waitq);
-	else
-		wake_up(&req->rq_set->set_waitq);
+	} else {
+		ptlrpc_set_req_ready(set, req);
+		wake_up(&set->set_waitq);
+	}
 }
 
 static inline void
@@ -69,6 +69,12 @@ struct nodemap_pde {
 	struct list_head	 npe_list_member;
 };
 
+/* size of the per-nodemap idmap lookup cache, see nodemap_idmap.c */
+#define NODEMAP_IDCACHE_BITS	8
+#define NODEMAP_IDCACHE_SIZE	(1 << NODEMAP_IDCACHE_BITS)
+
+struct nm_idcache_ent;
+
 /** The nodemap id 0 will be the default nodemap. It will have a configuration
  * set by the MGS, but no ranges will be allowed as all NIDs that do not map
  * will be added to the default nodemap
@@ -112,6 +118,10 @@ struct lu_nodemap {
 	struct rb_root		 nm_fs_to_client_projidmap;
 	/* PROJID map keyed by remote UID */
 	struct rb_root		 nm_client_to_fs_projidmap;
+	/* lockless cache of idmap lookups, entries freed via RCU and only
+	 * valid while their generation matches nodemap_config_gen
+	 */
+	struct nm_idcache_ent	*nm_idcache[NODEMAP_IDCACHE_SIZE];
 	/* attached client members of this nodemap */
 	struct mutex		 nm_member_list_lock;
 	struct list_head	 nm_member_list;
@@ -108,6 +108,15 @@ struct osc_device {
 		ktime_t		os_init;
 		uint64_t	os_lockless_writes;    /* by bytes */
 		uint64_t	os_lockless_reads;     /* by bytes */
+		/* OST_SYNC RPCs sent by fsync */
+		uint64_t	os_fsync_count;
+		/* time waiting for writeback before OST_SYNC, by usec */
+		uint64_t	os_fsync_wait_us;
+		/* OST_SYNC RPC latency, by usec */
+		uint64_t	os_fsync_rpc_us;
+		uint64_t	os_fsync_rpc_max_us;
+		/* writeback waits started with an OST_SYNC in flight */
+		uint64_t	os_fsync_overlap;
 	} od_stats;
 
 	/* configuration item(s) */
@@ -129,7 +138,12 @@ struct osc_io {
 	/** true if this io has CAP_SYS_RESOURCE */
 			   oi_cap_sys_resource:1,
 	/** true if this io issued by readahead */
-			   oi_is_readahead:1;
+			   oi_is_readahead:1,
+	/** true if OST_SYNC of this fsync io is sent by osc_io_fsync_end() */
+			   oi_fsync_deferred:1,
+	/** true if another OST_SYNC was in flight when the writeback wait of
+	 * this fsync io started */
+			   oi_fsync_overlap:1;
 	/** how many LRU pages are reserved for this IO */
 	unsigned long	   oi_lru_reserved;
 
@@ -147,6 +161,11 @@ struct osc_io {
 		int		  opc_rc;
 		struct completion opc_sync;
 	} oi_cbarg;
+	/** when fsync started waiting for writeback before OST_SYNC, when
+	 * OST_SYNC was sent and when its reply arrived */
+	ktime_t		   oi_fsync_start;
+	ktime_t		   oi_fsync_sent;
+	ktime_t		   oi_fsync_done;
 };
 
 /**
@@ -157,6 +176,7 @@ struct osc_session {
 };
 
 #define OTI_PVEC_SIZE 256
+#define OTI_LRU_USE_SIZE 16
 struct osc_thread_info {
 	struct ldlm_res_id	oti_resname;
 	union ldlm_policy_data	oti_policy;
@@ -173,6 +193,12 @@ struct osc_thread_info {
 	struct cl_sync_io	oti_anchor;
 	struct cl_req_attr	oti_req_attr;
 	struct lu_buf		oti_ladvise_buf;
+	/**
+	 * Pages to take off the LRU, batched by osc_lru_use().
+	 */
+	struct client_obd	*oti_lru_use_cli;
+	struct osc_page		*oti_lru_use[OTI_LRU_USE_SIZE];
+	unsigned int		oti_lru_use_nr;
 };
 
 static inline __u64 osc_enq2ldlm_flags(__u32 enqflags)
@@ -532,6 +558,11 @@ struct osc_page {
 	 * lru page list. See osc_lru_{del|use}() in osc_page.c for usage.
 	 */
 	struct list_head	ops_lru;
+	/**
+	 * LRU partition of the page, the CPT of the node of its memory.
+	 * See osc_lru_alloc().
+	 */
+	__u16			ops_lru_part;
 	/**
 	 * Submit time - the time when the page is starting RPC. For debugging.
 	 */
@@ -569,6 +600,7 @@ int osc_page_init(const struct lu_env *env, struct cl_object *obj,
 void osc_index2policy(union ldlm_policy_data *policy, const struct cl_object *obj,
 		      pgoff_t start, pgoff_t end);
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *list);
+void osc_lru_use_flush(const struct lu_env *env);
 void osc_page_submit(const struct lu_env *env, struct osc_page *opg,
 		     enum cl_req_type crt, int brw_flags, ktime_t submit_time);
 int lru_queue_work(const struct lu_env *env, void *data);
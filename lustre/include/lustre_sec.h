@@ -1169,6 +1169,11 @@ void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc);
 int get_free_pages_in_pool(void);
 int pool_is_at_full_capacity(void);
 
+/* process pages [first, first + count) of a bulk, return 0 or an error */
+typedef int (*sptlrpc_crypt_chunk_t)(void *data, u32 first, u32 count);
+int sptlrpc_crypt_parallel(sptlrpc_crypt_chunk_t fn, void *data, u32 count,
+			   unsigned int chunk);
+
 int sptlrpc_cli_wrap_bulk(struct ptlrpc_request *req,
                           struct ptlrpc_bulk_desc *desc);
 int sptlrpc_cli_unwrap_bulk_read(struct ptlrpc_request *req,
@@ -175,7 +175,35 @@ enum obd_cl_sem_lock_class {
 	OBD_CLI_SEM_MDCOSC,
 };
 
+/**
+ * One partition of the LRU page list of a client_obd. Cached pages are kept
+ * on the partition of the CPT their memory belongs to, so that threads on
+ * different nodes adding, using and shrinking LRU pages don't contend on a
+ * single lock, and shrinking walks node local pages first.
+ */
+struct cl_lru_part {
+	/** Lock for clp_list */
+	spinlock_t		clp_lock;
+	/** List of LRU pages of this partition */
+	struct list_head	clp_list;
+	/** # of pages in clp_list */
+	long			clp_count;
+	/** # of threads shrinking this partition */
+	atomic_t		clp_shrinkers;
+};
+
 struct obd_import;
+
+/* per-CPU counters for bulk page encryption/decryption */
+struct cli_crypt_stats {
+	__u64	ccs_encrypt_pages;
+	__u64	ccs_encrypt_bytes;
+	__u64	ccs_encrypt_usec;
+	__u64	ccs_decrypt_pages;
+	__u64	ccs_decrypt_bytes;
+	__u64	ccs_decrypt_usec;
+};
+
 struct client_obd {
 	struct rw_semaphore	 cl_sem;
 	struct obd_uuid		 cl_target_uuid;
@@ -287,6 +315,10 @@ struct client_obd {
 	struct obd_histogram	cl_write_page_hist;
 	struct obd_histogram	cl_read_offset_hist;
 	struct obd_histogram	cl_write_offset_hist;
+	/* bulk page encryption: pages per worker chunk, 0 means inline */
+	unsigned int		cl_crypt_pipeline_pages;
+	struct cli_crypt_stats __percpu *cl_crypt_stats;
+	ktime_t			cl_crypt_stats_init;
 
 	/** LRU for osc caching pages */
 	struct cl_client_cache  *cl_cache;
@@ -303,7 +335,7 @@ struct client_obd {
 	/** # of LRU pages in the cache for this client_obd */
 	atomic_long_t            cl_lru_in_list;
 	/** # of threads are shrinking LRU cache. To avoid contention, it's not
-	 * allowed to have multiple threads shrinking LRU cache. */
+	 * allowed to have multiple threads shrinking the same LRU partition. */
 	atomic_t                 cl_lru_shrinkers;
 	/** The time when this LRU cache was last used. */
 	time64_t		 cl_lru_last_used;
@@ -312,10 +344,8 @@ struct client_obd {
 	 * reclaim is sync, initiated by IO thread when the LRU slots are
 	 * in shortage. */
 	__u64                    cl_lru_reclaim;
-	/** List of LRU pages for this client_obd */
-	struct list_head         cl_lru_list;
-	/** Lock for LRU page list */
-	spinlock_t		 cl_lru_list_lock;
+	/** Per-CPT partitions of the LRU page list for this client_obd */
+	struct cl_lru_part	**cl_lru_parts;
 	/** # of unstable pages in this client_obd.
 	 * An unstable page is a page state that WRITE RPC has finished but
 	 * the transaction has NOT yet committed. */
@@ -447,6 +477,13 @@ struct lmv_obd {
 	void			*lmv_cache;
 
 	__u32			lmv_qos_rr_index;
+
+	/* striped directory readdir lookahead, pages per stripe */
+	unsigned int		lmv_readdir_prefetch;
+	atomic_t		lmv_readdir_inflight;
+	bool			lmv_readdir_stop;
+	struct workqueue_struct	*lmv_readdir_wq;
+	struct lprocfs_stats	*lmv_readdir_stats;
 };
 
 #define lmv_mdt_count	lmv_mdt_descs.ltd_lmv_desc.ld_tgt_count
@@ -796,6 +833,7 @@ void obd_nid_del(struct obd_device *obd, struct obd_export *exp);
 #define KEY_DEFAULT_EASIZE	"default_easize"
 #define KEY_MGSSEC              "mgssec"
 #define KEY_READ_ONLY           "read-only"
+#define KEY_READDIR_AHEAD_STOP	"readdir_ahead_stop"
 #define KEY_REGISTER_TARGET     "register_target"
 #define KEY_SET_FS              "set_fs"
 #define KEY_TGT_COUNT           "tgt_count"
@@ -964,6 +1002,9 @@ struct md_readdir_info {
 			       void *data, int flag);
 	/* if striped directory is partially read, the result is stored here */
 	int mr_partial_readdir_rc;
+	/* directory pages read, and time spent waiting for them */
+	__u64 mr_pages;
+	__u64 mr_wait_us;
 };
 
 struct md_enqueue_info;
@@ -142,6 +142,32 @@ typedef __u16 (obd_dif_csum_fn) (void *, unsigned int);
 
 __u16 obd_dif_crc_fn(void *data, unsigned int len);
 __u16 obd_dif_ip_fn(void *data, unsigned int len);
+
+enum obd_dif_csum {
+	OBD_DIF_CSUM_IP = 0,
+	OBD_DIF_CSUM_CRC,
+	OBD_DIF_CSUM_MAX
+};
+
+/* One implementation of a T10-PI guard tag checksum */
+struct obd_dif_impl {
+	const char		*odi_name;
+	enum obd_dif_csum	 odi_csum;
+	obd_dif_csum_fn		*odi_fn;
+	/* MB/s for 512 byte sectors, measured when selecting */
+	int			 odi_speed;
+	/* result matches the reference implementation */
+	bool			 odi_valid;
+};
+
+const struct obd_dif_impl *obd_dif_impl_get(unsigned int index);
+const char *obd_dif_impl_current(enum obd_dif_csum csum);
+int obd_dif_impl_selftest(const struct obd_dif_impl *impl);
+int obd_dif_impl_speed(const struct obd_dif_impl *impl, void *buf,
+		       unsigned int len, unsigned int msecs);
+unsigned int obd_dif_guards_compare(const __u16 *guards, const void *tuples,
+				    unsigned int sectors,
+				    unsigned int tuple_size);
 int obd_page_dif_generate_buffer(const char *obd_name, struct page *page,
 				 __u32 offset, __u32 length,
 				 __u16 *guard_start, int guard_number,
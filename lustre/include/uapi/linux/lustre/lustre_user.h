@@ -636,6 +636,7 @@ struct ll_ioc_lease_id {
 #define LL_IOC_PCC_DETACH_BY_FID	_IOW('f', 252, struct lu_pcc_detach_fid)
 #define LL_IOC_PCC_STATE		_IOR('f', 252, struct lu_pcc_state)
 #define LL_IOC_PROJECT			_IOW('f', 253, struct lu_project)
+#define LL_IOC_HEAT_TOP			_IOWR('f', 254, struct lu_heat_top)
 
 #ifndef	FS_IOC_FSGETXATTR
 /*
@@ -2649,6 +2650,22 @@ struct lu_heat {
 	__u64 lh_heat[0];
 };
 
+/* One file of the client hot file table, see LL_IOC_HEAT_TOP */
+struct lu_heat_top_entry {
+	struct lu_fid	lhte_fid;
+	__u64		lhte_heat[OBD_HEAT_COUNT];
+};
+
+/*
+ * Hottest files of a client mount, hottest first. The files are ranked by
+ * the sum of their read and write sample heat.
+ */
+struct lu_heat_top {
+	__u32			 lht_count; /* in: max entries, out: returned */
+	__u32			 lht_padding;
+	struct lu_heat_top_entry lht_entries[0];
+};
+
 enum lu_pcc_type {
 	LU_PCC_NONE = 0,
 	LU_PCC_READWRITE,
@@ -327,6 +327,8 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	char *cli_name = lustre_cfg_buf(lcfg, 0);
 	struct ptlrpc_connection fake_conn = { .c_self = {},
 					       .c_remote_uuid.uuid[0] = 0 };
+	struct cl_lru_part *part;
+	int i;
 	int rc;
 
 	ENTRY;
@@ -446,8 +448,6 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	atomic_set(&cli->cl_lru_shrinkers, 0);
 	atomic_long_set(&cli->cl_lru_busy, 0);
 	atomic_long_set(&cli->cl_lru_in_list, 0);
-	INIT_LIST_HEAD(&cli->cl_lru_list);
-	spin_lock_init(&cli->cl_lru_list_lock);
 	atomic_long_set(&cli->cl_unstable_count, 0);
 	INIT_LIST_HEAD(&cli->cl_shrink_list);
 	INIT_LIST_HEAD(&cli->cl_grant_chain);
@@ -512,6 +512,15 @@ int client_obd_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	INIT_LIST_HEAD(&cli->cl_chg_dev_linkage);
 
+	cli->cl_lru_parts = cfs_percpt_alloc(cfs_cpt_tab,
+					     sizeof(struct cl_lru_part));
+	if (cli->cl_lru_parts == NULL)
+		GOTO(err, rc = -ENOMEM);
+	cfs_percpt_for_each(part, i, cli->cl_lru_parts) {
+		spin_lock_init(&part->clp_lock);
+		INIT_LIST_HEAD(&part->clp_list);
+	}
+
 	if (connect_op == MDS_CONNECT) {
 		cli->cl_max_mod_rpcs_in_flight = cli->cl_max_rpcs_in_flight - 1;
 		OBD_ALLOC(cli->cl_mod_tag_bitmap,
@@ -597,6 +606,9 @@ err:
 		OBD_FREE(cli->cl_mod_tag_bitmap,
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
 	cli->cl_mod_tag_bitmap = NULL;
+	if (cli->cl_lru_parts != NULL)
+		cfs_percpt_free(cli->cl_lru_parts);
+	cli->cl_lru_parts = NULL;
 
 	RETURN(rc);
 }
@@ -621,6 +633,11 @@ int client_obd_cleanup(struct obd_device *obd)
 			 BITS_TO_LONGS(OBD_MAX_RIF_MAX) * sizeof(long));
 	cli->cl_mod_tag_bitmap = NULL;
 
+	if (cli->cl_lru_parts != NULL) {
+		cfs_percpt_free(cli->cl_lru_parts);
+		cli->cl_lru_parts = NULL;
+	}
+
 	RETURN(0);
 }
 EXPORT_SYMBOL(client_obd_cleanup);
@@ -665,9 +682,13 @@ int client_connect_import(const struct lu_env *env,
 		imp->imp_connect_flags2_orig = data->ocd_connect_flags2;
 	}
 
-	rc = ptlrpc_connect_import(imp);
+	if (imp->imp_lazy_connect)
+		rc = ptlrpc_connect_import_lazy(imp);
+	else
+		rc = ptlrpc_connect_import(imp);
 	if (rc != 0) {
-		LASSERT(imp->imp_state == LUSTRE_IMP_DISCON);
+		LASSERT(imp->imp_state == LUSTRE_IMP_DISCON ||
+			imp->imp_state == LUSTRE_IMP_NEW);
 		GOTO(out_ldlm, rc);
 	}
 	LASSERT(*exp != NULL && (*exp)->exp_connection);
@@ -142,19 +142,23 @@
  *
  */
 struct page *ll_get_dir_page(struct inode *dir, struct md_op_data *op_data,
-			     __u64 offset, int *partial_readdir_rc)
+			     __u64 offset, struct md_readdir_info *mrinfo)
 {
-	struct md_readdir_info mrinfo = {
+	struct md_readdir_info local = {
 					.mr_blocking_ast = ll_md_blocking_ast };
+	ktime_t kstart = ktime_get();
 	struct page *page;
 	int rc;
 
-	rc = md_read_page(ll_i2mdexp(dir), op_data, &mrinfo, offset, &page);
+	if (!mrinfo)
+		mrinfo = &local;
+
+	rc = md_read_page(ll_i2mdexp(dir), op_data, mrinfo, offset, &page);
+	mrinfo->mr_wait_us += ktime_us_delta(ktime_get(), kstart);
 	if (rc != 0)
 		return ERR_PTR(rc);
 
-	if (partial_readdir_rc && mrinfo.mr_partial_readdir_rc)
-		*partial_readdir_rc = mrinfo.mr_partial_readdir_rc;
+	mrinfo->mr_pages++;
 
 	return page;
 }
@@ -183,11 +187,11 @@ void ll_release_page(struct inode *inode, struct page *page,
 
 #ifdef HAVE_DIR_CONTEXT
 int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
-		struct dir_context *ctx, int *partial_readdir_rc)
+		struct dir_context *ctx, struct md_readdir_info *mrinfo)
 {
 #else
 int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
-		void *cookie, filldir_t filldir, int *partial_readdir_rc)
+		void *cookie, filldir_t filldir, struct md_readdir_info *mrinfo)
 {
 #endif
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
@@ -206,7 +210,7 @@ int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 			RETURN(rc);
 	}
 
-	page = ll_get_dir_page(inode, op_data, pos, partial_readdir_rc);
+	page = ll_get_dir_page(inode, op_data, pos, mrinfo);
 
 	while (rc == 0 && !done) {
 		struct lu_dirpage *dp;
@@ -302,8 +306,7 @@ int ll_dir_read(struct inode *inode, __u64 *ppos, struct md_op_data *op_data,
 					le32_to_cpu(dp->ldp_flags) &
 					LDF_COLLIDE);
 			next = pos;
-			page = ll_get_dir_page(inode, op_data, pos,
-					       partial_readdir_rc);
+			page = ll_get_dir_page(inode, op_data, pos, mrinfo);
 		}
 	}
 #ifdef HAVE_DIR_CONTEXT
@@ -329,8 +332,9 @@ static int ll_readdir(struct file *filp, void *cookie, filldir_t filldir)
 	struct md_op_data *op_data;
 	struct lu_fid pfid = { 0 };
 	ktime_t kstart = ktime_get();
-	/* result of possible partial readdir */
-	int partial_readdir_rc = 0;
+	/* result of possible partial readdir, and readdir statistics */
+	struct md_readdir_info mrinfo = {
+					.mr_blocking_ast = ll_md_blocking_ast };
 	__u64 pos;
 	int rc;
 
@@ -396,15 +400,17 @@ static int ll_readdir(struct file *filp, void *cookie, filldir_t filldir)
 
 #ifdef HAVE_DIR_CONTEXT
 	ctx->pos = pos;
-	rc = ll_dir_read(inode, &pos, op_data, ctx, &partial_readdir_rc);
+	rc = ll_dir_read(inode, &pos, op_data, ctx, &mrinfo);
 	pos = ctx->pos;
 #else
-	rc = ll_dir_read(inode, &pos, op_data, cookie, filldir,
-			 &partial_readdir_rc);
+	rc = ll_dir_read(inode, &pos, op_data, cookie, filldir, &mrinfo);
 #endif
 	lfd->lfd_pos = pos;
 	if (!lfd->fd_partial_readdir_rc)
-		lfd->fd_partial_readdir_rc = partial_readdir_rc;
+		lfd->fd_partial_readdir_rc = mrinfo.mr_partial_readdir_rc;
+	lfd->fd_readdir_pages += mrinfo.mr_pages;
+	lfd->fd_readdir_wait_us += mrinfo.mr_wait_us;
+	lfd->fd_readdir_us += ktime_us_delta(ktime_get(), kstart);
 
 	if (pos == MDS_DIR_END_OFF) {
 		if (api32)
@@ -2079,6 +2085,8 @@ out_quotactl:
 		RETURN(ll_fid2path(inode, (void __user *)arg));
 	case LL_IOC_GETPARENT:
 		RETURN(ll_getparent(file, (void __user *)arg));
+	case LL_IOC_HEAT_TOP:
+		RETURN(ll_ioctl_heat_top(inode, arg));
 	case LL_IOC_FID2MDTIDX: {
 		struct obd_export *exp = ll_i2mdexp(inode);
 		struct lu_fid	  fid;
@@ -2400,8 +2408,20 @@ static int ll_dir_open(struct inode *inode, struct file *file)
 
 static int ll_dir_release(struct inode *inode, struct file *file)
 {
-        ENTRY;
-        RETURN(ll_file_release(inode, file));
+	struct ll_file_data *lfd = file->private_data;
+
+	ENTRY;
+
+	if (lfd && lfd->fd_readdir_pages)
+		CDEBUG(D_INFO,
+		       "readdir "DFID": %llu pages in %llu us (%llu pages/s), %llu us waiting for pages\n",
+		       PFID(ll_inode2fid(inode)), lfd->fd_readdir_pages,
+		       lfd->fd_readdir_us,
+		       div64_u64(lfd->fd_readdir_pages * USEC_PER_SEC,
+				 max_t(__u64, lfd->fd_readdir_us, 1)),
+		       lfd->fd_readdir_wait_us);
+
+	RETURN(ll_file_release(inode, file));
 }
 
 /* notify error if partially read striped directory */
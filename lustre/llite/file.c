@@ -44,6 +44,7 @@
 #include <linux/uidgid.h>
 #include <linux/falloc.h>
 #include <linux/ktime.h>
+#include <linux/sort.h>
 
 #include <uapi/linux/lustre/lustre_ioctl.h>
 #include <lustre_swab.h>
@@ -601,6 +602,11 @@ void ll_dom_finish_open(struct inode *inode, struct ptlrpc_request *req)
 		index++;
 	} while (rnb->rnb_len > (index << PAGE_SHIFT));
 
+	/* data installed from the open reply will not need a separate BRW */
+	if (index)
+		ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_INLINE_READ_BYTES,
+				   min_t(unsigned int, rnb->rnb_len,
+					 index << PAGE_SHIFT));
 out_io:
 	cl_io_fini(env, io);
 	cl_env_put(env, &refcheck);
@@ -1595,6 +1601,379 @@ void ll_io_init(struct cl_io *io, struct file *file, enum cl_io_type iot,
 	ll_io_set_mirror(io, file);
 }
 
+static inline __u64 ll_heat_score(struct obd_heat_instance *heat,
+				  __u64 now, struct ll_sb_info *sbi)
+{
+	return obd_heat_get(&heat[OBD_HEAT_READSAMPLE], now,
+			    sbi->ll_heat_decay_weight,
+			    sbi->ll_heat_period_second) +
+	       obd_heat_get(&heat[OBD_HEAT_WRITESAMPLE], now,
+			    sbi->ll_heat_decay_weight,
+			    sbi->ll_heat_period_second);
+}
+
+static inline spinlock_t *ll_heat_top_bucket(struct ll_heat_top *top,
+					     unsigned int slot)
+{
+	return &top->lht_bucket_lock[slot % LL_HEAT_TOP_BUCKETS];
+}
+
+/* find the coldest entry of the hot file table, called with lht_lock held */
+static void ll_heat_top_find_min(struct ll_heat_top *top)
+{
+	unsigned int i;
+	__u64 score;
+
+	top->lht_min = 0;
+	top->lht_min_score = top->lht_count ?
+			     READ_ONCE(top->lht_entries[0].lhte_score) : 0;
+	for (i = 1; i < top->lht_count; i++) {
+		/* entries in the table are updated under their bucket lock */
+		score = READ_ONCE(top->lht_entries[i].lhte_score);
+		if (score < top->lht_min_score) {
+			top->lht_min = i;
+			top->lht_min_score = score;
+		}
+	}
+}
+
+/* decay all the entries once per heat period, called with lht_lock held */
+static void ll_heat_top_decay(struct ll_sb_info *sbi, __u64 now)
+{
+	struct ll_heat_top *top = &sbi->ll_heat_top;
+	struct ll_heat_top_entry *entry;
+	unsigned int i;
+
+	for (i = 0; i < top->lht_count; i++) {
+		entry = &top->lht_entries[i];
+		spin_lock(ll_heat_top_bucket(top, i));
+		entry->lhte_score = ll_heat_score(entry->lhte_heat, now, sbi);
+		spin_unlock(ll_heat_top_bucket(top, i));
+	}
+	ll_heat_top_find_min(top);
+	WRITE_ONCE(top->lht_decay_time, now);
+}
+
+/*
+ * Return the slot of \a lli in the hot file table. Only the slot recorded
+ * in the inode is checked: a file whose entry was taken by a hotter one, or
+ * whose inode was reclaimed, gets a new entry, and the stale entries are
+ * dropped when the table is read. Called with lht_lock held.
+ */
+static unsigned int ll_heat_top_lookup(struct ll_heat_top *top,
+				       struct ll_inode_info *lli)
+{
+	unsigned int slot = READ_ONCE(lli->lli_heat_top_slot);
+
+	if (slot < top->lht_count &&
+	    lu_fid_eq(&top->lht_entries[slot].lhte_fid, &lli->lli_fid))
+		return slot;
+
+	return LL_HEAT_TOP_NONE;
+}
+
+/*
+ * Update the entry of \a lli in place with only its bucket locked.
+ *
+ * \retval 1 if the coldest entry has to be found again
+ * \retval 0 if the entry was updated
+ * \retval -ENOENT if \a lli has no entry in the table
+ */
+static int ll_heat_top_update_entry(struct ll_heat_top *top,
+				    struct ll_inode_info *lli,
+				    unsigned int slot,
+				    struct obd_heat_instance *heat,
+				    __u64 score)
+{
+	struct ll_heat_top_entry *entries;
+	int rc = -ENOENT;
+
+	spin_lock(ll_heat_top_bucket(top, slot));
+	entries = READ_ONCE(top->lht_entries);
+	/* pairs with smp_wmb() in ll_heat_top_resize() */
+	smp_rmb();
+	if (entries && slot < READ_ONCE(top->lht_count) &&
+	    lu_fid_eq(&entries[slot].lhte_fid, &lli->lli_fid)) {
+		memcpy(entries[slot].lhte_heat, heat,
+		       sizeof(entries[slot].lhte_heat));
+		WRITE_ONCE(entries[slot].lhte_score, score);
+		rc = slot == READ_ONCE(top->lht_min) ||
+		     score < READ_ONCE(top->lht_min_score);
+	}
+	spin_unlock(ll_heat_top_bucket(top, slot));
+
+	return rc;
+}
+
+/**
+ * Update the hot file table with the new heat of a file.
+ *
+ * Files already in the table are updated in place under the lock of their
+ * bucket only. Other files only get in if they are hotter than the coldest
+ * file of a full table, which is checked without the lock first.
+ */
+static void ll_heat_top_update(struct ll_sb_info *sbi,
+			       struct ll_inode_info *lli,
+			       struct obd_heat_instance *heat,
+			       __u64 score, __u64 now)
+{
+	struct ll_heat_top *top = &sbi->ll_heat_top;
+	struct ll_heat_top_entry *entry;
+	unsigned int slot;
+	int rc;
+
+	if (READ_ONCE(top->lht_size) == 0)
+		return;
+
+	slot = READ_ONCE(lli->lli_heat_top_slot);
+	if (now < READ_ONCE(top->lht_decay_time) + sbi->ll_heat_period_second) {
+		if (slot != LL_HEAT_TOP_NONE) {
+			rc = ll_heat_top_update_entry(top, lli, slot, heat,
+						      score);
+			if (rc == 0)
+				return;
+			if (rc < 0)
+				WRITE_ONCE(lli->lli_heat_top_slot,
+					   LL_HEAT_TOP_NONE);
+		} else if (READ_ONCE(top->lht_count) ==
+			   READ_ONCE(top->lht_size) &&
+			   score <= READ_ONCE(top->lht_min_score)) {
+			return;
+		}
+	}
+
+	spin_lock(&top->lht_lock);
+	if (now >= top->lht_decay_time + sbi->ll_heat_period_second)
+		ll_heat_top_decay(sbi, now);
+
+	slot = ll_heat_top_lookup(top, lli);
+	if (slot == LL_HEAT_TOP_NONE) {
+		if (top->lht_count < top->lht_size)
+			slot = top->lht_count;
+		else if (top->lht_size && score > top->lht_min_score)
+			slot = top->lht_min;
+	}
+	WRITE_ONCE(lli->lli_heat_top_slot, slot);
+	if (slot == LL_HEAT_TOP_NONE)
+		goto out_unlock;
+
+	entry = &top->lht_entries[slot];
+	spin_lock(ll_heat_top_bucket(top, slot));
+	entry->lhte_fid = lli->lli_fid;
+	memcpy(entry->lhte_heat, heat, sizeof(entry->lhte_heat));
+	entry->lhte_score = score;
+	if (slot == top->lht_count)
+		WRITE_ONCE(top->lht_count, slot + 1);
+	spin_unlock(ll_heat_top_bucket(top, slot));
+
+	if (slot == top->lht_min || score < top->lht_min_score ||
+	    top->lht_count == 1)
+		ll_heat_top_find_min(top);
+out_unlock:
+	spin_unlock(&top->lht_lock);
+}
+
+/* remove a file from the hot file table, after its heat was cleared */
+static void ll_heat_top_del(struct ll_sb_info *sbi, struct ll_inode_info *lli)
+{
+	struct ll_heat_top *top = &sbi->ll_heat_top;
+	unsigned int slot;
+
+	if (READ_ONCE(lli->lli_heat_top_slot) == LL_HEAT_TOP_NONE)
+		return;
+
+	spin_lock(&top->lht_lock);
+	slot = ll_heat_top_lookup(top, lli);
+	if (slot != LL_HEAT_TOP_NONE) {
+		/* leave an empty slot, the coldest one, for the next file */
+		spin_lock(ll_heat_top_bucket(top, slot));
+		memset(&top->lht_entries[slot], 0,
+		       sizeof(top->lht_entries[slot]));
+		spin_unlock(ll_heat_top_bucket(top, slot));
+		ll_heat_top_find_min(top);
+	}
+	WRITE_ONCE(lli->lli_heat_top_slot, LL_HEAT_TOP_NONE);
+	spin_unlock(&top->lht_lock);
+}
+
+/**
+ * Resize the hot file table to \a size entries, 0 disables it. The table
+ * is emptied.
+ */
+int ll_heat_top_resize(struct ll_sb_info *sbi, unsigned int size)
+{
+	struct ll_heat_top *top = &sbi->ll_heat_top;
+	struct ll_heat_top_entry *entries = NULL;
+	struct ll_heat_top_entry *old;
+	unsigned int old_size;
+	unsigned int i;
+
+	if (size > LL_HEAT_TOP_MAX)
+		return -ERANGE;
+
+	if (size) {
+		OBD_ALLOC_PTR_ARRAY_LARGE(entries, size);
+		if (entries == NULL)
+			return -ENOMEM;
+	}
+
+	spin_lock(&top->lht_lock);
+	old = top->lht_entries;
+	old_size = top->lht_size;
+	WRITE_ONCE(top->lht_count, 0);
+	/* pairs with smp_rmb() in ll_heat_top_update_entry() */
+	smp_wmb();
+	WRITE_ONCE(top->lht_entries, entries);
+	WRITE_ONCE(top->lht_size, size);
+	top->lht_min = 0;
+	top->lht_min_score = 0;
+	top->lht_decay_time = ktime_get_real_seconds();
+	spin_unlock(&top->lht_lock);
+
+	/* wait for the in place updates still using the old entries */
+	for (i = 0; i < LL_HEAT_TOP_BUCKETS; i++) {
+		spin_lock(&top->lht_bucket_lock[i]);
+		spin_unlock(&top->lht_bucket_lock[i]);
+	}
+
+	if (old)
+		OBD_FREE_PTR_ARRAY_LARGE(old, old_size);
+
+	return 0;
+}
+
+void ll_heat_top_fini(struct ll_sb_info *sbi)
+{
+	ll_heat_top_resize(sbi, 0);
+}
+
+/* order by FID, hottest first for the same FID */
+static int ll_heat_top_fid_cmp(const void *a, const void *b)
+{
+	const struct ll_heat_top_entry *ea = a;
+	const struct ll_heat_top_entry *eb = b;
+	int rc;
+
+	rc = lu_fid_cmp(&ea->lhte_fid, &eb->lhte_fid);
+	if (rc || ea->lhte_score == eb->lhte_score)
+		return rc;
+
+	return ea->lhte_score > eb->lhte_score ? -1 : 1;
+}
+
+static int ll_heat_top_cmp(const void *a, const void *b)
+{
+	const struct ll_heat_top_entry *ea = a;
+	const struct ll_heat_top_entry *eb = b;
+
+	if (ea->lhte_score == eb->lhte_score)
+		return 0;
+
+	return ea->lhte_score > eb->lhte_score ? -1 : 1;
+}
+
+/**
+ * Get up to \a count of the hottest files of the mount, hottest first, with
+ * their heat decayed to the current time. Empty slots and the stale entries
+ * of files which got a new entry are dropped here.
+ *
+ * \retval number of entries filled in \a top
+ * \retval negative errno on failure
+ */
+int ll_heat_top_get(struct ll_sb_info *sbi, struct lu_heat_top_entry *top,
+		    unsigned int count)
+{
+	struct ll_heat_top *table = &sbi->ll_heat_top;
+	struct ll_heat_top_entry *entries;
+	__u64 now = ktime_get_real_seconds();
+	unsigned int size = READ_ONCE(table->lht_size);
+	unsigned int nr;
+	unsigned int i;
+	unsigned int k;
+	int j;
+
+	if (size == 0 || count == 0)
+		return 0;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(entries, size);
+	if (entries == NULL)
+		return -ENOMEM;
+
+	spin_lock(&table->lht_lock);
+	nr = min(table->lht_count, size);
+	for (i = 0; i < nr; i++) {
+		spin_lock(ll_heat_top_bucket(table, i));
+		entries[i] = table->lht_entries[i];
+		spin_unlock(ll_heat_top_bucket(table, i));
+	}
+	spin_unlock(&table->lht_lock);
+
+	for (i = 0; i < nr; i++)
+		entries[i].lhte_score = ll_heat_score(entries[i].lhte_heat,
+						      now, sbi);
+
+	/* keep the hottest entry of each file */
+	sort(entries, nr, sizeof(*entries), ll_heat_top_fid_cmp, NULL);
+	for (i = 0, k = 0; i < nr; i++) {
+		if (fid_is_zero(&entries[i].lhte_fid))
+			continue;
+		if (k > 0 && lu_fid_eq(&entries[i].lhte_fid,
+				       &entries[k - 1].lhte_fid))
+			continue;
+		entries[k++] = entries[i];
+	}
+	nr = k;
+	sort(entries, nr, sizeof(*entries), ll_heat_top_cmp, NULL);
+
+	nr = min(nr, count);
+	for (i = 0; i < nr; i++) {
+		top[i].lhte_fid = entries[i].lhte_fid;
+		for (j = 0; j < OBD_HEAT_COUNT; j++)
+			top[i].lhte_heat[j] =
+				obd_heat_get(&entries[i].lhte_heat[j], now,
+					     sbi->ll_heat_decay_weight,
+					     sbi->ll_heat_period_second);
+	}
+	OBD_FREE_PTR_ARRAY_LARGE(entries, size);
+
+	return nr;
+}
+
+int ll_ioctl_heat_top(struct inode *inode, unsigned long arg)
+{
+	struct lu_heat_top __user *utop = (void __user *)arg;
+	struct lu_heat_top *top;
+	struct lu_heat_top head;
+	size_t size;
+	int rc;
+
+	ENTRY;
+	if (!capable(CAP_SYS_ADMIN))
+		RETURN(-EPERM);
+
+	if (copy_from_user(&head, utop, sizeof(head)))
+		RETURN(-EFAULT);
+
+	head.lht_count = min_t(__u32, head.lht_count, LL_HEAT_TOP_MAX);
+	size = offsetof(typeof(*top), lht_entries[head.lht_count]);
+	OBD_ALLOC_LARGE(top, size);
+	if (top == NULL)
+		RETURN(-ENOMEM);
+
+	rc = ll_heat_top_get(ll_i2sbi(inode), top->lht_entries,
+			     head.lht_count);
+	if (rc < 0)
+		GOTO(out_free, rc);
+
+	top->lht_count = rc;
+	size = offsetof(typeof(*top), lht_entries[top->lht_count]);
+	rc = copy_to_user(utop, top, size) ? -EFAULT : 0;
+out_free:
+	OBD_FREE_LARGE(top, offsetof(typeof(*top),
+				     lht_entries[head.lht_count]));
+	RETURN(rc);
+}
+
 static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
 			__u64 count)
 {
@@ -1602,7 +1981,9 @@ static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
 	struct ll_sb_info *sbi = ll_i2sbi(inode);
 	enum obd_heat_type sample_type;
 	enum obd_heat_type iobyte_type;
+	struct obd_heat_instance heat[OBD_HEAT_COUNT];
 	__u64 now = ktime_get_real_seconds();
+	__u64 score;
 
 	if (!ll_sbi_has_file_heat(sbi) ||
 	    lli->lli_heat_flags & LU_HEAT_FLAG_OFF)
@@ -1623,7 +2004,11 @@ static void ll_heat_add(struct inode *inode, enum cl_io_type iot,
 		     sbi->ll_heat_decay_weight, sbi->ll_heat_period_second);
 	obd_heat_add(&lli->lli_heat_instances[iobyte_type], now, count,
 		     sbi->ll_heat_decay_weight, sbi->ll_heat_period_second);
+	score = ll_heat_score(lli->lli_heat_instances, now, sbi);
+	memcpy(heat, lli->lli_heat_instances, sizeof(heat));
 	spin_unlock(&lli->lli_heat_lock);
+
+	ll_heat_top_update(sbi, lli, heat, score, now);
 }
 
 static ssize_t
@@ -1970,7 +2355,21 @@ static ssize_t ll_file_read_iter(struct kiocb *iocb, struct iov_iter *to)
 	if (cached)
 		GOTO(out, result);
 
-	ll_ras_enter(file, iocb->ki_pos, iov_iter_count(to));
+	if (iov_iter_is_pipe(to)) {
+		size_t count = iov_iter_count(to);
+
+		/* a splice can only read as much as the pipe has room for,
+		 * feed that to the pattern detector and use the full length
+		 * to size the readahead window
+		 */
+		ll_ras_enter(file, iocb->ki_pos,
+			     min_t(size_t, count,
+				   (size_t)iov_iter_npages(to, INT_MAX) <<
+				   PAGE_SHIFT));
+		ll_ras_splice_window(file, iocb->ki_pos, count);
+	} else {
+		ll_ras_enter(file, iocb->ki_pos, iov_iter_count(to));
+	}
 
 	result = ll_do_fast_read(iocb, to);
 	if (result < 0 || iov_iter_count(to) == 0)
@@ -1999,6 +2398,9 @@ out:
 				  READ);
 		ll_stats_ops_tally(ll_i2sbi(file_inode(file)), LPROC_LL_READ,
 				   ktime_us_delta(ktime_get(), kstart));
+		if (!cached)
+			pcc_stats_tally(file_inode(file), PCC_STATS_READ_MISS,
+					result);
 	}
 
 	CDEBUG(D_IOTRACE,
@@ -2302,6 +2704,52 @@ static ssize_t ll_file_write(struct file *file, const char __user *buf,
 }
 #endif /* !HAVE_FILE_OPERATIONS_READ_WRITE_ITER */
 
+#ifdef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
+/*
+ * default_file_splice_read() reads through ->read() into newly allocated
+ * pages and copies them into the pipe. Pages already cached under a DLM
+ * lock are instead spliced to the pipe by reference through the fast read
+ * path of ll_readpage(), without any cl_io setup, and only a cache miss
+ * takes the copying path, whose readahead fills the cache for the next call.
+ */
+static ssize_t ll_file_splice_read(struct file *in_file, loff_t *ppos,
+				   struct pipe_inode_info *pipe, size_t count,
+				   unsigned int flags)
+{
+	struct inode *inode = file_inode(in_file);
+	struct ll_sb_info *sbi = ll_i2sbi(inode);
+	bool cached;
+	ssize_t result;
+
+	ENTRY;
+
+	result = pcc_file_splice_read(in_file, ppos, pipe, count, flags,
+				      &cached);
+	if (cached)
+		RETURN(result);
+
+	ll_ras_splice_window(in_file, *ppos, count);
+
+	if (ll_sbi_has_fast_read(sbi) && !(in_file->f_flags & O_DIRECT)) {
+		result = generic_file_splice_read(in_file, ppos, pipe, count,
+						  flags);
+		if (result > 0) {
+			ll_heat_add(inode, CIT_READ, result);
+			ll_stats_ops_tally(sbi, LPROC_LL_READ_BYTES, result);
+			pcc_stats_tally(inode, PCC_STATS_READ_MISS, result);
+			RETURN(result);
+		}
+		/* -ENODATA: the first page is not cached, see ll_readpage().
+		 * 0 may come from a stale i_size, let the slow path glimpse.
+		 */
+		if (result < 0 && result != -ENODATA)
+			RETURN(result);
+	}
+
+	RETURN(default_file_splice_read(in_file, ppos, pipe, count, flags));
+}
+#endif /* HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT */
+
 int ll_lov_setstripe_ea_info(struct inode *inode, struct dentry *dentry,
 			     __u64 flags, struct lov_user_md *lum, int lum_size)
 {
@@ -3901,6 +4349,9 @@ static int ll_heat_set(struct inode *inode, enum lu_heat_flag flags)
 
 	spin_unlock(&lli->lli_heat_lock);
 
+	if (flags & LU_HEAT_FLAG_CLEAR)
+		ll_heat_top_del(ll_i2sbi(inode), lli);
+
 	RETURN(rc);
 }
 
@@ -4338,6 +4789,8 @@ out_ladvise:
 		rc = ll_heat_set(inode, flags);
 		RETURN(rc);
 	}
+	case LL_IOC_HEAT_TOP:
+		RETURN(ll_ioctl_heat_top(inode, arg));
 	case LL_IOC_PCC_DETACH: {
 		struct lu_pcc_detach *detach;
 
@@ -4617,23 +5070,20 @@ int ll_fsync(struct file *file, loff_t start, loff_t end, int datasync)
 	       "VFS Op:inode="DFID"(%p), start %lld, end %lld, datasync %d\n",
 	       PFID(ll_inode2fid(inode)), inode, start, end, datasync);
 
-	/* fsync's caller has already called _fdata{sync,write}, we want
-	 * that IO to finish before calling the osc and mdc sync methods */
-	rc = filemap_write_and_wait_range(inode->i_mapping, start, end);
-
-	/* catch async errors that were recorded back when async writeback
-	 * failed for pages in this mapping. */
-	if (!S_ISDIR(inode->i_mode)) {
-		err = lli->lli_async_rc;
-		lli->lli_async_rc = 0;
-		if (rc == 0)
-			rc = err;
-		if (lli->lli_clob != NULL) {
-			err = lov_read_and_clear_async_rc(lli->lli_clob);
-			if (rc == 0)
-				rc = err;
-		}
-	}
+	/* For regular files only start writeback of the dirty pages here,
+	 * like ll_writepages() does for WB_SYNC_NONE, so the MDS sync below
+	 * is sent while they are written. filemap_fdatawrite_range() would
+	 * wait for them in osc_cache_wait_range() as it uses WB_SYNC_ALL.
+	 * The CL_FSYNC_ALL io then waits for the pages of each stripe and
+	 * sends its OST_SYNC. Pages are waited for again before checking
+	 * for errors. */
+	if (S_ISREG(inode->i_mode)) {
+		rc = cl_sync_file_range(inode, start, end, CL_FSYNC_NONE, 0);
+		if (rc > 0)
+			rc = 0;
+	} else
+		rc = filemap_write_and_wait_range(inode->i_mapping, start,
+						  end);
 
 	err = md_fsync(ll_i2sbi(inode)->ll_md_exp, ll_inode2fid(inode), &req);
 	if (!rc)
@@ -4642,7 +5092,6 @@ int ll_fsync(struct file *file, loff_t start, loff_t end, int datasync)
 		ptlrpc_req_finished(req);
 
 	if (S_ISREG(inode->i_mode)) {
-		struct ll_file_data *fd = file->private_data;
 		bool cached;
 
 		/* Sync metadata on MDT first, and then sync the cached data
@@ -4654,6 +5103,29 @@ int ll_fsync(struct file *file, loff_t start, loff_t end, int datasync)
 						 CL_FSYNC_ALL, 0);
 		if (rc == 0 && err < 0)
 			rc = err;
+
+		err = filemap_fdatawait_range(inode->i_mapping, start, end);
+		if (rc == 0)
+			rc = err;
+	}
+
+	/* catch async errors that were recorded back when async writeback
+	 * failed for pages in this mapping. */
+	if (!S_ISDIR(inode->i_mode)) {
+		err = lli->lli_async_rc;
+		lli->lli_async_rc = 0;
+		if (rc == 0)
+			rc = err;
+		if (lli->lli_clob != NULL) {
+			err = lov_read_and_clear_async_rc(lli->lli_clob);
+			if (rc == 0)
+				rc = err;
+		}
+	}
+
+	if (S_ISREG(inode->i_mode)) {
+		struct ll_file_data *fd = file->private_data;
+
 		if (rc < 0)
 			fd->fd_write_failed = true;
 		else
@@ -5628,7 +6100,7 @@ static const struct file_operations ll_file_operations = {
 #ifndef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
 	.splice_read	= generic_file_splice_read,
 #else
-	.splice_read	= pcc_file_splice_read,
+	.splice_read	= ll_file_splice_read,
 #endif
 	.fsync		= ll_fsync,
 	.flush		= ll_flush,
@@ -5657,7 +6129,7 @@ static const struct file_operations ll_file_operations_flock = {
 #ifndef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
 	.splice_read	= generic_file_splice_read,
 #else
-	.splice_read	= pcc_file_splice_read,
+	.splice_read	= ll_file_splice_read,
 #endif
 	.fsync		= ll_fsync,
 	.flush		= ll_flush,
@@ -5689,7 +6161,7 @@ static const struct file_operations ll_file_operations_noflock = {
 #ifndef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
 	.splice_read	= generic_file_splice_read,
 #else
-	.splice_read	= pcc_file_splice_read,
+	.splice_read	= ll_file_splice_read,
 #endif
 	.fsync		= ll_fsync,
 	.flush		= ll_flush,
@@ -207,6 +207,8 @@ struct ll_inode_info {
 			spinlock_t			lli_heat_lock;
 			__u32				lli_heat_flags;
 			struct obd_heat_instance	lli_heat_instances[OBD_HEAT_COUNT];
+			/* slot in ll_heat_top, only a hint */
+			unsigned int			lli_heat_top_slot;
 
 			/*
 			 * Whenever a process try to read/write the file, the
@@ -527,6 +529,9 @@ static inline struct pcc_inode *ll_i2pcci(struct inode *inode)
 /* Min range pages */
 #define RA_MIN_MMAP_RANGE_PAGES			16UL
 
+/* default read-around pages for a page fault cache miss, 0 is disabled */
+#define SBI_DEFAULT_RA_FAULT_PAGES		0UL
+
 enum ra_stat {
         RA_STAT_HIT = 0,
         RA_STAT_MISS,
@@ -544,6 +549,8 @@ enum ra_stat {
 	RA_STAT_ASYNC,
 	RA_STAT_FAILED_FAST_READ,
 	RA_STAT_MMAP_RANGE_READ,
+	RA_STAT_MMAP_FAULT_READ,
+	RA_STAT_SPLICE_WINDOW,
 	_NR_RA_STAT,
 };
 
@@ -552,6 +559,8 @@ struct ll_ra_info {
 	unsigned long	ra_max_pages;
 	unsigned long	ra_max_pages_per_file;
 	unsigned long	ra_range_pages;
+	/* pages read around the faulting page under the fault lock */
+	unsigned long	ra_fault_pages;
 	unsigned long	ra_max_read_ahead_whole_pages;
 	struct workqueue_struct  *ll_readahead_wq;
 	/*
@@ -672,6 +681,54 @@ struct lustre_client_ocd {
 	struct obd_export	*lco_dt_exp;
 };
 
+/* phases of client mount, timed in ll_fill_super() */
+enum ll_mount_phase {
+	LL_MOUNT_CONFIG_LOG = 0,	/* config llog processing, OBD setup */
+	LL_MOUNT_MD_CONNECT,		/* MDT connect and statfs */
+	LL_MOUNT_DT_CONNECT,		/* OST connect */
+	LL_MOUNT_ROOT,			/* root FID lookup and getattr */
+	LL_MOUNT_PHASE_NR
+};
+
+/* lli_heat_top_slot of a file not in the hot file table */
+#define LL_HEAT_TOP_NONE	UINT_MAX
+/* default and maximum number of files in the hot file table */
+#define LL_HEAT_TOP_DEFAULT	128
+#define LL_HEAT_TOP_MAX		16384
+
+struct ll_heat_top_entry {
+	struct lu_fid			lhte_fid;
+	struct obd_heat_instance	lhte_heat[OBD_HEAT_COUNT];
+	/* read and write sample heat at the last update or decay */
+	__u64				lhte_score;
+};
+
+/* number of locks protecting the entries of the hot file table */
+#define LL_HEAT_TOP_BUCKETS	16
+
+/*
+ * The hottest files of a mount. The table is unsorted, and only the slot
+ * and score of the coldest entry are tracked, so that a file which is not
+ * hot enough to get in is rejected without taking lht_lock. All entries
+ * are decayed at once every heat period.
+ *
+ * Entries never move, a removed file leaves an empty slot behind. A file
+ * already in the table is updated with only the lock of its bucket held.
+ * lht_lock serializes the changes of which file is in which slot, and
+ * nests outside the bucket locks.
+ */
+struct ll_heat_top {
+	spinlock_t		  lht_lock;
+	/* slot i is protected by lht_bucket_lock[i % LL_HEAT_TOP_BUCKETS] */
+	spinlock_t		  lht_bucket_lock[LL_HEAT_TOP_BUCKETS];
+	unsigned int		  lht_size;	/* allocated entries */
+	unsigned int		  lht_count;	/* used entries */
+	unsigned int		  lht_min;	/* slot of the coldest entry */
+	__u64			  lht_min_score;
+	__u64			  lht_decay_time;
+	struct ll_heat_top_entry *lht_entries;
+};
+
 struct ll_sb_info {
 	/* this protects pglist and ra_info.  It isn't safe to
 	 * grab from interrupt contexts */
@@ -755,6 +812,7 @@ struct ll_sb_info {
 	/* File heat */
 	unsigned int		  ll_heat_decay_weight;
 	unsigned int		  ll_heat_period_second;
+	struct ll_heat_top	  ll_heat_top;
 
 	/* Opens of the same inode before we start requesting open lock */
 	u32			  ll_oc_thrsh_count;
@@ -785,8 +843,23 @@ struct ll_sb_info {
 	struct ll_foreign_symlink_upcall_item *ll_foreign_symlink_upcall_items;
 	/* foreign symlink path upcall nb infos */
 	unsigned int		  ll_foreign_symlink_upcall_nb_items;
+
+	/* time spent in each phase of mount, in usec */
+	s64			  ll_mount_phase_us[LL_MOUNT_PHASE_NR];
 };
 
+/* account the time elapsed since \a start to mount \a phase, and restart
+ * \a start for the next phase */
+static inline void ll_mount_phase_done(struct ll_sb_info *sbi,
+				       enum ll_mount_phase phase,
+				       ktime_t *start)
+{
+	ktime_t now = ktime_get();
+
+	sbi->ll_mount_phase_us[phase] = ktime_us_delta(now, *start);
+	*start = now;
+}
+
 #define SBI_DEFAULT_HEAT_DECAY_WEIGHT	((80 * 256 + 50) / 100)
 #define SBI_DEFAULT_HEAT_PERIOD_SECOND	(60)
 
@@ -926,6 +999,12 @@ struct ll_file_data {
 	 * -errno is saved here, and will return to user in close().
 	 */
 	int fd_partial_readdir_rc;
+	/* readdir of this directory: pages read, time spent in readdir and
+	 * time of that spent waiting for directory pages
+	 */
+	__u64 fd_readdir_pages;
+	__u64 fd_readdir_us;
+	__u64 fd_readdir_wait_us;
 };
 
 void llite_tunables_unregister(void);
@@ -988,6 +1067,7 @@ static inline bool ll_sbi_has_parallel_dio(struct ll_sb_info *sbi)
 }
 
 void ll_ras_enter(struct file *f, loff_t pos, size_t count);
+void ll_ras_splice_window(struct file *f, loff_t pos, size_t count);
 
 /* llite/lcommon_misc.c */
 int cl_ocd_update(struct obd_device *host, struct obd_device *watched,
@@ -1005,6 +1085,7 @@ void ll_free_rw_stats_info(struct ll_sb_info *sbi);
 enum {
 	LPROC_LL_READ_BYTES,
 	LPROC_LL_WRITE_BYTES,
+	LPROC_LL_INLINE_READ_BYTES,
 	LPROC_LL_READ,
 	LPROC_LL_WRITE,
 	LPROC_LL_IOCTL,
@@ -1012,6 +1093,8 @@ enum {
 	LPROC_LL_RELEASE,
 	LPROC_LL_MMAP,
 	LPROC_LL_FAULT,
+	LPROC_LL_FAULT_PAGES,
+	LPROC_LL_MAP_PAGES,
 	LPROC_LL_MKWRITE,
 	LPROC_LL_LLSEEK,
 	LPROC_LL_FSYNC,
@@ -1050,15 +1133,16 @@ extern const struct file_operations ll_dir_operations;
 extern const struct inode_operations ll_dir_inode_operations;
 #ifdef HAVE_DIR_CONTEXT
 int ll_dir_read(struct inode *inode, __u64 *pos, struct md_op_data *op_data,
-		struct dir_context *ctx, int *partial_readdir_rc);
+		struct dir_context *ctx, struct md_readdir_info *mrinfo);
 #else
 int ll_dir_read(struct inode *inode, __u64 *pos, struct md_op_data *op_data,
-		void *cookie, filldir_t filldir, int *partial_readdir_rc);
+		void *cookie, filldir_t filldir,
+		struct md_readdir_info *mrinfo);
 #endif
 int ll_get_mdt_idx(struct inode *inode);
 int ll_get_mdt_idx_by_fid(struct ll_sb_info *sbi, const struct lu_fid *fid);
 struct page *ll_get_dir_page(struct inode *dir, struct md_op_data *op_data,
-			      __u64 offset, int *partial_readdir_rc);
+			      __u64 offset, struct md_readdir_info *mrinfo);
 void ll_release_page(struct inode *inode, struct page *page, bool remove);
 int quotactl_ioctl(struct super_block *sb, struct if_quotactl *qctl);
 
@@ -1158,6 +1242,11 @@ int ll_ioctl_fssetxattr(struct inode *inode, unsigned int cmd,
 			unsigned long arg);
 int ll_ioctl_project(struct file *file, unsigned int cmd,
 		     unsigned long arg);
+int ll_heat_top_resize(struct ll_sb_info *sbi, unsigned int size);
+void ll_heat_top_fini(struct ll_sb_info *sbi);
+int ll_heat_top_get(struct ll_sb_info *sbi, struct lu_heat_top_entry *top,
+		    unsigned int count);
+int ll_ioctl_heat_top(struct inode *inode, unsigned long arg);
 
 int ll_lov_setstripe_ea_info(struct inode *inode, struct dentry *dentry,
 			     __u64 flags, struct lov_user_md *lum,
@@ -92,6 +92,7 @@ static struct ll_sb_info *ll_init_sbi(void)
 	unsigned long pages;
 	unsigned long lru_page_max;
 	struct sysinfo si;
+	int i;
 	int rc;
 
 	ENTRY;
@@ -155,6 +156,7 @@ static struct ll_sb_info *ll_init_sbi(void)
 	sbi->ll_ra_info.ra_async_pages_per_file_threshold =
 				sbi->ll_ra_info.ra_max_pages_per_file;
 	sbi->ll_ra_info.ra_range_pages = SBI_DEFAULT_RA_RANGE_PAGES;
+	sbi->ll_ra_info.ra_fault_pages = SBI_DEFAULT_RA_FAULT_PAGES;
 	sbi->ll_ra_info.ra_max_read_ahead_whole_pages = -1;
 	atomic_set(&sbi->ll_ra_info.ra_async_inflight, 0);
 
@@ -193,6 +195,11 @@ static struct ll_sb_info *ll_init_sbi(void)
 	/* Per-filesystem file heat */
 	sbi->ll_heat_decay_weight = SBI_DEFAULT_HEAT_DECAY_WEIGHT;
 	sbi->ll_heat_period_second = SBI_DEFAULT_HEAT_PERIOD_SECOND;
+	spin_lock_init(&sbi->ll_heat_top.lht_lock);
+	for (i = 0; i < LL_HEAT_TOP_BUCKETS; i++)
+		spin_lock_init(&sbi->ll_heat_top.lht_bucket_lock[i]);
+	if (ll_heat_top_resize(sbi, LL_HEAT_TOP_DEFAULT))
+		GOTO(out_destroy_ra, rc = -ENOMEM);
 
 	/* Per-fs open heat level before requesting open lock */
 	sbi->ll_oc_thrsh_count = SBI_DEFAULT_OPENCACHE_THRESHOLD_COUNT;
@@ -224,6 +231,7 @@ static void ll_free_sbi(struct super_block *sb)
 			cfs_free_nidlist(&sbi->ll_squash.rsi_nosquash_nids);
 		if (sbi->ll_ra_info.ll_readahead_wq)
 			destroy_workqueue(sbi->ll_ra_info.ll_readahead_wq);
+		ll_heat_top_fini(sbi);
 		if (sbi->ll_cache != NULL) {
 			cl_cache_decref(sbi->ll_cache);
 			sbi->ll_cache = NULL;
@@ -276,6 +284,7 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 	bool api32;
 	void *encctx;
 	int encctxlen;
+	ktime_t start = ktime_get();
 
 	ENTRY;
 	sbi->ll_md_obd = class_name2obd(md);
@@ -506,6 +515,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 		}
 	}
 
+	ll_mount_phase_done(sbi, LL_MOUNT_MD_CONNECT, &start);
+
 	sbi->ll_dt_obd = class_name2obd(dt);
 	if (!sbi->ll_dt_obd) {
 		CERROR("DT %s: not setup or attached\n", dt);
@@ -619,6 +630,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 	sbi->ll_lco.lco_dt_exp = sbi->ll_dt_exp;
 	mutex_unlock(&sbi->ll_lco.lco_lock);
 
+	ll_mount_phase_done(sbi, LL_MOUNT_DT_CONNECT, &start);
+
 	fid_zero(&sbi->ll_root_fid);
 	err = md_get_root(sbi->ll_md_exp, get_mount_fileset(sb),
 			   &sbi->ll_root_fid);
@@ -709,6 +722,8 @@ static int client_common_fill_super(struct super_block *sb, char *md, char *dt)
 	}
 	ptlrpc_req_finished(request);
 
+	ll_mount_phase_done(sbi, LL_MOUNT_ROOT, &start);
+
 	checksum = test_bit(LL_SBI_CHECKSUM, sbi->ll_flags);
 	if (sbi->ll_checksum_set) {
 		err = obd_set_info_async(NULL, sbi->ll_dt_exp,
@@ -907,6 +922,15 @@ void ll_kill_super(struct super_block *sb)
 		while (atomic_read(&sbi->ll_sa_running) > 0)
 			schedule_timeout_uninterruptible(
 				cfs_time_seconds(1) >> 3);
+
+		/* striped dir readdir lookahead holds stripe inodes, stop it
+		 * before generic_shutdown_super() evicts them
+		 */
+		if (sbi->ll_md_exp)
+			obd_set_info_async(NULL, sbi->ll_md_exp,
+					   sizeof(KEY_READDIR_AHEAD_STOP),
+					   KEY_READDIR_AHEAD_STOP, 0, NULL,
+					   NULL);
 	}
 
 	EXIT;
@@ -1201,6 +1225,7 @@ void ll_lli_init(struct ll_inode_info *lli)
 		spin_lock_init(&lli->lli_heat_lock);
 		obd_heat_clear(lli->lli_heat_instances, OBD_HEAT_COUNT);
 		lli->lli_heat_flags = 0;
+		lli->lli_heat_top_slot = LL_HEAT_TOP_NONE;
 		mutex_init(&lli->lli_pcc_lock);
 		lli->lli_pcc_state = PCC_STATE_FL_NONE;
 		lli->lli_pcc_inode = NULL;
@@ -1264,6 +1289,7 @@ int ll_fill_super(struct super_block *sb)
 	int md_len = 0;
 	int dt_len = 0;
 	uuid_t uuid;
+	ktime_t start;
 	char *ptr;
 	int len;
 	int err;
@@ -1345,9 +1371,11 @@ int ll_fill_super(struct super_block *sb)
 	cfg->cfg_callback = class_config_llog_handler;
 	cfg->cfg_sub_clds = CONFIG_SUB_CLIENT;
 	/* set up client obds */
+	start = ktime_get();
 	err = lustre_process_log(sb, profilenm, cfg);
 	if (err < 0)
 		GOTO(out_debugfs, err);
+	ll_mount_phase_done(sbi, LL_MOUNT_CONFIG_LOG, &start);
 
 	/* Profile set with LCFG_MOUNTOPT so we can find our mdc and osc obds */
 	lprof = class_get_profile(profilenm);
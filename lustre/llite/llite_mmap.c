@@ -511,6 +511,60 @@ out:
 	return result;
 }
 
+#ifdef HAVE_VM_OPS_USE_VM_FAULT_ONLY
+/**
+ * Lustre implementation of a vm_operations_struct::map_pages() method,
+ * called by VM on a read fault to map the pages around the faulting address
+ * which are already cached and uptodate ("fault-around").
+ *
+ * Like the fast fault path in ll_fault0(), this relies on lock cancellation
+ * to remove the pages from the page cache, so it is only done when fast_read
+ * is enabled. Pages which are not cached are left to ll_fault().
+ *
+ * \param vmf - structure which describe type and address where hit fault
+ * \param start_pgoff - first page index of the fault-around window
+ * \param end_pgoff - last page index of the fault-around window
+ */
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+static vm_fault_t ll_map_pages(struct vm_fault *vmf, pgoff_t start_pgoff,
+			       pgoff_t end_pgoff)
+#else
+static void ll_map_pages(struct vm_fault *vmf, pgoff_t start_pgoff,
+			 pgoff_t end_pgoff)
+#endif
+{
+	struct file *file = vmf->vma->vm_file;
+	struct inode *inode = file_inode(file);
+	struct ll_file_data *fd = file->private_data;
+	ktime_t kstart = ktime_get();
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+	vm_fault_t result = 0;
+#endif
+
+	/* PCC cached files are faulted one page at a time from PCC */
+	if (!ll_sbi_has_fast_read(ll_i2sbi(inode)) ||
+	    fd->fd_pcc_file.pccf_file)
+		goto out;
+
+	CDEBUG(D_MMAP, DFID": fault-around %lu-%lu at %lu\n",
+	       PFID(ll_inode2fid(inode)), start_pgoff, end_pgoff, vmf->pgoff);
+
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+	result = filemap_map_pages(vmf, start_pgoff, end_pgoff);
+#else
+	filemap_map_pages(vmf, start_pgoff, end_pgoff);
+#endif
+	ll_stats_ops_tally(ll_i2sbi(inode), LPROC_LL_MAP_PAGES,
+			   ktime_us_delta(ktime_get(), kstart));
+out:
+#ifdef HAVE_MAP_PAGES_VM_FAULT_T
+	return result;
+#else
+	return;
+#endif
+}
+#endif /* HAVE_VM_OPS_USE_VM_FAULT_ONLY */
+
 /**
  *  To avoid cancel the locks covering mmapped region for lock cache pressure,
  *  we track the mapped vma count in vvp_object::vob_mmap_cnt.
@@ -544,6 +598,9 @@ static void ll_vm_close(struct vm_area_struct *vma)
 
 static const struct vm_operations_struct ll_file_vm_ops = {
 	.fault			= ll_fault,
+#ifdef HAVE_VM_OPS_USE_VM_FAULT_ONLY
+	.map_pages		= ll_map_pages,
+#endif
 	.page_mkwrite		= ll_page_mkwrite,
 	.open			= ll_vm_open,
 	.close			= ll_vm_close,
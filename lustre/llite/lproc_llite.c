@@ -463,6 +463,7 @@ static int ll_max_cached_mb_seq_show(struct seq_file *m, void *v)
 
 	mutex_lock(&cache->ccc_max_cache_mb_lock);
 	max_cached_mb = PAGES_TO_MiB(cache->ccc_lru_max);
+	cl_cache_lru_flush(cache);
 	unused_mb = PAGES_TO_MiB(atomic_long_read(&cache->ccc_lru_left));
 	mutex_unlock(&cache->ccc_max_cache_mb_lock);
 
@@ -540,7 +541,9 @@ static ssize_t ll_max_cached_mb_seq_write(struct file *file,
 	while (diff > 0) {
 		long tmp;
 
-		/* reduce LRU budget from free slots. */
+		/* reduce LRU budget from free slots, including the ones
+		 * freed pages have not returned yet */
+		cl_cache_lru_flush(cache);
 		do {
 			long lru_left_old, lru_left_new, lru_left_ret;
 
@@ -842,6 +845,31 @@ static int ll_statahead_stats_seq_show(struct seq_file *m, void *v)
 
 LDEBUGFS_SEQ_FOPS_RO(ll_statahead_stats);
 
+static const char *const ll_mount_phase_names[LL_MOUNT_PHASE_NR] = {
+	[LL_MOUNT_CONFIG_LOG]	= "config_log",
+	[LL_MOUNT_MD_CONNECT]	= "md_connect",
+	[LL_MOUNT_DT_CONNECT]	= "dt_connect",
+	[LL_MOUNT_ROOT]		= "root",
+};
+
+static int ll_mount_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	s64 total = 0;
+	int i;
+
+	for (i = 0; i < LL_MOUNT_PHASE_NR; i++) {
+		seq_printf(m, "%-12s %lld usec\n", ll_mount_phase_names[i],
+			   sbi->ll_mount_phase_us[i]);
+		total += sbi->ll_mount_phase_us[i];
+	}
+	seq_printf(m, "%-12s %lld usec\n", "total", total);
+	return 0;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ll_mount_stats);
+
 static ssize_t lazystatfs_show(struct kobject *kobj,
 			       struct attribute *attr,
 			       char *buf)
@@ -1234,6 +1262,53 @@ out:
 }
 LUSTRE_RW_ATTR(read_ahead_range_kb);
 
+static ssize_t read_ahead_fault_kb_show(struct kobject *kobj,
+					struct attribute *attr, char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return snprintf(buf, PAGE_SIZE, "%lu\n",
+			sbi->ll_ra_info.ra_fault_pages << (PAGE_SHIFT - 10));
+}
+
+/*
+ * Number of pages read around a faulting page on a page cache miss. The
+ * DLM lock taken by the fault covers the whole window, so that it is read
+ * in a few large RPCs instead of one small RPC per faulting page.
+ */
+static ssize_t
+read_ahead_fault_kb_store(struct kobject *kobj, struct attribute *attr,
+			  const char *buffer, size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned long pages_number;
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "KiB");
+	if (rc < 0)
+		return rc;
+
+	pages_number = val >> PAGE_SHIFT;
+	/* Disable fault read-around */
+	if (pages_number == 0)
+		goto out;
+
+	if (pages_number > sbi->ll_ra_info.ra_max_pages_per_file ||
+	    pages_number < RA_MIN_MMAP_RANGE_PAGES)
+		return -ERANGE;
+
+out:
+	spin_lock(&sbi->ll_lock);
+	sbi->ll_ra_info.ra_fault_pages = pages_number;
+	spin_unlock(&sbi->ll_lock);
+
+	return count;
+}
+LUSTRE_RW_ATTR(read_ahead_fault_kb);
+
 static ssize_t fast_read_show(struct kobject *kobj,
 			      struct attribute *attr,
 			      char *buf)
@@ -1373,6 +1448,75 @@ static ssize_t heat_period_second_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(heat_period_second);
 
+static ssize_t heat_top_count_show(struct kobject *kobj,
+				   struct attribute *attr,
+				   char *buf)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n", sbi->ll_heat_top.lht_size);
+}
+
+static ssize_t heat_top_count_store(struct kobject *kobj,
+				    struct attribute *attr,
+				    const char *buffer,
+				    size_t count)
+{
+	struct ll_sb_info *sbi = container_of(kobj, struct ll_sb_info,
+					      ll_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 10, &val);
+	if (rc)
+		return rc;
+
+	rc = ll_heat_top_resize(sbi, val);
+	if (rc)
+		return rc;
+
+	return count;
+}
+LUSTRE_RW_ATTR(heat_top_count);
+
+static int ll_heat_top_seq_show(struct seq_file *m, void *v)
+{
+	struct super_block *sb = m->private;
+	struct ll_sb_info *sbi = ll_s2sbi(sb);
+	struct lu_heat_top_entry *top;
+	unsigned int size = sbi->ll_heat_top.lht_size;
+	int rc;
+	int i;
+
+	if (size == 0)
+		return 0;
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(top, size);
+	if (top == NULL)
+		return -ENOMEM;
+
+	rc = ll_heat_top_get(sbi, top, size);
+	if (rc < 0)
+		GOTO(out_free, rc);
+
+	seq_printf(m, "%-*s %12s %12s %16s %16s\n", FID_LEN, "fid",
+		   "readsample", "writesample", "readbyte", "writebyte");
+	for (i = 0; i < rc; i++)
+		seq_printf(m, DFID" %12llu %12llu %16llu %16llu\n",
+			   PFID(&top[i].lhte_fid),
+			   top[i].lhte_heat[OBD_HEAT_READSAMPLE],
+			   top[i].lhte_heat[OBD_HEAT_WRITESAMPLE],
+			   top[i].lhte_heat[OBD_HEAT_READBYTE],
+			   top[i].lhte_heat[OBD_HEAT_WRITEBYTE]);
+	rc = 0;
+out_free:
+	OBD_FREE_PTR_ARRAY_LARGE(top, size);
+	return rc;
+}
+
+LDEBUGFS_SEQ_FOPS_RO(ll_heat_top);
+
 static ssize_t opencache_threshold_count_show(struct kobject *kobj,
 					      struct attribute *attr,
 					      char *buf)
@@ -1698,10 +1842,14 @@ struct ldebugfs_vars lprocfs_llite_obd_vars[] = {
 	  .fops	=	&ll_max_cached_mb_fops			},
 	{ .name	=	"statahead_stats",
 	  .fops	=	&ll_statahead_stats_fops		},
+	{ .name	=	"mount_stats",
+	  .fops	=	&ll_mount_stats_fops			},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&ll_unstable_stats_fops			},
 	{ .name =	"sbi_flags",
 	  .fops =	&ll_sbi_flags_fops			},
+	{ .name	=	"heat_top",
+	  .fops	=	&ll_heat_top_fops			},
 	{ .name	=	"root_squash",
 	  .fops	=	&ll_root_squash_fops			},
 	{ .name	=	"nosquash_nids",
@@ -1738,6 +1886,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_max_read_ahead_async_active.attr,
 	&lustre_attr_read_ahead_async_file_threshold_mb.attr,
 	&lustre_attr_read_ahead_range_kb.attr,
+	&lustre_attr_read_ahead_fault_kb.attr,
 	&lustre_attr_stats_track_pid.attr,
 	&lustre_attr_stats_track_ppid.attr,
 	&lustre_attr_stats_track_gid.attr,
@@ -1755,6 +1904,7 @@ static struct attribute *llite_attrs[] = {
 	&lustre_attr_file_heat.attr,
 	&lustre_attr_heat_decay_percentage.attr,
 	&lustre_attr_heat_period_second.attr,
+	&lustre_attr_heat_top_count.attr,
 	&lustre_attr_opencache_threshold_count.attr,
 	&lustre_attr_opencache_threshold_ms.attr,
 	&lustre_attr_opencache_max_ms.attr,
@@ -1783,6 +1933,7 @@ static const struct llite_file_opcode {
 	/* file operation */
 	{ LPROC_LL_READ_BYTES,	LPROCFS_TYPE_BYTES_FULL, "read_bytes" },
 	{ LPROC_LL_WRITE_BYTES,	LPROCFS_TYPE_BYTES_FULL, "write_bytes" },
+	{ LPROC_LL_INLINE_READ_BYTES, LPROCFS_TYPE_BYTES, "inline_read_bytes" },
 	{ LPROC_LL_READ,	LPROCFS_TYPE_LATENCY,	"read" },
 	{ LPROC_LL_WRITE,	LPROCFS_TYPE_LATENCY,	"write" },
 	{ LPROC_LL_IOCTL,	LPROCFS_TYPE_REQS,	"ioctl" },
@@ -1790,6 +1941,9 @@ static const struct llite_file_opcode {
 	{ LPROC_LL_RELEASE,	LPROCFS_TYPE_LATENCY,	"close" },
 	{ LPROC_LL_MMAP,	LPROCFS_TYPE_LATENCY,	"mmap" },
 	{ LPROC_LL_FAULT,	LPROCFS_TYPE_LATENCY,	"page_fault" },
+	{ LPROC_LL_FAULT_PAGES,	LPROCFS_TYPE_PAGES |
+				LPROCFS_CNTR_AVGMINMAX,	"fault_pages" },
+	{ LPROC_LL_MAP_PAGES,	LPROCFS_TYPE_LATENCY,	"fault_around" },
 	{ LPROC_LL_MKWRITE,	LPROCFS_TYPE_LATENCY,	"page_mkwrite" },
 	{ LPROC_LL_LLSEEK,	LPROCFS_TYPE_LATENCY,	"seek" },
 	{ LPROC_LL_FSYNC,	LPROCFS_TYPE_LATENCY,	"fsync" },
@@ -1860,6 +2014,8 @@ static const char *const ra_stat_string[] = {
 	[RA_STAT_ASYNC]			= "async_readahead",
 	[RA_STAT_FAILED_FAST_READ]	= "failed_to_fast_read",
 	[RA_STAT_MMAP_RANGE_READ]	= "mmap_range_read",
+	[RA_STAT_MMAP_FAULT_READ]	= "mmap_fault_read",
+	[RA_STAT_SPLICE_WINDOW]		= "splice_window",
 };
 
 int ll_debugfs_register_super(struct super_block *sb, const char *name)
@@ -1905,6 +2061,8 @@ int ll_debugfs_register_super(struct super_block *sb, const char *name)
 			ptr = "reqs";
 		else if (type & LPROCFS_TYPE_BYTES)
 			ptr = "bytes";
+		else if (type & LPROCFS_TYPE_PAGES)
+			ptr = "pages";
 		else if (type & LPROCFS_TYPE_USEC)
 			ptr = "usec";
 		lprocfs_counter_init(sbi->ll_stats,
@@ -1927,6 +2085,10 @@ int ll_debugfs_register_super(struct super_block *sb, const char *name)
 	debugfs_create_file("read_ahead_stats", 0644, sbi->ll_debugfs_entry,
 			    sbi->ll_ra_stats, &ldebugfs_stats_seq_fops);
 
+	debugfs_create_file("pcc_stats", 0644, sbi->ll_debugfs_entry,
+			    sbi->ll_pcc_super.pccs_stats,
+			    &ldebugfs_stats_seq_fops);
+
 out_ll_kset:
 	/* Yes we also register sysfs mount kset here as well */
 	sbi->ll_kset.kobj.parent = llite_kobj;
@@ -112,13 +112,37 @@
 
 struct kmem_cache *pcc_inode_slab;
 
+static const char *const pcc_stats_names[] = {
+	[PCC_STATS_READ_HIT]	= "read_hit",
+	[PCC_STATS_READ_MISS]	= "read_miss",
+	[PCC_STATS_WRITE]	= "write",
+	[PCC_STATS_ATTACH]	= "attach",
+	[PCC_STATS_DETACH]	= "detach",
+};
+
 int pcc_super_init(struct pcc_super *super)
 {
 	struct cred *cred;
+	int i;
+
+	super->pccs_stats = lprocfs_alloc_stats(PCC_STATS_NUM,
+						LPROCFS_STATS_FLAG_NONE);
+	if (super->pccs_stats == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < PCC_STATS_NUM; i++)
+		lprocfs_counter_init(super->pccs_stats, i,
+				     i == PCC_STATS_DETACH ?
+				     LPROCFS_TYPE_REQS :
+				     LPROCFS_TYPE_BYTES | LPROCFS_CNTR_AVGMINMAX,
+				     pcc_stats_names[i],
+				     i == PCC_STATS_DETACH ? "reqs" : "bytes");
 
 	super->pccs_cred = cred = prepare_creds();
-	if (!cred)
+	if (!cred) {
+		lprocfs_free_stats(&super->pccs_stats);
 		return -ENOMEM;
+	}
 
 	/* Never override disk quota limits or use reserved space */
 	cap_lower(cred->cap_effective, CAP_SYS_RESOURCE);
@@ -882,6 +906,7 @@ void pcc_super_fini(struct pcc_super *super)
 {
 	pcc_remove_datasets(super);
 	put_cred(super->pccs_cred);
+	lprocfs_free_stats(&super->pccs_stats);
 }
 
 static bool pathname_is_valid(const char *pathname)
@@ -1041,6 +1066,18 @@ static void pcc_inode_put(struct pcc_inode *pcci)
 		pcc_inode_fini(pcci);
 }
 
+void pcc_stats_tally(struct inode *inode, enum pcc_stats_type type,
+		     long amount)
+{
+	struct pcc_super *super = ll_i2pccs(inode);
+
+	/* Misses are only meaningful when some dataset could cache the file */
+	if (type == PCC_STATS_READ_MISS && list_empty(&super->pccs_datasets))
+		return;
+
+	lprocfs_counter_add(super->pccs_stats, type, amount);
+}
+
 void pcc_inode_free(struct inode *inode)
 {
 	struct pcc_inode *pcci = ll_i2pcci(inode);
@@ -1667,6 +1704,8 @@ ssize_t pcc_file_read_iter(struct kiocb *iocb,
 	 */
 	result = __pcc_file_read_iter(iocb, iter);
 	iocb->ki_filp = file;
+	if (result > 0)
+		pcc_stats_tally(inode, PCC_STATS_READ_HIT, result);
 
 	pcc_io_fini(inode);
 	RETURN(result);
@@ -1743,6 +1782,8 @@ ssize_t pcc_file_write_iter(struct kiocb *iocb,
 	 */
 	result = __pcc_file_write_iter(iocb, iter);
 	iocb->ki_filp = file;
+	if (result > 0)
+		pcc_stats_tally(inode, PCC_STATS_WRITE, result);
 out:
 	pcc_io_fini(inode);
 	RETURN(result);
@@ -1854,26 +1895,26 @@ out:
 #ifdef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
 ssize_t pcc_file_splice_read(struct file *in_file, loff_t *ppos,
 			     struct pipe_inode_info *pipe,
-			     size_t count, unsigned int flags)
+			     size_t count, unsigned int flags, bool *cached)
 {
 	struct inode *inode = file_inode(in_file);
 	struct ll_file_data *fd = in_file->private_data;
 	struct file *pcc_file = fd->fd_pcc_file.pccf_file;
-	bool cached = false;
 	ssize_t result;
 
 	ENTRY;
 
+	*cached = false;
 	if (!pcc_file)
-		RETURN(default_file_splice_read(in_file, ppos, pipe,
-						count, flags));
+		RETURN(0);
 
-	pcc_io_init(inode, PIT_SPLICE_READ, &cached);
-	if (!cached)
-		RETURN(default_file_splice_read(in_file, ppos, pipe,
-						count, flags));
+	pcc_io_init(inode, PIT_SPLICE_READ, cached);
+	if (!*cached)
+		RETURN(0);
 
 	result = default_file_splice_read(pcc_file, ppos, pipe, count, flags);
+	if (result > 0)
+		pcc_stats_tally(inode, PCC_STATS_READ_HIT, result);
 
 	pcc_io_fini(inode);
 	RETURN(result);
@@ -2585,6 +2626,8 @@ int pcc_readwrite_attach_fini(struct file *file, struct inode *inode,
 	if (!rc) {
 		if (gen2 == gen) {
 			pcc_layout_gen_set(pcci, gen);
+			pcc_stats_tally(inode, PCC_STATS_ATTACH,
+				i_size_read(pcci->pcci_path.dentry->d_inode));
 		} else {
 			CDEBUG(D_CACHE,
 			       DFID" layout changed from %d to %d.\n",
@@ -2677,6 +2720,7 @@ int pcc_ioctl_detach(struct inode *inode, __u32 opt)
 
 		__pcc_layout_invalidate(pcci);
 		pcc_inode_put(pcci);
+		pcc_stats_tally(inode, PCC_STATS_DETACH, 1);
 	}
 
 out_unlock:
@@ -122,6 +122,20 @@ struct pcc_dataset {
 	atomic_t		pccd_refcount; /* Reference count */
 };
 
+enum pcc_stats_type {
+	/* reads served from PCC, in bytes */
+	PCC_STATS_READ_HIT = 0,
+	/* reads of uncached files while PCC is set up, in bytes */
+	PCC_STATS_READ_MISS,
+	/* writes to PCC, in bytes */
+	PCC_STATS_WRITE,
+	/* files attached into PCC, in bytes copied */
+	PCC_STATS_ATTACH,
+	/* files detached from PCC */
+	PCC_STATS_DETACH,
+	PCC_STATS_NUM
+};
+
 struct pcc_super {
 	/* Protect pccs_datasets */
 	struct rw_semaphore	 pccs_rw_sem;
@@ -135,6 +149,8 @@ struct pcc_super {
 	 * parameters for PCC.
 	 */
 	__u64			 pccs_generation;
+	/* Hit/miss and traffic statistics, see enum pcc_stats_type */
+	struct lprocfs_stats	*pccs_stats;
 };
 
 struct pcc_inode {
@@ -245,7 +261,7 @@ int pcc_inode_setattr(struct inode *inode, struct iattr *attr, bool *cached);
 #ifdef HAVE_DEFAULT_FILE_SPLICE_READ_EXPORT
 ssize_t pcc_file_splice_read(struct file *in_file, loff_t *ppos,
 			     struct pipe_inode_info *pipe, size_t count,
-			     unsigned int flags);
+			     unsigned int flags, bool *cached);
 #endif
 int pcc_fsync(struct file *file, loff_t start, loff_t end,
 	      int datasync, bool *cached);
@@ -264,5 +280,7 @@ struct pcc_dataset *pcc_dataset_match_get(struct pcc_super *super,
 					  struct pcc_matcher *matcher);
 void pcc_dataset_put(struct pcc_dataset *dataset);
 void pcc_inode_free(struct inode *inode);
+void pcc_stats_tally(struct inode *inode, enum pcc_stats_type type,
+		     long amount);
 void pcc_layout_invalidate(struct inode *inode);
 #endif /* LLITE_PCC_H */
@@ -1264,6 +1264,37 @@ out_unlock:
 	spin_unlock(&ras->ras_lock);
 }
 
+/**
+ * splice_read() and sendfile() are told how much the caller will read in
+ * total, but each call can only fill one pipe, so ll_ras_enter() only sees
+ * pipe sized requests and the window grows by one RPC per call. Once the
+ * stream has been seen to be sequential, open the window up to the whole
+ * splice length, capped by ra_max_pages_per_file.
+ */
+void ll_ras_splice_window(struct file *f, loff_t pos, size_t count)
+{
+	struct ll_file_data *fd = f->private_data;
+	struct ll_readahead_state *ras = &fd->fd_ras;
+	struct ll_sb_info *sbi = ll_i2sbi(file_inode(f));
+	pgoff_t pages;
+
+	if (count == 0)
+		return;
+
+	pages = ((pos + count - 1) >> PAGE_SHIFT) - (pos >> PAGE_SHIFT) + 1;
+	pages = min_t(pgoff_t, pages, sbi->ll_ra_info.ra_max_pages_per_file);
+
+	spin_lock(&ras->ras_lock);
+	if (!stride_io_mode(ras) && !ras->ras_no_miss_check &&
+	    ras->ras_consecutive_requests > 0 &&
+	    ras->ras_window_pages < pages) {
+		ras->ras_window_pages = pages;
+		ll_ra_stats_inc_sbi(sbi, RA_STAT_SPLICE_WINDOW);
+		RAS_CDEBUG(ras);
+	}
+	spin_unlock(&ras->ras_lock);
+}
+
 static bool index_in_stride_window(struct ll_readahead_state *ras,
 				   pgoff_t index)
 {
@@ -1358,6 +1389,23 @@ static void ras_update(struct ll_sb_info *sbi, struct inode *inode,
 			}
 			goto skip;
 		}
+
+		/*
+		 * Cache miss with no pattern detected: read around the
+		 * faulting page, the fault lock already covers the window.
+		 */
+		if (!hit && ra->ra_fault_pages &&
+		    !ras->ras_need_increase_window &&
+		    ras->ras_window_pages < ra->ra_fault_pages) {
+			ra_pages = ra->ra_fault_pages;
+			if (index < ra_pages / 2)
+				index = 0;
+			else
+				index -= ra_pages / 2;
+			ras->ras_window_pages = ra_pages;
+			ll_ra_stats_inc_sbi(sbi, RA_STAT_MMAP_FAULT_READ);
+			goto skip;
+		}
 	}
 
 	if (!hit && ras->ras_window_pages &&
@@ -1713,6 +1761,9 @@ int ll_io_read_page(const struct lu_env *env, struct cl_io *io,
 		rc = cl_io_submit_rw(env, io, CRT_READ, queue);
 		if (rc == 0)
 			task_io_account_read(PAGE_SIZE * count);
+		/* pages read by the fault itself, async readahead excluded */
+		if (rc == 0 && io->ci_type == CIT_FAULT)
+			ll_stats_ops_tally(sbi, LPROC_LL_FAULT_PAGES, count);
 	}
 
 
@@ -600,16 +600,33 @@ static int vvp_io_read_lock(const struct lu_env *env,
 static int vvp_io_fault_lock(const struct lu_env *env,
                              const struct cl_io_slice *ios)
 {
-        struct cl_io *io   = ios->cis_io;
-        struct vvp_io *vio = cl2vvp_io(env, ios);
-        /*
-         * XXX LDLM_FL_CBPENDING
-         */
-	return vvp_io_one_lock_index(env,
-				     io, 0,
-				     vvp_mode_from_vma(vio->u.fault.ft_vma),
-				     io->u.ci_fault.ft_index,
-				     io->u.ci_fault.ft_index);
+	struct cl_io *io = ios->cis_io;
+	struct vvp_io *vio = cl2vvp_io(env, ios);
+	struct vm_area_struct *vma = vio->u.fault.ft_vma;
+	struct ll_sb_info *sbi = ll_i2sbi(vvp_object_inode(io->ci_obj));
+	enum cl_lock_mode mode = vvp_mode_from_vma(vma);
+	unsigned long ra_pages = sbi->ll_ra_info.ra_fault_pages;
+	pgoff_t start = io->u.ci_fault.ft_index;
+	pgoff_t end = start;
+
+	/*
+	 * For a read fault cover the read-around window of the fault
+	 * with the same lock, so that readahead from the fault path is
+	 * not trimmed to the single faulting page, see ras_update().
+	 */
+	if (ra_pages && mode == CLM_READ && !io->u.ci_fault.ft_mkwrite &&
+	    !io->ci_rand_read) {
+		start = start < ra_pages / 2 ? 0 : start - ra_pages / 2;
+		start = max_t(pgoff_t, start, vma->vm_pgoff);
+		end = min_t(pgoff_t, start + ra_pages - 1,
+			    vma->vm_pgoff + vma_pages(vma) - 1);
+		end = max_t(pgoff_t, end, io->u.ci_fault.ft_index);
+	}
+
+	/*
+	 * XXX LDLM_FL_CBPENDING
+	 */
+	return vvp_io_one_lock_index(env, io, 0, mode, start, end);
 }
 
 static int vvp_io_write_lock(const struct lu_env *env,
@@ -37,6 +37,20 @@
 
 #define LMV_MAX_TGT_COUNT 128
 
+/* striped directory readdir lookahead, in pages per stripe */
+#define LMV_READDIR_PREFETCH_DEFAULT	2
+#define LMV_READDIR_PREFETCH_MAX	64
+/* lookahead requests in flight per LMV */
+#define LMV_READDIR_INFLIGHT_MAX	256
+
+enum lmv_readdir_stats {
+	LMV_READDIR_PAGE,
+	LMV_READDIR_STRIPE_WAIT,
+	LMV_READDIR_PREFETCH,
+	LMV_READDIR_PREFETCH_SKIP,
+	LMV_READDIR_STATS_NUM,
+};
+
 #define LL_IT2STR(it)				        \
 	((it) ? ldlm_it2str((it)->it_op) : "0")
 
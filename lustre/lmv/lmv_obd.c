@@ -1123,6 +1123,13 @@ static int lmv_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 
 	spin_lock_init(&lmv->lmv_lock);
 
+	lmv->lmv_readdir_prefetch = LMV_READDIR_PREFETCH_DEFAULT;
+	atomic_set(&lmv->lmv_readdir_inflight, 0);
+	lmv->lmv_readdir_stop = false;
+	lmv->lmv_readdir_wq = alloc_workqueue("lmv_readdir", WQ_UNBOUND, 0);
+	if (!lmv->lmv_readdir_wq)
+		RETURN(-ENOMEM);
+
 	/*
 	 * initialize rr_index to lower 32bit of netid, so that client
 	 * can distribute subdirs evenly from the beginning.
@@ -1145,9 +1152,12 @@ static int lmv_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 		CERROR("Can't init FLD, err %d\n", rc);
 
 	rc = lu_tgt_descs_init(&lmv->lmv_mdt_descs, true);
-	if (rc)
+	if (rc) {
 		CWARN("%s: error initialize target table: rc = %d\n",
 		      obd->obd_name, rc);
+		destroy_workqueue(lmv->lmv_readdir_wq);
+		lmv->lmv_readdir_wq = NULL;
+	}
 
 	RETURN(rc);
 }
@@ -1161,6 +1171,10 @@ static int lmv_cleanup(struct obd_device *obd)
 	ENTRY;
 
 	fld_client_fini(&lmv->lmv_fld);
+	if (lmv->lmv_readdir_wq) {
+		destroy_workqueue(lmv->lmv_readdir_wq);
+		lmv->lmv_readdir_wq = NULL;
+	}
 	lmv_foreach_tgt_safe(lmv, tgt, tmp)
 		lmv_del_target(lmv, tgt);
 	lu_tgt_descs_fini(&lmv->lmv_mdt_descs);
@@ -2635,6 +2649,134 @@ struct lmv_dir_ctxt {
 	struct stripe_dirent	 ldc_stripes[0];
 };
 
+/* lookahead of one stripe of a striped directory, see lmv_readdir_ahead() */
+struct lmv_readdir_ahead {
+	struct work_struct	 lra_work;
+	struct lmv_obd		*lra_lmv;
+	struct obd_export	*lra_exp;
+	struct md_op_data	 lra_op_data;
+	struct md_readdir_info	 lra_mrinfo;
+	__u64			 lra_hash;
+	unsigned int		 lra_pages;
+};
+
+static void lmv_readdir_ahead_work(struct work_struct *work)
+{
+	struct lmv_readdir_ahead *lra = container_of(work,
+						     struct lmv_readdir_ahead,
+						     lra_work);
+	struct lmv_obd *lmv = lra->lra_lmv;
+	struct lu_dirpage *dp;
+	struct page *page;
+	__u64 hash = lra->lra_hash;
+	unsigned int i;
+	int rc = 0;
+
+	/* unmounting, only drop the references */
+	for (i = 0; i < lra->lra_pages && hash != MDS_DIR_END_OFF &&
+		    !READ_ONCE(lmv->lmv_readdir_stop); i++) {
+		rc = md_read_page(lra->lra_exp, &lra->lra_op_data,
+				  &lra->lra_mrinfo, hash, &page);
+		if (rc)
+			break;
+
+		/* the page stays in the stripe cache under the DLM lock */
+		dp = page_address(page);
+		hash = le64_to_cpu(dp->ldp_hash_end);
+		kunmap(page);
+		put_page(page);
+		if (lmv->lmv_readdir_stats)
+			lprocfs_counter_incr(lmv->lmv_readdir_stats,
+					     LMV_READDIR_PREFETCH);
+	}
+
+	if (rc)
+		CDEBUG(D_INFO, "%s: readdir ahead "DFID" at %#llx: rc = %d\n",
+		       lra->lra_exp->exp_obd->obd_name,
+		       PFID(&lra->lra_op_data.op_fid1), hash, rc);
+
+	iput(lra->lra_op_data.op_data);
+	class_export_put(lra->lra_exp);
+	OBD_FREE_PTR(lra);
+	atomic_dec(&lmv->lmv_readdir_inflight);
+}
+
+/**
+ * Start reading @pages dir pages of stripe @stripe_index from @hash in the
+ * background. The pages are only brought into the page cache of the stripe,
+ * so that stripe_dirent_load() finds them there, or waits for the page under
+ * read, instead of issuing the RPCs one stripe after another.
+ *
+ * The next lookahead of the stripe is issued once half of the window has
+ * been consumed, see lmo_ra_skip.
+ */
+static void lmv_readdir_ahead(struct lmv_dir_ctxt *ctxt, int stripe_index,
+			      __u64 hash, unsigned int pages)
+{
+	struct lmv_obd *lmv = ctxt->ldc_lmv;
+	struct md_op_data *op_data = ctxt->ldc_op_data;
+	struct lmv_oinfo *oinfo = &op_data->op_mea1->lsm_md_oinfo[stripe_index];
+	struct lmv_readdir_ahead *lra;
+	struct lmv_tgt_desc *tgt;
+	struct inode *inode;
+
+	if (!pages || hash == MDS_DIR_END_OFF || !oinfo->lmo_root ||
+	    READ_ONCE(lmv->lmv_readdir_stop))
+		return;
+
+	if (atomic_inc_return(&lmv->lmv_readdir_inflight) >
+	    LMV_READDIR_INFLIGHT_MAX)
+		goto skip;
+
+	tgt = lmv_tgt(lmv, oinfo->lmo_mds);
+	if (!tgt || !tgt->ltd_exp || !tgt->ltd_active)
+		goto skip;
+
+	inode = igrab(oinfo->lmo_root);
+	if (!inode)
+		goto skip;
+
+	OBD_ALLOC_PTR(lra);
+	if (!lra) {
+		iput(inode);
+		goto skip;
+	}
+
+	lra->lra_lmv = lmv;
+	lra->lra_exp = class_export_get(tgt->ltd_exp);
+	/* private copy, @op_data is gone by the time the work runs */
+	lra->lra_op_data = *op_data;
+	lra->lra_op_data.op_fid1 = oinfo->lmo_fid;
+	lra->lra_op_data.op_fid2 = oinfo->lmo_fid;
+	lra->lra_op_data.op_data = inode;
+	lra->lra_op_data.op_name = NULL;
+	lra->lra_op_data.op_namelen = 0;
+	lra->lra_op_data.op_mea1_sem = NULL;
+	lra->lra_op_data.op_mea2_sem = NULL;
+	lra->lra_op_data.op_mea1 = NULL;
+	lra->lra_op_data.op_mea2 = NULL;
+	lra->lra_op_data.op_default_mea1 = NULL;
+	lra->lra_op_data.op_file_secctx_name = NULL;
+	lra->lra_op_data.op_file_secctx = NULL;
+	lra->lra_op_data.op_file_secctx_size = 0;
+	lra->lra_op_data.op_file_encctx = NULL;
+	lra->lra_op_data.op_file_encctx_size = 0;
+	lra->lra_mrinfo.mr_blocking_ast = ctxt->ldc_mrinfo->mr_blocking_ast;
+	lra->lra_hash = hash;
+	lra->lra_pages = pages;
+
+	INIT_WORK(&lra->lra_work, lmv_readdir_ahead_work);
+	queue_work(lmv->lmv_readdir_wq, &lra->lra_work);
+	WRITE_ONCE(oinfo->lmo_ra_skip, pages / 2);
+	return;
+
+skip:
+	atomic_dec(&lmv->lmv_readdir_inflight);
+	if (lmv->lmv_readdir_stats)
+		lprocfs_counter_incr(lmv->lmv_readdir_stats,
+				     LMV_READDIR_PREFETCH_SKIP);
+}
+
 static inline void stripe_dirent_unload(struct stripe_dirent *stripe)
 {
 	if (stripe->sd_page) {
@@ -2689,6 +2831,10 @@ static struct lu_dirent *stripe_dirent_load(struct lmv_dir_ctxt *ctxt,
 	struct lmv_tgt_desc *tgt;
 	struct lu_dirent *ent = stripe->sd_ent;
 	__u64 hash = ctxt->ldc_hash;
+	unsigned int pages;
+	unsigned int skip;
+	ktime_t kstart;
+	s64 wait;
 	int rc = 0;
 
 	ENTRY;
@@ -2712,6 +2858,18 @@ static struct lu_dirent *stripe_dirent_load(struct lmv_dir_ctxt *ctxt,
 				break;
 			}
 			hash = end;
+
+			/* moving on to the next page, refill the lookahead
+			 * window of this stripe once half of it is consumed
+			 */
+			oinfo = &op_data->op_mea1->lsm_md_oinfo[stripe_index];
+			skip = READ_ONCE(oinfo->lmo_ra_skip);
+			pages = READ_ONCE(ctxt->ldc_lmv->lmv_readdir_prefetch);
+			if (skip)
+				WRITE_ONCE(oinfo->lmo_ra_skip, skip - 1);
+			else if (pages)
+				lmv_readdir_ahead(ctxt, stripe_index, hash,
+						  pages + 1);
 		}
 
 		oinfo = &op_data->op_mea1->lsm_md_oinfo[stripe_index];
@@ -2731,8 +2889,13 @@ static struct lu_dirent *stripe_dirent_load(struct lmv_dir_ctxt *ctxt,
 		op_data->op_fid2 = oinfo->lmo_fid;
 		op_data->op_data = oinfo->lmo_root;
 
+		kstart = ktime_get();
 		rc = md_read_page(tgt->ltd_exp, op_data, ctxt->ldc_mrinfo, hash,
 				  &stripe->sd_page);
+		wait = ktime_us_delta(ktime_get(), kstart);
+		if (ctxt->ldc_lmv->lmv_readdir_stats)
+			lprocfs_counter_add(ctxt->ldc_lmv->lmv_readdir_stats,
+					    LMV_READDIR_STRIPE_WAIT, wait);
 
 		op_data->op_fid1 = fid;
 		op_data->op_fid2 = fid;
@@ -2910,6 +3073,15 @@ static int lmv_striped_read_page(struct obd_export *exp,
 	ctxt->ldc_hash = offset;
 	ctxt->ldc_count = stripe_count;
 
+	/* start of a listing, read the first pages of all stripes at once */
+	if (offset == 0) {
+		unsigned int pages = READ_ONCE(ctxt->ldc_lmv->lmv_readdir_prefetch);
+		int i;
+
+		for (i = 0; i < stripe_count; i++)
+			lmv_readdir_ahead(ctxt, i, 0, pages);
+	}
+
 	while (1) {
 		next = lmv_dirent_next(ctxt);
 
@@ -2964,6 +3136,11 @@ static int lmv_striped_read_page(struct obd_export *exp,
 	dp->ldp_flags = cpu_to_le32(dp->ldp_flags);
 	dp->ldp_hash_end = cpu_to_le64(ctxt->ldc_hash);
 
+	if (ctxt->ldc_lmv->lmv_readdir_stats)
+		lprocfs_counter_add(ctxt->ldc_lmv->lmv_readdir_stats,
+				    LMV_READDIR_PAGE,
+				    PAGE_SIZE - sizeof(*dp) - left_bytes);
+
 	put_lmv_dir_ctxt(ctxt);
 	OBD_FREE(ctxt, offsetof(typeof(*ctxt), ldc_stripes[stripe_count]));
 
@@ -3114,11 +3291,20 @@ retry:
 
 static int lmv_precleanup(struct obd_device *obd)
 {
+	struct lmv_obd *lmv = &obd->u.lmv;
+
 	ENTRY;
 	libcfs_kkuc_group_rem(&obd->obd_uuid, 0, KUC_GRP_HSM);
-	fld_client_debugfs_fini(&obd->u.lmv.lmv_fld);
+	fld_client_debugfs_fini(&lmv->lmv_fld);
+	/* readdir lookahead holds references on the MDC exports */
+	if (lmv->lmv_readdir_wq)
+		flush_workqueue(lmv->lmv_readdir_wq);
 	lprocfs_obd_cleanup(obd);
 	lprocfs_free_md_stats(obd);
+	if (lmv->lmv_readdir_stats) {
+		lprocfs_free_stats(&lmv->lmv_readdir_stats);
+		lmv->lmv_readdir_stats = NULL;
+	}
 	RETURN(0);
 }
 
@@ -3313,6 +3499,16 @@ static int lmv_set_info_async(const struct lu_env *env, struct obd_export *exp,
 	}
 	lmv = &obd->u.lmv;
 
+	if (KEY_IS(KEY_READDIR_AHEAD_STOP)) {
+		/* the lookahead work holds stripe inodes and MDC exports,
+		 * drop them before the superblock goes away
+		 */
+		WRITE_ONCE(lmv->lmv_readdir_stop, true);
+		if (lmv->lmv_readdir_wq)
+			flush_workqueue(lmv->lmv_readdir_wq);
+		RETURN(0);
+	}
+
 	if (KEY_IS(KEY_READ_ONLY) || KEY_IS(KEY_FLUSH_CTX) ||
 	    KEY_IS(KEY_DEFAULT_EASIZE)) {
 		int err = 0;
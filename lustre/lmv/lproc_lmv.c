@@ -197,6 +197,40 @@ static ssize_t qos_threshold_rr_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(qos_threshold_rr);
 
+static ssize_t readdir_prefetch_show(struct kobject *kobj,
+				     struct attribute *attr,
+				     char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 obd->u.lmv.lmv_readdir_prefetch);
+}
+
+static ssize_t readdir_prefetch_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer,
+				      size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > LMV_READDIR_PREFETCH_MAX)
+		return -ERANGE;
+
+	obd->u.lmv.lmv_readdir_prefetch = val;
+
+	return count;
+}
+LUSTRE_RW_ATTR(readdir_prefetch);
+
 #ifdef CONFIG_PROC_FS
 static void *lmv_tgt_seq_start(struct seq_file *p, loff_t *pos)
 {
@@ -287,17 +321,53 @@ static struct attribute *lmv_attrs[] = {
 	&lustre_attr_qos_maxage.attr,
 	&lustre_attr_qos_prio_free.attr,
 	&lustre_attr_qos_threshold_rr.attr,
+	&lustre_attr_readdir_prefetch.attr,
 	NULL,
 };
 
+static const char * const lmv_readdir_stats_names[] = {
+	[LMV_READDIR_PAGE]		= "read_page",
+	[LMV_READDIR_STRIPE_WAIT]	= "stripe_wait",
+	[LMV_READDIR_PREFETCH]		= "prefetch",
+	[LMV_READDIR_PREFETCH_SKIP]	= "prefetch_skip",
+};
+
 int lmv_tunables_init(struct obd_device *obd)
 {
+	struct lmv_obd *lmv = &obd->u.lmv;
 	int rc;
 
 	obd->obd_ktype.default_attrs = lmv_attrs;
 	rc = lprocfs_obd_setup(obd, true);
 	if (rc)
 		goto out_failed;
+
+	lmv->lmv_readdir_stats = lprocfs_alloc_stats(LMV_READDIR_STATS_NUM,
+						     LPROCFS_STATS_FLAG_NONE);
+	if (lmv->lmv_readdir_stats) {
+		lprocfs_counter_init(lmv->lmv_readdir_stats, LMV_READDIR_PAGE,
+				     LPROCFS_TYPE_BYTES | LPROCFS_CNTR_AVGMINMAX,
+				     lmv_readdir_stats_names[LMV_READDIR_PAGE],
+				     "bytes");
+		lprocfs_counter_init(lmv->lmv_readdir_stats,
+				     LMV_READDIR_STRIPE_WAIT,
+				     LPROCFS_TYPE_LATENCY,
+				     lmv_readdir_stats_names[LMV_READDIR_STRIPE_WAIT],
+				     "usecs");
+		lprocfs_counter_init(lmv->lmv_readdir_stats,
+				     LMV_READDIR_PREFETCH, LPROCFS_TYPE_PAGES,
+				     lmv_readdir_stats_names[LMV_READDIR_PREFETCH],
+				     "pages");
+		lprocfs_counter_init(lmv->lmv_readdir_stats,
+				     LMV_READDIR_PREFETCH_SKIP,
+				     LPROCFS_TYPE_REQS,
+				     lmv_readdir_stats_names[LMV_READDIR_PREFETCH_SKIP],
+				     "reqs");
+		debugfs_create_file("readdir_stats", 0644,
+				    obd->obd_debugfs_entry,
+				    lmv->lmv_readdir_stats,
+				    &ldebugfs_stats_seq_fops);
+	}
 #ifdef CONFIG_PROC_FS
 	rc = lprocfs_alloc_md_stats(obd, 0);
 	if (rc) {
@@ -98,6 +98,31 @@ struct chlg_reader_state {
 	unsigned int		    crs_last_catidx;
 	unsigned int		    crs_last_idx;
 	bool			    crs_poll;
+	/* Changelog catalogs (shards) of the MDT, 0 until first load */
+	unsigned int		    crs_nshards;
+	/* Per shard state, only used if there are several shards */
+	struct chlg_shard	   *crs_shards;
+	/* Sequence number of the last shard read pass */
+	__u64			    crs_fill_seq;
+};
+
+/*
+ * An MDT can spread changelog records over several catalogs, each ordered
+ * by cr_index. Records of every shard are buffered separately and merged
+ * by index before being handed to readers.
+ */
+struct chlg_shard {
+	struct chlg_reader_state   *cs_crs;
+	/* Records read from this shard and not merged yet, in index order */
+	struct list_head	    cs_queue;
+	unsigned int		    cs_count;
+	/* Position of the last record read, to resume the next pass */
+	unsigned int		    cs_last_catidx;
+	unsigned int		    cs_last_idx;
+	/* Last pass stopped on the batch limit rather than the shard end */
+	bool			    cs_more;
+	/* Pass that last reached the end of the shard */
+	__u64			    cs_tail_seq;
 };
 
 struct chlg_rec_entry {
@@ -105,6 +130,8 @@ struct chlg_rec_entry {
 	struct list_head	enq_linkage;
 	/* Data (enq_record) field length */
 	__u64			enq_length;
+	/* Shard read pass this record was found in */
+	__u64			enq_seq;
 	/* Copy of a changelog record (see struct llog_changelog_rec) */
 	struct changelog_rec	enq_record[];
 };
@@ -112,8 +139,16 @@ struct chlg_rec_entry {
 enum {
 	/* Number of records to prefetch locally. */
 	CDEV_CHLG_MAX_PREFETCH = 1024,
+	/* Number of records read from one shard per pass. */
+	CDEV_CHLG_SHARD_BATCH = 256,
 };
 
+/* Changelog catalog flags understood by this client */
+#define CHLG_CAT_FLAGS	(LLOG_F_IS_CAT | LLOG_F_EXT_JOBID |		\
+			 LLOG_F_EXT_EXTRA_FLAGS | LLOG_F_EXT_X_UIDGID |	\
+			 LLOG_F_EXT_X_NID | LLOG_F_EXT_X_OMODE |	\
+			 LLOG_F_EXT_X_XATTR)
+
 DEFINE_IDR(mdc_changelog_minor_idr);
 static DEFINE_SPINLOCK(chlg_minor_lock);
 
@@ -189,6 +224,62 @@ static inline void chlg_obd_put(struct chlg_registered_dev *dev,
 	class_decref(obd, "changelog", dev);
 }
 
+/**
+ * Copy a changelog record into a new queue entry.
+ */
+static struct chlg_rec_entry *
+chlg_rec_entry_alloc(struct llog_changelog_rec *rec)
+{
+	struct chlg_rec_entry *enq;
+	size_t len;
+
+	CDEBUG(D_HSM, "%llu %02d%-5s %llu 0x%x t="DFID" p="DFID" %.*s\n",
+	       rec->cr.cr_index, rec->cr.cr_type,
+	       changelog_type2str(rec->cr.cr_type), rec->cr.cr_time,
+	       rec->cr.cr_flags & CLF_FLAGMASK,
+	       PFID(&rec->cr.cr_tfid), PFID(&rec->cr.cr_pfid),
+	       rec->cr.cr_namelen, changelog_rec_name(&rec->cr));
+
+	len = changelog_rec_size(&rec->cr) + rec->cr.cr_namelen;
+	OBD_ALLOC(enq, sizeof(*enq) + len);
+	if (enq == NULL)
+		return NULL;
+
+	INIT_LIST_HEAD(&enq->enq_linkage);
+	enq->enq_length = len;
+	memcpy(enq->enq_record, &rec->cr, len);
+
+	return enq;
+}
+
+/**
+ * Hand a record over to the readers, waiting for room in the prefetch queue.
+ *
+ * @return 0 on success, LLOG_PROC_BREAK if the thread is being stopped, in
+ *	   which case the record is freed.
+ */
+static int chlg_rec_enqueue(struct chlg_reader_state *crs,
+			    struct chlg_rec_entry *enq)
+{
+	wait_event_interruptible(crs->crs_waitq_prod,
+				 crs->crs_rec_count < CDEV_CHLG_MAX_PREFETCH ||
+				 kthread_should_stop());
+
+	if (kthread_should_stop()) {
+		OBD_FREE(enq, sizeof(*enq) + enq->enq_length);
+		return LLOG_PROC_BREAK;
+	}
+
+	mutex_lock(&crs->crs_lock);
+	list_add_tail(&enq->enq_linkage, &crs->crs_rec_queue);
+	crs->crs_rec_count++;
+	mutex_unlock(&crs->crs_lock);
+
+	wake_up(&crs->crs_waitq_cons);
+
+	return 0;
+}
+
 /**
  * ChangeLog catalog processing callback invoked on each record.
  * If the current record is eligible to userland delivery, push
@@ -208,7 +299,6 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	struct llog_changelog_rec *rec;
 	struct chlg_reader_state *crs = data;
 	struct chlg_rec_entry *enq;
-	size_t len;
 	int rc;
 	ENTRY;
 
@@ -232,35 +322,65 @@ static int chlg_read_cat_process_cb(const struct lu_env *env,
 	if (rec->cr.cr_index < crs->crs_start_offset)
 		RETURN(0);
 
-	CDEBUG(D_HSM, "%llu %02d%-5s %llu 0x%x t="DFID" p="DFID" %.*s\n",
-	       rec->cr.cr_index, rec->cr.cr_type,
-	       changelog_type2str(rec->cr.cr_type), rec->cr.cr_time,
-	       rec->cr.cr_flags & CLF_FLAGMASK,
-	       PFID(&rec->cr.cr_tfid), PFID(&rec->cr.cr_pfid),
-	       rec->cr.cr_namelen, changelog_rec_name(&rec->cr));
+	enq = chlg_rec_entry_alloc(rec);
+	if (enq == NULL)
+		RETURN(-ENOMEM);
 
-	wait_event_interruptible(crs->crs_waitq_prod,
-				 crs->crs_rec_count < CDEV_CHLG_MAX_PREFETCH ||
-				 kthread_should_stop());
+	RETURN(chlg_rec_enqueue(crs, enq));
+}
+
+/**
+ * Callback reading one shard of a sharded changelog. Records are buffered
+ * in the shard queue, and the pass stops after CDEV_CHLG_SHARD_BATCH records
+ * so that all shards advance together.
+ *
+ * @param[in]     env  (unused)
+ * @param[in]     llh  Client-side handle used to identify the llog
+ * @param[in]     hdr  Header of the current llog record
+ * @param[in,out] data chlg_shard being read
+ *
+ * @return 0 or LLOG_PROC_* control code on success, negated error on failure.
+ */
+static int chlg_read_shard_cb(const struct lu_env *env,
+			      struct llog_handle *llh,
+			      struct llog_rec_hdr *hdr, void *data)
+{
+	struct chlg_shard *cs = data;
+	struct chlg_reader_state *crs = cs->cs_crs;
+	struct llog_changelog_rec *rec;
+	struct chlg_rec_entry *enq;
+	int rc;
+
+	ENTRY;
+	rec = container_of(hdr, struct llog_changelog_rec, cr_hdr);
+
+	cs->cs_last_catidx = llh->lgh_hdr->llh_cat_idx;
+	cs->cs_last_idx = hdr->lrh_index;
+
+	if (rec->cr_hdr.lrh_type != CHANGELOG_REC) {
+		rc = -EINVAL;
+		CERROR("%s: not a changelog rec %x/%d in llog : rc = %d\n",
+		       crs->crs_obd->obd_name, rec->cr_hdr.lrh_type,
+		       rec->cr.cr_type, rc);
+		RETURN(rc);
+	}
 
 	if (kthread_should_stop())
 		RETURN(LLOG_PROC_BREAK);
 
-	len = changelog_rec_size(&rec->cr) + rec->cr.cr_namelen;
-	OBD_ALLOC(enq, sizeof(*enq) + len);
+	if (rec->cr.cr_index < crs->crs_start_offset)
+		RETURN(0);
+
+	enq = chlg_rec_entry_alloc(rec);
 	if (enq == NULL)
 		RETURN(-ENOMEM);
 
-	INIT_LIST_HEAD(&enq->enq_linkage);
-	enq->enq_length = len;
-	memcpy(enq->enq_record, &rec->cr, len);
-
-	mutex_lock(&crs->crs_lock);
-	list_add_tail(&enq->enq_linkage, &crs->crs_rec_queue);
-	crs->crs_rec_count++;
-	mutex_unlock(&crs->crs_lock);
-
-	wake_up(&crs->crs_waitq_cons);
+	enq->enq_seq = crs->crs_fill_seq;
+	list_add_tail(&enq->enq_linkage, &cs->cs_queue);
+	if (++cs->cs_count >= CDEV_CHLG_SHARD_BATCH) {
+		cs->cs_more = true;
+		RETURN(LLOG_PROC_BREAK);
+	}
 
 	RETURN(0);
 }
@@ -274,6 +394,263 @@ static void enq_record_delete(struct chlg_rec_entry *rec)
 	OBD_FREE(rec, sizeof(*rec) + rec->enq_length);
 }
 
+/**
+ * Open changelog catalog \a idx of the MDT through the llog RPCs.
+ * Shard 0 is CHANGELOG_CATALOG, other shards are "changelog_catalog.N".
+ */
+static int chlg_cat_open(struct chlg_reader_state *crs, struct llog_ctxt *ctx,
+			 unsigned int idx, struct llog_handle **llhp)
+{
+	char name[32];
+	int rc;
+
+	if (idx == 0)
+		strlcpy(name, CHANGELOG_CATALOG, sizeof(name));
+	else
+		snprintf(name, sizeof(name), "%s.%u", CHANGELOG_CATALOG, idx);
+
+	rc = llog_open(NULL, ctx, llhp, NULL, name, LLOG_OPEN_EXISTS);
+	if (rc) {
+		if (rc != -ENOENT || idx == 0)
+			CERROR("%s: fail to open changelog catalog %s: rc = %d\n",
+			       crs->crs_obd->obd_name, name, rc);
+		return rc;
+	}
+
+	rc = llog_init_handle(NULL, *llhp, CHLG_CAT_FLAGS, NULL);
+	if (rc) {
+		CERROR("%s: fail to init llog handle: rc = %d\n",
+		       crs->crs_obd->obd_name, rc);
+		llog_cat_close(NULL, *llhp);
+		*llhp = NULL;
+	}
+
+	return rc;
+}
+
+/**
+ * Count the changelog shards of the MDT and set up per shard state if there
+ * are several. Servers without sharding only have CHANGELOG_CATALOG.
+ *
+ * This is done again when a pass finds nothing new, so that a reader
+ * following the changelog also gets the shards added on the MDT since.
+ */
+static int chlg_shards_init(struct chlg_reader_state *crs,
+			    struct llog_ctxt *ctx)
+{
+	struct chlg_shard *shards;
+	struct llog_handle *llh;
+	unsigned int nshards;
+	unsigned int i;
+	int rc;
+
+	for (nshards = crs->crs_nshards; ; nshards++) {
+		rc = chlg_cat_open(crs, ctx, nshards, &llh);
+		if (rc == -ENOENT && nshards > 0)
+			break;
+		if (rc)
+			return rc;
+		llog_cat_close(NULL, llh);
+	}
+
+	if (nshards == crs->crs_nshards)
+		return 0;
+
+	if (nshards > 1) {
+		OBD_ALLOC_PTR_ARRAY(shards, nshards);
+		if (shards == NULL)
+			return -ENOMEM;
+
+		for (i = 0; i < nshards; i++) {
+			shards[i].cs_crs = crs;
+			INIT_LIST_HEAD(&shards[i].cs_queue);
+			if (crs->crs_shards == NULL || i >= crs->crs_nshards)
+				continue;
+
+			/* keep what was read from the known shards */
+			list_splice_init(&crs->crs_shards[i].cs_queue,
+					 &shards[i].cs_queue);
+			shards[i].cs_count = crs->crs_shards[i].cs_count;
+			shards[i].cs_last_catidx =
+				crs->crs_shards[i].cs_last_catidx;
+			shards[i].cs_last_idx = crs->crs_shards[i].cs_last_idx;
+			shards[i].cs_more = crs->crs_shards[i].cs_more;
+			shards[i].cs_tail_seq = crs->crs_shards[i].cs_tail_seq;
+		}
+
+		if (crs->crs_shards != NULL) {
+			OBD_FREE_PTR_ARRAY(crs->crs_shards, crs->crs_nshards);
+		} else if (crs->crs_nshards == 1) {
+			/* resume shard 0 where the single catalog read ended */
+			shards[0].cs_last_catidx = crs->crs_last_catidx;
+			shards[0].cs_last_idx = crs->crs_last_idx;
+		}
+		crs->crs_shards = shards;
+	}
+	crs->crs_nshards = nshards;
+
+	return 0;
+}
+
+static void chlg_shards_fini(struct chlg_reader_state *crs)
+{
+	struct chlg_rec_entry *rec;
+	struct chlg_rec_entry *tmp;
+	unsigned int i;
+
+	if (crs->crs_shards == NULL)
+		return;
+
+	for (i = 0; i < crs->crs_nshards; i++)
+		list_for_each_entry_safe(rec, tmp,
+					 &crs->crs_shards[i].cs_queue,
+					 enq_linkage)
+			enq_record_delete(rec);
+
+	OBD_FREE_PTR_ARRAY(crs->crs_shards, crs->crs_nshards);
+	crs->crs_shards = NULL;
+}
+
+/**
+ * Read the next batch of records of shard \a idx into its queue.
+ */
+static int chlg_shard_fill(struct chlg_reader_state *crs,
+			   struct llog_ctxt *ctx, unsigned int idx)
+{
+	struct chlg_shard *cs = &crs->crs_shards[idx];
+	struct llog_handle *llh;
+	int rc;
+
+	rc = chlg_cat_open(crs, ctx, idx, &llh);
+	if (rc == -ENOENT && idx > 0) {
+		/* drained shard retired by the MDT on remount */
+		cs->cs_more = false;
+		cs->cs_tail_seq = ++crs->crs_fill_seq;
+		return 0;
+	}
+	if (rc)
+		return rc;
+
+	cs->cs_more = false;
+	crs->crs_fill_seq++;
+	rc = llog_cat_process(NULL, llh, chlg_read_shard_cb, cs,
+			      cs->cs_last_catidx, cs->cs_last_idx);
+	llog_cat_close(NULL, llh);
+	if (rc < 0) {
+		CERROR("%s: fail to process llog: rc = %d\n",
+		       crs->crs_obd->obd_name, rc);
+		return rc;
+	}
+
+	if (!cs->cs_more)
+		cs->cs_tail_seq = crs->crs_fill_seq;
+
+	return 0;
+}
+
+/**
+ * Pick the record with the lowest index among the shard queues.
+ *
+ * A shard with nothing buffered may still hold a lower index: either it has
+ * more records to read, or a record was being written to it when it was
+ * last read. The head record is only released once every such shard has
+ * been found at its end by a pass started after the record itself was read,
+ * as the index of a record is allocated while its shard is being written.
+ *
+ * @return the record removed from its shard queue, or NULL if none can be
+ *	   released yet.
+ */
+static struct chlg_rec_entry *chlg_shards_next(struct chlg_reader_state *crs)
+{
+	struct chlg_rec_entry *best = NULL;
+	struct chlg_rec_entry *head;
+	struct chlg_shard *cs;
+	unsigned int best_idx = 0;
+	unsigned int i;
+
+	for (i = 0; i < crs->crs_nshards; i++) {
+		cs = &crs->crs_shards[i];
+		if (list_empty(&cs->cs_queue))
+			continue;
+
+		head = list_first_entry(&cs->cs_queue, struct chlg_rec_entry,
+					enq_linkage);
+		if (best == NULL ||
+		    head->enq_record->cr_index < best->enq_record->cr_index) {
+			best = head;
+			best_idx = i;
+		}
+	}
+
+	if (best == NULL)
+		return NULL;
+
+	for (i = 0; i < crs->crs_nshards; i++) {
+		cs = &crs->crs_shards[i];
+		if (i == best_idx || !list_empty(&cs->cs_queue))
+			continue;
+
+		if (cs->cs_more || cs->cs_tail_seq <= best->enq_seq)
+			return NULL;
+	}
+
+	cs = &crs->crs_shards[best_idx];
+	list_del_init(&best->enq_linkage);
+	cs->cs_count--;
+
+	return best;
+}
+
+/**
+ * Merge the changelog shards into the reader queue in index order.
+ *
+ * @return 1 once all records available have been delivered, 0 if there were
+ *	   none, negated error code on failure.
+ */
+static int chlg_load_shards(struct chlg_reader_state *crs,
+			    struct llog_ctxt *ctx)
+{
+	struct chlg_rec_entry *enq;
+	bool found = false;
+	bool idle;
+	unsigned int i;
+	int rc;
+
+	do {
+		idle = true;
+
+		/* refill drained shards, this re-polls the ones at their end */
+		for (i = 0; i < crs->crs_nshards; i++) {
+			if (crs->crs_shards[i].cs_count > 0)
+				continue;
+
+			rc = chlg_shard_fill(crs, ctx, i);
+			if (rc < 0)
+				return rc;
+			if (crs->crs_shards[i].cs_count > 0)
+				idle = false;
+		}
+
+		while ((enq = chlg_shards_next(crs)) != NULL) {
+			idle = false;
+			found = true;
+			if (enq->enq_record->cr_index < crs->crs_start_offset) {
+				enq_record_delete(enq);
+				continue;
+			}
+
+			rc = chlg_rec_enqueue(crs, enq);
+			if (rc)
+				return 1;
+		}
+
+		if (kthread_should_stop())
+			return 1;
+	} while (!idle);
+
+	return found;
+}
+
 /**
  * Record prefetch thread entry point. Opens the changelog catalog and starts
  * reading records.
@@ -288,6 +665,9 @@ static int chlg_load(void *args)
 	struct obd_device *obd = NULL;
 	struct llog_ctxt *ctx = NULL;
 	struct llog_handle *llh = NULL;
+	unsigned int last_catidx;
+	unsigned int last_idx;
+	bool found = true;
 	int rc;
 	ENTRY;
 
@@ -305,38 +685,40 @@ again:
 	if (ctx == NULL)
 		GOTO(err_out, rc = -ENOENT);
 
-	rc = llog_open(NULL, ctx, &llh, NULL, CHANGELOG_CATALOG,
-		       LLOG_OPEN_EXISTS);
-	if (rc) {
-		CERROR("%s: fail to open changelog catalog: rc = %d\n",
-		       obd->obd_name, rc);
-		GOTO(err_out, rc);
+	/* probe again if the last pass found nothing, shards may be added */
+	if (crs->crs_nshards == 0 || !found) {
+		rc = chlg_shards_init(crs, ctx);
+		if (rc)
+			GOTO(err_out, rc);
 	}
 
+	if (crs->crs_nshards > 1) {
+		rc = chlg_load_shards(crs, ctx);
+		if (rc < 0)
+			GOTO(err_out, rc);
+		found = rc > 0;
+		rc = 0;
+		goto loaded;
+	}
 
-	rc = llog_init_handle(NULL, llh,
-			      LLOG_F_IS_CAT |
-			      LLOG_F_EXT_JOBID |
-			      LLOG_F_EXT_EXTRA_FLAGS |
-			      LLOG_F_EXT_X_UIDGID |
-			      LLOG_F_EXT_X_NID |
-			      LLOG_F_EXT_X_OMODE |
-			      LLOG_F_EXT_X_XATTR,
-			      NULL);
-	if (rc) {
-		CERROR("%s: fail to init llog handle: rc = %d\n",
-		       obd->obd_name, rc);
+	rc = chlg_cat_open(crs, ctx, 0, &llh);
+	if (rc)
 		GOTO(err_out, rc);
-	}
 
+	last_catidx = crs->crs_last_catidx;
+	last_idx = crs->crs_last_idx;
 	rc = llog_cat_process(NULL, llh, chlg_read_cat_process_cb, crs,
 				crs->crs_last_catidx, crs->crs_last_idx);
 	if (rc < 0) {
 		CERROR("%s: fail to process llog: rc = %d\n", obd->obd_name, rc);
 		GOTO(err_out, rc);
 	}
+	llog_cat_close(NULL, llh);
+	llh = NULL;
+	found = crs->crs_last_catidx != last_catidx ||
+		crs->crs_last_idx != last_idx;
+loaded:
 	if (!kthread_should_stop() && crs->crs_poll) {
-		llog_cat_close(NULL, llh);
 		llog_ctxt_put(ctx);
 		class_decref(obd, "changelog", crs);
 		schedule_timeout_interruptible(cfs_time_seconds(1));
@@ -665,6 +1047,7 @@ static int chlg_release(struct inode *inode, struct file *file)
 
 	list_for_each_entry_safe(rec, tmp, &crs->crs_rec_queue, enq_linkage)
 		enq_record_delete(rec);
+	chlg_shards_fini(crs);
 
 	kref_put(&crs->crs_ced->ced_refs, chlg_dev_clear);
 	OBD_FREE_PTR(crs);
@@ -191,8 +191,11 @@ int mdc_ldlm_blocking_ast(struct ldlm_lock *dlmlock,
 int mdc_ldlm_glimpse_ast(struct ldlm_lock *dlmlock, void *data);
 int mdc_fill_lvb(struct req_capsule *pill, struct ost_lvb *lvb);
 
-/* the minimum inline repsize should be PAGE_SIZE at least */
-#define MDC_DOM_DEF_INLINE_REPSIZE max(8192UL, PAGE_SIZE)
+/* the minimum inline repsize should be PAGE_SIZE at least, the default lets
+ * DoM files up to the default mdt.*.dom_read_open_max_size come whole in the
+ * first open reply
+ */
+#define MDC_DOM_DEF_INLINE_REPSIZE max(65536UL, PAGE_SIZE)
 #define MDC_DOM_MAX_INLINE_REPSIZE XATTR_SIZE_MAX
 
 #endif
@@ -57,6 +57,7 @@ static struct lu_device_type mdd_device_type;
 static const char mdd_root_dir_name[] = "ROOT";
 static const char mdd_obf_dir_name[] = "fid";
 static const char mdd_lpf_dir_name[] = "lost+found";
+static const char mdd_chlg_shards_name[] = "changelog_shards";
 
 /* Slab for MDD object allocation */
 struct kmem_cache *mdd_object_kmem;
@@ -199,8 +200,10 @@ static int changelog_init_cb(const struct lu_env *env, struct llog_handle *llh,
 	       DFID"\n", hdr->lrh_index, rec->cr_hdr.lrh_index,
 	       rec->cr.cr_index, rec->cr.cr_type, rec->cr.cr_namelen,
 	       changelog_rec_name(&rec->cr), PFID(&llh->lgh_id.lgl_oi.oi_fid));
+	/* last record of each shard, keep the highest one */
 	spin_lock(&mdd->mdd_cl.mc_lock);
-	mdd->mdd_cl.mc_index = rec->cr.cr_index;
+	if (rec->cr.cr_index > mdd->mdd_cl.mc_index)
+		mdd->mdd_cl.mc_index = rec->cr.cr_index;
 	spin_unlock(&mdd->mdd_cl.mc_lock);
 	return LLOG_PROC_BREAK;
 }
@@ -392,8 +395,11 @@ static int llog_changelog_cancel_cb(const struct lu_env *env,
 	/* Records folow one by one, cr_index++. We could calculate the
 	 * last cr_index at this plain llog. And if it less then cookie endrec
 	 * cancel the whole file.
+	 * With several shards the indexes of a plain llog are increasing but
+	 * not consecutive, so records are cancelled one by one instead.
 	 */
-	if ((LLOG_HDR_BITMAP_SIZE(llh->lgh_hdr) - hdr->lrh_index +
+	if (cl_cookie->mdd->mdd_cl.mc_nshards_open == 1 &&
+	    (LLOG_HDR_BITMAP_SIZE(llh->lgh_hdr) - hdr->lrh_index +
 	     rec->cr.cr_index) < cl_cookie->endrec) {
 		int rc;
 
@@ -422,25 +428,263 @@ static int llog_changelog_cancel(const struct lu_env *env,
 				 struct llog_ctxt *ctxt,
 				 struct changelog_cancel_cookie *cookie)
 {
-	struct llog_handle	*cathandle = ctxt->loc_handle;
-	int			 rc;
+	struct mdd_changelog	*mc = &cookie->mdd->mdd_cl;
+	struct llog_handle	*cathandle;
+	unsigned int		 i;
+	int			 rc = 0;
 
 	ENTRY;
 
-	/* This should only be called with the catalog handle */
-	LASSERT(cathandle->lgh_hdr->llh_flags & LLOG_F_IS_CAT);
+	for (i = 0; i < READ_ONCE(mc->mc_nshards_open); i++) {
+		cathandle = mdd_changelog_shard(cookie->mdd, i);
+
+		/* This should only be called with the catalog handle */
+		LASSERT(cathandle->lgh_hdr->llh_flags & LLOG_F_IS_CAT);
+
+		rc = llog_cat_process(env, cathandle, llog_changelog_cancel_cb,
+				      cookie, 0, 0);
+		if (rc >= 0) {
+			/* 0 or 1 means we're done */
+			rc = 0;
+		} else {
+			CERROR("%s: cancel idx %u of catalog "DFID": rc = %d\n",
+			       ctxt->loc_obd->obd_name,
+			       cathandle->lgh_last_idx,
+			       PFID(&cathandle->lgh_id.lgl_oi.oi_fid), rc);
+			break;
+		}
+	}
 
-	rc = llog_cat_process(env, cathandle, llog_changelog_cancel_cb,
-			      cookie, 0, 0);
-	if (rc >= 0)
-		/* 0 or 1 means we're done */
-		rc = 0;
+	RETURN(rc);
+}
+
+/**
+ * Open changelog shard \a idx of the changelog context and publish it.
+ * Shard 0 is the CHANGELOG_CATALOG itself, the others are the
+ * "changelog_catalog.N" catalogs in the same context, so that clients can
+ * open them by name through the llog RPCs like the first one.
+ *
+ * \param[in] create	create the catalog if it does not exist yet
+ *
+ * \retval 0 on success, -ENOENT if \a create is false and it does not exist
+ */
+static int mdd_changelog_shard_open(const struct lu_env *env,
+				    struct mdd_device *mdd,
+				    struct llog_ctxt *ctxt,
+				    unsigned int idx, bool create)
+{
+	struct mdd_changelog *mc = &mdd->mdd_cl;
+	struct llog_handle *lgh;
+	char name[32];
+	int rc;
+
+	LASSERT(idx > 0 && idx < MDD_CHLG_SHARDS_MAX);
+	LASSERT(idx == mc->mc_nshards_open);
+
+	snprintf(name, sizeof(name), "%s.%u", CHANGELOG_CATALOG, idx);
+	if (create)
+		rc = llog_open_create(env, ctxt, &lgh, NULL, name);
 	else
-		CERROR("%s: cancel idx %u of catalog "DFID": rc = %d\n",
-		       ctxt->loc_obd->obd_name, cathandle->lgh_last_idx,
-		       PFID(&cathandle->lgh_id.lgl_oi.oi_fid), rc);
+		rc = llog_open(env, ctxt, &lgh, NULL, name, LLOG_OPEN_EXISTS);
+	if (rc)
+		return rc;
 
-	RETURN(rc);
+	rc = llog_init_handle(env, lgh, LLOG_F_IS_CAT, NULL);
+	if (rc) {
+		llog_cat_close(env, lgh);
+		return rc;
+	}
+
+	mc->mc_shards[idx] = lgh;
+	/* pairs with smp_rmb() in mdd_changelog_shard() */
+	smp_wmb();
+	WRITE_ONCE(mc->mc_nshards_open, idx + 1);
+
+	return 0;
+}
+
+static void mdd_changelog_shards_close(const struct lu_env *env,
+				       struct mdd_device *mdd)
+{
+	struct mdd_changelog *mc = &mdd->mdd_cl;
+
+	/* shard 0 is closed with its context */
+	while (mc->mc_nshards_open > 1) {
+		mc->mc_nshards_open--;
+		llog_cat_close(env, mc->mc_shards[mc->mc_nshards_open]);
+		mc->mc_shards[mc->mc_nshards_open] = NULL;
+	}
+	mc->mc_nshards_open = 0;
+	mc->mc_nshards = 0;
+}
+
+/**
+ * Load the shard count saved by mdd_changelog_shards_store().
+ *
+ * \retval 0 on success, -ENOENT if the count was never set
+ */
+static int mdd_changelog_shards_load(const struct lu_env *env,
+				     struct mdd_device *mdd,
+				     unsigned int *nshards)
+{
+	struct dt_object *root, *obj;
+	struct lu_fid fid;
+	__le32 val;
+	struct lu_buf buf = { .lb_buf = &val, .lb_len = sizeof(val) };
+	loff_t pos = 0;
+	int rc;
+
+	root = dt_locate(env, mdd->mdd_bottom, &mdd->mdd_local_root_fid);
+	if (IS_ERR(root))
+		return PTR_ERR(root);
+
+	rc = dt_lookup_dir(env, root, mdd_chlg_shards_name, &fid);
+	dt_object_put(env, root);
+	if (rc)
+		return rc;
+
+	obj = dt_locate(env, mdd->mdd_bottom, &fid);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	rc = dt_record_read(env, obj, &buf, &pos);
+	/* the stack is not fully set up yet, see mdd_local_file_create() */
+	dt_object_put_nocache(env, obj);
+	if (rc == -EFAULT && pos == 0)
+		return -ENOENT;
+	if (rc == 0)
+		*nshards = le32_to_cpu(val);
+
+	return rc;
+}
+
+/* save the shard count so that it is not lost on remount */
+static int mdd_changelog_shards_store(const struct lu_env *env,
+				      struct mdd_device *mdd,
+				      unsigned int nshards)
+{
+	struct dt_object *root, *obj;
+	struct thandle *th;
+	__le32 val = cpu_to_le32(nshards);
+	struct lu_buf buf = { .lb_buf = &val, .lb_len = sizeof(val) };
+	loff_t pos = 0;
+	int rc;
+
+	root = dt_locate(env, mdd->mdd_bottom, &mdd->mdd_local_root_fid);
+	if (IS_ERR(root))
+		return PTR_ERR(root);
+
+	obj = local_file_find_or_create(env, mdd->mdd_los, root,
+					mdd_chlg_shards_name,
+					S_IFREG | S_IRUGO | S_IWUSR);
+	dt_object_put(env, root);
+	if (IS_ERR(obj))
+		return PTR_ERR(obj);
+
+	th = dt_trans_create(env, mdd->mdd_bottom);
+	if (IS_ERR(th))
+		GOTO(out_put, rc = PTR_ERR(th));
+
+	rc = dt_declare_record_write(env, obj, &buf, pos, th);
+	if (rc)
+		GOTO(out_stop, rc);
+
+	rc = dt_trans_start_local(env, mdd->mdd_bottom, th);
+	if (rc)
+		GOTO(out_stop, rc);
+
+	rc = dt_record_write(env, obj, &buf, &pos, th);
+out_stop:
+	dt_trans_stop(env, mdd->mdd_bottom, th);
+out_put:
+	dt_object_put(env, obj);
+	return rc;
+}
+
+/**
+ * Destroy the catalogs of shards above mc_nshards that have no records
+ * left, starting from the last one so that the shards stay contiguous.
+ * Only called at mount time, when no record can be in flight to them, after
+ * the empty plain llogs of the shards were cleaned up.
+ */
+static void mdd_changelog_shards_retire(const struct lu_env *env,
+					struct mdd_device *mdd)
+{
+	struct mdd_changelog *mc = &mdd->mdd_cl;
+	struct llog_handle *lgh;
+	int rc;
+
+	while (mc->mc_nshards_open > mc->mc_nshards) {
+		lgh = mc->mc_shards[mc->mc_nshards_open - 1];
+		/* the catalog header counts itself */
+		if (lgh->lgh_hdr->llh_count > 1)
+			break;
+
+		rc = llog_destroy(env, lgh);
+		if (rc) {
+			CWARN("%s: cannot destroy changelog shard %u: rc = %d\n",
+			      mdd2obd_dev(mdd)->obd_name,
+			      mc->mc_nshards_open - 1, rc);
+			break;
+		}
+		llog_cat_close(env, lgh);
+		mc->mc_nshards_open--;
+		mc->mc_shards[mc->mc_nshards_open] = NULL;
+		CDEBUG(D_INFO, "%s: retired changelog shard %u\n",
+		       mdd2obd_dev(mdd)->obd_name, mc->mc_nshards_open);
+	}
+}
+
+/**
+ * Change the number of changelog shards new records are spread over.
+ *
+ * Missing shard catalogs are created, shards above \a nshards are kept
+ * open so that their records can still be read and purged.  The count is
+ * saved, and shards above it are destroyed at mount once they are drained.
+ */
+int mdd_changelog_shards_set(const struct lu_env *env, struct mdd_device *mdd,
+			     unsigned int nshards)
+{
+	struct obd_device *obd = mdd2obd_dev(mdd);
+	struct mdd_changelog *mc = &mdd->mdd_cl;
+	struct llog_ctxt *ctxt;
+	int rc = 0;
+
+	if (nshards == 0 || nshards > MDD_CHLG_SHARDS_MAX)
+		return -ERANGE;
+
+	ctxt = llog_get_context(obd, LLOG_CHANGELOG_ORIG_CTXT);
+	if (ctxt == NULL)
+		return -ENXIO;
+
+	mutex_lock(&mc->mc_shard_mutex);
+	if (mc->mc_nshards_open == 0)
+		GOTO(out, rc = -ENXIO);
+
+	while (rc == 0 && mc->mc_nshards_open < nshards)
+		rc = mdd_changelog_shard_open(env, mdd, ctxt,
+					      mc->mc_nshards_open, true);
+	if (rc) {
+		CERROR("%s: cannot create changelog shard %u: rc = %d\n",
+		       obd->obd_name, mc->mc_nshards_open, rc);
+		GOTO(out, rc);
+	}
+
+	rc = mdd_changelog_shards_store(env, mdd, nshards);
+	if (rc) {
+		CERROR("%s: cannot save changelog shards %u: rc = %d\n",
+		       obd->obd_name, nshards, rc);
+		GOTO(out, rc);
+	}
+
+	if (mc->mc_nshards != nshards)
+		CDEBUG(D_INFO, "%s: changelog shards %u -> %u\n",
+		       obd->obd_name, mc->mc_nshards, nshards);
+	WRITE_ONCE(mc->mc_nshards, nshards);
+out:
+	mutex_unlock(&mc->mc_shard_mutex);
+	llog_ctxt_put(ctxt);
+	return rc;
 }
 
 static struct llog_operations changelog_orig_logops;
@@ -501,6 +745,8 @@ static int mdd_changelog_llog_init(const struct lu_env *env,
 		.clod_mdd = mdd,
 		.clod_index = -1,
 	};
+	unsigned int nshards = 0;
+	unsigned int i;
 	int rc;
 
 	ENTRY;
@@ -531,17 +777,47 @@ static int mdd_changelog_llog_init(const struct lu_env *env,
 	if (rc)
 		GOTO(out_close, rc);
 
-	rc = llog_cat_reverse_process(env, ctxt->loc_handle,
-				      changelog_init_cb, mdd);
-
-	if (rc < 0) {
-		CERROR("%s: changelog init failed: rc = %d\n", obd->obd_name,
-		       rc);
-		GOTO(out_close, rc);
+	mdd->mdd_cl.mc_shards[0] = ctxt->loc_handle;
+	mdd->mdd_cl.mc_nshards_open = 1;
+
+	/* open the shards created earlier, records are still read from all */
+	while (mdd->mdd_cl.mc_nshards_open < MDD_CHLG_SHARDS_MAX) {
+		rc = mdd_changelog_shard_open(env, mdd, ctxt,
+					      mdd->mdd_cl.mc_nshards_open,
+					      false);
+		if (rc == -ENOENT)
+			break;
+		if (rc) {
+			CERROR("%s: cannot open changelog shard %u: rc = %d\n",
+			       obd->obd_name, mdd->mdd_cl.mc_nshards_open, rc);
+			GOTO(out_close, rc);
+		}
 	}
+	/* all the shards are used if the count was never set */
+	rc = mdd_changelog_shards_load(env, mdd, &nshards);
+	if (rc == 0 && nshards > 0)
+		mdd->mdd_cl.mc_nshards = min(nshards,
+					     mdd->mdd_cl.mc_nshards_open);
+	else
+		mdd->mdd_cl.mc_nshards = mdd->mdd_cl.mc_nshards_open;
+	if (rc && rc != -ENOENT)
+		CWARN("%s: cannot load changelog shards: rc = %d\n",
+		      obd->obd_name, rc);
+
+	for (i = 0; i < mdd->mdd_cl.mc_nshards_open; i++) {
+		rc = llog_cat_reverse_process(env, mdd->mdd_cl.mc_shards[i],
+					      changelog_init_cb, mdd);
+		if (rc < 0) {
+			CERROR("%s: changelog init failed: rc = %d\n",
+			       obd->obd_name, rc);
+			GOTO(out_close, rc);
+		}
+	}
+	/* empty plain llogs were destroyed while looking for the last index */
+	mdd_changelog_shards_retire(env, mdd);
 
-	CDEBUG(D_IOCTL, "changelog starting index=%llu\n",
-	       mdd->mdd_cl.mc_index);
+	CDEBUG(D_IOCTL, "changelog starting index=%llu shards=%u\n",
+	       mdd->mdd_cl.mc_index, mdd->mdd_cl.mc_nshards);
 
 	/* setup user changelog */
 	rc = llog_setup(env, obd, &obd->obd_olg, LLOG_CHANGELOG_USER_ORIG_CTXT,
@@ -592,12 +868,22 @@ static int mdd_changelog_llog_init(const struct lu_env *env,
 	 * processed as a long time idle user record could have been deleted
 	 * XXX we may need to run end of purge as a separate thread
 	 */
-	rc = llog_cat_process(env, ctxt->loc_handle, changelog_detect_orphan_cb,
-			      &clod, 0, 0);
-	if (rc < 0) {
-		CERROR("%s: changelog detect orphan failed: rc = %d\n",
-		       obd->obd_name, rc);
-		GOTO(out_uclose, rc);
+	for (i = 0; i < mdd->mdd_cl.mc_nshards_open; i++) {
+		struct changelog_orphan_data shard_orphan = {
+			.clod_mdd = mdd,
+			.clod_index = -1,
+		};
+
+		rc = llog_cat_process(env, mdd->mdd_cl.mc_shards[i],
+				      changelog_detect_orphan_cb,
+				      &shard_orphan, 0, 0);
+		if (rc < 0) {
+			CERROR("%s: changelog detect orphan failed: rc = %d\n",
+			       obd->obd_name, rc);
+			GOTO(out_uclose, rc);
+		}
+		/* oldest record is the first one of some shard */
+		clod.clod_index = min(clod.clod_index, shard_orphan.clod_index);
 	}
 	rc = llog_cat_process(env, uctxt->loc_handle,
 			      changelog_user_detect_orphan_cb,
@@ -634,6 +920,7 @@ out_uclose:
 out_ucleanup:
 	llog_cleanup(env, uctxt);
 out_close:
+	mdd_changelog_shards_close(env, mdd);
 	llog_cat_close(env, ctxt->loc_handle);
 out_cleanup:
 	llog_cleanup(env, ctxt);
@@ -647,6 +934,7 @@ static int mdd_changelog_init(const struct lu_env *env, struct mdd_device *mdd)
 
 	mdd->mdd_cl.mc_index = 0;
 	spin_lock_init(&mdd->mdd_cl.mc_lock);
+	mutex_init(&mdd->mdd_cl.mc_shard_mutex);
 	mdd->mdd_cl.mc_starttime = ktime_get();
 	spin_lock_init(&mdd->mdd_cl.mc_user_lock);
 	mdd->mdd_cl.mc_lastuser = 0;
@@ -712,6 +1000,7 @@ again:
 
 	ctxt = llog_get_context(obd, LLOG_CHANGELOG_ORIG_CTXT);
 	if (ctxt) {
+		mdd_changelog_shards_close(env, mdd);
 		llog_cat_close(env, ctxt->loc_handle);
 		llog_cleanup(env, ctxt);
 	}
@@ -814,6 +1103,7 @@ int mdd_changelog_write_header(const struct lu_env *env,
 					    rec->cr.cr_namelen);
 	rec->cr_hdr.lrh_type = CHANGELOG_REC;
 	rec->cr.cr_time = cl_time();
+	rec->cr.cr_index = 0;
 
 	ctxt = llog_get_context(obd, LLOG_CHANGELOG_ORIG_CTXT);
 	LASSERT(ctxt);
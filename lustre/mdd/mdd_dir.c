@@ -746,6 +746,21 @@ static int mdd_llog_record_calc_size(const struct lu_env *env,
 			     (sname != NULL ? 1 + sname->ln_namelen : 0));
 }
 
+/**
+ * Select the changelog shard for the current thread.
+ *
+ * MDT service threads are bound to a CPT, so keying on the CPT of the
+ * current CPU spreads concurrent writers over the shards. The choice is kept
+ * in mdi_chlg_shard, so a given transaction always uses the same catalog for
+ * its declaration and for the record itself.
+ */
+static inline unsigned int mdd_changelog_shard_pick(struct mdd_device *mdd)
+{
+	unsigned int nshards = READ_ONCE(mdd->mdd_cl.mc_nshards);
+
+	return nshards > 1 ? cfs_cpt_current(cfs_cpt_tab, 1) % nshards : 0;
+}
+
 int mdd_declare_changelog_store(const struct lu_env *env,
 				struct mdd_device *mdd,
 				enum changelog_rec_type type,
@@ -754,6 +769,8 @@ int mdd_declare_changelog_store(const struct lu_env *env,
 				struct thandle *handle)
 {
 	struct obd_device *obd = mdd2obd_dev(mdd);
+	struct mdd_thread_info *info = mdd_env_info(env);
+	struct llog_handle *cathandle;
 	struct llog_ctxt *ctxt;
 	struct llog_rec_hdr rec_hdr;
 	struct thandle *llog_th;
@@ -769,11 +786,15 @@ int mdd_declare_changelog_store(const struct lu_env *env,
 	if (ctxt == NULL)
 		return -ENXIO;
 
-	llog_th = thandle_get_sub(env, handle, ctxt->loc_handle->lgh_obj);
+	/* the record must be added to the very catalog declared here */
+	info->mdi_chlg_shard = mdd_changelog_shard_pick(mdd);
+	cathandle = mdd_changelog_shard(mdd, info->mdi_chlg_shard);
+
+	llog_th = thandle_get_sub(env, handle, cathandle->lgh_obj);
 	if (IS_ERR(llog_th))
 		GOTO(out_put, rc = PTR_ERR(llog_th));
 
-	rc = llog_declare_add(env, ctxt->loc_handle, &rec_hdr, llog_th);
+	rc = llog_declare_add(env, cathandle, &rec_hdr, llog_th);
 
 out_put:
 	llog_ctxt_put(ctxt);
@@ -796,23 +817,32 @@ int mdd_changelog_write_rec(const struct lu_env *env,
 		mdd = lu2mdd_dev(loghandle->lgh_ctxt->loc_obd->obd_lu_dev);
 		rec = container_of(r, struct llog_changelog_rec, cr_hdr);
 
+		/*
+		 * The index comes from the global sequence while the plain
+		 * llog of this shard is locked, so records are ordered within
+		 * each shard and readers merge shards by cr_index.
+		 */
 		spin_lock(&mdd->mdd_cl.mc_lock);
-		rec->cr.cr_index = mdd->mdd_cl.mc_index + 1;
+		rec->cr.cr_index = ++mdd->mdd_cl.mc_index;
 		spin_unlock(&mdd->mdd_cl.mc_lock);
 
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
 						cookie, idx, th);
 
 		/*
-		 * if current llog is full, we will generate a new
-		 * llog, and since it's actually not an error, let's
-		 * avoid increasing index so that userspace apps
-		 * should not see a gap in the changelog sequence
+		 * If the current llog is full, the record is retried on a new
+		 * llog of this shard, and gets a new index there: writers
+		 * which found the new llog first already stored higher
+		 * indexes in it. Give the index back if nobody took a later
+		 * one, so that userspace apps do not see a gap in the common
+		 * case.
 		 */
-		if (!(rc == -ENOSPC && llog_is_full(loghandle))) {
+		if (rc == -ENOSPC && llog_is_full(loghandle)) {
 			spin_lock(&mdd->mdd_cl.mc_lock);
-			++mdd->mdd_cl.mc_index;
+			if (mdd->mdd_cl.mc_index == rec->cr.cr_index)
+				mdd->mdd_cl.mc_index--;
 			spin_unlock(&mdd->mdd_cl.mc_lock);
+			rec->cr.cr_index = 0;
 		}
 	} else {
 		rc = llog_osd_ops.lop_write_rec(env, loghandle, r,
@@ -844,6 +874,7 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 			struct llog_changelog_rec *rec, struct thandle *th)
 {
 	struct obd_device *obd = mdd2obd_dev(mdd);
+	struct llog_handle *cathandle;
 	struct llog_ctxt *ctxt;
 	struct thandle *llog_th;
 	int rc;
@@ -855,18 +886,21 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 	/* llog_lvfs_write_rec sets the llog tail len */
 	rec->cr_hdr.lrh_type = CHANGELOG_REC;
 	rec->cr.cr_time = cl_time();
+	/* assigned by mdd_changelog_write_rec() */
+	rec->cr.cr_index = 0;
 
 	ctxt = llog_get_context(obd, LLOG_CHANGELOG_ORIG_CTXT);
 	if (ctxt == NULL)
 		return -ENXIO;
 
-	llog_th = thandle_get_sub(env, th, ctxt->loc_handle->lgh_obj);
+	cathandle = mdd_changelog_shard(mdd, mdd_env_info(env)->mdi_chlg_shard);
+	llog_th = thandle_get_sub(env, th, cathandle->lgh_obj);
 	if (IS_ERR(llog_th))
 		GOTO(out_put, rc = PTR_ERR(llog_th));
 
 	OBD_FAIL_TIMEOUT(OBD_FAIL_MDS_CHANGELOG_REORDER, cfs_fail_val);
 	/* nested journal transaction */
-	rc = llog_add(env, ctxt->loc_handle, &rec->cr_hdr, NULL, llog_th);
+	rc = llog_add(env, cathandle, &rec->cr_hdr, NULL, llog_th);
 
 	/* time to recover some space ?? */
 	if (likely(!mdd->mdd_changelog_gc ||
@@ -882,7 +916,7 @@ int mdd_changelog_store(const struct lu_env *env, struct mdd_device *mdd,
 		spin_unlock(&mdd->mdd_cl.mc_lock);
 	}
 
-	need_gc = mdd_changelog_need_gc(env, mdd, ctxt->loc_handle);
+	need_gc = mdd_changelog_need_gc(env, mdd, cathandle);
 	spin_lock(&mdd->mdd_cl.mc_lock);
 	if (likely(mdd->mdd_changelog_gc &&
 		     mdd->mdd_cl.mc_gc_task == MDD_CHLG_GC_NONE &&
@@ -92,6 +92,9 @@
 #define MDD_CHLG_GC_START (struct task_struct *)(-2)
 /** else the started task_struct address when running **/
 
+/* maximum number of changelog catalogs (shards) per MDT */
+#define MDD_CHLG_SHARDS_MAX 16
+
 struct mdd_changelog {
 	spinlock_t		mc_lock;	/* for index */
 	int			mc_flags;
@@ -109,6 +112,11 @@ struct mdd_changelog {
 	unsigned int		mc_deniednext; /* interval for recording denied
 						* accesses
 						*/
+	/* changelog catalogs, shard 0 is the context loc_handle */
+	struct llog_handle	*mc_shards[MDD_CHLG_SHARDS_MAX];
+	unsigned int		mc_nshards;	 /* shards records go to */
+	unsigned int		mc_nshards_open; /* shards to read/purge */
+	struct mutex		mc_shard_mutex;	 /* serialize shard opens */
 };
 
 static inline __u64 cl_time(void)
@@ -214,6 +222,8 @@ struct mdd_thread_info {
 	struct dt_insert_rec	  mdi_dt_rec;
 	struct lu_seq_range	  mdi_range;
 	struct md_layout_change	  mdi_mlc;
+	/* changelog shard declared for the current transaction */
+	unsigned int		  mdi_chlg_shard;
 };
 
 int mdd_la_get(const struct lu_env *env, struct mdd_object *obj,
@@ -438,6 +448,8 @@ char *mdd_chlg_username(struct llog_changelog_user_rec2 *rec, char *buf,
 			size_t len);
 __u32 mdd_chlg_usermask(struct llog_changelog_user_rec2 *rec);
 int mdd_changelog_recalc_mask(const struct lu_env *env, struct mdd_device *mdd);
+int mdd_changelog_shards_set(const struct lu_env *env, struct mdd_device *mdd,
+			     unsigned int nshards);
 
 /* mdd_prepare.c */
 int mdd_compat_fixes(const struct lu_env *env, struct mdd_device *mdd);
@@ -864,4 +876,15 @@ static inline bool mdd_changelog_is_too_idle(struct mdd_device *mdd,
 		idle_time * idle_indexes > (24 * 3600ULL << 32));
 }
 
+/* catalog of changelog shard \a idx, falls back to shard 0 */
+static inline struct llog_handle *
+mdd_changelog_shard(struct mdd_device *mdd, unsigned int idx)
+{
+	if (idx >= READ_ONCE(mdd->mdd_cl.mc_nshards_open))
+		idx = 0;
+	/* pairs with smp_wmb() in mdd_changelog_shard_open() */
+	smp_rmb();
+	return mdd->mdd_cl.mc_shards[idx];
+}
+
 #endif
@@ -272,7 +272,15 @@ static int mdd_changelog_size_ctxt(const struct lu_env *env,
 		return -EINVAL;
 	}
 
-	*val += llog_cat_size(env, ctxt->loc_handle);
+	if (index == LLOG_CHANGELOG_ORIG_CTXT) {
+		unsigned int i;
+
+		for (i = 0; i < READ_ONCE(mdd->mdd_cl.mc_nshards_open); i++)
+			*val += llog_cat_size(env,
+					      mdd_changelog_shard(mdd, i));
+	} else {
+		*val += llog_cat_size(env, ctxt->loc_handle);
+	}
 
 	llog_ctxt_put(ctxt);
 
@@ -337,6 +345,41 @@ static ssize_t changelog_gc_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(changelog_gc);
 
+static ssize_t changelog_shards_show(struct kobject *kobj,
+				     struct attribute *attr,
+				     char *buf)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+
+	return sprintf(buf, "%u\n", READ_ONCE(mdd->mdd_cl.mc_nshards));
+}
+
+static ssize_t changelog_shards_store(struct kobject *kobj,
+				      struct attribute *attr,
+				      const char *buffer, size_t count)
+{
+	struct mdd_device *mdd = container_of(kobj, struct mdd_device,
+					      mdd_kobj);
+	struct lu_env env;
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	rc = lu_env_init(&env, LCT_LOCAL);
+	if (rc)
+		return rc;
+
+	rc = mdd_changelog_shards_set(&env, mdd, val);
+	lu_env_fini(&env);
+
+	return rc ? rc : count;
+}
+LUSTRE_RW_ATTR(changelog_shards);
+
 static ssize_t changelog_max_idle_time_show(struct kobject *kobj,
 					    struct attribute *attr,
 					    char *buf)
@@ -737,6 +780,7 @@ static struct attribute *mdd_attrs[] = {
 	&lustre_attr_atime_diff.attr,
 	&lustre_attr_changelog_size.attr,
 	&lustre_attr_changelog_gc.attr,
+	&lustre_attr_changelog_shards.attr,
 	&lustre_attr_changelog_max_idle_time.attr,
 	&lustre_attr_changelog_max_idle_indexes.attr,
 	&lustre_attr_changelog_min_gc_interval.attr,
@@ -5989,6 +5989,7 @@ static int mdt_init0(const struct lu_env *env, struct mdt_device *m,
 	m->mdt_opts.mo_dom_lock = TRYLOCK_DOM_ON_OPEN;
 	/* DoM files are read at open and data is packed in the reply */
 	m->mdt_opts.mo_dom_read_open = 1;
+	m->mdt_opts.mo_dom_read_open_max = MDT_DOM_READ_OPEN_MAX_DEF;
 
 	m->mdt_squash.rsi_uid = 0;
 	m->mdt_squash.rsi_gid = 0;
@@ -200,6 +200,13 @@ enum {
 	NUM_DOM_LOCK_ON_OPEN_MODES
 };
 
+/* default and maximum size of DoM files returned whole in the open reply,
+ * the default matches the inline reply buffer allocated by clients by default
+ * (MDC_DOM_DEF_INLINE_REPSIZE), so no resend is needed to deliver the data
+ */
+#define MDT_DOM_READ_OPEN_MAX_DEF	(64 << 10)
+#define MDT_DOM_READ_OPEN_MAX_LIMIT	(512 << 10)
+
 struct mdt_statfs_cache {
 	struct obd_statfs msf_osfs;
 	__u64 msf_age;
@@ -263,6 +270,10 @@ struct mdt_device {
 				   mo_migrate_hsm_allowed:1,
 				   mo_enable_strict_som:1;
 		unsigned int       mo_dom_lock;
+		/* DoM files up to this size are returned whole on open even
+		 * if the client reply buffer is too small for them
+		 */
+		unsigned int       mo_dom_read_open_max;
 	} mdt_opts;
         /* mdt state flags */
         unsigned long              mdt_state;
@@ -1307,6 +1318,7 @@ enum mdt_stat_idx {
 	LPROC_MDT_IO_PUNCH,
 	LPROC_MDT_MIGRATE,
 	LPROC_MDT_FALLOCATE,
+	LPROC_MDT_IO_READ_OPEN_BYTES,
 	LPROC_MDT_LAST,
 };
 
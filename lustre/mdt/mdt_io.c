@@ -1694,6 +1694,7 @@ int mdt_dom_read_on_open(struct mdt_thread_info *mti, struct mdt_device *mdt,
 	__u64 real_dom_size;
 	int lnbs, nr_local, i;
 	bool dom_lock = false;
+	bool truncated = false;
 
 	ENTRY;
 
@@ -1753,12 +1754,22 @@ int mdt_dom_read_on_open(struct mdt_thread_info *mti, struct mdt_device *mdt,
 	 *
 	 * At the moment the following strategy is used:
 	 * 1) try to fit into the buffer we have
-	 * 2) return just file tail otherwise.
+	 * 2) return whole file up to mo_dom_read_open_max, the reply is
+	 *    truncated and the client resends with a larger buffer, but saves
+	 *    the separate DoM lock and BRW. The data is only delivered by the
+	 *    resend, so it is not counted in read_open_bytes here.
+	 * 3) return just file tail otherwise.
 	 */
 	if (real_dom_size <= len) {
 		/* can fit whole data */
 		len = real_dom_size;
 		offset = 0;
+	} else if (real_dom_size <= mdt->mdt_opts.mo_dom_read_open_max) {
+		CDEBUG(D_INFO, "%s: grow reply by %llu bytes for whole file\n",
+		       mdt_obd_name(mdt), real_dom_size - len);
+		len = real_dom_size;
+		offset = 0;
+		truncated = true;
 	} else if (real_dom_size <
 		   mdt_lmm_dom_stripesize(mti->mti_attr.ma_lmm)) {
 		int tail, pgbits;
@@ -1862,6 +1873,8 @@ int mdt_dom_read_on_open(struct mdt_thread_info *mti, struct mdt_device *mdt,
 		      PFID(&tsi->tsi_fid), len);
 		/* Ignore partially copied data */
 		copied = 0;
+	} else if (!truncated) {
+		mdt_counter_incr(req, LPROC_MDT_IO_READ_OPEN_BYTES, copied);
 	}
 	EXIT;
 buf_put:
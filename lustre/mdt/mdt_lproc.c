@@ -1046,6 +1046,56 @@ static ssize_t dom_read_open_store(struct kobject *kobj,
 }
 LUSTRE_RW_ATTR(dom_read_open);
 
+/**
+ * Show the size up to which DoM files are returned whole on open.
+ */
+static ssize_t dom_read_open_max_size_show(struct kobject *kobj,
+					   struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 mdt->mdt_opts.mo_dom_read_open_max);
+}
+
+/**
+ * Set the size up to which DoM files are returned whole on open.
+ *
+ * Files fitting in the reply buffer allocated by the client are always
+ * returned whole. Bigger files up to this size are returned whole too, the
+ * client then resends the open once with a larger reply buffer, which is
+ * still cheaper than a separate lock enqueue and BRW. The default matches
+ * the buffer clients allocate by default; raise it together with the client
+ * mdc.*.mdc_dom_min_repsize to return bigger files without the resend.
+ * 0 restores the old behaviour of returning only a partial tail page.
+ *
+ * \retval		\a count on success
+ * \retval		negative number on error
+ */
+static ssize_t dom_read_open_max_size_store(struct kobject *kobj,
+					    struct attribute *attr,
+					    const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct mdt_device *mdt = mdt_dev(obd->obd_lu_dev);
+	u64 val;
+	int rc;
+
+	rc = sysfs_memparse(buffer, count, &val, "B");
+	if (rc)
+		return rc;
+
+	if (val > MDT_DOM_READ_OPEN_MAX_LIMIT)
+		return -ERANGE;
+
+	mdt->mdt_opts.mo_dom_read_open_max = val;
+	return count;
+}
+LUSTRE_RW_ATTR(dom_read_open_max_size);
+
 /**
  * Show policy for using strict SOM information for real size (stat size).
  *
@@ -1465,6 +1515,7 @@ static struct attribute *mdt_attrs[] = {
 	&lustre_attr_sync_count.attr,
 	&lustre_attr_dom_lock.attr,
 	&lustre_attr_dom_read_open.attr,
+	&lustre_attr_dom_read_open_max_size.attr,
 	&lustre_attr_enable_strict_som.attr,
 	&lustre_attr_migrate_hsm_allowed.attr,
 	&lustre_attr_hsm_control.attr,
@@ -1584,6 +1635,7 @@ static const char * const mdt_stats[] = {
 	[LPROC_MDT_IO_PUNCH]		= "punch",
 	[LPROC_MDT_MIGRATE]		= "migrate",
 	[LPROC_MDT_FALLOCATE]		= "fallocate",
+	[LPROC_MDT_IO_READ_OPEN_BYTES]	= "read_open_bytes",
 };
 
 void mdt_stats_counter_init(struct lprocfs_stats *stats, unsigned int offset)
@@ -1597,7 +1649,8 @@ void mdt_stats_counter_init(struct lprocfs_stats *stats, unsigned int offset)
 	for (midx = 0; midx < array_size; midx++) {
 		oidx = midx + offset;
 		if (midx == LPROC_MDT_IO_READ_BYTES ||
-		    midx == LPROC_MDT_IO_WRITE_BYTES)
+		    midx == LPROC_MDT_IO_WRITE_BYTES ||
+		    midx == LPROC_MDT_IO_READ_OPEN_BYTES)
 			lprocfs_counter_init(stats, oidx,
 					     LPROCFS_TYPE_BYTES_FULL,
 					     mdt_stats[midx], "bytes");
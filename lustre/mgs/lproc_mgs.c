@@ -201,6 +201,27 @@ int lproc_mgs_del_live(struct mgs_device *mgs, struct fs_db *fsdb)
 	return 0;
 }
 
+static ssize_t mgs_llog_cache_seq_write(struct file *file,
+					const char __user *buffer,
+					size_t count, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_device *obd = seq->private;
+	struct mgs_device *mgs = lu2mgs_dev(obd->obd_lu_dev);
+	unsigned int max;
+	int rc;
+
+	/* writing 0 disables the cache and drops all cached replies */
+	rc = kstrtouint_from_user(buffer, count, 0, &max);
+	if (rc)
+		return rc;
+
+	mgs_llog_cache_set_max(mgs, max);
+
+	return count;
+}
+LPROC_SEQ_FOPS(mgs_llog_cache);
+
 LPROC_SEQ_FOPS_RO_TYPE(mgs, hash);
 LPROC_SEQ_FOPS_WR_ONLY(mgs, evict_client);
 LPROC_SEQ_FOPS_RW_TYPE(mgs, ir_timeout);
@@ -212,6 +233,8 @@ static struct lprocfs_vars lprocfs_mgs_obd_vars[] = {
 	  .fops	=	&mgs_evict_client_fops	},
 	{ .name	=	"ir_timeout",
 	  .fops	=	&mgs_ir_timeout_fops	},
+	{ .name	=	"llog_cache",
+	  .fops	=	&mgs_llog_cache_fops	},
 	{ NULL }
 };
 
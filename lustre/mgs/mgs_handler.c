@@ -225,6 +225,10 @@ void mgs_revoke_lock(struct mgs_device *mgs, struct fs_db *fsdb,
 	LASSERT(fsdb->fsdb_name[0] != '\0');
 	rc = mgc_fsname2resid(fsdb->fsdb_name, &res_id, type);
 	LASSERT(rc == 0);
+	/* clients are about to re-read their logs, don't serve stale data */
+	if (type == MGS_CFG_T_CONFIG || type == MGS_CFG_T_PARAMS)
+		mgs_llog_cache_invalidate(mgs);
+
 	switch (type) {
 	case MGS_CFG_T_CONFIG:
 	case MGS_CFG_T_NODEMAP:
@@ -1133,6 +1137,9 @@ out_free:
 		ctxt = llog_get_context(mgs->mgs_obd, LLOG_CONFIG_ORIG_CTXT);
 		rc = llog_ioctl(&env, ctxt, cmd, data);
 		llog_ctxt_put(ctxt);
+		/* records or whole logs may be gone even on error */
+		if (cmd == OBD_IOC_LLOG_CANCEL || cmd == OBD_IOC_LLOG_REMOVE)
+			mgs_llog_cache_invalidate(mgs);
 		break;
         }
 
@@ -1220,8 +1227,8 @@ static struct tgt_handler mgs_dlm_handlers[] = {
 
 static struct tgt_handler mgs_llog_handlers[] = {
 TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_CREATE,	mgs_llog_open),
-TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_NEXT_BLOCK,	tgt_llog_next_block),
-TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_READ_HEADER,	tgt_llog_read_header),
+TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_NEXT_BLOCK,	mgs_llog_next_block),
+TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_READ_HEADER,	mgs_llog_read_header),
 TGT_LLOG_HDL    (0,	LLOG_ORIGIN_HANDLE_PREV_BLOCK,	tgt_llog_prev_block),
 };
 
@@ -1333,6 +1340,7 @@ static int mgs_init0(const struct lu_env *env, struct mgs_device *mgs,
 	spin_lock_init(&mgs->mgs_lock);
 	mutex_init(&mgs->mgs_health_mutex);
 	init_rwsem(&mgs->mgs_barrier_rwsem);
+	mgs_llog_cache_init(mgs);
 
 	rc = mgs_lcfg_rename(env, mgs);
 	if (rc)
@@ -1403,6 +1411,7 @@ err_lproc:
 	mgs_params_fsdb_cleanup(env, mgs);
 	lproc_mgs_cleanup(mgs);
 err_llog:
+	mgs_llog_cache_fini(mgs);
 	ctxt = llog_get_context(mgs->mgs_obd, LLOG_CONFIG_ORIG_CTXT);
 	if (ctxt) {
 		ctxt->loc_dir = NULL;
@@ -1580,6 +1589,7 @@ static struct lu_device *mgs_device_fini(const struct lu_env *env,
 
 	tgt_fini(env, &mgs->mgs_lut);
 	lproc_mgs_cleanup(mgs);
+	mgs_llog_cache_fini(mgs);
 
 	ctxt = llog_get_context(mgs->mgs_obd, LLOG_CONFIG_ORIG_CTXT);
 	if (ctxt) {
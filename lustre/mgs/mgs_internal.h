@@ -164,6 +164,23 @@ struct fs_db {
 	__u32		fsdb_gen;
 };
 
+#define MGS_LLOG_CACHE_HASH_SIZE	64
+#define MGS_LLOG_CACHE_MAX_DEFAULT	256
+
+/* cache of config llog read replies, see mgs_llog_cache.c */
+struct mgs_llog_cache {
+	spinlock_t		mlc_lock;
+	struct hlist_head	mlc_hash[MGS_LLOG_CACHE_HASH_SIZE];
+	struct list_head	mlc_lru;
+	unsigned int		mlc_count;
+	unsigned int		mlc_max;
+	/* bumped on every config log modification */
+	__u64			mlc_gen;
+	__u64			mlc_hits;
+	__u64			mlc_misses;
+	__u64			mlc_invalidations;
+};
+
 struct mgs_device {
 	struct dt_device		 mgs_dt_dev;
 	struct ptlrpc_service		*mgs_service;
@@ -184,6 +201,7 @@ struct mgs_device {
 	struct mutex			 mgs_health_mutex;
 	struct rw_semaphore		 mgs_barrier_rwsem;
 	struct lu_target		 mgs_lut;
+	struct mgs_llog_cache		 mgs_llog_cache;
 };
 
 /* this is a top object */
@@ -238,6 +256,15 @@ int  mgs_put_lock(struct lustre_handle *lockh);
 void mgs_revoke_lock(struct mgs_device *mgs, struct fs_db *fsdb,
 		     enum mgs_cfg_type type);
 
+/* mgs_llog_cache.c */
+void mgs_llog_cache_init(struct mgs_device *mgs);
+void mgs_llog_cache_fini(struct mgs_device *mgs);
+void mgs_llog_cache_invalidate(struct mgs_device *mgs);
+void mgs_llog_cache_set_max(struct mgs_device *mgs, unsigned int max);
+int mgs_llog_cache_seq_show(struct seq_file *seq, void *v);
+int mgs_llog_read_header(struct tgt_session_info *tsi);
+int mgs_llog_next_block(struct tgt_session_info *tsi);
+
 /* mgs_nids.c */
 int  mgs_ir_update(const struct lu_env *env, struct mgs_device *mgs,
 		   struct mgs_target_info *mti);
@@ -960,6 +960,8 @@ static int mgs_modify(const struct lu_env *env, struct mgs_device *mgs,
 			  NULL);
 	if (!rc && !mml->mml_modified)
 		rc = 1;
+	else
+		mgs_llog_cache_invalidate(mgs);
 
 out_free:
         OBD_FREE_PTR(mml);
@@ -1455,6 +1457,8 @@ out_restore:
 
 out_free:
 	OBD_FREE(backup, buf_size);
+	/* the log was erased and rewritten, or restored from the backup */
+	mgs_llog_cache_invalidate(mgs_dev);
 
 out_put:
 	llog_ctxt_put(ctxt);
@@ -1973,6 +1977,9 @@ static int record_end_log(const struct lu_env *env, struct llog_handle **llh)
 {
 	int rc;
 
+	if (*llh != NULL && (*llh)->lgh_ctxt != NULL)
+		mgs_llog_cache_invalidate(
+			lu2mgs_dev((*llh)->lgh_ctxt->loc_obd->obd_lu_dev));
 	rc = llog_close(env, *llh);
 	*llh = NULL;
 
@@ -4462,6 +4469,7 @@ int mgs_erase_log(const struct lu_env *env, struct mgs_device *mgs, char *name)
 		rc = -ENODEV;
 	} else {
 		rc = llog_erase(env, ctxt, NULL, name);
+		mgs_llog_cache_invalidate(mgs);
 		/* llog may not exist */
 		if (rc == -ENOENT)
 			rc = 0;
@@ -4888,8 +4896,10 @@ static int mgs_lcfg_fork_one(const struct lu_env *env, struct mgs_device *mgs,
 out:
 	if (old_llh)
 		llog_close(env, old_llh);
-	if (new_llh)
+	if (new_llh) {
 		llog_close(env, new_llh);
+		mgs_llog_cache_invalidate(mgs);
+	}
 	if (name_buf)
 		OBD_FREE(name_buf, name_buflen);
 	if (ctxt)
@@ -0,0 +1,376 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/mgs/mgs_llog_cache.c
+ *
+ * Cache of config llog read replies served by the MGS.
+ *
+ * After a config lock is revoked every MGC re-reads the changed config
+ * log starting from its last processed index.  With many clients this
+ * results in the same LLOG_ORIGIN_HANDLE_READ_HEADER/NEXT_BLOCK request
+ * being handled thousands of times, each doing a full llog open, header
+ * read and block scan on the backing storage.  The replies only depend on
+ * the request tuple and on the log content, so they are kept here and
+ * served directly until the config logs are modified again.
+ *
+ * Any modification of a config log bumps mlc_gen and drops the cached
+ * replies.  A reply computed while a modification was in progress is
+ * tagged with the generation sampled before the read and is discarded
+ * on insert, so stale data is never handed out after the lock revocation
+ * which notifies clients about the change.
+ */
+
+#define DEBUG_SUBSYSTEM S_MGS
+
+#include <linux/jhash.h>
+#include <obd_class.h>
+#include <lustre_log.h>
+
+#include "mgs_internal.h"
+
+struct mgs_llog_cache_key {
+	struct llog_logid	mlk_logid;
+	__u32			mlk_opc;
+	__u32			mlk_flags;
+	__u32			mlk_index;
+	__u32			mlk_saved_index;
+	__u64			mlk_cur_offset;
+};
+
+struct mgs_llog_cache_entry {
+	struct hlist_node		mle_hash;
+	struct list_head		mle_lru;
+	struct mgs_llog_cache_key	mle_key;
+	atomic_t			mle_refcount;
+	/* reply body for NEXT_BLOCK, unused for READ_HEADER */
+	struct llogd_body		mle_body;
+	/* llog block or llog header, LLOG_MIN_CHUNK_SIZE bytes */
+	char				mle_buf[0];
+};
+
+#define MGS_LLOG_CACHE_ENTRY_SIZE \
+	(offsetof(struct mgs_llog_cache_entry, mle_buf[LLOG_MIN_CHUNK_SIZE]))
+
+static void mgs_llog_cache_key_init(struct mgs_llog_cache_key *key,
+				    __u32 opc, struct llogd_body *body)
+{
+	memset(key, 0, sizeof(*key));
+	key->mlk_logid = body->lgd_logid;
+	key->mlk_opc = opc;
+	key->mlk_flags = body->lgd_llh_flags;
+	if (opc == LLOG_ORIGIN_HANDLE_NEXT_BLOCK) {
+		key->mlk_index = body->lgd_index;
+		key->mlk_saved_index = body->lgd_saved_index;
+		key->mlk_cur_offset = body->lgd_cur_offset;
+	}
+}
+
+static struct hlist_head *
+mgs_llog_cache_bucket(struct mgs_llog_cache *mlc,
+		      const struct mgs_llog_cache_key *key)
+{
+	return &mlc->mlc_hash[jhash(key, sizeof(*key), 0) &
+			      (MGS_LLOG_CACHE_HASH_SIZE - 1)];
+}
+
+static void mgs_llog_cache_entry_put(struct mgs_llog_cache_entry *mle)
+{
+	if (atomic_dec_and_test(&mle->mle_refcount))
+		OBD_FREE_LARGE(mle, MGS_LLOG_CACHE_ENTRY_SIZE);
+}
+
+/* must be called with mlc_lock held */
+static void mgs_llog_cache_entry_del(struct mgs_llog_cache *mlc,
+				     struct mgs_llog_cache_entry *mle)
+{
+	hlist_del_init(&mle->mle_hash);
+	list_del_init(&mle->mle_lru);
+	mlc->mlc_count--;
+	mgs_llog_cache_entry_put(mle);
+}
+
+static void mgs_llog_cache_purge(struct mgs_llog_cache *mlc,
+				 unsigned int limit)
+{
+	struct mgs_llog_cache_entry *mle;
+
+	while (mlc->mlc_count > limit) {
+		mle = list_last_entry(&mlc->mlc_lru,
+				      struct mgs_llog_cache_entry, mle_lru);
+		mgs_llog_cache_entry_del(mlc, mle);
+	}
+}
+
+static struct mgs_llog_cache_entry *
+mgs_llog_cache_lookup(struct mgs_llog_cache *mlc,
+		      const struct mgs_llog_cache_key *key)
+{
+	struct mgs_llog_cache_entry *mle;
+	struct hlist_head *head = mgs_llog_cache_bucket(mlc, key);
+
+	spin_lock(&mlc->mlc_lock);
+	hlist_for_each_entry(mle, head, mle_hash) {
+		if (memcmp(&mle->mle_key, key, sizeof(*key)) == 0) {
+			atomic_inc(&mle->mle_refcount);
+			list_move(&mle->mle_lru, &mlc->mlc_lru);
+			mlc->mlc_hits++;
+			spin_unlock(&mlc->mlc_lock);
+			return mle;
+		}
+	}
+	mlc->mlc_misses++;
+	spin_unlock(&mlc->mlc_lock);
+
+	return NULL;
+}
+
+static void mgs_llog_cache_insert(struct mgs_llog_cache *mlc,
+				  const struct mgs_llog_cache_key *key,
+				  __u64 gen, struct llogd_body *body,
+				  const void *buf)
+{
+	struct mgs_llog_cache_entry *mle;
+	struct mgs_llog_cache_entry *tmp;
+	struct hlist_head *head;
+
+	OBD_ALLOC_LARGE(mle, MGS_LLOG_CACHE_ENTRY_SIZE);
+	if (mle == NULL)
+		return;
+
+	INIT_HLIST_NODE(&mle->mle_hash);
+	INIT_LIST_HEAD(&mle->mle_lru);
+	atomic_set(&mle->mle_refcount, 1);
+	mle->mle_key = *key;
+	if (body != NULL)
+		mle->mle_body = *body;
+	memcpy(mle->mle_buf, buf, LLOG_MIN_CHUNK_SIZE);
+
+	head = mgs_llog_cache_bucket(mlc, key);
+	spin_lock(&mlc->mlc_lock);
+	/* the log was modified while this reply was being built */
+	if (gen != mlc->mlc_gen || mlc->mlc_max == 0)
+		GOTO(out_unlock, 0);
+
+	hlist_for_each_entry(tmp, head, mle_hash) {
+		if (memcmp(&tmp->mle_key, key, sizeof(*key)) == 0)
+			GOTO(out_unlock, 0);
+	}
+
+	hlist_add_head(&mle->mle_hash, head);
+	list_add(&mle->mle_lru, &mlc->mlc_lru);
+	mlc->mlc_count++;
+	mgs_llog_cache_purge(mlc, mlc->mlc_max);
+	mle = NULL;
+out_unlock:
+	spin_unlock(&mlc->mlc_lock);
+	if (mle != NULL)
+		OBD_FREE_LARGE(mle, MGS_LLOG_CACHE_ENTRY_SIZE);
+}
+
+/**
+ * Drop all cached config llog replies.
+ *
+ * Called whenever a config log is written, modified or erased, and before
+ * clients are told to re-read their config logs.
+ */
+void mgs_llog_cache_invalidate(struct mgs_device *mgs)
+{
+	struct mgs_llog_cache *mlc = &mgs->mgs_llog_cache;
+
+	spin_lock(&mlc->mlc_lock);
+	mlc->mlc_gen++;
+	if (mlc->mlc_count > 0)
+		mlc->mlc_invalidations++;
+	mgs_llog_cache_purge(mlc, 0);
+	spin_unlock(&mlc->mlc_lock);
+}
+
+void mgs_llog_cache_set_max(struct mgs_device *mgs, unsigned int max)
+{
+	struct mgs_llog_cache *mlc = &mgs->mgs_llog_cache;
+
+	spin_lock(&mlc->mlc_lock);
+	mlc->mlc_max = max;
+	mgs_llog_cache_purge(mlc, max);
+	spin_unlock(&mlc->mlc_lock);
+}
+
+void mgs_llog_cache_init(struct mgs_device *mgs)
+{
+	struct mgs_llog_cache *mlc = &mgs->mgs_llog_cache;
+	int i;
+
+	spin_lock_init(&mlc->mlc_lock);
+	INIT_LIST_HEAD(&mlc->mlc_lru);
+	for (i = 0; i < MGS_LLOG_CACHE_HASH_SIZE; i++)
+		INIT_HLIST_HEAD(&mlc->mlc_hash[i]);
+	mlc->mlc_max = MGS_LLOG_CACHE_MAX_DEFAULT;
+	mlc->mlc_count = 0;
+	mlc->mlc_gen = 0;
+	mlc->mlc_hits = 0;
+	mlc->mlc_misses = 0;
+	mlc->mlc_invalidations = 0;
+}
+
+void mgs_llog_cache_fini(struct mgs_device *mgs)
+{
+	struct mgs_llog_cache *mlc = &mgs->mgs_llog_cache;
+
+	spin_lock(&mlc->mlc_lock);
+	mlc->mlc_max = 0;
+	mgs_llog_cache_purge(mlc, 0);
+	spin_unlock(&mlc->mlc_lock);
+}
+
+int mgs_llog_cache_seq_show(struct seq_file *seq, void *v)
+{
+	struct obd_device *obd = seq->private;
+	struct mgs_device *mgs = lu2mgs_dev(obd->obd_lu_dev);
+	struct mgs_llog_cache *mlc = &mgs->mgs_llog_cache;
+
+	spin_lock(&mlc->mlc_lock);
+	seq_printf(seq, "max_entries: %u\n"
+		   "entries: %u\n"
+		   "generation: %llu\n"
+		   "hits: %llu\n"
+		   "misses: %llu\n"
+		   "invalidations: %llu\n",
+		   mlc->mlc_max, mlc->mlc_count, mlc->mlc_gen,
+		   mlc->mlc_hits, mlc->mlc_misses, mlc->mlc_invalidations);
+	spin_unlock(&mlc->mlc_lock);
+
+	return 0;
+}
+
+static bool mgs_llog_cache_enabled(struct mgs_device *mgs,
+				   struct llogd_body *body)
+{
+	return body != NULL && body->lgd_ctxt_idx == LLOG_CONFIG_ORIG_CTXT &&
+	       READ_ONCE(mgs->mgs_llog_cache.mlc_max) != 0;
+}
+
+static __u64 mgs_llog_cache_gen(struct mgs_device *mgs)
+{
+	__u64 gen;
+
+	spin_lock(&mgs->mgs_llog_cache.mlc_lock);
+	gen = mgs->mgs_llog_cache.mlc_gen;
+	spin_unlock(&mgs->mgs_llog_cache.mlc_lock);
+
+	return gen;
+}
+
+int mgs_llog_read_header(struct tgt_session_info *tsi)
+{
+	struct ptlrpc_request *req = tgt_ses_req(tsi);
+	struct mgs_device *mgs = exp2mgs_dev(tsi->tsi_exp);
+	struct mgs_llog_cache_entry *mle;
+	struct mgs_llog_cache_key key;
+	struct llog_log_hdr *hdr;
+	struct llogd_body *body;
+	__u64 gen;
+	int rc;
+
+	ENTRY;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_LLOGD_BODY);
+	if (!mgs_llog_cache_enabled(mgs, body))
+		RETURN(tgt_llog_read_header(tsi));
+
+	mgs_llog_cache_key_init(&key, LLOG_ORIGIN_HANDLE_READ_HEADER, body);
+	mle = mgs_llog_cache_lookup(&mgs->mgs_llog_cache, &key);
+	if (mle != NULL) {
+		rc = req_capsule_server_pack(&req->rq_pill);
+		if (rc == 0) {
+			hdr = req_capsule_server_get(&req->rq_pill,
+						     &RMF_LLOG_LOG_HDR);
+			memcpy(hdr, mle->mle_buf, sizeof(*hdr));
+		} else {
+			rc = err_serious(-ENOMEM);
+		}
+		mgs_llog_cache_entry_put(mle);
+		RETURN(rc);
+	}
+
+	gen = mgs_llog_cache_gen(mgs);
+	rc = llog_origin_handle_read_header(req);
+	if (rc == 0) {
+		hdr = req_capsule_server_get(&req->rq_pill, &RMF_LLOG_LOG_HDR);
+		mgs_llog_cache_insert(&mgs->mgs_llog_cache, &key, gen, NULL,
+				      hdr);
+	}
+
+	RETURN(rc);
+}
+
+int mgs_llog_next_block(struct tgt_session_info *tsi)
+{
+	struct ptlrpc_request *req = tgt_ses_req(tsi);
+	struct mgs_device *mgs = exp2mgs_dev(tsi->tsi_exp);
+	struct mgs_llog_cache_entry *mle;
+	struct mgs_llog_cache_key key;
+	struct llogd_body *body;
+	struct llogd_body *repbody;
+	void *ptr;
+	__u64 gen;
+	int rc;
+
+	ENTRY;
+
+	body = req_capsule_client_get(&req->rq_pill, &RMF_LLOGD_BODY);
+	if (!mgs_llog_cache_enabled(mgs, body))
+		RETURN(tgt_llog_next_block(tsi));
+
+	mgs_llog_cache_key_init(&key, LLOG_ORIGIN_HANDLE_NEXT_BLOCK, body);
+	mle = mgs_llog_cache_lookup(&mgs->mgs_llog_cache, &key);
+	if (mle != NULL) {
+		req_capsule_set_size(&req->rq_pill, &RMF_EADATA, RCL_SERVER,
+				     LLOG_MIN_CHUNK_SIZE);
+		rc = req_capsule_server_pack(&req->rq_pill);
+		if (rc == 0) {
+			repbody = req_capsule_server_get(&req->rq_pill,
+							 &RMF_LLOGD_BODY);
+			*repbody = mle->mle_body;
+			ptr = req_capsule_server_get(&req->rq_pill,
+						     &RMF_EADATA);
+			memcpy(ptr, mle->mle_buf, LLOG_MIN_CHUNK_SIZE);
+		} else {
+			rc = err_serious(-ENOMEM);
+		}
+		mgs_llog_cache_entry_put(mle);
+		RETURN(rc);
+	}
+
+	gen = mgs_llog_cache_gen(mgs);
+	rc = llog_origin_handle_next_block(req);
+	if (rc == 0) {
+		repbody = req_capsule_server_get(&req->rq_pill,
+						 &RMF_LLOGD_BODY);
+		ptr = req_capsule_server_get(&req->rq_pill, &RMF_EADATA);
+		mgs_llog_cache_insert(&mgs->mgs_llog_cache, &key, gen,
+				      repbody, ptr);
+	}
+
+	RETURN(rc);
+}
@@ -1231,6 +1231,13 @@ struct cl_client_cache *cl_cache_init(unsigned long lru_page_max)
 	if (cache == NULL)
 		RETURN(NULL);
 
+	cache->ccc_lru_pending = cfs_percpt_alloc(cfs_cpt_tab,
+						  sizeof(atomic_long_t));
+	if (cache->ccc_lru_pending == NULL) {
+		OBD_FREE(cache, sizeof(*cache));
+		RETURN(NULL);
+	}
+
 	/* Initialize cache data */
 	atomic_set(&cache->ccc_users, 1);
 	cache->ccc_lru_max = lru_page_max;
@@ -1264,7 +1271,56 @@ EXPORT_SYMBOL(cl_cache_incref);
  */
 void cl_cache_decref(struct cl_client_cache *cache)
 {
-	if (atomic_dec_and_test(&cache->ccc_users))
+	if (atomic_dec_and_test(&cache->ccc_users)) {
+		cfs_percpt_free(cache->ccc_lru_pending);
 		OBD_FREE(cache, sizeof(*cache));
+	}
 }
 EXPORT_SYMBOL(cl_cache_decref);
+
+/**
+ * Number of freed LRU slots gathered on a CPT before they are returned to
+ * cl_client_cache::ccc_lru_left.
+ */
+#define CCC_LRU_PENDING_BATCH	64
+
+/**
+ * Return \a npages LRU slots freed by page destruction to the cache.
+ *
+ * Pages are destroyed one at a time, so the slots are gathered per CPT and
+ * returned to ccc_lru_left in batches, instead of having every CPU bounce
+ * the shared counter. Callers that need an exact ccc_lru_left, or that find
+ * LRU waiters, call cl_cache_lru_flush().
+ */
+void cl_cache_lru_put(struct cl_client_cache *cache, long npages)
+{
+	atomic_long_t *pending;
+
+	pending = cache->ccc_lru_pending[cfs_cpt_current(cfs_cpt_tab, 1)];
+	if (atomic_long_add_return(npages, pending) >= CCC_LRU_PENDING_BATCH)
+		atomic_long_add(atomic_long_xchg(pending, 0),
+				&cache->ccc_lru_left);
+}
+EXPORT_SYMBOL(cl_cache_lru_put);
+
+/**
+ * Return all the LRU slots gathered by cl_cache_lru_put() to ccc_lru_left.
+ *
+ * \retval number of slots returned
+ */
+long cl_cache_lru_flush(struct cl_client_cache *cache)
+{
+	atomic_long_t *pending;
+	long total = 0;
+	int i;
+
+	cfs_percpt_for_each(pending, i, cache->ccc_lru_pending) {
+		if (atomic_long_read(pending) > 0)
+			total += atomic_long_xchg(pending, 0);
+	}
+	if (total > 0)
+		atomic_long_add(total, &cache->ccc_lru_left);
+
+	return total;
+}
+EXPORT_SYMBOL(cl_cache_lru_flush);
@@ -27,23 +27,359 @@
  */
 #include <linux/blkdev.h>
 #include <linux/crc-t10dif.h>
+#include <linux/random.h>
 #include <asm/checksum.h>
+#include <asm/unaligned.h>
 #include <obd_class.h>
 #include <obd_cksum.h>
 
 #if IS_ENABLED(CONFIG_CRC_T10DIF)
-__u16 obd_dif_crc_fn(void *data, unsigned int len)
+/*
+ * Guard tag implementations
+ *
+ * Several implementations of each guard tag checksum are available, all of
+ * them returning the same result. The "arch" ones use the kernel library,
+ * which dispatches to the CPU accelerated code where the architecture and
+ * CPU support it (PCLMULQDQ/PMULL/VPMSUM CRC-T10DIF transforms of the
+ * crypto API, the arch csum_partial() for the IP checksum). The others are
+ * portable C, a word-at-a-time one and a byte/halfword-at-a-time reference.
+ *
+ * On the first use the implementations are checked against the reference
+ * ones and timed, and the fastest correct one of each type is used by
+ * obd_dif_crc_fn() and obd_dif_ip_fn(), see obd_dif_select().
+ */
+#define OBD_DIF_CRC_POLY	0x8BB7
+
+/* slicing-by-8 tables, [0] is the byte-at-a-time table */
+static __u16 obd_dif_crc_table[8][256];
+
+static void obd_dif_crc_table_init(void)
+{
+	unsigned int i, j;
+	__u16 crc;
+
+	for (i = 0; i < 256; i++) {
+		crc = i << 8;
+		for (j = 0; j < 8; j++)
+			crc = (crc << 1) ^ (crc & 0x8000 ? OBD_DIF_CRC_POLY : 0);
+		obd_dif_crc_table[0][i] = crc;
+	}
+
+	for (j = 1; j < 8; j++) {
+		for (i = 0; i < 256; i++) {
+			crc = obd_dif_crc_table[j - 1][i];
+			obd_dif_crc_table[j][i] = (crc << 8) ^
+				obd_dif_crc_table[0][crc >> 8];
+		}
+	}
+}
+
+static inline __u16 obd_dif_crc_bytes(__u16 crc, const __u8 *p,
+				      unsigned int len)
+{
+	while (len--)
+		crc = (crc << 8) ^ obd_dif_crc_table[0][(crc >> 8) ^ *p++];
+
+	return crc;
+}
+
+static __u16 obd_dif_crc_generic(void *data, unsigned int len)
+{
+	return cpu_to_be16(obd_dif_crc_bytes(0, data, len));
+}
+
+static __u16 obd_dif_crc_slice8(void *data, unsigned int len)
+{
+	const __u8 *p = data;
+	__u16 crc = 0;
+
+	for (; len >= 8; len -= 8, p += 8)
+		crc = obd_dif_crc_table[7][p[0] ^ (crc >> 8)] ^
+		      obd_dif_crc_table[6][p[1] ^ (crc & 0xff)] ^
+		      obd_dif_crc_table[5][p[2]] ^
+		      obd_dif_crc_table[4][p[3]] ^
+		      obd_dif_crc_table[3][p[4]] ^
+		      obd_dif_crc_table[2][p[5]] ^
+		      obd_dif_crc_table[1][p[6]] ^
+		      obd_dif_crc_table[0][p[7]];
+
+	return cpu_to_be16(obd_dif_crc_bytes(crc, p, len));
+}
+
+static __u16 obd_dif_crc_arch(void *data, unsigned int len)
 {
 	return cpu_to_be16(crc_t10dif(data, len));
 }
+
+/* fold a one's complement sum to 16 bits and complement it */
+static inline __u16 obd_dif_ip_fold(__u64 sum)
+{
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffffffff) + (sum >> 32);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+	sum = (sum & 0xffff) + (sum >> 16);
+
+	return (__u16)~sum;
+}
+
+/* the trailing odd byte is summed in memory order, as csum_partial() does */
+static inline __u64 obd_dif_ip_tail(const __u8 *p)
+{
+#ifdef __BIG_ENDIAN
+	return (__u64)*p << 8;
+#else
+	return *p;
+#endif
+}
+
+static __u16 obd_dif_ip_generic(void *data, unsigned int len)
+{
+	const __u8 *p = data;
+	__u64 sum = 0;
+
+	for (; len >= 2; len -= 2, p += 2)
+		sum += get_unaligned((const __u16 *)p);
+	if (len)
+		sum += obd_dif_ip_tail(p);
+
+	return obd_dif_ip_fold(sum);
+}
+
+static __u16 obd_dif_ip_wide(void *data, unsigned int len)
+{
+	const __u8 *p = data;
+	__u64 sum = 0;
+	__u64 word;
+
+	/* 32-bit halves of each word cannot overflow 64 bits for a sector */
+	for (; len >= 8; len -= 8, p += 8) {
+		word = get_unaligned((const __u64 *)p);
+		sum += (word & 0xffffffff) + (word >> 32);
+	}
+	for (; len >= 2; len -= 2, p += 2)
+		sum += get_unaligned((const __u16 *)p);
+	if (len)
+		sum += obd_dif_ip_tail(p);
+
+	return obd_dif_ip_fold(sum);
+}
+
+static __u16 obd_dif_ip_arch(void *data, unsigned int len)
+{
+	return ip_compute_csum(data, len);
+}
+
+/* the reference implementation of each type must be first */
+static struct obd_dif_impl obd_dif_impls[] = {
+	{ .odi_name = "ip-generic",	.odi_csum = OBD_DIF_CSUM_IP,
+	  .odi_fn = obd_dif_ip_generic },
+	{ .odi_name = "ip-wide",	.odi_csum = OBD_DIF_CSUM_IP,
+	  .odi_fn = obd_dif_ip_wide },
+	{ .odi_name = "ip-arch",	.odi_csum = OBD_DIF_CSUM_IP,
+	  .odi_fn = obd_dif_ip_arch },
+	{ .odi_name = "crc-generic",	.odi_csum = OBD_DIF_CSUM_CRC,
+	  .odi_fn = obd_dif_crc_generic },
+	{ .odi_name = "crc-slice8",	.odi_csum = OBD_DIF_CSUM_CRC,
+	  .odi_fn = obd_dif_crc_slice8 },
+	{ .odi_name = "crc-arch",	.odi_csum = OBD_DIF_CSUM_CRC,
+	  .odi_fn = obd_dif_crc_arch },
+};
+
+/* used until obd_dif_select() runs, these need no initialization */
+static obd_dif_csum_fn *obd_dif_fns[OBD_DIF_CSUM_MAX] = {
+	[OBD_DIF_CSUM_IP]	= obd_dif_ip_arch,
+	[OBD_DIF_CSUM_CRC]	= obd_dif_crc_arch,
+};
+static const char *obd_dif_names[OBD_DIF_CSUM_MAX] = {
+	[OBD_DIF_CSUM_IP]	= "ip-arch",
+	[OBD_DIF_CSUM_CRC]	= "crc-arch",
+};
+static bool obd_dif_selected;
+static DEFINE_MUTEX(obd_dif_select_mutex);
+/* keeps the compiler from dropping the timed calls */
+static __u16 obd_dif_speed_sink;
+
+__u16 obd_dif_crc_fn(void *data, unsigned int len)
+{
+	return READ_ONCE(obd_dif_fns[OBD_DIF_CSUM_CRC])(data, len);
+}
 EXPORT_SYMBOL(obd_dif_crc_fn);
 
 __u16 obd_dif_ip_fn(void *data, unsigned int len)
 {
-	return ip_compute_csum(data, len);
+	return READ_ONCE(obd_dif_fns[OBD_DIF_CSUM_IP])(data, len);
 }
 EXPORT_SYMBOL(obd_dif_ip_fn);
 
+static struct obd_dif_impl *obd_dif_reference(enum obd_dif_csum csum)
+{
+	int i;
+
+	for (i = 0; i < ARRAY_SIZE(obd_dif_impls); i++)
+		if (obd_dif_impls[i].odi_csum == csum)
+			return &obd_dif_impls[i];
+
+	LBUG();
+	return NULL;
+}
+
+/**
+ * Check a guard tag implementation against the reference one of its type.
+ *
+ * Odd lengths and unaligned buffers are checked too, the T10 sectors are
+ * always aligned but the implementations should not depend on it.
+ *
+ * \param[in] impl	implementation to check
+ *
+ * \retval 0 on success
+ * \retval -EINVAL if the results differ
+ * \retval negative errno on other failure
+ */
+int obd_dif_impl_selftest(const struct obd_dif_impl *impl)
+{
+	static const unsigned int lens[] = { 0, 1, 2, 7, 8, 9, 63, 511, 512,
+					     4095, 4096 };
+	obd_dif_csum_fn *ref = obd_dif_reference(impl->odi_csum)->odi_fn;
+	unsigned int offset;
+	__u8 *buf;
+	__u16 expect;
+	__u16 csum;
+	int rc = 0;
+	int i;
+
+	OBD_ALLOC_LARGE(buf, 4096 + 8);
+	if (buf == NULL)
+		return -ENOMEM;
+
+	get_random_bytes(buf, 4096 + 8);
+	/* CRC-T10DIF has a known check value over "123456789" */
+	memcpy(buf, "123456789", 9);
+	expect = impl->odi_csum == OBD_DIF_CSUM_CRC ? cpu_to_be16(0xd0db) :
+						      ref(buf, 9);
+	csum = impl->odi_fn(buf, 9);
+	if (csum != expect)
+		GOTO(out, rc = -EINVAL);
+
+	for (offset = 0; offset < 4; offset++) {
+		for (i = 0; i < ARRAY_SIZE(lens); i++) {
+			expect = ref(buf + offset, lens[i]);
+			csum = impl->odi_fn(buf + offset, lens[i]);
+			if (csum != expect)
+				GOTO(out, rc = -EINVAL);
+		}
+	}
+out:
+	if (rc == -EINVAL)
+		CERROR("T10-PI %s: selftest failed, guard %04x expected %04x: rc = %d\n",
+		       impl->odi_name, csum, expect, rc);
+	OBD_FREE_LARGE(buf, 4096 + 8);
+
+	return rc;
+}
+EXPORT_SYMBOL(obd_dif_impl_selftest);
+
+/**
+ * Measure the speed of a guard tag implementation.
+ *
+ * Guards are computed for 512 byte sectors over \a buf, as many times as
+ * fit in \a msecs milliseconds.
+ *
+ * \retval speed in MB/s
+ */
+int obd_dif_impl_speed(const struct obd_dif_impl *impl, void *buf,
+		       unsigned int len, unsigned int msecs)
+{
+	unsigned long start = jiffies;
+	unsigned long end = start + msecs_to_jiffies(msecs);
+	unsigned long bytes = 0;
+	unsigned int i;
+	__u16 csum = 0;
+
+	while (time_before(jiffies, end)) {
+		for (i = 0; i + 512 <= len; i += 512)
+			csum ^= impl->odi_fn(buf + i, 512);
+		bytes += len & ~511U;
+		cond_resched();
+	}
+	WRITE_ONCE(obd_dif_speed_sink, csum);
+
+	return bytes / max(jiffies_to_msecs(jiffies - start), 1U) * 1000 /
+	       (1024 * 1024);
+}
+EXPORT_SYMBOL(obd_dif_impl_speed);
+
+/**
+ * Select the fastest correct implementation of each guard tag type.
+ *
+ * This runs once, on the first use of a T10 checksum type for an RPC, see
+ * obd_t10_cksum_speed(). Until then the "arch" implementations are used.
+ */
+static void obd_dif_select(void)
+{
+	struct obd_dif_impl *impl;
+	int best[OBD_DIF_CSUM_MAX] = { 0 };
+	const unsigned int len = 64 * 1024;
+	void *buf;
+	int i;
+
+	mutex_lock(&obd_dif_select_mutex);
+	if (obd_dif_selected)
+		goto out_unlock;
+
+	obd_dif_crc_table_init();
+
+	OBD_ALLOC_LARGE(buf, len);
+	if (buf == NULL)
+		goto out_unlock;
+	memset(buf, 0xAD, len);
+
+	for (i = 0; i < ARRAY_SIZE(obd_dif_impls); i++) {
+		impl = &obd_dif_impls[i];
+		impl->odi_valid = obd_dif_impl_selftest(impl) == 0;
+		if (!impl->odi_valid)
+			continue;
+
+		impl->odi_speed = obd_dif_impl_speed(impl, buf, len, 10);
+		CDEBUG(D_CONFIG, "T10-PI %s: %d MB/s\n", impl->odi_name,
+		       impl->odi_speed);
+		if (impl->odi_speed > best[impl->odi_csum]) {
+			best[impl->odi_csum] = impl->odi_speed;
+			obd_dif_names[impl->odi_csum] = impl->odi_name;
+			WRITE_ONCE(obd_dif_fns[impl->odi_csum],
+				   impl->odi_fn);
+		}
+	}
+	OBD_FREE_LARGE(buf, len);
+	obd_dif_selected = true;
+
+out_unlock:
+	mutex_unlock(&obd_dif_select_mutex);
+}
+
+/**
+ * Return implementation \a index of the guard tag checksums, or NULL past
+ * the last one. The selftest and speed results are valid on return.
+ */
+const struct obd_dif_impl *obd_dif_impl_get(unsigned int index)
+{
+	if (unlikely(!obd_dif_selected))
+		obd_dif_select();
+
+	if (index >= ARRAY_SIZE(obd_dif_impls))
+		return NULL;
+
+	return &obd_dif_impls[index];
+}
+EXPORT_SYMBOL(obd_dif_impl_get);
+
+/* Return the name of the implementation used for guard tags of \a csum */
+const char *obd_dif_impl_current(enum obd_dif_csum csum)
+{
+	return obd_dif_names[csum];
+}
+EXPORT_SYMBOL(obd_dif_impl_current);
+
 int obd_page_dif_generate_buffer(const char *obd_name, struct page *page,
 				 __u32 offset, __u32 length,
 				 __u16 *guard_start, int guard_number,
@@ -57,9 +393,16 @@ int obd_page_dif_generate_buffer(const char *obd_name, struct page *page,
 	unsigned int data_size;
 	int used = 0;
 
+	/* fn is one of the dispatchers, call the selected code directly */
+	if (fn == obd_dif_crc_fn)
+		fn = READ_ONCE(obd_dif_fns[OBD_DIF_CSUM_CRC]);
+	else if (fn == obd_dif_ip_fn)
+		fn = READ_ONCE(obd_dif_fns[OBD_DIF_CSUM_IP]);
+
 	data_buf = kmap(page) + offset;
 	while (i < end) {
 		if (used >= guard_number) {
+			kunmap(page);
 			CERROR("%s: unexpected used guard number of DIF %u/%u, "
 			       "data length %u, sector size %u: rc = %d\n",
 			       obd_name, used, guard_number, length,
@@ -260,6 +603,9 @@ int obd_t10_cksum_speed(const char *obd_name,
 #if IS_ENABLED(CONFIG_CRC_T10DIF)
 	enum obd_t10_cksum_type index = obd_t10_cksum2type(cksum_type);
 
+	if (unlikely(!obd_dif_selected))
+		obd_dif_select();
+
 	if (unlikely(obd_t10_cksum_speeds[index] == 0)) {
 		static DEFINE_MUTEX(obd_t10_cksum_speed_mutex);
 
@@ -275,3 +621,34 @@ int obd_t10_cksum_speed(const char *obd_name,
 #endif /* !CONFIG_CRC_T10DIF */
 }
 EXPORT_SYMBOL(obd_t10_cksum_speed);
+
+/**
+ * Compare guard tags computed for \a sectors sectors with the guard tags of
+ * protection information tuples of \a tuple_size bytes.
+ *
+ * The tuples are checked four at a time, and only searched one by one once
+ * a mismatch is found.
+ *
+ * \retval index of the first mismatching sector, or \a sectors if none
+ */
+unsigned int obd_dif_guards_compare(const __u16 *guards, const void *tuples,
+				    unsigned int sectors,
+				    unsigned int tuple_size)
+{
+	const __u8 *t = tuples;
+	unsigned int i = 0;
+
+	for (; i + 4 <= sectors; i += 4, t += 4 * tuple_size) {
+		if ((guards[i] ^ *(const __u16 *)t) |
+		    (guards[i + 1] ^ *(const __u16 *)(t + tuple_size)) |
+		    (guards[i + 2] ^ *(const __u16 *)(t + 2 * tuple_size)) |
+		    (guards[i + 3] ^ *(const __u16 *)(t + 3 * tuple_size)))
+			break;
+	}
+	for (; i < sectors; i++, t += tuple_size)
+		if (guards[i] != *(const __u16 *)t)
+			break;
+
+	return i;
+}
+EXPORT_SYMBOL(obd_dif_guards_compare);
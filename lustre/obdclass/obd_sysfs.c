@@ -66,6 +66,7 @@
 #include <obd_support.h>
 #include <obd_class.h>
 #include <lprocfs_status.h>
+#include <obd_cksum.h>
 #include <uapi/linux/lnet/lnetctl.h>
 #include <uapi/linux/lustre/lustre_ioctl.h>
 #include <uapi/linux/lustre/lustre_ver.h>
@@ -558,6 +559,24 @@ static const struct file_operations checksum_speed_fops = {
 	.release = seq_release,
 };
 
+/* t10pi_kernels */
+static int t10pi_kernels_seq_show(struct seq_file *m, void *v)
+{
+#if IS_ENABLED(CONFIG_CRC_T10DIF)
+	const struct obd_dif_impl *impl;
+	unsigned int i;
+
+	for (i = 0; (impl = obd_dif_impl_get(i)) != NULL; i++)
+		seq_printf(m, "%s: %d%s%s\n", impl->odi_name,
+			   impl->odi_valid ? impl->odi_speed : -EINVAL,
+			   impl->odi_valid ? "" : " (selftest failed)",
+			   strcmp(obd_dif_impl_current(impl->odi_csum),
+				  impl->odi_name) ? "" : " [selected]");
+#endif
+	return 0;
+}
+LDEBUGFS_SEQ_FOPS_RO(t10pi_kernels);
+
 static int
 health_check_seq_show(struct seq_file *m, void *unused)
 {
@@ -653,6 +672,9 @@ int class_procfs_init(void)
 	file = debugfs_create_file("checksum_speed", 0444, debugfs_lustre_root,
 				   NULL, &checksum_speed_fops);
 
+	file = debugfs_create_file("t10pi_kernels", 0444, debugfs_lustre_root,
+				   NULL, &t10pi_kernels_fops);
+
 	entry = lprocfs_register("fs/lustre", NULL, NULL, NULL);
 	if (IS_ERR(entry)) {
 		rc = PTR_ERR(entry);
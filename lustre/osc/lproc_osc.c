@@ -531,6 +531,38 @@ LPROC_SEQ_FOPS_RW_TYPE(osc, obd_max_pages_per_rpc);
 
 LUSTRE_RW_ATTR(short_io_bytes);
 
+static ssize_t crypt_pipeline_pages_show(struct kobject *kobj,
+					 struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+
+	return scnprintf(buf, PAGE_SIZE, "%u\n",
+			 obd->u.cli.cl_crypt_pipeline_pages);
+}
+
+static ssize_t crypt_pipeline_pages_store(struct kobject *kobj,
+					  struct attribute *attr,
+					  const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	unsigned int val;
+	int rc;
+
+	rc = kstrtouint(buffer, 0, &val);
+	if (rc)
+		return rc;
+
+	if (val > OSC_CRYPT_PIPELINE_PAGES_MAX)
+		return -ERANGE;
+
+	WRITE_ONCE(obd->u.cli.cl_crypt_pipeline_pages, val);
+
+	return count;
+}
+LUSTRE_RW_ATTR(crypt_pipeline_pages);
+
 #ifdef CONFIG_PROC_FS
 static int osc_unstable_stats_seq_show(struct seq_file *m, void *v)
 {
@@ -549,6 +581,64 @@ static int osc_unstable_stats_seq_show(struct seq_file *m, void *v)
 }
 LPROC_SEQ_FOPS_RO(osc_unstable_stats);
 
+static int osc_crypt_stats_seq_show(struct seq_file *m, void *v)
+{
+	struct obd_device *obd = m->private;
+	struct client_obd *cli = &obd->u.cli;
+	struct cli_crypt_stats *stats;
+	int cpu;
+
+	if (cli->cl_crypt_stats == NULL)
+		return 0;
+
+	lprocfs_stats_header(m, ktime_get(), cli->cl_crypt_stats_init, 25,
+			     ":", true);
+	seq_printf(m, "%-5s %12s %16s %10s %12s %16s %10s\n", "cpu",
+		   "enc_pages", "enc_bytes", "enc_MB/s",
+		   "dec_pages", "dec_bytes", "dec_MB/s");
+	for_each_possible_cpu(cpu) {
+		stats = per_cpu_ptr(cli->cl_crypt_stats, cpu);
+		if (!stats->ccs_encrypt_pages && !stats->ccs_decrypt_pages)
+			continue;
+
+		/* bytes per usec is MB/s */
+		seq_printf(m, "%-5d %12llu %16llu %10llu %12llu %16llu %10llu\n",
+			   cpu, stats->ccs_encrypt_pages,
+			   stats->ccs_encrypt_bytes,
+			   stats->ccs_encrypt_usec ?
+			   div64_u64(stats->ccs_encrypt_bytes,
+				     stats->ccs_encrypt_usec) : 0,
+			   stats->ccs_decrypt_pages,
+			   stats->ccs_decrypt_bytes,
+			   stats->ccs_decrypt_usec ?
+			   div64_u64(stats->ccs_decrypt_bytes,
+				     stats->ccs_decrypt_usec) : 0);
+	}
+
+	return 0;
+}
+
+static ssize_t osc_crypt_stats_seq_write(struct file *file,
+					 const char __user *buf,
+					 size_t len, loff_t *off)
+{
+	struct seq_file *seq = file->private_data;
+	struct obd_device *obd = seq->private;
+	struct client_obd *cli = &obd->u.cli;
+	int cpu;
+
+	if (cli->cl_crypt_stats == NULL)
+		return len;
+
+	for_each_possible_cpu(cpu)
+		memset(per_cpu_ptr(cli->cl_crypt_stats, cpu), 0,
+		       sizeof(struct cli_crypt_stats));
+	cli->cl_crypt_stats_init = ktime_get();
+
+	return len;
+}
+LPROC_SEQ_FOPS(osc_crypt_stats);
+
 static ssize_t idle_timeout_show(struct kobject *kobj, struct attribute *attr,
 				 char *buf)
 {
@@ -627,6 +717,42 @@ static ssize_t idle_connect_store(struct kobject *kobj, struct attribute *attr,
 }
 LUSTRE_WO_ATTR(idle_connect);
 
+static ssize_t lazy_connect_show(struct kobject *kobj, struct attribute *attr,
+				 char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct obd_import *imp;
+	ssize_t len;
+
+	with_imp_locked(obd, imp, len)
+		len = sprintf(buf, "%u\n", imp->imp_lazy_connect);
+
+	return len;
+}
+
+/* only takes effect for a connect which is yet to come, i.e. when set from
+ * the config log before the client mount connects the OSC */
+static ssize_t lazy_connect_store(struct kobject *kobj, struct attribute *attr,
+				  const char *buffer, size_t count)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct obd_import *imp;
+	bool val;
+	int rc;
+
+	rc = kstrtobool(buffer, &val);
+	if (rc)
+		return rc;
+
+	with_imp_locked(obd, imp, rc)
+		imp->imp_lazy_connect = val;
+
+	return rc ?: count;
+}
+LUSTRE_RW_ATTR(lazy_connect);
+
 static ssize_t grant_shrink_show(struct kobject *kobj, struct attribute *attr,
 				 char *buf)
 {
@@ -701,6 +827,8 @@ struct lprocfs_vars lprocfs_osc_obd_vars[] = {
 	  .fops	=	&osc_pinger_recov_fops		},
 	{ .name	=	"unstable_stats",
 	  .fops	=	&osc_unstable_stats_fops	},
+	{ .name	=	"crypt_stats",
+	  .fops	=	&osc_crypt_stats_fops		},
 	{ NULL }
 };
 
@@ -827,6 +955,16 @@ static int osc_stats_seq_show(struct seq_file *seq, void *v)
 		   stats->os_lockless_writes);
 	seq_printf(seq, "lockless_read_bytes\t\t%llu\n",
 		   stats->os_lockless_reads);
+	seq_printf(seq, "fsync_count\t\t\t%llu\n",
+		   stats->os_fsync_count);
+	seq_printf(seq, "fsync_wait_usec\t\t\t%llu\n",
+		   stats->os_fsync_wait_us);
+	seq_printf(seq, "fsync_rpc_usec\t\t\t%llu\n",
+		   stats->os_fsync_rpc_us);
+	seq_printf(seq, "fsync_rpc_max_usec\t\t%llu\n",
+		   stats->os_fsync_rpc_max_us);
+	seq_printf(seq, "fsync_overlap\t\t\t%llu\n",
+		   stats->os_fsync_overlap);
 	return 0;
 }
 
@@ -864,6 +1002,7 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_active.attr,
 	&lustre_attr_checksums.attr,
 	&lustre_attr_checksum_dump.attr,
+	&lustre_attr_crypt_pipeline_pages.attr,
 	&lustre_attr_cur_dirty_bytes.attr,
 	&lustre_attr_cur_lost_grant_bytes.attr,
 	&lustre_attr_cur_dirty_grant_bytes.attr,
@@ -878,6 +1017,7 @@ static struct attribute *osc_attrs[] = {
 	&lustre_attr_ping.attr,
 	&lustre_attr_idle_timeout.attr,
 	&lustre_attr_idle_connect.attr,
+	&lustre_attr_lazy_connect.attr,
 	&lustre_attr_grant_shrink.attr,
 	NULL,
 };
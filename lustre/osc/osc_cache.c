@@ -593,6 +593,9 @@ void osc_extent_release(const struct lu_env *env, struct osc_extent *ext)
 	LASSERT(sanity_check(ext) == 0);
 	LASSERT(ext->oe_grants > 0);
 
+	/* pages leave the LRU before the extent can be sent */
+	osc_lru_use_flush(env);
+
 	if (atomic_dec_and_lock(&ext->oe_users, &obj->oo_lock)) {
 		LASSERT(ext->oe_state == OES_ACTIVE);
 		if (ext->oe_trunc_pending) {
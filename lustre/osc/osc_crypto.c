@@ -0,0 +1,240 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * Encryption and decryption of bulk pages for encrypted files.
+ *
+ * The pages of a bulk RPC are processed in chunks of
+ * cl_crypt_pipeline_pages pages by sptlrpc_crypt_parallel(). Every page is
+ * processed by exactly one thread, so the bounce page bookkeeping done for
+ * each brw_page is the same as with inline processing.
+ */
+
+#define DEBUG_SUBSYSTEM S_OSC
+
+#include <libcfs/libcfs.h>
+#include <obd.h>
+#include <obd_class.h>
+#include <lustre_osc.h>
+#include <lustre_sec.h>
+
+#include "osc_internal.h"
+
+struct osc_crypt_batch {
+	struct client_obd	*ocb_cli;
+	struct inode		*ocb_inode;
+	struct brw_page		**ocb_pga;
+	/* non-zero for direct IO reads */
+	unsigned int		 ocb_blockbits;
+	bool			 ocb_write;
+	bool			 ocb_directio;
+};
+
+static int osc_encrypt_brw_page(struct inode *inode, struct brw_page *brwpg,
+				bool directio)
+{
+	struct page *data_page = NULL;
+	bool retried = false;
+	bool lockedbymyself;
+	u32 nunits = (brwpg->off & ~PAGE_MASK) + brwpg->count;
+	struct address_space *map_orig = NULL;
+	struct cl_page *clpage;
+	pgoff_t index_orig;
+	int rc;
+
+retry_encrypt:
+	nunits = round_up(nunits, LUSTRE_ENCRYPTION_UNIT_SIZE);
+	/* The page can already be locked when we arrive here.
+	 * This is possible when cl_page_assume/vvp_page_assume
+	 * is stuck on wait_on_page_writeback with page lock
+	 * held. In this case there is no risk for the lock to
+	 * be released while we are doing our encryption
+	 * processing, because writeback against that page will
+	 * end in vvp_page_completion_write/cl_page_completion,
+	 * which means only once the page is fully processed.
+	 */
+	lockedbymyself = trylock_page(brwpg->pg);
+	if (directio) {
+		map_orig = brwpg->pg->mapping;
+		brwpg->pg->mapping = inode->i_mapping;
+		index_orig = brwpg->pg->index;
+		clpage = oap2cl_page(brw_page2oap(brwpg));
+		brwpg->pg->index = clpage->cp_page_index;
+	}
+	data_page = llcrypt_encrypt_pagecache_blocks(brwpg->pg, nunits, 0,
+						     GFP_NOFS);
+	if (directio) {
+		brwpg->pg->mapping = map_orig;
+		brwpg->pg->index = index_orig;
+	}
+	if (lockedbymyself)
+		unlock_page(brwpg->pg);
+	if (IS_ERR(data_page)) {
+		rc = PTR_ERR(data_page);
+		if (rc == -ENOMEM && !retried) {
+			retried = true;
+			goto retry_encrypt;
+		}
+		return rc;
+	}
+	/* Set PageChecked flag on bounce page for
+	 * disambiguation in osc_release_bounce_pages().
+	 */
+	SetPageChecked(data_page);
+	brwpg->pg = data_page;
+	/* len is forced to nunits, and relative offset to 0
+	 * so store the old, clear text info
+	 */
+	brwpg->bp_count_diff = nunits - brwpg->count;
+	brwpg->count = nunits;
+	brwpg->bp_off_diff = brwpg->off & ~PAGE_MASK;
+	brwpg->off = brwpg->off & PAGE_MASK;
+
+	return 0;
+}
+
+static int osc_decrypt_brw_page(struct inode *inode, struct brw_page *brwpg,
+				unsigned int blockbits)
+{
+	unsigned int blocksize = blockbits ? 1 << blockbits : 0;
+	unsigned int offs = 0;
+	int rc = 0;
+
+	while (offs < PAGE_SIZE) {
+		/* do not decrypt if page is all 0s */
+		if (memchr_inv(page_address(brwpg->pg) + offs, 0,
+			       LUSTRE_ENCRYPTION_UNIT_SIZE) == NULL) {
+			/* if page is empty forward info to upper layers
+			 * (ll_io_zero_page) by clearing PagePrivate2
+			 */
+			if (!offs)
+				ClearPagePrivate2(brwpg->pg);
+			break;
+		}
+
+		if (blockbits) {
+			/* This is direct IO case. Directly call decrypt
+			 * function that takes inode as input parameter.
+			 * Page does not need to be locked.
+			 */
+			struct cl_page *clpage;
+			u64 lblk_num;
+			unsigned int i;
+
+			clpage = oap2cl_page(brw_page2oap(brwpg));
+			lblk_num = ((u64)(clpage->cp_page_index) <<
+				    (PAGE_SHIFT - blockbits)) +
+				   (offs >> blockbits);
+			for (i = offs;
+			     i < offs + LUSTRE_ENCRYPTION_UNIT_SIZE;
+			     i += blocksize, lblk_num++) {
+				rc = llcrypt_decrypt_block_inplace(inode,
+								   brwpg->pg,
+								   blocksize, i,
+								   lblk_num);
+				if (rc)
+					break;
+			}
+		} else {
+			rc = llcrypt_decrypt_pagecache_blocks(brwpg->pg,
+						LUSTRE_ENCRYPTION_UNIT_SIZE,
+						offs);
+		}
+		if (rc)
+			return rc;
+
+		offs += LUSTRE_ENCRYPTION_UNIT_SIZE;
+	}
+
+	return 0;
+}
+
+/* process a contiguous run of pages, accounted to the current CPU */
+static int osc_crypt_chunk(void *data, u32 first, u32 count)
+{
+	struct osc_crypt_batch *ocb = data;
+	struct brw_page **pga = ocb->ocb_pga + first;
+	struct cli_crypt_stats *stats;
+	ktime_t start = ktime_get();
+	u64 bytes = 0;
+	u32 i;
+	int rc = 0;
+
+	for (i = 0; i < count; i++) {
+		if (ocb->ocb_write)
+			rc = osc_encrypt_brw_page(ocb->ocb_inode, pga[i],
+						  ocb->ocb_directio);
+		else
+			rc = osc_decrypt_brw_page(ocb->ocb_inode, pga[i],
+						  ocb->ocb_blockbits);
+		if (rc)
+			break;
+		bytes += pga[i]->count;
+	}
+
+	if (ocb->ocb_cli->cl_crypt_stats == NULL)
+		return rc;
+
+	stats = get_cpu_ptr(ocb->ocb_cli->cl_crypt_stats);
+	if (ocb->ocb_write) {
+		stats->ccs_encrypt_pages += i;
+		stats->ccs_encrypt_bytes += bytes;
+		stats->ccs_encrypt_usec += ktime_us_delta(ktime_get(), start);
+	} else {
+		stats->ccs_decrypt_pages += i;
+		stats->ccs_decrypt_bytes += bytes;
+		stats->ccs_decrypt_usec += ktime_us_delta(ktime_get(), start);
+	}
+	put_cpu_ptr(ocb->ocb_cli->cl_crypt_stats);
+
+	return rc;
+}
+
+/**
+ * Encrypt (\a write) or decrypt the pages of a bulk RPC.
+ *
+ * On write, every page successfully encrypted is replaced in \a pga by its
+ * bounce page, marked PageChecked for osc_release_bounce_pages(). On error,
+ * pages may be left partially processed, exactly as with inline processing.
+ *
+ * \param[in] blockbits	inode block bits for direct IO reads, 0 otherwise
+ *
+ * \retval 0		success
+ * \retval negative	first error met while processing the pages
+ */
+int osc_crypt_pages(struct client_obd *cli, struct inode *inode,
+		    struct brw_page **pga, u32 page_count, bool write,
+		    bool directio, unsigned int blockbits)
+{
+	struct osc_crypt_batch ocb = {
+		.ocb_cli	= cli,
+		.ocb_inode	= inode,
+		.ocb_pga	= pga,
+		.ocb_blockbits	= blockbits,
+		.ocb_write	= write,
+		.ocb_directio	= directio,
+	};
+
+	return sptlrpc_crypt_parallel(osc_crypt_chunk, &ocb, page_count,
+				      READ_ONCE(cli->cl_crypt_pipeline_pages));
+}
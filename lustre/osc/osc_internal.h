@@ -86,6 +86,14 @@ int osc_process_config_base(struct obd_device *obd, struct lustre_cfg *cfg);
 int osc_build_rpc(const struct lu_env *env, struct client_obd *cli,
 		  struct list_head *ext_list, int cmd);
 void osc_send_empty_rpc(struct osc_object *osc, pgoff_t start);
+
+/* default pages per encryption worker chunk, 0 encrypts inline */
+#define OSC_CRYPT_PIPELINE_PAGES_DEFAULT	16
+#define OSC_CRYPT_PIPELINE_PAGES_MAX		PTLRPC_MAX_BRW_PAGES
+int osc_crypt_pages(struct client_obd *cli, struct inode *inode,
+		    struct brw_page **pga, u32 page_count, bool write,
+		    bool directio, unsigned int blockbits);
+
 unsigned long osc_lru_reserve(struct client_obd *cli, unsigned long npages);
 void osc_lru_unreserve(struct client_obd *cli, unsigned long npages);
 
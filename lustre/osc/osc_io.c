@@ -227,6 +227,7 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 		}
 
 		if (sync_queue) {
+			osc_lru_use_flush(env);
 			result = osc_queue_sync_pages(env, io, osc, &list,
 						      brw_flags);
 			if (result < 0)
@@ -236,6 +237,7 @@ int osc_io_submit(const struct lu_env *env, const struct cl_io_slice *ios,
 		}
 	}
 
+	osc_lru_use_flush(env);
 	if (queued > 0)
 		result = osc_queue_sync_pages(env, io, osc, &list, brw_flags);
 
@@ -363,6 +365,7 @@ int osc_io_commit_async(const struct lu_env *env,
 			pagevec_reinit(pvec);
 		}
 	}
+	osc_lru_use_flush(env);
 	/* The shrink interval is in seconds, so we can update it once per
 	 * write, rather than once per page.
 	 */
@@ -925,6 +928,19 @@ int osc_io_write_start(const struct lu_env *env,
 }
 EXPORT_SYMBOL(osc_io_write_start);
 
+/* OST_SYNC RPCs sent by fsync and not replied yet, on all OSCs */
+static atomic_t osc_fsync_inflight = ATOMIC_INIT(0);
+
+static int osc_fsync_upcall(void *a, int rc)
+{
+	struct osc_async_cbargs *args = a;
+	struct osc_io *oio = container_of(args, struct osc_io, oi_cbarg);
+
+	oio->oi_fsync_done = ktime_get();
+	atomic_dec(&osc_fsync_inflight);
+	return osc_async_upcall(a, rc);
+}
+
 int osc_fsync_ost(const struct lu_env *env, struct osc_object *obj,
 		  struct cl_fsync_io *fio)
 {
@@ -948,11 +964,34 @@ int osc_fsync_ost(const struct lu_env *env, struct osc_object *obj,
 
 	init_completion(&cbargs->opc_sync);
 
-	rc = osc_sync_base(obj, oa, osc_async_upcall, cbargs, PTLRPCD_SET);
+	oio->oi_fsync_sent = ktime_get();
+	atomic_inc(&osc_fsync_inflight);
+	rc = osc_sync_base(obj, oa, osc_fsync_upcall, cbargs, PTLRPCD_SET);
+	if (rc)
+		atomic_dec(&osc_fsync_inflight);
+	cbargs->opc_rpc_sent = rc == 0;
 	RETURN(rc);
 }
 EXPORT_SYMBOL(osc_fsync_ost);
 
+static void osc_fsync_stats(struct osc_object *osc, ktime_t wait,
+			    ktime_t rpc, bool overlap)
+{
+	struct osc_stats *stats = &lu2osc_dev(osc2lu(osc)->lo_dev)->od_stats;
+	struct client_obd *cli = osc_cli(osc);
+	u64 rpc_us = ktime_to_us(rpc);
+
+	spin_lock(&cli->cl_loi_list_lock);
+	stats->os_fsync_count++;
+	stats->os_fsync_wait_us += ktime_to_us(wait);
+	stats->os_fsync_rpc_us += rpc_us;
+	if (rpc_us > stats->os_fsync_rpc_max_us)
+		stats->os_fsync_rpc_max_us = rpc_us;
+	if (overlap)
+		stats->os_fsync_overlap++;
+	spin_unlock(&cli->cl_loi_list_lock);
+}
+
 int osc_io_fsync_start(const struct lu_env *env,
 		       const struct cl_io_slice *slice)
 {
@@ -974,21 +1013,13 @@ int osc_io_fsync_start(const struct lu_env *env,
 		fio->fi_nr_written += result;
 		result = 0;
 	}
-	if (fio->fi_mode == CL_FSYNC_ALL) {
-		int rc;
-
-		/* we have to wait for writeback to finish before we can
-		 * send OST_SYNC RPC. This is bad because it causes extents
-		 * to be written osc by osc. However, we usually start
-		 * writeback before CL_FSYNC_ALL so this won't have any real
-		 * problem. */
-		rc = osc_cache_wait_range(env, osc, start, end);
-		if (result == 0)
-			result = rc;
-		rc = osc_fsync_ost(env, osc, fio);
-		if (result == 0)
-			result = rc;
-	}
+	/* We have to wait for writeback to finish before we can send
+	 * OST_SYNC RPC. Doing that here would write the stripes one by one,
+	 * so only start writeback now, and wait for it and send OST_SYNC in
+	 * osc_io_fsync_end(), after writeback has been started on all the
+	 * stripes of the file. */
+	if (fio->fi_mode == CL_FSYNC_ALL)
+		cl2osc_io(env, slice)->oi_fsync_deferred = 1;
 
 	RETURN(result);
 }
@@ -1002,20 +1033,66 @@ void osc_io_fsync_end(const struct lu_env *env,
 	pgoff_t end   = cl_index(obj, fio->fi_end);
 	int result = 0;
 
+	if (fio->fi_end == OBD_OBJECT_EOF)
+		end = CL_PAGE_EOF;
+
 	if (fio->fi_mode == CL_FSYNC_LOCAL) {
 		result = osc_cache_wait_range(env, cl2osc(obj), start, end);
 	} else if (fio->fi_mode == CL_FSYNC_ALL) {
 		struct osc_io           *oio    = cl2osc_io(env, slice);
 		struct osc_async_cbargs *cbargs = &oio->oi_cbarg;
 
-		wait_for_completion(&cbargs->opc_sync);
-		if (result == 0)
-			result = cbargs->opc_rc;
+		if (oio->oi_fsync_deferred) {
+			int rc;
+
+			/* OST_SYNC of this stripe overlaps with the writeback
+			 * of the next ones, its reply is waited for by
+			 * osc_io_fsync_iter_fini() */
+			oio->oi_fsync_start = ktime_get();
+			oio->oi_fsync_overlap =
+				atomic_read(&osc_fsync_inflight) > 0;
+			result = osc_cache_wait_range(env, cl2osc(obj), start,
+						      end);
+			rc = osc_fsync_ost(env, cl2osc(obj), fio);
+			if (result == 0)
+				result = rc;
+		} else if (cbargs->opc_rpc_sent) {
+			wait_for_completion(&cbargs->opc_sync);
+			if (result == 0)
+				result = cbargs->opc_rc;
+		}
 	}
 	slice->cis_io->ci_result = result;
 }
 EXPORT_SYMBOL(osc_io_fsync_end);
 
+/**
+ * Wait for the OST_SYNC RPC sent by osc_io_fsync_end().
+ *
+ * lov ends the fsync io of every stripe before finishing any of them, so the
+ * OST_SYNC RPCs of all the stripes of a file are in flight concurrently.
+ */
+static void osc_io_fsync_iter_fini(const struct lu_env *env,
+				   const struct cl_io_slice *slice)
+{
+	struct osc_io *oio = cl2osc_io(env, slice);
+	struct osc_async_cbargs *cbargs = &oio->oi_cbarg;
+	struct cl_io *io = slice->cis_io;
+
+	if (!oio->oi_fsync_deferred || !cbargs->opc_rpc_sent)
+		return;
+
+	wait_for_completion(&cbargs->opc_sync);
+	cbargs->opc_rpc_sent = false;
+	if (io->ci_result == 0)
+		io->ci_result = cbargs->opc_rc;
+
+	osc_fsync_stats(cl2osc(slice->cis_obj),
+			ktime_sub(oio->oi_fsync_sent, oio->oi_fsync_start),
+			ktime_sub(oio->oi_fsync_done, oio->oi_fsync_sent),
+			oio->oi_fsync_overlap);
+}
+
 static int osc_io_ladvise_start(const struct lu_env *env,
 				const struct cl_io_slice *slice)
 {
@@ -1280,6 +1357,7 @@ static const struct cl_io_operations osc_io_ops = {
 			.cio_fini   = osc_io_fini
 		},
 		[CIT_FSYNC] = {
+			.cio_iter_fini = osc_io_fsync_iter_fini,
 			.cio_start  = osc_io_fsync_start,
 			.cio_end    = osc_io_fsync_end,
 			.cio_fini   = osc_io_fini
@@ -40,7 +40,8 @@
 #include "osc_internal.h"
 
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg);
-static void osc_lru_use(struct client_obd *cli, struct osc_page *opg);
+static void osc_lru_use(const struct lu_env *env, struct client_obd *cli,
+			struct osc_page *opg);
 static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 			 struct osc_page *opg);
 
@@ -83,7 +84,7 @@ static void osc_page_transfer_add(const struct lu_env *env,
 {
 	struct osc_object *obj = cl2osc(opg->ops_cl.cpl_obj);
 
-	osc_lru_use(osc_cli(obj), opg);
+	osc_lru_use(env, osc_cli(obj), opg);
 }
 
 int osc_page_cache_add(const struct lu_env *env, struct osc_page *opg,
@@ -417,11 +418,42 @@ int lru_queue_work(const struct lu_env *env, void *data)
 	RETURN(0);
 }
 
+/**
+ * LRU partition of a page, the CPT of the NUMA node of its memory. Pages of
+ * nodes that aren't in the CPT table go to the CPT of the current CPU.
+ */
+static int osc_page_lru_part(struct osc_page *opg)
+{
+	struct page *vmpage = cl_page_vmpage(opg->ops_cl.cpl_page);
+	int cpt;
+
+	cpt = cfs_cpt_of_node(cfs_cpt_tab, page_to_nid(vmpage));
+	if (cpt < 0 || cpt >= cfs_cpt_number(cfs_cpt_tab))
+		cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+
+	return cpt;
+}
+
+static void osc_lru_splice(struct client_obd *cli, int cpt,
+			   struct list_head *lru, long npages)
+{
+	struct cl_lru_part *part = cli->cl_lru_parts[cpt];
+
+	spin_lock(&part->clp_lock);
+	list_splice_tail_init(lru, &part->clp_list);
+	part->clp_count += npages;
+	atomic_long_sub(npages, &cli->cl_lru_busy);
+	atomic_long_add(npages, &cli->cl_lru_in_list);
+	spin_unlock(&part->clp_lock);
+}
+
 void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 {
 	LIST_HEAD(lru);
 	struct osc_async_page *oap;
 	long npages = 0;
+	long total = 0;
+	int cpt = 0;
 
 	list_for_each_entry(oap, plist, oap_pending_item) {
 		struct osc_page *opg = oap2osc_page(oap);
@@ -429,31 +461,70 @@ void osc_lru_add_batch(struct client_obd *cli, struct list_head *plist)
 		if (!opg->ops_in_lru)
 			continue;
 
+		/* pages of an RPC are mostly from the same node, so they are
+		 * moved to their LRU partition in runs */
+		if (npages > 0 && opg->ops_lru_part != cpt) {
+			osc_lru_splice(cli, cpt, &lru, npages);
+			npages = 0;
+		}
+
+		cpt = opg->ops_lru_part;
 		++npages;
+		++total;
 		LASSERT(list_empty(&opg->ops_lru));
 		list_add(&opg->ops_lru, &lru);
 	}
 
-	if (npages > 0) {
-		spin_lock(&cli->cl_lru_list_lock);
-		list_splice_tail(&lru, &cli->cl_lru_list);
-		atomic_long_sub(npages, &cli->cl_lru_busy);
-		atomic_long_add(npages, &cli->cl_lru_in_list);
+	if (npages > 0)
+		osc_lru_splice(cli, cpt, &lru, npages);
+
+	if (total > 0) {
 		cli->cl_lru_last_used = ktime_get_real_seconds();
-		spin_unlock(&cli->cl_lru_list_lock);
 
 		if (waitqueue_active(&osc_lru_waitq))
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 	}
 }
 
-static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
+static void __osc_lru_del(struct client_obd *cli, struct cl_lru_part *part,
+			  struct osc_page *opg)
 {
 	LASSERT(atomic_long_read(&cli->cl_lru_in_list) > 0);
+	LASSERT(part->clp_count > 0);
 	list_del_init(&opg->ops_lru);
+	part->clp_count--;
 	atomic_long_dec(&cli->cl_lru_in_list);
 }
 
+/**
+ * Check if there are free LRU slots, including the ones freed pages have
+ * not returned to the cache yet.
+ *
+ * This is called by the LRU waiters after they are queued on osc_lru_waitq,
+ * so that a slot put by osc_lru_left_put() is either seen here or the waiter
+ * is woken up.
+ */
+static bool osc_lru_left_avail(struct client_obd *cli)
+{
+	return atomic_long_read(cli->cl_lru_left) > 0 ||
+	       cl_cache_lru_flush(cli->cl_cache) > 0;
+}
+
+/**
+ * Return the LRU slot of a destroyed page to the cache.
+ */
+static void osc_lru_left_put(struct client_obd *cli)
+{
+	cl_cache_lru_put(cli->cl_cache, 1);
+
+	/* pairs with the barrier in prepare_to_wait_event() of the waiters */
+	smp_mb();
+	if (waitqueue_active(&osc_lru_waitq)) {
+		cl_cache_lru_flush(cli->cl_cache);
+		wake_up(&osc_lru_waitq);
+	}
+}
+
 /**
  * Page is being destroyed. The page may be not in LRU list, if the transfer
  * has never finished(error occurred).
@@ -461,16 +532,18 @@ static void __osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 {
 	if (opg->ops_in_lru) {
-		spin_lock(&cli->cl_lru_list_lock);
+		struct cl_lru_part *part = cli->cl_lru_parts[opg->ops_lru_part];
+
+		spin_lock(&part->clp_lock);
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, part, opg);
 		} else {
 			LASSERT(atomic_long_read(&cli->cl_lru_busy) > 0);
 			atomic_long_dec(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
+		spin_unlock(&part->clp_lock);
 
-		atomic_long_inc(cli->cl_lru_left);
+		osc_lru_left_put(cli);
 		/* this is a great place to release more LRU pages if
 		 * this osc occupies too many LRU pages and kernel is
 		 * stealing one of them. */
@@ -478,29 +551,77 @@ static void osc_lru_del(struct client_obd *cli, struct osc_page *opg)
 			CDEBUG(D_CACHE, "%s: queue LRU work\n", cli_name(cli));
 			(void)ptlrpcd_queue_work(cli->cl_lru_work);
 		}
-		wake_up(&osc_lru_waitq);
 	} else {
 		LASSERT(list_empty(&opg->ops_lru));
 	}
 }
 
 /**
- * Delete page from LRU list for redirty.
+ * Take the pages batched by osc_lru_use() off their LRU partitions.
+ *
+ * Pages of an IO are mostly in the same partition, so the partition lock is
+ * taken once per run of pages instead of once per page. This must be called
+ * before the pages can be sent, since the RPC completion puts them back on
+ * the LRU, so osc_extent_release() and osc_io_submit() flush the batch too.
  */
-static void osc_lru_use(struct client_obd *cli, struct osc_page *opg)
+void osc_lru_use_flush(const struct lu_env *env)
 {
-	/* If page is being transferred for the first time,
-	 * ops_lru should be empty */
-	if (opg->ops_in_lru) {
-		if (list_empty(&opg->ops_lru))
-			return;
-		spin_lock(&cli->cl_lru_list_lock);
+	struct osc_thread_info *oti = osc_env_info(env);
+	struct client_obd *cli = oti->oti_lru_use_cli;
+	struct cl_lru_part *part = NULL;
+	unsigned int i;
+
+	if (oti->oti_lru_use_nr == 0)
+		return;
+
+	for (i = 0; i < oti->oti_lru_use_nr; i++) {
+		struct osc_page *opg = oti->oti_lru_use[i];
+
+		if (part != cli->cl_lru_parts[opg->ops_lru_part]) {
+			if (part)
+				spin_unlock(&part->clp_lock);
+			part = cli->cl_lru_parts[opg->ops_lru_part];
+			spin_lock(&part->clp_lock);
+		}
 		if (!list_empty(&opg->ops_lru)) {
-			__osc_lru_del(cli, opg);
+			__osc_lru_del(cli, part, opg);
 			atomic_long_inc(&cli->cl_lru_busy);
 		}
-		spin_unlock(&cli->cl_lru_list_lock);
 	}
+	spin_unlock(&part->clp_lock);
+
+	for (i = 0; i < oti->oti_lru_use_nr; i++) {
+		cl_page_put(env, oti->oti_lru_use[i]->ops_cl.cpl_page);
+		oti->oti_lru_use[i] = NULL;
+	}
+	oti->oti_lru_use_nr = 0;
+	oti->oti_lru_use_cli = NULL;
+}
+EXPORT_SYMBOL(osc_lru_use_flush);
+
+/**
+ * Delete page from LRU list for redirty.
+ *
+ * The page is only queued here, it is taken off the LRU by
+ * osc_lru_use_flush() together with the other pages of the IO.
+ */
+static void osc_lru_use(const struct lu_env *env, struct client_obd *cli,
+			struct osc_page *opg)
+{
+	struct osc_thread_info *oti = osc_env_info(env);
+
+	/* If page is being transferred for the first time,
+	 * ops_lru should be empty */
+	if (!opg->ops_in_lru || list_empty(&opg->ops_lru))
+		return;
+
+	if (oti->oti_lru_use_nr == OTI_LRU_USE_SIZE ||
+	    (oti->oti_lru_use_nr > 0 && oti->oti_lru_use_cli != cli))
+		osc_lru_use_flush(env);
+
+	cl_page_get(opg->ops_cl.cpl_page);
+	oti->oti_lru_use_cli = cli;
+	oti->oti_lru_use[oti->oti_lru_use_nr++] = opg;
 }
 
 static void discard_pagevec(const struct lu_env *env, struct cl_io *io,
@@ -552,61 +673,43 @@ static inline bool lru_page_busy(struct client_obd *cli, struct cl_page *page)
 }
 
 /**
- * Drop @target of pages from LRU at most.
+ * Drop @target of pages from LRU partition @part at most.
  */
-long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
-		   long target, bool force)
+static long osc_lru_shrink_part(const struct lu_env *env,
+				struct client_obd *cli,
+				struct cl_lru_part *part, long target,
+				bool force)
 {
 	struct cl_io *io;
 	struct cl_object *clobj = NULL;
 	struct cl_page **pvec;
 	struct osc_page *opg;
 	long count = 0;
-	int maxscan = 0;
+	long maxscan = 0;
 	int index = 0;
 	int rc = 0;
 	ENTRY;
 
-	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
-	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
-		RETURN(0);
-
-	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
-	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
-	if (!force) {
-		if (atomic_read(&cli->cl_lru_shrinkers) > 0)
-			RETURN(-EBUSY);
-
-		if (atomic_inc_return(&cli->cl_lru_shrinkers) > 1) {
-			atomic_dec(&cli->cl_lru_shrinkers);
-			RETURN(-EBUSY);
-		}
-	} else {
-		atomic_inc(&cli->cl_lru_shrinkers);
-	}
-
 	pvec = (struct cl_page **)osc_env_info(env)->oti_pvec;
 	io = osc_env_thread_io(env);
 
-	spin_lock(&cli->cl_lru_list_lock);
-	if (force)
-		cli->cl_lru_reclaim++;
-	maxscan = min(target << 1, atomic_long_read(&cli->cl_lru_in_list));
-	while (!list_empty(&cli->cl_lru_list)) {
+	spin_lock(&part->clp_lock);
+	maxscan = min(target << 1, part->clp_count);
+	while (!list_empty(&part->clp_list)) {
 		struct cl_page *page;
 		bool will_free = false;
 
-		if (!force && atomic_read(&cli->cl_lru_shrinkers) > 1)
+		if (!force && atomic_read(&part->clp_shrinkers) > 1)
 			break;
 
 		if (--maxscan < 0)
 			break;
 
-		opg = list_first_entry(&cli->cl_lru_list, struct osc_page,
+		opg = list_first_entry(&part->clp_list, struct osc_page,
 				       ops_lru);
 		page = opg->ops_cl.cpl_page;
 		if (lru_page_busy(cli, page)) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &part->clp_list);
 			continue;
 		}
 
@@ -615,7 +718,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			struct cl_object *tmp = page->cp_obj;
 
 			cl_object_get(tmp);
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&part->clp_lock);
 
 			if (clobj != NULL) {
 				discard_pagevec(env, io, pvec, index);
@@ -631,7 +734,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			io->ci_ignore_layout = 1;
 			rc = cl_io_init(env, io, CIT_MISC, clobj);
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&part->clp_lock);
 
 			if (rc != 0)
 				break;
@@ -644,7 +747,7 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 			if (!lru_page_busy(cli, page)) {
 				/* remove it from lru list earlier to avoid
 				 * lock contention */
-				__osc_lru_del(cli, opg);
+				__osc_lru_del(cli, part, opg);
 				opg->ops_in_lru = 0; /* will be discarded */
 
 				cl_page_get(page);
@@ -655,24 +758,24 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		}
 
 		if (!will_free) {
-			list_move_tail(&opg->ops_lru, &cli->cl_lru_list);
+			list_move_tail(&opg->ops_lru, &part->clp_list);
 			continue;
 		}
 
-		/* Don't discard and free the page with cl_lru_list held */
+		/* Don't discard and free the page with clp_lock held */
 		pvec[index++] = page;
 		if (unlikely(index == OTI_PVEC_SIZE)) {
-			spin_unlock(&cli->cl_lru_list_lock);
+			spin_unlock(&part->clp_lock);
 			discard_pagevec(env, io, pvec, index);
 			index = 0;
 
-			spin_lock(&cli->cl_lru_list_lock);
+			spin_lock(&part->clp_lock);
 		}
 
 		if (++count >= target)
 			break;
 	}
-	spin_unlock(&cli->cl_lru_list_lock);
+	spin_unlock(&part->clp_lock);
 
 	if (clobj != NULL) {
 		discard_pagevec(env, io, pvec, index);
@@ -681,10 +784,75 @@ long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
 		cl_object_put(env, clobj);
 	}
 
+	RETURN(count > 0 ? count : rc);
+}
+
+/**
+ * Drop @target of pages from LRU at most.
+ *
+ * The LRU partitions are scanned starting from the one local to the calling
+ * thread, so that reclaimers running on different nodes shrink different
+ * partitions in parallel and free node local memory first. Without @force,
+ * partitions being shrunk by another thread are skipped.
+ */
+long osc_lru_shrink(const struct lu_env *env, struct client_obd *cli,
+		   long target, bool force)
+{
+	struct cl_lru_part *part;
+	long count = 0;
+	long rc = 0;
+	bool busy = false;
+	int ncpt = cfs_cpt_number(cfs_cpt_tab);
+	int cpt;
+	int i;
+	ENTRY;
+
+	LASSERT(atomic_long_read(&cli->cl_lru_in_list) >= 0);
+	if (atomic_long_read(&cli->cl_lru_in_list) == 0 || target <= 0)
+		RETURN(0);
+
+	CDEBUG(D_CACHE, "%s: shrinkers: %d, force: %d\n",
+	       cli_name(cli), atomic_read(&cli->cl_lru_shrinkers), force);
+
+	atomic_inc(&cli->cl_lru_shrinkers);
+	if (force)
+		cli->cl_lru_reclaim++;
+
+	cpt = cfs_cpt_current(cfs_cpt_tab, 1);
+	for (i = 0; i < ncpt && count < target; i++) {
+		part = cli->cl_lru_parts[(cpt + i) % ncpt];
+		if (READ_ONCE(part->clp_count) == 0)
+			continue;
+
+		if (!force) {
+			if (atomic_read(&part->clp_shrinkers) > 0) {
+				busy = true;
+				continue;
+			}
+
+			if (atomic_inc_return(&part->clp_shrinkers) > 1) {
+				atomic_dec(&part->clp_shrinkers);
+				busy = true;
+				continue;
+			}
+		} else {
+			atomic_inc(&part->clp_shrinkers);
+		}
+
+		rc = osc_lru_shrink_part(env, cli, part, target - count,
+					 force);
+		atomic_dec(&part->clp_shrinkers);
+		if (rc < 0)
+			break;
+		count += rc;
+	}
+
 	atomic_dec(&cli->cl_lru_shrinkers);
 	if (count > 0) {
 		atomic_long_add(count, cli->cl_lru_left);
 		wake_up(&osc_lru_waitq);
+	} else if (rc == 0 && busy) {
+		rc = -EBUSY;
 	}
 	RETURN(count > 0 ? count : rc);
 }
@@ -712,6 +880,14 @@ static long osc_lru_reclaim(struct client_obd *cli, unsigned long npages)
 	if (IS_ERR(env))
 		RETURN(rc);
 
+	/* slots freed by destroyed pages may not have been returned yet */
+	rc = cl_cache_lru_flush(cache);
+	if (rc > 0) {
+		CDEBUG(D_CACHE, "%s: returned %ld freed LRU slots\n",
+		       cli_name(cli), rc);
+		GOTO(out, rc);
+	}
+
 	npages = max_t(int, npages, cli->cl_max_pages_per_rpc);
 	CDEBUG(D_CACHE, "%s: start to reclaim %ld pages from LRU\n",
 	       cli_name(cli), npages);
@@ -787,6 +963,8 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 	if (cli->cl_cache == NULL) /* shall not be in LRU */
 		RETURN(0);
 
+	opg->ops_lru_part = osc_page_lru_part(opg);
+
 	if (oio->oi_lru_reserved > 0) {
 		--oio->oi_lru_reserved;
 		goto out;
@@ -802,16 +980,15 @@ static int osc_lru_alloc(const struct lu_env *env, struct client_obd *cli,
 			continue;
 		/* IO issued by readahead, don't try hard */
 		if (oio->oi_is_readahead) {
-			if (atomic_long_read(cli->cl_lru_left) > 0)
+			if (osc_lru_left_avail(cli))
 				continue;
 			rc = -EBUSY;
 			break;
 		}
 
 		cond_resched();
-		rc = l_wait_event_abortable(
-			osc_lru_waitq,
-			atomic_long_read(cli->cl_lru_left) > 0);
+		rc = l_wait_event_abortable(osc_lru_waitq,
+					    osc_lru_left_avail(cli));
 		if (rc < 0) {
 			rc = -EINTR;
 			break;
@@ -866,9 +1043,8 @@ again:
 
 	if (reserved != npages) {
 		cond_resched();
-		rc = l_wait_event_abortable(
-			osc_lru_waitq,
-			atomic_long_read(cli->cl_lru_left) > 0);
+		rc = l_wait_event_abortable(osc_lru_waitq,
+					    osc_lru_left_avail(cli));
 		goto again;
 	}
 
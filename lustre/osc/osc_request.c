@@ -61,6 +61,10 @@ module_param(osc_reqpool_mem_max, uint, 0444);
 static int osc_idle_timeout = 20;
 module_param(osc_idle_timeout, uint, 0644);
 
+static bool osc_lazy_connect;
+module_param(osc_lazy_connect, bool, 0644);
+MODULE_PARM_DESC(osc_lazy_connect, "connect OSCs on first use instead of at mount");
+
 #define osc_grant_args osc_brw_async_args
 
 struct osc_setattr_args {
@@ -1377,7 +1381,7 @@ static inline void osc_release_bounce_pages(struct brw_page **pga,
 
 	for (i = 0; i < page_count; i++) {
 		/* Bounce pages allocated by a call to
-		 * llcrypt_encrypt_pagecache_blocks() in osc_brw_prep_request()
+		 * llcrypt_encrypt_pagecache_blocks() in osc_crypt_pages()
 		 * are identified thanks to the PageChecked flag.
 		 */
 		if (PageChecked(pga[i]->pg))
@@ -1436,75 +1440,18 @@ osc_brw_prep_request(int cmd, struct client_obd *cli, struct obdo *oa,
 
 	if (opc == OST_WRITE && inode && IS_ENCRYPTED(inode) &&
 	    llcrypt_has_encryption_key(inode)) {
-		for (i = 0; i < page_count; i++) {
-			struct brw_page *brwpg = pga[i];
-			struct page *data_page = NULL;
-			bool retried = false;
-			bool lockedbymyself;
-			u32 nunits = (brwpg->off & ~PAGE_MASK) + brwpg->count;
-			struct address_space *map_orig = NULL;
-			pgoff_t index_orig;
-
-retry_encrypt:
-			nunits = round_up(nunits, LUSTRE_ENCRYPTION_UNIT_SIZE);
-			/* The page can already be locked when we arrive here.
-			 * This is possible when cl_page_assume/vvp_page_assume
-			 * is stuck on wait_on_page_writeback with page lock
-			 * held. In this case there is no risk for the lock to
-			 * be released while we are doing our encryption
-			 * processing, because writeback against that page will
-			 * end in vvp_page_completion_write/cl_page_completion,
-			 * which means only once the page is fully processed.
-			 */
-			lockedbymyself = trylock_page(brwpg->pg);
-			if (directio) {
-				map_orig = brwpg->pg->mapping;
-				brwpg->pg->mapping = inode->i_mapping;
-				index_orig = brwpg->pg->index;
-				clpage = oap2cl_page(brw_page2oap(brwpg));
-				brwpg->pg->index = clpage->cp_page_index;
-			}
-			data_page =
-				llcrypt_encrypt_pagecache_blocks(brwpg->pg,
-								 nunits, 0,
-								 GFP_NOFS);
-			if (directio) {
-				brwpg->pg->mapping = map_orig;
-				brwpg->pg->index = index_orig;
-			}
-			if (lockedbymyself)
-				unlock_page(brwpg->pg);
-			if (IS_ERR(data_page)) {
-				rc = PTR_ERR(data_page);
-				if (rc == -ENOMEM && !retried) {
-					retried = true;
-					rc = 0;
-					goto retry_encrypt;
-				}
-				ptlrpc_request_free(req);
-				RETURN(rc);
-			}
-			/* Set PageChecked flag on bounce page for
-			 * disambiguation in osc_release_bounce_pages().
-			 */
-			SetPageChecked(data_page);
-			brwpg->pg = data_page;
-			/* there should be no gap in the middle of page array */
-			if (i == page_count - 1) {
-				struct osc_async_page *oap =
-					brw_page2oap(brwpg);
-
-				oa->o_size = oap->oap_count +
-					oap->oap_obj_off + oap->oap_page_off;
-			}
-			/* len is forced to nunits, and relative offset to 0
-			 * so store the old, clear text info
-			 */
-			brwpg->bp_count_diff = nunits - brwpg->count;
-			brwpg->count = nunits;
-			brwpg->bp_off_diff = brwpg->off & ~PAGE_MASK;
-			brwpg->off = brwpg->off & PAGE_MASK;
+		struct osc_async_page *oap;
+
+		rc = osc_crypt_pages(cli, inode, pga, page_count, true,
+				     directio, 0);
+		if (rc) {
+			ptlrpc_request_free(req);
+			RETURN(rc);
 		}
+		/* there should be no gap in the middle of page array */
+		oap = brw_page2oap(pga[page_count - 1]);
+		oa->o_size = oap->oap_count + oap->oap_obj_off +
+			     oap->oap_page_off;
 	} else if (opc == OST_WRITE && inode && IS_ENCRYPTED(inode)) {
 		struct osc_async_page *oap = brw_page2oap(pga[0]);
 		struct cl_page *clpage = oap2cl_page(oap);
@@ -1972,7 +1919,7 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 	struct ost_body *body;
 	u32 client_cksum = 0;
 	struct inode *inode = NULL;
-	unsigned int blockbits = 0, blocksize = 0;
+	unsigned int blockbits = 0;
 	struct cl_page *clpage;
 
 	ENTRY;
@@ -2170,73 +2117,18 @@ static int osc_brw_fini_request(struct ptlrpc_request *req, int rc)
 	/* get the inode from the first cl_page */
 	clpage = oap2cl_page(brw_page2oap(aa->aa_ppga[0]));
 	inode = clpage->cp_inode;
-	if (clpage->cp_type == CPT_TRANSIENT && inode) {
+	if (clpage->cp_type == CPT_TRANSIENT && inode)
 		blockbits = inode->i_blkbits;
-		blocksize = 1 << blockbits;
-	}
 	if (inode && IS_ENCRYPTED(inode)) {
-		int idx;
-
 		if (!llcrypt_has_encryption_key(inode)) {
 			CDEBUG(D_SEC, "no enc key for ino %lu\n", inode->i_ino);
 			GOTO(out, rc);
 		}
-		for (idx = 0; idx < aa->aa_page_count; idx++) {
-			struct brw_page *brwpg = aa->aa_ppga[idx];
-			unsigned int offs = 0;
-
-			while (offs < PAGE_SIZE) {
-				/* do not decrypt if page is all 0s */
-				if (memchr_inv(page_address(brwpg->pg) + offs,
-				      0, LUSTRE_ENCRYPTION_UNIT_SIZE) == NULL) {
-					/* if page is empty forward info to
-					 * upper layers (ll_io_zero_page) by
-					 * clearing PagePrivate2
-					 */
-					if (!offs)
-						ClearPagePrivate2(brwpg->pg);
-					break;
-				}
-
-				if (blockbits) {
-					/* This is direct IO case. Directly call
-					 * decrypt function that takes inode as
-					 * input parameter. Page does not need
-					 * to be locked.
-					 */
-					u64 lblk_num;
-					unsigned int i;
-
-					clpage =
-					       oap2cl_page(brw_page2oap(brwpg));
-					lblk_num =
-						((u64)(clpage->cp_page_index) <<
-						(PAGE_SHIFT - blockbits)) +
-						(offs >> blockbits);
-					for (i = offs;
-					     i < offs +
-						    LUSTRE_ENCRYPTION_UNIT_SIZE;
-					     i += blocksize, lblk_num++) {
-						rc =
-						  llcrypt_decrypt_block_inplace(
-							  inode, brwpg->pg,
-							  blocksize, i,
-							  lblk_num);
-						if (rc)
-							break;
-					}
-				} else {
-					rc = llcrypt_decrypt_pagecache_blocks(
-						brwpg->pg,
-						LUSTRE_ENCRYPTION_UNIT_SIZE,
-						offs);
-				}
-				if (rc)
-					GOTO(out, rc);
-
-				offs += LUSTRE_ENCRYPTION_UNIT_SIZE;
-			}
-		}
+		rc = osc_crypt_pages(aa->aa_cli, inode, aa->aa_ppga,
+				     aa->aa_page_count, false, false,
+				     blockbits);
+		if (rc)
+			GOTO(out, rc);
 	}
 
 out:
@@ -3547,12 +3439,20 @@ int osc_setup_common(struct obd_device *obd, struct lustre_cfg *lcfg)
 	if (rc)
 		GOTO(out_ptlrpcd_work, rc);
 
+	cli->cl_crypt_stats = alloc_percpu(struct cli_crypt_stats);
+	if (cli->cl_crypt_stats == NULL)
+		GOTO(out_quota, rc = -ENOMEM);
+	cli->cl_crypt_stats_init = ktime_get();
+	cli->cl_crypt_pipeline_pages = OSC_CRYPT_PIPELINE_PAGES_DEFAULT;
+
 	cli->cl_grant_shrink_interval = GRANT_SHRINK_INTERVAL;
 	cli->cl_root_squash = 0;
 	osc_update_next_shrink(cli);
 
 	RETURN(rc);
 
+out_quota:
+	osc_quota_cleanup(obd);
 out_ptlrpcd_work:
 	if (cli->cl_writeback_work != NULL) {
 		ptlrpcd_destroy_work(cli->cl_writeback_work);
@@ -3609,6 +3509,7 @@ int osc_setup(struct obd_device *obd, struct lustre_cfg *lcfg)
 	spin_unlock(&osc_shrink_lock);
 	cli->cl_import->imp_idle_timeout = osc_idle_timeout;
 	cli->cl_import->imp_idle_debug = D_HA;
+	cli->cl_import->imp_lazy_connect = osc_lazy_connect;
 
 	RETURN(0);
 }
@@ -3678,6 +3579,11 @@ int osc_cleanup_common(struct obd_device *obd)
 	/* free memory of osc quota cache */
 	osc_quota_cleanup(obd);
 
+	if (cli->cl_crypt_stats != NULL) {
+		free_percpu(cli->cl_crypt_stats);
+		cli->cl_crypt_stats = NULL;
+	}
+
 	rc = client_obd_cleanup(obd);
 
 	ptlrpcd_decref();
@@ -52,6 +52,8 @@
  * OBD_FAIL_CHECK
  */
 #include <obd_support.h>
+/* obd_dif_guards_compare() */
+#include <obd_cksum.h>
 
 #include "osd_internal.h"
 
@@ -299,22 +301,18 @@ static void bio_integrity_fault_inject(struct bio *bio)
 static int bio_dif_compare(__u16 *expected_guard_buf, void *bio_prot_buf,
 			   unsigned int sectors, int tuple_size)
 {
-	__u16 *expected_guard;
 	__u16 *bio_guard;
-	int i;
-
-	expected_guard = expected_guard_buf;
-	for (i = 0; i < sectors; i++) {
-		bio_guard = (__u16 *)bio_prot_buf;
-		if (*bio_guard != *expected_guard) {
-			CERROR(
-			       "unexpected guard tags on sector %d expected guard %u, bio guard %u, sectors %u, tuple size %d\n",
-			       i, *expected_guard, *bio_guard, sectors,
-			       tuple_size);
-			return -EIO;
-		}
-		expected_guard++;
-		bio_prot_buf += tuple_size;
+	unsigned int i;
+
+	i = obd_dif_guards_compare(expected_guard_buf, bio_prot_buf, sectors,
+				   tuple_size);
+	if (i < sectors) {
+		bio_guard = bio_prot_buf + i * tuple_size;
+		CERROR(
+		       "unexpected guard tags on sector %u expected guard %u, bio guard %u, sectors %u, tuple size %d\n",
+		       i, expected_guard_buf[i], *bio_guard, sectors,
+		       tuple_size);
+		return -EIO;
 	}
 	return 0;
 }
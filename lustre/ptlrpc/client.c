@@ -1037,6 +1037,150 @@ struct ptlrpc_request *ptlrpc_request_alloc_pack(struct obd_import *imp,
 }
 EXPORT_SYMBOL(ptlrpc_request_alloc_pack);
 
+static int ptlrpc_set_timer_compare(struct binheap_node *a,
+				    struct binheap_node *b)
+{
+	struct ptlrpc_request *ra;
+	struct ptlrpc_request *rb;
+
+	ra = container_of(a, struct ptlrpc_request, rq_timer_node);
+	rb = container_of(b, struct ptlrpc_request, rq_timer_node);
+
+	return ra->rq_set_deadline < rb->rq_set_deadline;
+}
+
+static struct binheap_ops ptlrpc_set_timer_ops = {
+	.hop_enter	= NULL,
+	.hop_exit	= NULL,
+	.hop_compare	= ptlrpc_set_timer_compare,
+};
+
+/**
+ * Time by which \a req has to be checked even if no event arrives for it,
+ * or 0 if it is not waiting for anything with a timeout.
+ */
+static time64_t ptlrpc_req_next_deadline(struct ptlrpc_request *req)
+{
+	time64_t deadline;
+
+	/* Request in-flight? */
+	if (!(((req->rq_phase == RQ_PHASE_RPC) && !req->rq_waiting) ||
+	      (req->rq_phase == RQ_PHASE_BULK) ||
+	      (req->rq_phase == RQ_PHASE_NEW)))
+		return 0;
+
+	/* Already timed out. */
+	if (req->rq_timedout)
+		return 0;
+
+	/* Waiting for ctx. */
+	if (req->rq_wait_ctx)
+		return 0;
+
+	if (req->rq_phase == RQ_PHASE_NEW)
+		deadline = req->rq_sent;
+	else if (req->rq_phase == RQ_PHASE_RPC && req->rq_resend)
+		deadline = req->rq_sent;
+	else
+		deadline = req->rq_sent + req->rq_timeout;
+
+	/* 0 is kept for requests which are not timed */
+	return max_t(time64_t, deadline, 1);
+}
+
+/**
+ * Stop using the timer heap of \a set, used when it cannot grow.
+ */
+static void ptlrpc_set_timer_fini(struct ptlrpc_request_set *set)
+{
+	struct ptlrpc_request *req;
+
+	list_for_each_entry(req, &set->set_requests, rq_set_chain)
+		req->rq_set_deadline = 0;
+
+	binheap_destroy(set->set_timer_heap);
+	set->set_timer_heap = NULL;
+	set->set_scan_only = 1;
+}
+
+/**
+ * Requeue \a req in the timer heap of \a set according to its current
+ * state. Only called by the thread processing the set.
+ */
+static void ptlrpc_set_timer_update(struct ptlrpc_request_set *set,
+				    struct ptlrpc_request *req)
+{
+	struct binheap *heap = set->set_timer_heap;
+	time64_t deadline;
+
+	if (heap == NULL)
+		return;
+
+	deadline = ptlrpc_req_next_deadline(req);
+	if (deadline == req->rq_set_deadline)
+		return;
+
+	if (deadline == 0) {
+		binheap_remove(heap, &req->rq_timer_node);
+		req->rq_set_deadline = 0;
+	} else if (req->rq_set_deadline == 0) {
+		req->rq_set_deadline = deadline;
+		if (binheap_insert(heap, &req->rq_timer_node) != 0) {
+			CDEBUG(D_RPCTRACE,
+			       "set %p: cannot grow timer heap, scanning\n",
+			       set);
+			req->rq_set_deadline = 0;
+			ptlrpc_set_timer_fini(set);
+		}
+	} else {
+		req->rq_set_deadline = deadline;
+		binheap_relocate(heap, &req->rq_timer_node);
+	}
+}
+
+static void ptlrpc_set_timer_del(struct ptlrpc_request_set *set,
+				 struct ptlrpc_request *req)
+{
+	if (req->rq_set_deadline == 0)
+		return;
+
+	binheap_remove(set->set_timer_heap, &req->rq_timer_node);
+	req->rq_set_deadline = 0;
+}
+
+/**
+ * Queue \a req for the next ptlrpc_check_set() of \a set, called whenever
+ * something happens to the request (reply, bulk or unlink event, error,
+ * resend...) which the set processing needs to act upon.
+ *
+ * This is called from event callbacks with rq_lock held, and with imp_lock
+ * and rq_lock held when in-flight requests are aborted, so set_ready_lock
+ * nests inside both and nothing else may be taken under it.
+ */
+void ptlrpc_set_req_ready(struct ptlrpc_request_set *set,
+			  struct ptlrpc_request *req)
+{
+	spin_lock(&set->set_ready_lock);
+	if (req->rq_set == set && list_empty(&req->rq_ready_chain))
+		list_add_tail(&req->rq_ready_chain, &set->set_ready);
+	spin_unlock(&set->set_ready_lock);
+}
+EXPORT_SYMBOL(ptlrpc_set_req_ready);
+
+/**
+ * Forget about \a req in \a set, once req->rq_set does not point to the
+ * set any more.
+ */
+void ptlrpc_set_req_unlink(struct ptlrpc_request_set *set,
+			   struct ptlrpc_request *req)
+{
+	ptlrpc_set_timer_del(set, req);
+
+	spin_lock(&set->set_ready_lock);
+	list_del_init(&req->rq_ready_chain);
+	spin_unlock(&set->set_ready_lock);
+}
+
 /**
  * Allocate and initialize new request set structure on the current CPT.
  * Returns a pointer to the newly allocated set structure or NULL on error.
@@ -1058,6 +1202,9 @@ struct ptlrpc_request_set *ptlrpc_prep_set(void)
 	atomic_set(&set->set_remaining, 0);
 	spin_lock_init(&set->set_new_req_lock);
 	INIT_LIST_HEAD(&set->set_new_requests);
+	spin_lock_init(&set->set_ready_lock);
+	INIT_LIST_HEAD(&set->set_ready);
+	set->set_timer_heap = NULL;
 	set->set_max_inflight = UINT_MAX;
 	set->set_producer     = NULL;
 	set->set_producer_arg = NULL;
@@ -1136,6 +1283,7 @@ void ptlrpc_set_destroy(struct ptlrpc_request_set *set)
 		req->rq_set = NULL;
 		req->rq_invalid_rqset = 0;
 		spin_unlock(&req->rq_lock);
+		ptlrpc_set_req_unlink(set, req);
 
 		ptlrpc_req_finished(req);
 	}
@@ -1170,6 +1318,7 @@ void ptlrpc_set_add_req(struct ptlrpc_request_set *set,
 	req->rq_set = set;
 	atomic_inc(&set->set_remaining);
 	req->rq_queued_time = ktime_get_seconds();
+	ptlrpc_set_req_ready(set, req);
 
 	if (req->rq_reqmsg)
 		lustre_msg_set_jobid(req->rq_reqmsg, NULL);
@@ -1782,478 +1931,581 @@ static inline int ptlrpc_set_producer(struct ptlrpc_request_set *set)
 }
 
 /**
- * this sends any unsent RPCs in \a set and returns 1 if all are sent
- * and no more replies are expected.
- * (it is possible to get less replies than requests sent e.g. due to timed out
- * requests or requests that we had trouble to send out)
+ * Advance request \a req of \a set through its state machine as far as
+ * possible. Requests which complete are moved to \a comp_reqs, unless the
+ * set has a producer in which case they are released straight away.
  *
- * NOTE: This function contains a potential schedule point (cond_resched()).
+ * \retval 1 if the set timeout needs to be recalculated
+ * \retval 0 otherwise
  */
-int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
+static int ptlrpc_check_req(const struct lu_env *env,
+			    struct ptlrpc_request_set *set,
+			    struct ptlrpc_request *req,
+			    struct list_head *comp_reqs)
 {
-	struct ptlrpc_request *req, *next;
-	LIST_HEAD(comp_reqs);
+	struct obd_import *imp = req->rq_import;
 	int force_timer_recalc = 0;
+	int unregistered = 0;
+	int async = 1;
+	int rc = 0;
 
 	ENTRY;
-	if (atomic_read(&set->set_remaining) == 0)
-		RETURN(1);
-
-	list_for_each_entry_safe(req, next, &set->set_requests,
-				 rq_set_chain) {
-		struct obd_import *imp = req->rq_import;
-		int unregistered = 0;
-		int async = 1;
-		int rc = 0;
+	if (req->rq_phase == RQ_PHASE_COMPLETE) {
+		list_move_tail(&req->rq_set_chain, comp_reqs);
+		RETURN(0);
+	}
 
-		if (req->rq_phase == RQ_PHASE_COMPLETE) {
-			list_move_tail(&req->rq_set_chain, &comp_reqs);
-			continue;
-		}
+	/*
+	 * This schedule point is mainly for the ptlrpcd caller of this
+	 * function.  Most ptlrpc sets are not long-lived and unbounded
+	 * in length, but at the least the set used by the ptlrpcd is.
+	 * Since the processing time is unbounded, we need to insert an
+	 * explicit schedule point to make the thread well-behaved.
+	 */
+	cond_resched();
 
-		/*
-		 * This schedule point is mainly for the ptlrpcd caller of this
-		 * function.  Most ptlrpc sets are not long-lived and unbounded
-		 * in length, but at the least the set used by the ptlrpcd is.
-		 * Since the processing time is unbounded, we need to insert an
-		 * explicit schedule point to make the thread well-behaved.
-		 */
-		cond_resched();
+	/*
+	 * If the caller requires to allow to be interpreted by force
+	 * and it has really been interpreted, then move the request
+	 * to RQ_PHASE_INTERPRET phase in spite of what the current
+	 * phase is.
+	 */
+	if (unlikely(req->rq_allow_intr && req->rq_intr)) {
+		req->rq_status = -EINTR;
+		ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
 
 		/*
-		 * If the caller requires to allow to be interpreted by force
-		 * and it has really been interpreted, then move the request
-		 * to RQ_PHASE_INTERPRET phase in spite of what the current
-		 * phase is.
+		 * Since it is interpreted and we have to wait for
+		 * the reply to be unlinked, then use sync mode.
 		 */
-		if (unlikely(req->rq_allow_intr && req->rq_intr)) {
-			req->rq_status = -EINTR;
-			ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
+		async = 0;
 
-			/*
-			 * Since it is interpreted and we have to wait for
-			 * the reply to be unlinked, then use sync mode.
-			 */
-			async = 0;
-
-			GOTO(interpret, req->rq_status);
-		}
+		GOTO(interpret, req->rq_status);
+	}
 
-		if (req->rq_phase == RQ_PHASE_NEW && ptlrpc_send_new_req(req))
-			force_timer_recalc = 1;
+	if (req->rq_phase == RQ_PHASE_NEW && ptlrpc_send_new_req(req))
+		force_timer_recalc = 1;
 
-		/* delayed send - skip */
-		if (req->rq_phase == RQ_PHASE_NEW && req->rq_sent)
-			continue;
+	/* delayed send - skip */
+	if (req->rq_phase == RQ_PHASE_NEW && req->rq_sent)
+		goto out;
 
-		/* delayed resend - skip */
-		if (req->rq_phase == RQ_PHASE_RPC && req->rq_resend &&
-		    req->rq_sent > ktime_get_real_seconds())
-			continue;
+	/* delayed resend - skip */
+	if (req->rq_phase == RQ_PHASE_RPC && req->rq_resend &&
+	    req->rq_sent > ktime_get_real_seconds())
+		goto out;
 
-		if (!(req->rq_phase == RQ_PHASE_RPC ||
-		      req->rq_phase == RQ_PHASE_BULK ||
-		      req->rq_phase == RQ_PHASE_INTERPRET ||
-		      req->rq_phase == RQ_PHASE_UNREG_RPC ||
-		      req->rq_phase == RQ_PHASE_UNREG_BULK)) {
-			DEBUG_REQ(D_ERROR, req, "bad phase %x", req->rq_phase);
-			LBUG();
-		}
+	if (!(req->rq_phase == RQ_PHASE_RPC ||
+	      req->rq_phase == RQ_PHASE_BULK ||
+	      req->rq_phase == RQ_PHASE_INTERPRET ||
+	      req->rq_phase == RQ_PHASE_UNREG_RPC ||
+	      req->rq_phase == RQ_PHASE_UNREG_BULK)) {
+		DEBUG_REQ(D_ERROR, req, "bad phase %x", req->rq_phase);
+		LBUG();
+	}
 
-		if (req->rq_phase == RQ_PHASE_UNREG_RPC ||
-		    req->rq_phase == RQ_PHASE_UNREG_BULK) {
-			LASSERT(req->rq_next_phase != req->rq_phase);
-			LASSERT(req->rq_next_phase != RQ_PHASE_UNDEFINED);
-
-			if (req->rq_req_deadline &&
-			    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REQ_UNLINK))
-				req->rq_req_deadline = 0;
-			if (req->rq_reply_deadline &&
-			    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK))
-				req->rq_reply_deadline = 0;
-			if (req->rq_bulk_deadline &&
-			    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK))
-				req->rq_bulk_deadline = 0;
+	if (req->rq_phase == RQ_PHASE_UNREG_RPC ||
+	    req->rq_phase == RQ_PHASE_UNREG_BULK) {
+		LASSERT(req->rq_next_phase != req->rq_phase);
+		LASSERT(req->rq_next_phase != RQ_PHASE_UNDEFINED);
 
-			/*
-			 * Skip processing until reply is unlinked. We
-			 * can't return to pool before that and we can't
-			 * call interpret before that. We need to make
-			 * sure that all rdma transfers finished and will
-			 * not corrupt any data.
-			 */
-			if (req->rq_phase == RQ_PHASE_UNREG_RPC &&
-			    ptlrpc_cli_wait_unlink(req))
-				continue;
-			if (req->rq_phase == RQ_PHASE_UNREG_BULK &&
-			    ptlrpc_client_bulk_active(req))
-				continue;
+		if (req->rq_req_deadline &&
+		    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REQ_UNLINK))
+			req->rq_req_deadline = 0;
+		if (req->rq_reply_deadline &&
+		    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK))
+			req->rq_reply_deadline = 0;
+		if (req->rq_bulk_deadline &&
+		    !OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK))
+			req->rq_bulk_deadline = 0;
 
-			/*
-			 * Turn fail_loc off to prevent it from looping
-			 * forever.
-			 */
-			if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK)) {
-				OBD_FAIL_CHECK_ORSET(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK,
-						     OBD_FAIL_ONCE);
-			}
-			if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK)) {
-				OBD_FAIL_CHECK_ORSET(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK,
-						     OBD_FAIL_ONCE);
-			}
+		/*
+		 * Skip processing until reply is unlinked. We
+		 * can't return to pool before that and we can't
+		 * call interpret before that. We need to make
+		 * sure that all rdma transfers finished and will
+		 * not corrupt any data.
+		 */
+		if (req->rq_phase == RQ_PHASE_UNREG_RPC &&
+		    ptlrpc_cli_wait_unlink(req))
+			goto out;
+		if (req->rq_phase == RQ_PHASE_UNREG_BULK &&
+		    ptlrpc_client_bulk_active(req))
+			goto out;
 
-			/*
-			 * Move to next phase if reply was successfully
-			 * unlinked.
-			 */
-			ptlrpc_rqphase_move(req, req->rq_next_phase);
+		/*
+		 * Turn fail_loc off to prevent it from looping
+		 * forever.
+		 */
+		if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK)) {
+			OBD_FAIL_CHECK_ORSET(OBD_FAIL_PTLRPC_LONG_REPL_UNLINK,
+					     OBD_FAIL_ONCE);
+		}
+		if (OBD_FAIL_CHECK(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK)) {
+			OBD_FAIL_CHECK_ORSET(OBD_FAIL_PTLRPC_LONG_BULK_UNLINK,
+					     OBD_FAIL_ONCE);
 		}
-
-		if (req->rq_phase == RQ_PHASE_INTERPRET)
-			GOTO(interpret, req->rq_status);
 
 		/*
-		 * Note that this also will start async reply unlink.
+		 * Move to next phase if reply was successfully
+		 * unlinked.
 		 */
-		if (req->rq_net_err && !req->rq_timedout) {
-			ptlrpc_expire_one_request(req, 1);
+		ptlrpc_rqphase_move(req, req->rq_next_phase);
+	}
 
-			/*
-			 * Check if we still need to wait for unlink.
-			 */
-			if (ptlrpc_cli_wait_unlink(req) ||
-			    ptlrpc_client_bulk_active(req))
-				continue;
-			/* If there is no need to resend, fail it now. */
-			if (req->rq_no_resend) {
-				if (req->rq_status == 0)
-					req->rq_status = -EIO;
-				ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
-				GOTO(interpret, req->rq_status);
-			} else {
-				continue;
-			}
-		}
+	if (req->rq_phase == RQ_PHASE_INTERPRET)
+		GOTO(interpret, req->rq_status);
 
-		if (req->rq_err) {
-			if (!ptlrpc_unregister_reply(req, 1)) {
-				ptlrpc_unregister_bulk(req, 1);
-				continue;
-			}
+	/*
+	 * Note that this also will start async reply unlink.
+	 */
+	if (req->rq_net_err && !req->rq_timedout) {
+		ptlrpc_expire_one_request(req, 1);
 
-			spin_lock(&req->rq_lock);
-			req->rq_replied = 0;
-			spin_unlock(&req->rq_lock);
+		/*
+		 * Check if we still need to wait for unlink.
+		 */
+		if (ptlrpc_cli_wait_unlink(req) ||
+		    ptlrpc_client_bulk_active(req))
+			goto out;
+		/* If there is no need to resend, fail it now. */
+		if (req->rq_no_resend) {
 			if (req->rq_status == 0)
 				req->rq_status = -EIO;
 			ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
 			GOTO(interpret, req->rq_status);
+		} else {
+			/* check again for resend on next pass */
+			ptlrpc_set_req_ready(set, req);
+			goto out;
 		}
+	}
 
-		/*
-		 * ptlrpc_set_wait uses l_wait_event_abortable_timeout()
-		 * so it sets rq_intr regardless of individual rpc
-		 * timeouts. The synchronous IO waiting path sets
-		 * rq_intr irrespective of whether ptlrpcd
-		 * has seen a timeout.  Our policy is to only interpret
-		 * interrupted rpcs after they have timed out, so we
-		 * need to enforce that here.
-		 */
-
-		if (req->rq_intr && (req->rq_timedout || req->rq_waiting ||
-				     req->rq_wait_ctx)) {
-			req->rq_status = -EINTR;
-			ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
-			GOTO(interpret, req->rq_status);
+	if (req->rq_err) {
+		if (!ptlrpc_unregister_reply(req, 1)) {
+			ptlrpc_unregister_bulk(req, 1);
+			goto out;
 		}
 
-		if (req->rq_phase == RQ_PHASE_RPC) {
-			if (req->rq_timedout || req->rq_resend ||
-			    req->rq_waiting || req->rq_wait_ctx) {
-				int status;
+		spin_lock(&req->rq_lock);
+		req->rq_replied = 0;
+		spin_unlock(&req->rq_lock);
+		if (req->rq_status == 0)
+			req->rq_status = -EIO;
+		ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
+		GOTO(interpret, req->rq_status);
+	}
+
+	/*
+	 * ptlrpc_set_wait uses l_wait_event_abortable_timeout()
+	 * so it sets rq_intr regardless of individual rpc
+	 * timeouts. The synchronous IO waiting path sets
+	 * rq_intr irrespective of whether ptlrpcd
+	 * has seen a timeout.  Our policy is to only interpret
+	 * interrupted rpcs after they have timed out, so we
+	 * need to enforce that here.
+	 */
 
-				if (!ptlrpc_unregister_reply(req, 1)) {
-					ptlrpc_unregister_bulk(req, 1);
-					continue;
-				}
+	if (req->rq_intr && (req->rq_timedout || req->rq_waiting ||
+			     req->rq_wait_ctx)) {
+		req->rq_status = -EINTR;
+		ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
+		GOTO(interpret, req->rq_status);
+	}
 
-				spin_lock(&imp->imp_lock);
-				if (ptlrpc_import_delay_req(imp, req,
-							    &status)) {
-					/*
-					 * put on delay list - only if we wait
-					 * recovery finished - before send
-					 */
-					list_move_tail(&req->rq_list,
-						       &imp->imp_delayed_list);
-					spin_unlock(&imp->imp_lock);
-					continue;
-				}
+	if (req->rq_phase == RQ_PHASE_RPC) {
+		if (req->rq_timedout || req->rq_resend ||
+		    req->rq_waiting || req->rq_wait_ctx) {
+			int status;
 
-				if (status != 0)  {
-					req->rq_status = status;
-					ptlrpc_rqphase_move(req,
-							    RQ_PHASE_INTERPRET);
-					spin_unlock(&imp->imp_lock);
-					GOTO(interpret, req->rq_status);
-				}
-				/* ignore on just initiated connections */
-				if (ptlrpc_no_resend(req) &&
-				    !req->rq_wait_ctx &&
-				    imp->imp_generation !=
-				    imp->imp_initiated_at) {
-					req->rq_status = -ENOTCONN;
-					ptlrpc_rqphase_move(req,
-							    RQ_PHASE_INTERPRET);
-					spin_unlock(&imp->imp_lock);
-					GOTO(interpret, req->rq_status);
-				}
+			if (!ptlrpc_unregister_reply(req, 1)) {
+				ptlrpc_unregister_bulk(req, 1);
+				goto out;
+			}
 
-				/* don't resend too fast in case of network
-				 * errors.
+			spin_lock(&imp->imp_lock);
+			if (ptlrpc_import_delay_req(imp, req,
+						    &status)) {
+				/*
+				 * put on delay list - only if we wait
+				 * recovery finished - before send
 				 */
-				if (ktime_get_real_seconds() < (req->rq_sent + 1)
-				    && req->rq_net_err && req->rq_timedout) {
-
-					DEBUG_REQ(D_INFO, req,
-						  "throttle request");
-					/* Don't try to resend RPC right away
-					 * as it is likely it will fail again
-					 * and ptlrpc_check_set() will be
-					 * called again, keeping this thread
-					 * busy. Instead, wait for the next
-					 * timeout. Flag it as resend to
-					 * ensure we don't wait to long.
-					 */
-					req->rq_resend = 1;
-					spin_unlock(&imp->imp_lock);
-					continue;
-				}
-
 				list_move_tail(&req->rq_list,
-					       &imp->imp_sending_list);
+					       &imp->imp_delayed_list);
+				spin_unlock(&imp->imp_lock);
+				goto out;
+			}
 
+			if (status != 0)  {
+				req->rq_status = status;
+				ptlrpc_rqphase_move(req,
+						    RQ_PHASE_INTERPRET);
+				spin_unlock(&imp->imp_lock);
+				GOTO(interpret, req->rq_status);
+			}
+			/* ignore on just initiated connections */
+			if (ptlrpc_no_resend(req) &&
+			    !req->rq_wait_ctx &&
+			    imp->imp_generation !=
+			    imp->imp_initiated_at) {
+				req->rq_status = -ENOTCONN;
+				ptlrpc_rqphase_move(req,
+						    RQ_PHASE_INTERPRET);
 				spin_unlock(&imp->imp_lock);
+				GOTO(interpret, req->rq_status);
+			}
 
-				spin_lock(&req->rq_lock);
-				req->rq_waiting = 0;
-				spin_unlock(&req->rq_lock);
+			/* don't resend too fast in case of network
+			 * errors.
+			 */
+			if (ktime_get_real_seconds() < (req->rq_sent + 1)
+			    && req->rq_net_err && req->rq_timedout) {
+
+				DEBUG_REQ(D_INFO, req,
+					  "throttle request");
+				/* Don't try to resend RPC right away
+				 * as it is likely it will fail again
+				 * and ptlrpc_check_set() will be
+				 * called again, keeping this thread
+				 * busy. Instead, wait for the next
+				 * timeout. Flag it as resend to
+				 * ensure we don't wait to long.
+				 */
+				req->rq_resend = 1;
+				spin_unlock(&imp->imp_lock);
+				goto out;
+			}
 
-				if (req->rq_timedout || req->rq_resend) {
-					/*
-					 * This is re-sending anyways,
-					 * let's mark req as resend.
-					 */
-					spin_lock(&req->rq_lock);
-					req->rq_resend = 1;
-					spin_unlock(&req->rq_lock);
-				}
+			list_move_tail(&req->rq_list,
+				       &imp->imp_sending_list);
+
+			spin_unlock(&imp->imp_lock);
+
+			spin_lock(&req->rq_lock);
+			req->rq_waiting = 0;
+			spin_unlock(&req->rq_lock);
+
+			if (req->rq_timedout || req->rq_resend) {
 				/*
-				 * rq_wait_ctx is only touched by ptlrpcd,
-				 * so no lock is needed here.
+				 * This is re-sending anyways,
+				 * let's mark req as resend.
 				 */
-				status = sptlrpc_req_refresh_ctx(req, 0);
-				if (status) {
-					if (req->rq_err) {
-						req->rq_status = status;
-						spin_lock(&req->rq_lock);
-						req->rq_wait_ctx = 0;
-						spin_unlock(&req->rq_lock);
-						force_timer_recalc = 1;
-					} else {
-						spin_lock(&req->rq_lock);
-						req->rq_wait_ctx = 1;
-						spin_unlock(&req->rq_lock);
-					}
-
-					continue;
-				} else {
+				spin_lock(&req->rq_lock);
+				req->rq_resend = 1;
+				spin_unlock(&req->rq_lock);
+			}
+			/*
+			 * rq_wait_ctx is only touched by ptlrpcd,
+			 * so no lock is needed here.
+			 */
+			status = sptlrpc_req_refresh_ctx(req, 0);
+			if (status) {
+				if (req->rq_err) {
+					req->rq_status = status;
 					spin_lock(&req->rq_lock);
 					req->rq_wait_ctx = 0;
 					spin_unlock(&req->rq_lock);
-				}
-
-				/*
-				 * In any case, the previous bulk should be
-				 * cleaned up to prepare for the new sending
-				 */
-				if (req->rq_bulk &&
-				    !ptlrpc_unregister_bulk(req, 1))
-					continue;
-
-				rc = ptl_send_rpc(req, 0);
-				if (rc == -ENOMEM) {
-					spin_lock(&imp->imp_lock);
-					if (!list_empty(&req->rq_list))
-						list_del_init(&req->rq_list);
-					spin_unlock(&imp->imp_lock);
-					ptlrpc_rqphase_move(req, RQ_PHASE_NEW);
-					continue;
-				}
-				if (rc) {
-					DEBUG_REQ(D_HA, req,
-						  "send failed: rc = %d", rc);
 					force_timer_recalc = 1;
+				} else {
 					spin_lock(&req->rq_lock);
-					req->rq_net_err = 1;
+					req->rq_wait_ctx = 1;
 					spin_unlock(&req->rq_lock);
-					continue;
 				}
-				/* need to reset the timeout */
-				force_timer_recalc = 1;
-			}
-
-			spin_lock(&req->rq_lock);
-
-			if (ptlrpc_client_early(req)) {
-				ptlrpc_at_recv_early_reply(req);
-				spin_unlock(&req->rq_lock);
-				continue;
-			}
 
-			/* Still waiting for a reply? */
-			if (ptlrpc_client_recv(req)) {
-				spin_unlock(&req->rq_lock);
-				continue;
-			}
-
-			/* Did we actually receive a reply? */
-			if (!ptlrpc_client_replied(req)) {
+				goto out;
+			} else {
+				spin_lock(&req->rq_lock);
+				req->rq_wait_ctx = 0;
 				spin_unlock(&req->rq_lock);
-				continue;
 			}
 
-			spin_unlock(&req->rq_lock);
-
 			/*
-			 * unlink from net because we are going to
-			 * swab in-place of reply buffer
+			 * In any case, the previous bulk should be
+			 * cleaned up to prepare for the new sending
 			 */
-			unregistered = ptlrpc_unregister_reply(req, 1);
-			if (!unregistered)
-				continue;
+			if (req->rq_bulk &&
+			    !ptlrpc_unregister_bulk(req, 1))
+				goto out;
 
-			req->rq_status = after_reply(req);
-			if (req->rq_resend) {
+			rc = ptl_send_rpc(req, 0);
+			if (rc == -ENOMEM) {
+				spin_lock(&imp->imp_lock);
+				if (!list_empty(&req->rq_list))
+					list_del_init(&req->rq_list);
+				spin_unlock(&imp->imp_lock);
+				ptlrpc_rqphase_move(req, RQ_PHASE_NEW);
+				goto out;
+			}
+			if (rc) {
+				DEBUG_REQ(D_HA, req,
+					  "send failed: rc = %d", rc);
 				force_timer_recalc = 1;
-				continue;
+				spin_lock(&req->rq_lock);
+				req->rq_net_err = 1;
+				spin_unlock(&req->rq_lock);
+				goto out;
 			}
+			/* need to reset the timeout */
+			force_timer_recalc = 1;
+		}
 
-			/*
-			 * If there is no bulk associated with this request,
-			 * then we're done and should let the interpreter
-			 * process the reply. Similarly if the RPC returned
-			 * an error, and therefore the bulk will never arrive.
-			 */
-			if (!req->rq_bulk || req->rq_status < 0) {
-				ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
-				GOTO(interpret, req->rq_status);
-			}
+		spin_lock(&req->rq_lock);
 
-			ptlrpc_rqphase_move(req, RQ_PHASE_BULK);
+		if (ptlrpc_client_early(req)) {
+			ptlrpc_at_recv_early_reply(req);
+			spin_unlock(&req->rq_lock);
+			goto out;
 		}
 
-		LASSERT(req->rq_phase == RQ_PHASE_BULK);
-		if (ptlrpc_client_bulk_active(req))
-			continue;
+		/* Still waiting for a reply? */
+		if (ptlrpc_client_recv(req)) {
+			spin_unlock(&req->rq_lock);
+			goto out;
+		}
 
-		if (req->rq_bulk->bd_failure) {
-			/*
-			 * The RPC reply arrived OK, but the bulk screwed
-			 * up!  Dead weird since the server told us the RPC
-			 * was good after getting the REPLY for her GET or
-			 * the ACK for her PUT.
-			 */
-			DEBUG_REQ(D_ERROR, req, "bulk transfer failed %d/%d/%d",
-				  req->rq_status,
-				  req->rq_bulk->bd_nob,
-				  req->rq_bulk->bd_nob_transferred);
-			req->rq_status = -EIO;
+		/* Did we actually receive a reply? */
+		if (!ptlrpc_client_replied(req)) {
+			spin_unlock(&req->rq_lock);
+			goto out;
 		}
 
-		ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
+		spin_unlock(&req->rq_lock);
 
-interpret:
-		LASSERT(req->rq_phase == RQ_PHASE_INTERPRET);
+		/*
+		 * unlink from net because we are going to
+		 * swab in-place of reply buffer
+		 */
+		unregistered = ptlrpc_unregister_reply(req, 1);
+		if (!unregistered)
+			goto out;
+
+		req->rq_status = after_reply(req);
+		if (req->rq_resend) {
+			force_timer_recalc = 1;
+			goto out;
+		}
 
 		/*
-		 * This moves to "unregistering" phase we need to wait for
-		 * reply unlink.
+		 * If there is no bulk associated with this request,
+		 * then we're done and should let the interpreter
+		 * process the reply. Similarly if the RPC returned
+		 * an error, and therefore the bulk will never arrive.
 		 */
-		if (!unregistered && !ptlrpc_unregister_reply(req, async)) {
-			/* start async bulk unlink too */
-			ptlrpc_unregister_bulk(req, 1);
-			continue;
+		if (!req->rq_bulk || req->rq_status < 0) {
+			ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
+			GOTO(interpret, req->rq_status);
 		}
 
-		if (!ptlrpc_unregister_bulk(req, async))
-			continue;
+		ptlrpc_rqphase_move(req, RQ_PHASE_BULK);
+	}
 
+	LASSERT(req->rq_phase == RQ_PHASE_BULK);
+	if (ptlrpc_client_bulk_active(req))
+		goto out;
+
+	if (req->rq_bulk->bd_failure) {
 		/*
-		 * When calling interpret receiving already should be
-		 * finished.
+		 * The RPC reply arrived OK, but the bulk screwed
+		 * up!  Dead weird since the server told us the RPC
+		 * was good after getting the REPLY for her GET or
+		 * the ACK for her PUT.
 		 */
-		LASSERT(!req->rq_receiving_reply);
+		DEBUG_REQ(D_ERROR, req, "bulk transfer failed %d/%d/%d",
+			  req->rq_status,
+			  req->rq_bulk->bd_nob,
+			  req->rq_bulk->bd_nob_transferred);
+		req->rq_status = -EIO;
+	}
 
-		ptlrpc_req_interpret(env, req, req->rq_status);
+	ptlrpc_rqphase_move(req, RQ_PHASE_INTERPRET);
 
-		if (ptlrpcd_check_work(req)) {
-			atomic_dec(&set->set_remaining);
-			continue;
-		}
-		ptlrpc_rqphase_move(req, RQ_PHASE_COMPLETE);
+interpret:
+	LASSERT(req->rq_phase == RQ_PHASE_INTERPRET);
 
-		if (req->rq_reqmsg)
-			CDEBUG(D_RPCTRACE,
-			       "Completed RPC req@%p pname:cluuid:pid:xid:nid:opc:job %s:%s:%d:%llu:%s:%d:%s\n",
-			       req, current->comm,
-			       imp->imp_obd->obd_uuid.uuid,
-			       lustre_msg_get_status(req->rq_reqmsg),
-			       req->rq_xid,
-			       obd_import_nid2str(imp),
-			       lustre_msg_get_opc(req->rq_reqmsg),
-			       lustre_msg_get_jobid(req->rq_reqmsg) ?: "");
+	/*
+	 * This moves to "unregistering" phase we need to wait for
+	 * reply unlink.
+	 */
+	if (!unregistered && !ptlrpc_unregister_reply(req, async)) {
+		/* start async bulk unlink too */
+		ptlrpc_unregister_bulk(req, 1);
+		goto out;
+	}
+
+	if (!ptlrpc_unregister_bulk(req, async))
+		goto out;
+
+	/*
+	 * When calling interpret receiving already should be
+	 * finished.
+	 */
+	LASSERT(!req->rq_receiving_reply);
+
+	/* the interpreter of a work request can requeue it to another set */
+	ptlrpc_set_timer_del(set, req);
+	ptlrpc_req_interpret(env, req, req->rq_status);
+
+	if (ptlrpcd_check_work(req)) {
+		atomic_dec(&set->set_remaining);
+		RETURN(force_timer_recalc);
+	}
+	ptlrpc_rqphase_move(req, RQ_PHASE_COMPLETE);
+
+	if (req->rq_reqmsg)
+		CDEBUG(D_RPCTRACE,
+		       "Completed RPC req@%p pname:cluuid:pid:xid:nid:opc:job %s:%s:%d:%llu:%s:%d:%s\n",
+		       req, current->comm,
+		       imp->imp_obd->obd_uuid.uuid,
+		       lustre_msg_get_status(req->rq_reqmsg),
+		       req->rq_xid,
+		       obd_import_nid2str(imp),
+		       lustre_msg_get_opc(req->rq_reqmsg),
+		       lustre_msg_get_jobid(req->rq_reqmsg) ?: "");
+
+	spin_lock(&imp->imp_lock);
+	/*
+	 * Request already may be not on sending or delaying list. This
+	 * may happen in the case of marking it erroneous for the case
+	 * ptlrpc_import_delay_req(req, status) find it impossible to
+	 * allow sending this rpc and returns *status != 0.
+	 */
+	if (!list_empty(&req->rq_list)) {
+		list_del_init(&req->rq_list);
+		if (atomic_dec_and_test(&imp->imp_inflight))
+			wake_up(&imp->imp_recovery_waitq);
+	}
+	list_del_init(&req->rq_unreplied_list);
+	spin_unlock(&imp->imp_lock);
+
+	atomic_dec(&set->set_remaining);
+	wake_up(&imp->imp_recovery_waitq);
+
+	if (set->set_producer) {
+		/* produce a new request if possible */
+		if (ptlrpc_set_producer(set) > 0)
+			force_timer_recalc = 1;
 
-		spin_lock(&imp->imp_lock);
 		/*
-		 * Request already may be not on sending or delaying list. This
-		 * may happen in the case of marking it erroneous for the case
-		 * ptlrpc_import_delay_req(req, status) find it impossible to
-		 * allow sending this rpc and returns *status != 0.
+		 * free the request that has just been completed
+		 * in order not to pollute set->set_requests
 		 */
-		if (!list_empty(&req->rq_list)) {
-			list_del_init(&req->rq_list);
-			if (atomic_dec_and_test(&imp->imp_inflight))
-				wake_up(&imp->imp_recovery_waitq);
+		list_del_init(&req->rq_set_chain);
+		spin_lock(&req->rq_lock);
+		req->rq_set = NULL;
+		req->rq_invalid_rqset = 0;
+		spin_unlock(&req->rq_lock);
+
+		/* record rq_status to compute the final status later */
+		if (req->rq_status != 0)
+			set->set_rc = req->rq_status;
+		ptlrpc_set_req_unlink(set, req);
+		ptlrpc_req_finished(req);
+	} else {
+		list_move_tail(&req->rq_set_chain, comp_reqs);
+	}
+
+	RETURN(force_timer_recalc);
+
+out:
+	/*
+	 * Anything that forces a timer recalculation needs the request to be
+	 * looked at again on the next pass, as the old full set walk did.
+	 */
+	if (force_timer_recalc)
+		ptlrpc_set_req_ready(set, req);
+	ptlrpc_set_timer_update(set, req);
+
+	RETURN(force_timer_recalc);
+}
+
+/**
+ * Whether the next ptlrpc_check_set() pass has to look at every request of
+ * \a set rather than only those on the ready list. Small sets are always
+ * walked, and large ones once a second in case a request is waiting for
+ * something that does not come with an event.
+ */
+static bool ptlrpc_set_needs_scan(struct ptlrpc_request_set *set)
+{
+	time64_t now = ktime_get_seconds();
+
+	if (set->set_scan_only)
+		return true;
+
+	if (set->set_timer_heap == NULL) {
+		if (atomic_read(&set->set_remaining) < PTLRPC_SET_EVENT_MIN)
+			return true;
+
+		set->set_timer_heap = binheap_create(&ptlrpc_set_timer_ops,
+						     CBH_FLAG_ATOMIC_GROW,
+						     PTLRPC_SET_EVENT_MIN,
+						     set, NULL, CFS_CPT_ANY);
+		if (set->set_timer_heap == NULL) {
+			set->set_scan_only = 1;
+			return true;
 		}
-		list_del_init(&req->rq_unreplied_list);
-		spin_unlock(&imp->imp_lock);
+		/* the walk below queues all requests in the timer heap */
+		set->set_scan_all = 1;
+	}
 
-		atomic_dec(&set->set_remaining);
-		wake_up(&imp->imp_recovery_waitq);
+	if (set->set_scan_all || now > set->set_scan_time)
+		return true;
 
-		if (set->set_producer) {
-			/* produce a new request if possible */
-			if (ptlrpc_set_producer(set) > 0)
-				force_timer_recalc = 1;
+	return false;
+}
 
-			/*
-			 * free the request that has just been completed
-			 * in order not to pollute set->set_requests
-			 */
-			list_del_init(&req->rq_set_chain);
-			spin_lock(&req->rq_lock);
-			req->rq_set = NULL;
-			req->rq_invalid_rqset = 0;
-			spin_unlock(&req->rq_lock);
+/**
+ * this sends any unsent RPCs in \a set and returns 1 if all are sent
+ * and no more replies are expected.
+ * (it is possible to get less replies than requests sent e.g. due to timed out
+ * requests or requests that we had trouble to send out)
+ *
+ * Only requests which got an event since the last call are checked for large
+ * sets, see ptlrpc_set_req_ready().
+ *
+ * NOTE: This function contains a potential schedule point (cond_resched()).
+ */
+int ptlrpc_check_set(const struct lu_env *env, struct ptlrpc_request_set *set)
+{
+	struct ptlrpc_request *req, *next;
+	LIST_HEAD(comp_reqs);
+	LIST_HEAD(ready);
+	int force_timer_recalc = 0;
 
-			/* record rq_status to compute the final status later */
-			if (req->rq_status != 0)
-				set->set_rc = req->rq_status;
-			ptlrpc_req_finished(req);
-		} else {
-			list_move_tail(&req->rq_set_chain, &comp_reqs);
+	ENTRY;
+	if (atomic_read(&set->set_remaining) == 0)
+		RETURN(1);
+
+	spin_lock(&set->set_ready_lock);
+	list_splice_init(&set->set_ready, &ready);
+	spin_unlock(&set->set_ready_lock);
+
+	if (ptlrpc_set_needs_scan(set)) {
+		set->set_scan_all = 0;
+		set->set_scan_time = ktime_get_seconds();
+
+		spin_lock(&set->set_ready_lock);
+		list_for_each_entry_safe(req, next, &ready, rq_ready_chain)
+			list_del_init(&req->rq_ready_chain);
+		spin_unlock(&set->set_ready_lock);
+
+		list_for_each_entry_safe(req, next, &set->set_requests,
+					 rq_set_chain)
+			force_timer_recalc |= ptlrpc_check_req(env, set, req,
+							       &comp_reqs);
+	} else {
+		spin_lock(&set->set_ready_lock);
+		while ((req = list_first_entry_or_null(&ready,
+						struct ptlrpc_request,
+						rq_ready_chain)) != NULL) {
+			list_del_init(&req->rq_ready_chain);
+			spin_unlock(&set->set_ready_lock);
+
+			force_timer_recalc |= ptlrpc_check_req(env, set, req,
+							       &comp_reqs);
+
+			spin_lock(&set->set_ready_lock);
 		}
+		spin_unlock(&set->set_ready_lock);
 	}
 
 	/*
@@ -2345,6 +2597,54 @@ int ptlrpc_expire_one_request(struct ptlrpc_request *req, int async_unlink)
 	RETURN(rc);
 }
 
+static void ptlrpc_expire_set_req(struct ptlrpc_request *req, time64_t now)
+{
+	/* don't expire request waiting for context */
+	if (req->rq_wait_ctx)
+		return;
+
+	/* Request in-flight? */
+	if (!((req->rq_phase == RQ_PHASE_RPC &&
+	       !req->rq_waiting && !req->rq_resend) ||
+	      (req->rq_phase == RQ_PHASE_BULK)))
+		return;
+
+	if (req->rq_timedout ||     /* already dealt with */
+	    req->rq_deadline > now) /* not expired */
+		return;
+
+	/*
+	 * Deal with this guy. Do it asynchronously to not block
+	 * ptlrpcd thread.
+	 */
+	ptlrpc_expire_one_request(req, 1);
+}
+
+/**
+ * Time out the requests of \a set whose deadline in the timer heap passed.
+ * They are taken out of the heap and queued for the next check, which puts
+ * them back according to their new state. That also covers delayed sends
+ * and resends, which are only found through their deadline.
+ */
+static void ptlrpc_expired_set_heap(struct ptlrpc_request_set *set,
+				    time64_t now)
+{
+	struct binheap_node *node;
+	struct ptlrpc_request *req;
+
+	while (set->set_timer_heap != NULL &&
+	       (node = binheap_root(set->set_timer_heap)) != NULL) {
+		req = container_of(node, struct ptlrpc_request, rq_timer_node);
+		if (req->rq_set_deadline > now)
+			break;
+
+		ptlrpc_set_timer_del(set, req);
+		ptlrpc_expire_set_req(req, now);
+		ptlrpc_set_req_ready(set, req);
+		cond_resched();
+	}
+}
+
 /**
  * Time out all uncompleted requests in request set pointed by \a data
  * This is called when a wait times out.
@@ -2357,29 +2657,16 @@ void ptlrpc_expired_set(struct ptlrpc_request_set *set)
 	ENTRY;
 	LASSERT(set != NULL);
 
+	if (set->set_timer_heap != NULL && !set->set_scan_all) {
+		ptlrpc_expired_set_heap(set, now);
+		RETURN_EXIT;
+	}
+
 	/*
 	 * A timeout expired. See which reqs it applies to...
 	 */
 	list_for_each_entry(req, &set->set_requests, rq_set_chain) {
-		/* don't expire request waiting for context */
-		if (req->rq_wait_ctx)
-			continue;
-
-		/* Request in-flight? */
-		if (!((req->rq_phase == RQ_PHASE_RPC &&
-		       !req->rq_waiting && !req->rq_resend) ||
-		      (req->rq_phase == RQ_PHASE_BULK)))
-			continue;
-
-		if (req->rq_timedout ||     /* already dealt with */
-		    req->rq_deadline > now) /* not expired */
-			continue;
-
-		/*
-		 * Deal with this guy. Do it asynchronously to not block
-		 * ptlrpcd thread.
-		 */
-		ptlrpc_expire_one_request(req, 1);
+		ptlrpc_expire_set_req(req, now);
 		/*
 		 * Loops require that we resched once in a while to avoid
 		 * RCU stalls and a few other problems.
@@ -2414,6 +2701,7 @@ static void ptlrpc_interrupted_set(struct ptlrpc_request_set *set)
 		req->rq_intr = 1;
 		spin_unlock(&req->rq_lock);
 	}
+	set->set_scan_all = 1;
 }
 
 /**
@@ -2424,38 +2712,63 @@ time64_t ptlrpc_set_next_timeout(struct ptlrpc_request_set *set)
 	time64_t now = ktime_get_real_seconds();
 	int timeout = 0;
 	struct ptlrpc_request *req;
+	struct binheap_node *node;
+	LIST_HEAD(ready);
 	time64_t deadline;
 
 	ENTRY;
-	list_for_each_entry(req, &set->set_requests, rq_set_chain) {
-		/* Request in-flight? */
-		if (!(((req->rq_phase == RQ_PHASE_RPC) && !req->rq_waiting) ||
-		      (req->rq_phase == RQ_PHASE_BULK) ||
-		      (req->rq_phase == RQ_PHASE_NEW)))
-			continue;
+	if (set->set_timer_heap == NULL || set->set_scan_all) {
+		list_for_each_entry(req, &set->set_requests, rq_set_chain) {
+			deadline = ptlrpc_req_next_deadline(req);
+			if (deadline == 0)
+				continue;
 
-		/* Already timed out. */
-		if (req->rq_timedout)
-			continue;
+			if (deadline <= now)    /* actually expired already */
+				timeout = 1;    /* ASAP */
+			else if (timeout == 0 || timeout > deadline - now)
+				timeout = deadline - now;
+		}
+		RETURN(timeout);
+	}
+
+	/*
+	 * Requests with pending events may have been (re)sent meanwhile.
+	 * The heap is only touched by this thread, so it is updated outside
+	 * set_ready_lock. Requests on the local list are not requeued by
+	 * ptlrpc_set_req_ready() as their rq_ready_chain is not empty.
+	 */
+	spin_lock(&set->set_ready_lock);
+	list_splice_init(&set->set_ready, &ready);
+	spin_unlock(&set->set_ready_lock);
 
-		/* Waiting for ctx. */
-		if (req->rq_wait_ctx)
+	list_for_each_entry(req, &ready, rq_ready_chain)
+		ptlrpc_set_timer_update(set, req);
+
+	spin_lock(&set->set_ready_lock);
+	list_splice(&ready, &set->set_ready);
+	spin_unlock(&set->set_ready_lock);
+
+	/*
+	 * Deadlines are only refreshed when a request is checked, so the root
+	 * may have moved on since, e.g. after an early reply.
+	 */
+	while (set->set_timer_heap != NULL &&
+	       (node = binheap_root(set->set_timer_heap)) != NULL) {
+		req = container_of(node, struct ptlrpc_request, rq_timer_node);
+		deadline = req->rq_set_deadline;
+		ptlrpc_set_timer_update(set, req);
+		if (req->rq_set_deadline != deadline)
 			continue;
 
-		if (req->rq_phase == RQ_PHASE_NEW)
-			deadline = req->rq_sent;
-		else if (req->rq_phase == RQ_PHASE_RPC && req->rq_resend)
-			deadline = req->rq_sent;
+		if (deadline <= now)
+			timeout = 1;
 		else
-			deadline = req->rq_sent + req->rq_timeout;
-
-		if (deadline <= now)    /* actually expired already */
-			timeout = 1;    /* ASAP */
-		else if (timeout == 0 || timeout > deadline - now)
 			timeout = deadline - now;
+		break;
 	}
 	RETURN(timeout);
 }
+EXPORT_SYMBOL(ptlrpc_set_next_timeout);
 
 /**
  * Send all unset request from the set and then wait untill all
@@ -2609,6 +2922,7 @@ static void __ptlrpc_free_req(struct ptlrpc_request *request, int locked)
 	LASSERTF(!request->rq_receiving_reply, "req %p\n", request);
 	LASSERTF(list_empty(&request->rq_list), "req %p\n", request);
 	LASSERTF(list_empty(&request->rq_set_chain), "req %p\n", request);
+	LASSERTF(list_empty(&request->rq_ready_chain), "req %p\n", request);
 	LASSERTF(!request->rq_replay, "req %p\n", request);
 
 	req_capsule_fini(&request->rq_pill);
@@ -3552,14 +3866,17 @@ static int work_interpreter(const struct lu_env *env,
 			    struct ptlrpc_request *req, void *args, int rc)
 {
 	struct ptlrpc_work_async_args *arg = args;
+	struct ptlrpc_request_set *set;
 
 	LASSERT(ptlrpcd_check_work(req));
 	LASSERT(arg->cb != NULL);
 
 	rc = arg->cb(env, arg->cbdata);
 
+	set = req->rq_set;
 	list_del_init(&req->rq_set_chain);
 	req->rq_set = NULL;
+	ptlrpc_set_req_unlink(set, req);
 
 	if (atomic_dec_return(&req->rq_refcount) > 1) {
 		atomic_set(&req->rq_refcount, 2);
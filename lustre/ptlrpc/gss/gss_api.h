@@ -53,6 +53,7 @@ __u32 lgss_inquire_context(
 		time64_t *endtime);
 __u32 lgss_get_mic(
                 struct gss_ctx          *ctx,
+		__u32                    svc,
                 int                      msgcnt,
                 rawobj_t                *msgs,
                 int                      iovcnt,
@@ -60,6 +61,7 @@ __u32 lgss_get_mic(
                 rawobj_t                *mic_token);
 __u32 lgss_verify_mic(
                 struct gss_ctx          *ctx,
+		__u32                    svc,
                 int                      msgcnt,
                 rawobj_t                *msgs,
                 int                      iovcnt,
@@ -103,6 +105,24 @@ struct subflavor_desc {
         char           *sf_name;
 };
 
+/* crypto operations accounted per flavor, see gss/crypto_stats */
+enum gss_mech_stat_op {
+	GSS_MECH_STAT_GET_MIC = 0,
+	GSS_MECH_STAT_VERIFY_MIC,
+	GSS_MECH_STAT_WRAP,
+	GSS_MECH_STAT_UNWRAP,
+	GSS_MECH_STAT_WRAP_BULK,
+	GSS_MECH_STAT_UNWRAP_BULK,
+	GSS_MECH_STAT_MAX,
+};
+
+/* indexed by the RPC service, which gives the flavor of the mechanism */
+struct gss_mech_stats {
+	__u64			gms_count[SPTLRPC_SVC_MAX][GSS_MECH_STAT_MAX];
+	__u64			gms_bytes[SPTLRPC_SVC_MAX][GSS_MECH_STAT_MAX];
+	__u64			gms_usec[SPTLRPC_SVC_MAX][GSS_MECH_STAT_MAX];
+};
+
 /* Each mechanism is described by the following struct: */
 struct gss_api_mech {
 	struct list_head	gm_list;
@@ -113,6 +133,8 @@ struct gss_api_mech {
 	struct gss_api_ops     *gm_ops;
 	int			gm_sf_num;
 	struct subflavor_desc  *gm_sfs;
+	/* percpu, NULL if it could not be allocated at registration */
+	struct gss_mech_stats __percpu *gm_stats;
 };
 
 /* and must provide the following operations: */
@@ -174,6 +196,8 @@ struct gss_api_ops {
 
 int lgss_mech_register(struct gss_api_mech *mech);
 void lgss_mech_unregister(struct gss_api_mech *mech);
+int lgss_mech_stats_seq_show(struct seq_file *m);
+void lgss_mech_stats_clear(void);
 
 struct gss_api_mech * lgss_OID_to_mech(rawobj_t *oid);
 struct gss_api_mech * lgss_name_to_mech(char *name);
@@ -123,10 +123,10 @@ int gss_cli_ctx_wrap_bulk(struct ptlrpc_cli_ctx *ctx,
 			token.len = lustre_msg_buflen(msg, offset) -
 				    sizeof(*bsd);
 
-			maj = lgss_get_mic(gctx->gc_mechctx, 0, NULL,
-					   desc->bd_iov_count,
-					   desc->bd_vec,
-					   &token);
+			maj = lgss_get_mic(gctx->gc_mechctx,
+					SPTLRPC_FLVR_SVC(req->rq_flvr.sf_rpc),
+					0, NULL, desc->bd_iov_count,
+					desc->bd_vec, &token);
 			if (maj != GSS_S_COMPLETE) {
 				CWARN("failed to sign bulk data: %x\n", maj);
 				RETURN(-EACCES);
@@ -262,10 +262,10 @@ int gss_cli_ctx_unwrap_bulk(struct ptlrpc_cli_ctx *ctx,
 			token.len = lustre_msg_buflen(vmsg, voff) -
 				    sizeof(*bsdv);
 
-			maj = lgss_verify_mic(gctx->gc_mechctx, 0, NULL,
-					      desc->bd_iov_count,
-					      desc->bd_vec,
-					      &token);
+			maj = lgss_verify_mic(gctx->gc_mechctx,
+					SPTLRPC_FLVR_SVC(req->rq_flvr.sf_rpc),
+					0, NULL, desc->bd_iov_count,
+					desc->bd_vec, &token);
                         if (maj != GSS_S_COMPLETE) {
                                 CERROR("failed to verify bulk read: %x\n", maj);
                                 RETURN(-EACCES);
@@ -397,8 +397,9 @@ int gss_svc_unwrap_bulk(struct ptlrpc_request *req,
                 token.data = bsdr->bsd_data;
                 token.len = grctx->src_reqbsd_size - sizeof(*bsdr);
 
-		maj = lgss_verify_mic(grctx->src_ctx->gsc_mechctx, 0, NULL,
-				      desc->bd_iov_count,
+		maj = lgss_verify_mic(grctx->src_ctx->gsc_mechctx,
+				      SPTLRPC_FLVR_SVC(req->rq_flvr.sf_rpc),
+				      0, NULL, desc->bd_iov_count,
 				      desc->bd_vec, &token);
                 if (maj != GSS_S_COMPLETE) {
                         bsdv->bsd_flags |= BSD_FL_ERR;
@@ -474,8 +475,9 @@ int gss_svc_wrap_bulk(struct ptlrpc_request *req,
                 token.data = bsdv->bsd_data;
                 token.len = grctx->src_repbsd_size - sizeof(*bsdv);
 
-		maj = lgss_get_mic(grctx->src_ctx->gsc_mechctx, 0, NULL,
-				   desc->bd_iov_count,
+		maj = lgss_get_mic(grctx->src_ctx->gsc_mechctx,
+				   SPTLRPC_FLVR_SVC(req->rq_flvr.sf_rpc),
+				   0, NULL, desc->bd_iov_count,
 				   desc->bd_vec, &token);
 		if (maj != GSS_S_COMPLETE) {
                         bsdv->bsd_flags |= BSD_FL_ERR;
@@ -63,10 +63,148 @@
 
 static LIST_HEAD(registered_mechs);
 static DEFINE_SPINLOCK(registered_mechs_lock);
+static ktime_t gss_mech_stats_init;
+
+static const char * const gss_mech_stat_names[] = {
+	[GSS_MECH_STAT_GET_MIC]		= "get_mic",
+	[GSS_MECH_STAT_VERIFY_MIC]	= "verify_mic",
+	[GSS_MECH_STAT_WRAP]		= "wrap",
+	[GSS_MECH_STAT_UNWRAP]		= "unwrap",
+	[GSS_MECH_STAT_WRAP_BULK]	= "wrap_bulk",
+	[GSS_MECH_STAT_UNWRAP_BULK]	= "unwrap_bulk",
+};
+
+/* \a svc is the RPC service of the flavor, messages and bulk are only
+ * wrapped by the privacy service
+ */
+static void lgss_stat_add(struct gss_api_mech *gm, __u32 svc,
+			  enum gss_mech_stat_op op, __u64 bytes, ktime_t start)
+{
+	struct gss_mech_stats *stats;
+
+	if (gm->gm_stats == NULL || svc >= SPTLRPC_SVC_MAX)
+		return;
+
+	stats = get_cpu_ptr(gm->gm_stats);
+	stats->gms_count[svc][op]++;
+	stats->gms_bytes[svc][op] += bytes;
+	stats->gms_usec[svc][op] += ktime_us_delta(ktime_get(), start);
+	put_cpu_ptr(gm->gm_stats);
+}
+
+/* name of the flavor of \a gm for RPC service \a svc */
+static const char *lgss_svc_name(struct gss_api_mech *gm, __u32 svc)
+{
+	int i;
+
+	for (i = 0; i < gm->gm_sf_num; i++) {
+		if (gm->gm_sfs[i].sf_service == svc)
+			return gm->gm_sfs[i].sf_name;
+	}
+
+	return gm->gm_name;
+}
+
+static __u64 lgss_msg_bytes(int msgcnt, rawobj_t *msg, int iovcnt,
+			    struct bio_vec *iovs)
+{
+	__u64 bytes = 0;
+	int i;
+
+	for (i = 0; i < msgcnt; i++)
+		bytes += msg[i].len;
+	for (i = 0; i < iovcnt; i++)
+		bytes += iovs[i].bv_len;
+
+	return bytes;
+}
+
+int lgss_mech_stats_seq_show(struct seq_file *m)
+{
+	struct gss_mech_stats *sum;
+	struct gss_api_mech *gm;
+	int cpu;
+	int svc;
+	int op;
+
+	OBD_ALLOC_PTR(sum);
+	if (sum == NULL)
+		return -ENOMEM;
+
+	lprocfs_stats_header(m, ktime_get(), gss_mech_stats_init, 25, ":",
+			     true);
+	seq_printf(m, "%-8s %-12s %12s %16s %12s %10s\n", "flavor", "op",
+		   "count", "bytes", "usec", "MB/s");
+
+	spin_lock(&registered_mechs_lock);
+	list_for_each_entry(gm, &registered_mechs, gm_list) {
+		if (gm->gm_stats == NULL)
+			continue;
+
+		memset(sum, 0, sizeof(*sum));
+		for_each_possible_cpu(cpu) {
+			struct gss_mech_stats *stats;
+
+			stats = per_cpu_ptr(gm->gm_stats, cpu);
+			for (svc = 0; svc < SPTLRPC_SVC_MAX; svc++) {
+				for (op = 0; op < GSS_MECH_STAT_MAX; op++) {
+					sum->gms_count[svc][op] +=
+						stats->gms_count[svc][op];
+					sum->gms_bytes[svc][op] +=
+						stats->gms_bytes[svc][op];
+					sum->gms_usec[svc][op] +=
+						stats->gms_usec[svc][op];
+				}
+			}
+		}
+
+		for (svc = 0; svc < SPTLRPC_SVC_MAX; svc++) {
+			for (op = 0; op < GSS_MECH_STAT_MAX; op++) {
+				__u64 usec = sum->gms_usec[svc][op];
+
+				if (sum->gms_count[svc][op] == 0)
+					continue;
+				seq_printf(m, "%-8s %-12s %12llu %16llu %12llu %10llu\n",
+					   lgss_svc_name(gm, svc),
+					   gss_mech_stat_names[op],
+					   sum->gms_count[svc][op],
+					   sum->gms_bytes[svc][op], usec,
+					   usec ? div64_u64(sum->gms_bytes[svc][op],
+							    usec) : 0);
+			}
+		}
+	}
+	spin_unlock(&registered_mechs_lock);
+	OBD_FREE_PTR(sum);
+
+	return 0;
+}
+
+void lgss_mech_stats_clear(void)
+{
+	struct gss_api_mech *gm;
+	int cpu;
+
+	spin_lock(&registered_mechs_lock);
+	list_for_each_entry(gm, &registered_mechs, gm_list) {
+		if (gm->gm_stats == NULL)
+			continue;
+		for_each_possible_cpu(cpu)
+			memset(per_cpu_ptr(gm->gm_stats, cpu), 0,
+			       sizeof(struct gss_mech_stats));
+	}
+	gss_mech_stats_init = ktime_get();
+	spin_unlock(&registered_mechs_lock);
+}
 
 int lgss_mech_register(struct gss_api_mech *gm)
 {
+	/* statistics are best effort, the mechanism works without them */
+	gm->gm_stats = alloc_percpu(struct gss_mech_stats);
+
 	spin_lock(&registered_mechs_lock);
+	if (list_empty(&registered_mechs))
+		gss_mech_stats_init = ktime_get();
 	list_add(&gm->gm_list, &registered_mechs);
 	spin_unlock(&registered_mechs_lock);
 	CDEBUG(D_SEC, "register %s mechanism\n", gm->gm_name);
@@ -78,6 +216,10 @@ void lgss_mech_unregister(struct gss_api_mech *gm)
 	spin_lock(&registered_mechs_lock);
 	list_del(&gm->gm_list);
 	spin_unlock(&registered_mechs_lock);
+	if (gm->gm_stats != NULL) {
+		free_percpu(gm->gm_stats);
+		gm->gm_stats = NULL;
+	}
 	CDEBUG(D_SEC, "Unregister %s mechanism\n", gm->gm_name);
 }
 
@@ -207,46 +349,61 @@ __u32 lgss_inquire_context(struct gss_ctx *context_handle,
 
 /* gss_get_mic: compute a mic over message and return mic_token. */
 __u32 lgss_get_mic(struct gss_ctx *context_handle,
+		   __u32 svc,
 		   int msgcnt,
 		   rawobj_t *msg,
 		   int iovcnt,
 		   struct bio_vec *iovs,
 		   rawobj_t *mic_token)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_get_mic);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_get_mic(context_handle,
                               msgcnt,
                               msg,
                               iovcnt,
                               iovs,
                               mic_token);
+	lgss_stat_add(context_handle->mech_type, svc, GSS_MECH_STAT_GET_MIC,
+		      lgss_msg_bytes(msgcnt, msg, iovcnt, iovs), start);
+	return major;
 }
 
 /* gss_verify_mic: check whether the provided mic_token verifies message. */
 __u32 lgss_verify_mic(struct gss_ctx *context_handle,
+		      __u32 svc,
 		      int msgcnt,
 		      rawobj_t *msg,
 		      int iovcnt,
 		      struct bio_vec *iovs,
 		      rawobj_t *mic_token)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_verify_mic);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_verify_mic(context_handle,
                                  msgcnt,
                                  msg,
                                  iovcnt,
                                  iovs,
                                  mic_token);
+	lgss_stat_add(context_handle->mech_type, svc,
+		      GSS_MECH_STAT_VERIFY_MIC,
+		      lgss_msg_bytes(msgcnt, msg, iovcnt, iovs), start);
+	return major;
 }
 
 __u32 lgss_wrap(struct gss_ctx *context_handle,
@@ -255,13 +412,20 @@ __u32 lgss_wrap(struct gss_ctx *context_handle,
                 int msg_buflen,
                 rawobj_t *out_token)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_wrap);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_wrap(context_handle, gsshdr, msg, msg_buflen, out_token);
+	lgss_stat_add(context_handle->mech_type, SPTLRPC_SVC_PRIV,
+		      GSS_MECH_STAT_WRAP,
+		      msg->len, start);
+	return major;
 }
 
 __u32 lgss_unwrap(struct gss_ctx *context_handle,
@@ -269,13 +433,20 @@ __u32 lgss_unwrap(struct gss_ctx *context_handle,
                   rawobj_t *token,
                   rawobj_t *out_msg)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_unwrap);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_unwrap(context_handle, gsshdr, token, out_msg);
+	lgss_stat_add(context_handle->mech_type, SPTLRPC_SVC_PRIV,
+		      GSS_MECH_STAT_UNWRAP,
+		      token->len, start);
+	return major;
 }
 
 
@@ -296,13 +467,20 @@ __u32 lgss_wrap_bulk(struct gss_ctx *context_handle,
                      rawobj_t *token,
                      int adj_nob)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_wrap_bulk);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_wrap_bulk(context_handle, desc, token, adj_nob);
+	lgss_stat_add(context_handle->mech_type, SPTLRPC_SVC_PRIV,
+		      GSS_MECH_STAT_WRAP_BULK,
+		      desc->bd_nob, start);
+	return major;
 }
 
 __u32 lgss_unwrap_bulk(struct gss_ctx *context_handle,
@@ -310,13 +488,20 @@ __u32 lgss_unwrap_bulk(struct gss_ctx *context_handle,
                        rawobj_t *token,
                        int adj_nob)
 {
+	ktime_t start = ktime_get();
+	__u32 major;
+
         LASSERT(context_handle);
         LASSERT(context_handle->mech_type);
         LASSERT(context_handle->mech_type->gm_ops);
         LASSERT(context_handle->mech_type->gm_ops->gss_unwrap_bulk);
 
-        return context_handle->mech_type->gm_ops
+	major = context_handle->mech_type->gm_ops
                 ->gss_unwrap_bulk(context_handle, desc, token, adj_nob);
+	lgss_stat_add(context_handle->mech_type, SPTLRPC_SVC_PRIV,
+		      GSS_MECH_STAT_UNWRAP_BULK,
+		      desc->bd_nob, start);
+	return major;
 }
 
 /* gss_delete_sec_context: free all resources associated with context_handle.
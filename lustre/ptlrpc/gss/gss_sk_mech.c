@@ -627,49 +627,187 @@ __u32 gss_prep_bulk_sk(struct gss_ctx *gss_context,
 	return GSS_S_COMPLETE;
 }
 
-static __u32 sk_encrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
-			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
-			     int adj_nob)
+/*
+ * Bulk pages are encrypted with AES-CTR as one keystream, page after page.
+ * As long as every page but the last covers whole AES blocks, the counter
+ * at the start of any page is known upfront, so the pages of a large bulk
+ * can be split in chunks of sk_bulk_pipeline_pages pages processed in
+ * parallel by sptlrpc_crypt_parallel().
+ */
+static unsigned int sk_bulk_pipeline_pages = 16;
+module_param(sk_bulk_pipeline_pages, uint, 0644);
+MODULE_PARM_DESC(sk_bulk_pipeline_pages,
+		 "Pages per chunk for parallel SK bulk encryption (0 for inline)");
+
+#define SK_CTR_BLOCK_SIZE	16
+
+struct sk_bulk_batch {
+	struct crypto_sync_skcipher	*skb_tfm;
+	struct ptlrpc_bulk_desc		*skb_desc;
+	bool				 skb_encrypt;
+	/* counter at the start of the first page */
+	__u8				 skb_iv[SK_IV_SIZE];
+};
+
+/* add \a nblocks to the 128-bit big endian counter \a iv, like ctr(aes) */
+static void sk_ctr_add(__u8 *iv, __u64 nblocks)
+{
+	int i;
+
+	for (i = SK_IV_SIZE - 1; i >= 0 && nblocks != 0; i--) {
+		nblocks += iv[i];
+		iv[i] = nblocks & 0xff;
+		nblocks >>= 8;
+	}
+}
+
+/*
+ * Encrypt or decrypt \a count pages of \a desc starting at \a first. The
+ * cipher text length of every page is already set in bd_enc_vec. \a iv is
+ * the counter for the first page and is advanced by the cipher.
+ */
+static int sk_crypt_pages(struct crypto_sync_skcipher *tfm, __u8 *iv,
+			  struct ptlrpc_bulk_desc *desc, bool encrypt,
+			  int first, int count)
 {
 	struct scatterlist ptxt;
 	struct scatterlist ctxt;
 	int blocksize;
 	int i;
-	int rc;
-	int nob = 0;
+	int rc = 0;
 	SYNC_SKCIPHER_REQUEST_ON_STACK(req, tfm);
 
 	blocksize = crypto_sync_skcipher_blocksize(tfm);
 
-	sg_init_table(&ptxt, 1);
-	sg_init_table(&ctxt, 1);
-
 	skcipher_request_set_sync_tfm(req, tfm);
 	skcipher_request_set_callback(req, 0, NULL, NULL);
 
-	for (i = 0; i < desc->bd_iov_count; i++) {
-		sg_set_page(&ptxt, desc->bd_vec[i].bv_page,
-			    sk_block_mask(desc->bd_vec[i].bv_len,
-					  blocksize),
-			    desc->bd_vec[i].bv_offset);
-		nob += ptxt.length;
+	for (i = first; i < first + count; i++) {
+		struct bio_vec *piov = &desc->bd_vec[i];
+		struct bio_vec *ciov = &desc->bd_enc_vec[i];
 
-		sg_set_page(&ctxt, desc->bd_enc_vec[i].bv_page,
-			    ptxt.length, ptxt.offset);
+		if (ciov->bv_len == 0)
+			continue;
+
+		sg_init_table(&ptxt, 1);
+		sg_init_table(&ctxt, 1);
+		sg_set_page(&ctxt, ciov->bv_page, ciov->bv_len,
+			    ciov->bv_offset);
+
+		if (encrypt) {
+			sg_set_page(&ptxt, piov->bv_page, ciov->bv_len,
+				    piov->bv_offset);
+			skcipher_request_set_crypt(req, &ptxt, &ctxt,
+						   ptxt.length, iv);
+			rc = crypto_skcipher_encrypt_iv(req, &ctxt, &ptxt,
+							ptxt.length);
+			if (rc) {
+				CERROR("failed to encrypt page: %d\n", rc);
+				break;
+			}
+			continue;
+		}
 
-		desc->bd_enc_vec[i].bv_offset = ctxt.offset;
-		desc->bd_enc_vec[i].bv_len = ctxt.length;
+		ptxt = ctxt;
+		/* In the event the plain text size is not a multiple
+		 * of blocksize we decrypt in place and copy the result
+		 * after the decryption */
+		if (piov->bv_len % blocksize == 0)
+			sg_assign_page(&ptxt, piov->bv_page);
 
-		skcipher_request_set_crypt(req, &ptxt, &ctxt, ptxt.length, iv);
-		rc = crypto_skcipher_encrypt_iv(req, &ctxt, &ptxt, ptxt.length);
+		skcipher_request_set_crypt(req, &ctxt, &ptxt, ptxt.length, iv);
+		rc = crypto_skcipher_decrypt_iv(req, &ptxt, &ctxt, ptxt.length);
 		if (rc) {
-			CERROR("failed to encrypt page: %d\n", rc);
-			skcipher_request_zero(req);
-			return rc;
+			CERROR("Decryption failed for page: %d\n", rc);
+			rc = GSS_S_FAILURE;
+			break;
+		}
+
+		if (piov->bv_len % blocksize != 0) {
+			memcpy(page_address(piov->bv_page) +
+			       piov->bv_offset,
+			       page_address(ciov->bv_page) +
+			       ciov->bv_offset,
+			       piov->bv_len);
 		}
 	}
 	skcipher_request_zero(req);
 
+	return rc;
+}
+
+/* counters can only be computed upfront if no page ends mid-block */
+static bool sk_bulk_can_split(struct ptlrpc_bulk_desc *desc, int count)
+{
+	int i;
+
+	for (i = 0; i < count - 1; i++) {
+		if (desc->bd_enc_vec[i].bv_len % SK_CTR_BLOCK_SIZE != 0)
+			return false;
+	}
+
+	return true;
+}
+
+/* sptlrpc_crypt_chunk_t for the pages of \a data starting at \a first */
+static int sk_crypt_chunk(void *data, u32 first, u32 count)
+{
+	struct sk_bulk_batch *skb = data;
+	__u8 iv[SK_IV_SIZE];
+	__u64 nblocks = 0;
+	u32 i;
+
+	for (i = 0; i < first; i++)
+		nblocks += skb->skb_desc->bd_enc_vec[i].bv_len /
+			   SK_CTR_BLOCK_SIZE;
+	memcpy(iv, skb->skb_iv, SK_IV_SIZE);
+	sk_ctr_add(iv, nblocks);
+
+	return sk_crypt_pages(skb->skb_tfm, iv, skb->skb_desc,
+			      skb->skb_encrypt, first, count);
+}
+
+/* Encrypt or decrypt the first \a count pages of \a desc */
+static int sk_crypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
+			 struct ptlrpc_bulk_desc *desc, bool encrypt,
+			 int count)
+{
+	struct sk_bulk_batch skb = {
+		.skb_tfm	= tfm,
+		.skb_desc	= desc,
+		.skb_encrypt	= encrypt,
+	};
+	unsigned int chunk = 0;
+
+	memcpy(skb.skb_iv, iv, SK_IV_SIZE);
+	if (sk_bulk_can_split(desc, count))
+		chunk = READ_ONCE(sk_bulk_pipeline_pages);
+
+	return sptlrpc_crypt_parallel(sk_crypt_chunk, &skb, count, chunk);
+}
+
+static __u32 sk_encrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
+			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
+			     int adj_nob)
+{
+	int blocksize;
+	int i;
+	int rc;
+	int nob = 0;
+
+	blocksize = crypto_sync_skcipher_blocksize(tfm);
+
+	for (i = 0; i < desc->bd_iov_count; i++) {
+		desc->bd_enc_vec[i].bv_offset = desc->bd_vec[i].bv_offset;
+		desc->bd_enc_vec[i].bv_len =
+			sk_block_mask(desc->bd_vec[i].bv_len, blocksize);
+		nob += desc->bd_enc_vec[i].bv_len;
+	}
+
+	rc = sk_crypt_bulk(tfm, iv, desc, true, desc->bd_iov_count);
+	if (rc)
+		return rc;
+
 	if (adj_nob)
 		desc->bd_nob = nob;
 
@@ -680,17 +818,11 @@ static __u32 sk_decrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
 			     struct ptlrpc_bulk_desc *desc, rawobj_t *cipher,
 			     int adj_nob)
 {
-	struct scatterlist ptxt;
-	struct scatterlist ctxt;
 	int blocksize;
 	int i;
 	int rc;
 	int pnob = 0;
 	int cnob = 0;
-	SYNC_SKCIPHER_REQUEST_ON_STACK(req, tfm);
-
-	sg_init_table(&ptxt, 1);
-	sg_init_table(&ctxt, 1);
 
 	blocksize = crypto_sync_skcipher_blocksize(tfm);
 	if (desc->bd_nob_transferred % blocksize != 0) {
@@ -699,9 +831,9 @@ static __u32 sk_decrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
 		return GSS_S_DEFECTIVE_TOKEN;
 	}
 
-	skcipher_request_set_sync_tfm(req, tfm);
-	skcipher_request_set_callback(req, 0, NULL, NULL);
-
+	/* settle the length of every page before any decryption, so that
+	 * the pages can be decrypted in parallel
+	 */
 	for (i = 0; i < desc->bd_iov_count && cnob < desc->bd_nob_transferred;
 	     i++) {
 		struct bio_vec *piov = &desc->bd_vec[i];
@@ -710,7 +842,6 @@ static __u32 sk_decrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
 		if (ciov->bv_offset % blocksize != 0 ||
 		    ciov->bv_len % blocksize != 0) {
 			CERROR("Invalid bulk descriptor vector\n");
-			skcipher_request_zero(req);
 			return GSS_S_DEFECTIVE_TOKEN;
 		}
 
@@ -734,45 +865,17 @@ static __u32 sk_decrypt_bulk(struct crypto_sync_skcipher *tfm, __u8 *iv,
 			if (ciov->bv_len + cnob > desc->bd_nob_transferred ||
 			    piov->bv_len > ciov->bv_len) {
 				CERROR("Invalid decrypted length\n");
-				skcipher_request_zero(req);
 				return GSS_S_FAILURE;
 			}
 		}
 
-		if (ciov->bv_len == 0)
-			continue;
-
-		sg_init_table(&ctxt, 1);
-		sg_set_page(&ctxt, ciov->bv_page, ciov->bv_len,
-			    ciov->bv_offset);
-		ptxt = ctxt;
-
-		/* In the event the plain text size is not a multiple
-		 * of blocksize we decrypt in place and copy the result
-		 * after the decryption */
-		if (piov->bv_len % blocksize == 0)
-			sg_assign_page(&ptxt, piov->bv_page);
-
-		skcipher_request_set_crypt(req, &ctxt, &ptxt, ptxt.length, iv);
-		rc = crypto_skcipher_decrypt_iv(req, &ptxt, &ctxt, ptxt.length);
-		if (rc) {
-			CERROR("Decryption failed for page: %d\n", rc);
-			skcipher_request_zero(req);
-			return GSS_S_FAILURE;
-		}
-
-		if (piov->bv_len % blocksize != 0) {
-			memcpy(page_address(piov->bv_page) +
-			       piov->bv_offset,
-			       page_address(ciov->bv_page) +
-			       ciov->bv_offset,
-			       piov->bv_len);
-		}
-
 		cnob += ciov->bv_len;
 		pnob += piov->bv_len;
 	}
-	skcipher_request_zero(req);
+
+	rc = sk_crypt_bulk(tfm, iv, desc, false, i);
+	if (rc)
+		return rc;
 
 	/* if needed, clear up the rest unused iovs */
 	if (adj_nob)
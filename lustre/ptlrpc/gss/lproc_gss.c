@@ -178,6 +178,23 @@ ssize_t sptlrpc_gss_check_upcall_ns_seq_write(struct file *file,
 LPROC_SEQ_FOPS(sptlrpc_gss_check_upcall_ns);
 #endif /* HAVE_GSS_KEYRING */
 
+/*
+ * time spent in each crypto operation of each mechanism, writing clears it
+ */
+static int gss_crypto_stats_seq_show(struct seq_file *m, void *v)
+{
+	return lgss_mech_stats_seq_show(m);
+}
+
+static ssize_t
+gss_crypto_stats_seq_write(struct file *file, const char __user *buffer,
+			   size_t count, loff_t *off)
+{
+	lgss_mech_stats_clear();
+	return count;
+}
+LPROC_SEQ_FOPS(gss_crypto_stats);
+
 static struct ldebugfs_vars gss_debugfs_vars[] = {
 	{ .name	=	"replays",
 	  .fops	=	&gss_proc_oos_fops	},
@@ -190,6 +207,8 @@ static struct ldebugfs_vars gss_debugfs_vars[] = {
 static struct lprocfs_vars gss_lprocfs_vars[] = {
 	{ .name	=	"krb5_allow_old_client_csum",
 	  .fops	=	&sptlrpc_krb5_allow_old_client_csum_fops },
+	{ .name	=	"crypto_stats",
+	  .fops	=	&gss_crypto_stats_fops },
 #ifdef HAVE_GSS_KEYRING
 	{ .name	=	"gss_check_upcall_ns",
 	  .fops	=	&sptlrpc_gss_check_upcall_ns_fops },
@@ -198,7 +198,7 @@ static int gss_sign_msg(struct lustre_msg *msg,
         mic.len = msg->lm_buflens[mic_idx];
         mic.data = lustre_msg_buf(msg, mic_idx, 0);
 
-        major = lgss_get_mic(mechctx, textcnt, text, 0, NULL, &mic);
+        major = lgss_get_mic(mechctx, svc, textcnt, text, 0, NULL, &mic);
         if (major != GSS_S_COMPLETE) {
                 CERROR("fail to generate MIC: %08x\n", major);
                 return -EPERM;
@@ -237,7 +237,7 @@ __u32 gss_verify_msg(struct lustre_msg *msg,
         mic.len = msg->lm_buflens[mic_idx];
         mic.data = lustre_msg_buf(msg, mic_idx, 0);
 
-        major = lgss_verify_mic(mechctx, textcnt, text, 0, NULL, &mic);
+        major = lgss_verify_mic(mechctx, svc, textcnt, text, 0, NULL, &mic);
         if (major != GSS_S_COMPLETE)
                 CERROR("mic verify error: %08x\n", major);
 
@@ -2914,6 +2914,7 @@ static void __exit sptlrpc_gss_exit(void)
 {
         gss_exit_keyring();
         gss_exit_pipefs();
+	cleanup_sk_module();
         cleanup_kerberos_module();
         gss_exit_svc_upcall();
         gss_exit_cli_upcall();
@@ -657,6 +657,69 @@ int ptlrpc_connect_import(struct obd_import *imp)
 	return ptlrpc_connect_import_locked(imp);
 }
 
+/**
+ * Prepare a new import \a imp without sending the CONNECT RPC.
+ *
+ * The connection is selected so that the export is usable, then the import
+ * is left in LUSTRE_IMP_IDLE state. The initial connect is sent by
+ * ptlrpc_reconnect_if_idle() when the first request is allocated, exactly
+ * like after an idle disconnect. This avoids connecting to every target at
+ * mount time.
+ *
+ * As after an idle disconnect, the import stays valid and the observers see
+ * it as active, so that e.g. LOV sends quotactl or fiemap to the target and
+ * connects it instead of skipping it as an inactive one.
+ *
+ * Returns 0 on success or error code.
+ */
+int ptlrpc_connect_import_lazy(struct obd_import *imp)
+{
+	struct obd_export *exp;
+	bool idle = false;
+	int rc;
+
+	ENTRY;
+
+	spin_lock(&imp->imp_lock);
+	if (imp->imp_state != LUSTRE_IMP_NEW) {
+		spin_unlock(&imp->imp_lock);
+		RETURN(ptlrpc_connect_import(imp));
+	}
+	spin_unlock(&imp->imp_lock);
+
+	rc = import_select_connection(imp);
+	if (rc)
+		RETURN(rc);
+
+	exp = class_conn2export(&imp->imp_dlm_handle);
+	if (!exp)
+		RETURN(-ENODEV);
+
+	spin_lock(&imp->imp_lock);
+	if (imp->imp_state == LUSTRE_IMP_NEW) {
+		/* Callers may check the export connect flags before the first
+		 * RPC, e.g. statfs or feature probes at mount. Until the reply
+		 * from the server is processed by ptlrpc_connect_interpret(),
+		 * which replaces them with the granted subset, expose the flags
+		 * the client will ask for.
+		 */
+		exp->exp_connect_data = imp->imp_connect_data;
+		imp->imp_obd->obd_self_export->exp_connect_data =
+			imp->imp_connect_data;
+		import_set_state_nolock(imp, LUSTRE_IMP_IDLE);
+		CDEBUG(D_HA, "%s: deferring connect to %s until first use\n",
+		       imp->imp_obd->obd_name, obd2cli_tgt(imp->imp_obd));
+		idle = true;
+	}
+	spin_unlock(&imp->imp_lock);
+	class_export_put(exp);
+
+	if (idle)
+		ptlrpc_activate_import(imp, false);
+
+	RETURN(0);
+}
+
 /**
  * Attempt to (re)connect import \a imp. This includes all preparations,
  * initializing CONNECT RPC request and passing it to ptlrpcd for
@@ -53,6 +53,11 @@ bool nodemap_active;
 DEFINE_MUTEX(active_config_lock);
 struct nodemap_config *active_config;
 
+atomic_t nodemap_config_gen = ATOMIC_INIT(0);
+
+/* classification and idmap lookup counters, see nodemap/stats */
+struct lprocfs_stats *nodemap_stats;
+
 /**
  * Nodemap destructor
  *
@@ -73,6 +78,7 @@ static void nodemap_destroy(struct lu_nodemap *nodemap)
 	down_write(&nodemap->nm_idmap_lock);
 	idmap_delete_tree(nodemap);
 	up_write(&nodemap->nm_idmap_lock);
+	idcache_free(nodemap);
 
 	mutex_unlock(&active_config_lock);
 
@@ -258,6 +264,7 @@ struct lu_nodemap *nodemap_classify_nid(lnet_nid_t nid)
 {
 	struct lu_nid_range *range;
 	struct lu_nodemap *nodemap;
+	ktime_t start = ktime_get();
 	int rc;
 
 	ENTRY;
@@ -286,6 +293,10 @@ struct lu_nodemap *nodemap_classify_nid(lnet_nid_t nid)
 	LASSERT(nodemap != NULL);
 	nodemap_getref(nodemap);
 
+	if (nodemap_stats)
+		lprocfs_counter_add(nodemap_stats, NODEMAP_STAT_CLASSIFY,
+				    ktime_us_delta(ktime_get(), start));
+
 	RETURN(nodemap);
 }
 
@@ -379,13 +390,32 @@ EXPORT_SYMBOL(nodemap_parse_idmap);
  */
 int nodemap_add_member(lnet_nid_t nid, struct obd_export *exp)
 {
+	struct tg_export_data *ted = &exp->exp_target_data;
 	struct lu_nodemap *nodemap;
+	bool cached;
+	__u32 gen;
 	int rc = 0;
 	ENTRY;
 
+	/* a reconnect from the same NID with no range change since the
+	 * export was classified keeps its nodemap, skip the config lock
+	 */
+	gen = atomic_read(&nodemap_config_gen);
+	spin_lock(&ted->ted_nodemap_lock);
+	cached = ted->ted_nodemap != NULL && ted->ted_nodemap_nid == nid &&
+		 ted->ted_nodemap_gen == gen;
+	spin_unlock(&ted->ted_nodemap_lock);
+	if (cached) {
+		if (nodemap_stats)
+			lprocfs_counter_incr(nodemap_stats,
+					     NODEMAP_STAT_CLASSIFY_CACHED);
+		RETURN(0);
+	}
+
 	mutex_lock(&active_config_lock);
 	down_read(&active_config->nmc_range_tree_lock);
 
+	gen = atomic_read(&nodemap_config_gen);
 	nodemap = nodemap_classify_nid(nid);
 
 	if (IS_ERR(nodemap)) {
@@ -394,6 +424,12 @@ int nodemap_add_member(lnet_nid_t nid, struct obd_export *exp)
 		rc = -EINVAL;
 	} else {
 		rc = nm_member_add(nodemap, exp);
+		if (rc == 0) {
+			spin_lock(&ted->ted_nodemap_lock);
+			ted->ted_nodemap_nid = nid;
+			ted->ted_nodemap_gen = gen;
+			spin_unlock(&ted->ted_nodemap_lock);
+		}
 	}
 
 	up_read(&active_config->nmc_range_tree_lock);
@@ -659,7 +695,10 @@ __u32 nodemap_map_id(struct lu_nodemap *nodemap,
 		     enum nodemap_tree_type tree_type, __u32 id)
 {
 	struct lu_idmap		*idmap = NULL;
-	__u32			 found_id;
+	__u32			 found_id = 0;
+	ktime_t			 start;
+	bool			 found;
+	__u32			 gen;
 
 	ENTRY;
 
@@ -694,18 +733,39 @@ __u32 nodemap_map_id(struct lu_nodemap *nodemap,
 	if (is_default_nodemap(nodemap))
 		goto squash;
 
+	/* sample the generation before searching, so that a result racing
+	 * with an idmap change is cached as already stale
+	 */
+	gen = atomic_read(&nodemap_config_gen);
+	if (idcache_lookup(nodemap, id_type, tree_type, id, gen, &found_id,
+			   &found)) {
+		if (nodemap_stats)
+			lprocfs_counter_incr(nodemap_stats,
+					     NODEMAP_STAT_IDMAP_HIT);
+		if (!found)
+			goto squash;
+		RETURN(found_id);
+	}
+
+	start = ktime_get();
 	down_read(&nodemap->nm_idmap_lock);
 	idmap = idmap_search(nodemap, tree_type, id_type, id);
-	if (idmap == NULL) {
-		up_read(&nodemap->nm_idmap_lock);
-		goto squash;
+	if (idmap != NULL) {
+		if (tree_type == NODEMAP_FS_TO_CLIENT)
+			found_id = idmap->id_client;
+		else
+			found_id = idmap->id_fs;
 	}
-
-	if (tree_type == NODEMAP_FS_TO_CLIENT)
-		found_id = idmap->id_client;
-	else
-		found_id = idmap->id_fs;
 	up_read(&nodemap->nm_idmap_lock);
+
+	idcache_insert(nodemap, id_type, tree_type, id, gen, found_id,
+		       idmap != NULL);
+	if (nodemap_stats)
+		lprocfs_counter_add(nodemap_stats, NODEMAP_STAT_IDMAP_MISS,
+				    ktime_us_delta(ktime_get(), start));
+
+	if (idmap == NULL)
+		goto squash;
 	RETURN(found_id);
 
 squash:
@@ -1778,6 +1838,7 @@ void nodemap_config_set_active(struct nodemap_config *config)
 	if (!config->nmc_nodemap_is_active)
 		nodemap_active = false;
 	active_config = config;
+	nodemap_config_gen_bump();
 	if (config->nmc_nodemap_is_active)
 		nodemap_active = true;
 
@@ -1799,6 +1860,7 @@ void nodemap_mod_exit(void)
 {
 	nodemap_config_dealloc(active_config);
 	nodemap_procfs_exit();
+	lprocfs_free_stats(&nodemap_stats);
 }
 
 /**
@@ -1810,13 +1872,32 @@ int nodemap_mod_init(void)
 	struct lu_nodemap	*nodemap;
 	int			 rc = 0;
 
+	/* counters are optional, lookups just don't account without them */
+	nodemap_stats = lprocfs_alloc_stats(NODEMAP_STAT_LAST, 0);
+	if (nodemap_stats) {
+		lprocfs_counter_init(nodemap_stats, NODEMAP_STAT_CLASSIFY,
+				     LPROCFS_CNTR_AVGMINMAX, "classify",
+				     "usecs");
+		lprocfs_counter_init(nodemap_stats,
+				     NODEMAP_STAT_CLASSIFY_CACHED, 0,
+				     "classify_cached", "reqs");
+		lprocfs_counter_init(nodemap_stats, NODEMAP_STAT_IDMAP_HIT, 0,
+				     "idmap_cache_hit", "reqs");
+		lprocfs_counter_init(nodemap_stats, NODEMAP_STAT_IDMAP_MISS,
+				     LPROCFS_CNTR_AVGMINMAX, "idmap_cache_miss",
+				     "usecs");
+	}
+
 	rc = nodemap_procfs_init();
-	if (rc != 0)
+	if (rc != 0) {
+		lprocfs_free_stats(&nodemap_stats);
 		return rc;
+	}
 
 	new_config = nodemap_config_alloc();
 	if (IS_ERR(new_config)) {
 		nodemap_procfs_exit();
+		lprocfs_free_stats(&nodemap_stats);
 		GOTO(out, rc = PTR_ERR(new_config));
 	}
 
@@ -1824,6 +1905,7 @@ int nodemap_mod_init(void)
 	if (IS_ERR(nodemap)) {
 		nodemap_config_dealloc(new_config);
 		nodemap_procfs_exit();
+		lprocfs_free_stats(&nodemap_stats);
 		GOTO(out, rc = PTR_ERR(nodemap));
 	}
 
@@ -27,6 +27,7 @@
  * Author: Joshua Walgenbach <jjw@iu.edu>
  */
 
+#include <linux/hash.h>
 #include <linux/rbtree.h>
 #include <lustre_net.h>
 #include "nodemap_internal.h"
@@ -160,6 +161,7 @@ struct lu_idmap *idmap_insert(enum nodemap_id_type id_type,
 		rb_insert_color(&idmap->id_client_to_fs, fwd_root);
 		rb_link_node(&idmap->id_fs_to_client, bck_parent, bck_node);
 		rb_insert_color(&idmap->id_fs_to_client, bck_root);
+		nodemap_config_gen_bump();
 		RETURN(NULL);
 	}
 
@@ -196,6 +198,7 @@ void idmap_delete(enum nodemap_id_type id_type, struct lu_idmap *idmap,
 
 	rb_erase(&idmap->id_client_to_fs, fwd_root);
 	rb_erase(&idmap->id_fs_to_client, bck_root);
+	nodemap_config_gen_bump();
 
 	idmap_destroy(idmap);
 }
@@ -279,6 +282,8 @@ void idmap_delete_tree(struct lu_nodemap *nodemap)
 	struct lu_idmap		*temp;
 	struct rb_root		root;
 
+	nodemap_config_gen_bump();
+
 	root = nodemap->nm_fs_to_client_uidmap;
 	nm_rbtree_postorder_for_each_entry_safe(idmap, temp, &root,
 						id_fs_to_client) {
@@ -297,3 +302,109 @@ void idmap_delete_tree(struct lu_nodemap *nodemap)
 		idmap_destroy(idmap);
 	}
 }
+
+/*
+ * The idmap cache is a direct mapped table of immutable entries hanging off
+ * each nodemap. Lookups are lockless under rcu_read_lock(), insertion swaps
+ * the slot with xchg() and frees the previous entry after a grace period.
+ * Entries are tagged with nodemap_config_gen, which idmap_insert/delete bump
+ * under nm_idmap_lock, so any change to the trees invalidates the whole cache
+ * at once without touching it.
+ */
+struct nm_idcache_ent {
+	struct rcu_head		nie_rcu;
+	__u64			nie_key;
+	__u32			nie_gen;
+	__u32			nie_id;
+	bool			nie_found;
+};
+
+static inline __u64 idcache_key(enum nodemap_id_type id_type,
+				enum nodemap_tree_type tree_type, __u32 id)
+{
+	return ((__u64)id_type << 40) | ((__u64)tree_type << 32) | id;
+}
+
+/**
+ * Look up a cached idmap search result.
+ *
+ * \param	nodemap		nodemap to look in
+ * \param	id_type		NODEMAP_UID, NODEMAP_GID or NODEMAP_PROJID
+ * \param	tree_type	direction of the mapping
+ * \param	id		id to map
+ * \param	gen		nodemap_config_gen sampled before the lookup
+ * \param	mapped_id	set to the mapped id on a positive hit
+ * \param	found		set to whether the id has a mapping
+ *
+ * \retval	true if a valid entry was found
+ */
+bool idcache_lookup(struct lu_nodemap *nodemap, enum nodemap_id_type id_type,
+		    enum nodemap_tree_type tree_type, __u32 id, __u32 gen,
+		    __u32 *mapped_id, bool *found)
+{
+	__u64 key = idcache_key(id_type, tree_type, id);
+	struct nm_idcache_ent *ent;
+	bool hit = false;
+
+	rcu_read_lock();
+	ent = rcu_dereference(
+		nodemap->nm_idcache[hash_64(key, NODEMAP_IDCACHE_BITS)]);
+	if (ent && ent->nie_key == key && ent->nie_gen == gen) {
+		*mapped_id = ent->nie_id;
+		*found = ent->nie_found;
+		hit = true;
+	}
+	rcu_read_unlock();
+
+	return hit;
+}
+
+/**
+ * Remember the result of an idmap search.  gen must have been sampled
+ * before the search so that a concurrent tree change leaves a stale entry.
+ * Allocation failure only costs the next lookup a tree walk.
+ */
+void idcache_insert(struct lu_nodemap *nodemap, enum nodemap_id_type id_type,
+		    enum nodemap_tree_type tree_type, __u32 id, __u32 gen,
+		    __u32 mapped_id, bool found)
+{
+	__u64 key = idcache_key(id_type, tree_type, id);
+	struct nm_idcache_ent *ent;
+	struct nm_idcache_ent *old;
+
+	OBD_ALLOC_GFP(ent, sizeof(*ent), GFP_ATOMIC);
+	if (ent == NULL)
+		return;
+
+	ent->nie_key = key;
+	ent->nie_gen = gen;
+	ent->nie_id = mapped_id;
+	ent->nie_found = found;
+
+	old = xchg(&nodemap->nm_idcache[hash_64(key, NODEMAP_IDCACHE_BITS)],
+		   ent);
+	if (old != NULL) {
+		OBD_FREE_PRE(old, sizeof(*old), "rcu");
+		kfree_rcu(old, nie_rcu);
+	}
+}
+
+/*
+ * free the idmap cache of a nodemap being destroyed, there can be no more
+ * readers since they all hold a nodemap reference
+ *
+ * \param	nodemap		nodemap to free the cache of
+ */
+void idcache_free(struct lu_nodemap *nodemap)
+{
+	int i;
+
+	for (i = 0; i < NODEMAP_IDCACHE_SIZE; i++) {
+		struct nm_idcache_ent *ent = nodemap->nm_idcache[i];
+
+		if (ent != NULL) {
+			nodemap->nm_idcache[i] = NULL;
+			OBD_FREE_PTR(ent);
+		}
+	}
+}
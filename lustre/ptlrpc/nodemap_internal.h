@@ -50,6 +50,27 @@ extern bool nodemap_active;
 extern struct mutex active_config_lock;
 extern struct nodemap_config *active_config;
 
+/* bumped whenever a range or idmap changes, or a new config is activated.
+ * Cached classifications and idmap lookups are only valid while their
+ * generation matches.
+ */
+extern atomic_t nodemap_config_gen;
+
+static inline void nodemap_config_gen_bump(void)
+{
+	atomic_inc(&nodemap_config_gen);
+}
+
+enum nodemap_stats_idx {
+	NODEMAP_STAT_CLASSIFY = 0,	/* NID range tree walks */
+	NODEMAP_STAT_CLASSIFY_CACHED,	/* reconnects using cached nodemap */
+	NODEMAP_STAT_IDMAP_HIT,		/* idmap lookups served from cache */
+	NODEMAP_STAT_IDMAP_MISS,	/* idmap lookups walking the rbtree */
+	NODEMAP_STAT_LAST,
+};
+
+extern struct lprocfs_stats *nodemap_stats;
+
 struct lu_nid_range {
 	/* unique id set by mgs */
 	unsigned int		 rn_id;
@@ -149,6 +170,13 @@ struct lu_idmap *idmap_search(struct lu_nodemap *nodemap,
 			      enum nodemap_tree_type,
 			      enum nodemap_id_type id_type,
 			      __u32 id);
+bool idcache_lookup(struct lu_nodemap *nodemap, enum nodemap_id_type id_type,
+		    enum nodemap_tree_type tree_type, __u32 id, __u32 gen,
+		    __u32 *mapped_id, bool *found);
+void idcache_insert(struct lu_nodemap *nodemap, enum nodemap_id_type id_type,
+		    enum nodemap_tree_type tree_type, __u32 id, __u32 gen,
+		    __u32 mapped_id, bool found);
+void idcache_free(struct lu_nodemap *nodemap);
 int nm_member_add(struct lu_nodemap *nodemap, struct obd_export *exp);
 void nm_member_del(struct lu_nodemap *nodemap, struct obd_export *exp);
 void nm_member_delete_list(struct lu_nodemap *nodemap);
@@ -886,6 +886,16 @@ int nodemap_procfs_init(void)
 		CERROR("cannot create 'nodemap' directory: rc = %d\n",
 		       rc);
 		proc_lustre_nodemap_root = NULL;
+		return rc;
+	}
+
+	if (nodemap_stats) {
+		rc = lprocfs_register_stats(proc_lustre_nodemap_root, "stats",
+					    nodemap_stats);
+		if (rc) {
+			CERROR("cannot create nodemap 'stats': rc = %d\n", rc);
+			lprocfs_remove(&proc_lustre_nodemap_root);
+		}
 	}
 	return rc;
 }
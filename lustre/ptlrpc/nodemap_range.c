@@ -140,6 +140,7 @@ int range_insert(struct nodemap_range_tree *nm_range_tree,
 		return -EEXIST;
 
 	nm_range_insert(range, &nm_range_tree->nmrt_range_interval_root);
+	nodemap_config_gen_bump();
 
 	return 0;
 }
@@ -155,6 +156,7 @@ void range_delete(struct nodemap_range_tree *nm_range_tree,
 {
 	list_del(&range->rn_list);
 	nm_range_remove(range, &nm_range_tree->nmrt_range_interval_root);
+	nodemap_config_gen_bump();
 	range_destroy(range);
 }
 
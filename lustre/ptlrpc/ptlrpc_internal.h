@@ -85,7 +85,8 @@ void ptlrpc_init_xid(void);
 void ptlrpc_set_add_new_req(struct ptlrpcd_ctl *pc,
 			    struct ptlrpc_request *req);
 void ptlrpc_expired_set(struct ptlrpc_request_set *set);
-time64_t ptlrpc_set_next_timeout(struct ptlrpc_request_set *);
+void ptlrpc_set_req_unlink(struct ptlrpc_request_set *set,
+			   struct ptlrpc_request *req);
 void ptlrpc_resend_req(struct ptlrpc_request *request);
 void ptlrpc_set_mbits(struct ptlrpc_request *req);
 void ptlrpc_assign_next_xid_nolock(struct ptlrpc_request *req);
@@ -293,6 +294,8 @@ void sptlrpc_plain_fini(void);
 /* sec_bulk.c */
 int  sptlrpc_enc_pool_init(void);
 void sptlrpc_enc_pool_fini(void);
+int  sptlrpc_crypt_init(void);
+void sptlrpc_crypt_fini(void);
 int sptlrpc_proc_enc_pool_seq_show(struct seq_file *m, void *v);
 
 /* sec_lproc.c */
@@ -355,8 +358,11 @@ static inline void nodemap_mod_exit(void)
 
 static inline void ptlrpc_reqset_put(struct ptlrpc_request_set *set)
 {
-	if (atomic_dec_and_test(&set->set_refcount))
+	if (atomic_dec_and_test(&set->set_refcount)) {
+		if (set->set_timer_heap)
+			binheap_destroy(set->set_timer_heap);
 		OBD_FREE_PTR(set);
+	}
 }
 
 /** initialise ptlrpc common fields */
@@ -381,6 +387,7 @@ static inline void ptlrpc_cli_req_init(struct ptlrpc_request *req)
 	req->rq_replied = 0;
 
 	INIT_LIST_HEAD(&cr->cr_set_chain);
+	INIT_LIST_HEAD(&cr->cr_ready_chain);
 	INIT_LIST_HEAD(&cr->cr_ctx_chain);
 	INIT_LIST_HEAD(&cr->cr_unreplied_list);
 	init_waitqueue_head(&cr->cr_reply_waitq);
@@ -160,6 +160,7 @@ void ptlrpcd_wake(struct ptlrpc_request *req)
 	struct ptlrpc_request_set *set = req->rq_set;
 
 	LASSERT(set != NULL);
+	ptlrpc_set_req_ready(set, req);
 	wake_up(&set->set_waitq);
 }
 EXPORT_SYMBOL(ptlrpcd_wake);
@@ -212,6 +213,7 @@ void ptlrpcd_add_rqset(struct ptlrpc_request_set *set)
 		LASSERT(req->rq_phase == RQ_PHASE_NEW);
 		req->rq_set = new;
 		req->rq_queued_time = ktime_get_seconds();
+		ptlrpc_set_req_unlink(set, req);
 	}
 
 	spin_lock(&new->set_new_req_lock);
@@ -244,8 +246,11 @@ static int ptlrpcd_steal_rqset(struct ptlrpc_request_set *des,
 
 	spin_lock(&src->set_new_req_lock);
 	if (likely(!list_empty(&src->set_new_requests))) {
-		list_for_each_entry(req, &src->set_new_requests, rq_set_chain)
+		list_for_each_entry(req, &src->set_new_requests, rq_set_chain) {
 			req->rq_set = des;
+			ptlrpc_set_req_unlink(src, req);
+			ptlrpc_set_req_ready(des, req);
+		}
 
 		list_splice_init(&src->set_new_requests,
 				 &des->set_requests);
@@ -288,7 +293,7 @@ void ptlrpcd_add_req(struct ptlrpc_request *req)
 		/* ptlrpc_check_set will decrease the count */
 		atomic_inc(&req->rq_set->set_remaining);
 		spin_unlock(&req->rq_lock);
-		wake_up(&req->rq_set->set_waitq);
+		ptlrpcd_wake(req);
 		return;
 	} else {
 		spin_unlock(&req->rq_lock);
@@ -324,6 +329,9 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 	if (atomic_read(&set->set_new_count)) {
 		spin_lock(&set->set_new_req_lock);
 		if (likely(!list_empty(&set->set_new_requests))) {
+			list_for_each_entry(req, &set->set_new_requests,
+					    rq_set_chain)
+				ptlrpc_set_req_ready(set, req);
 			list_splice_init(&set->set_new_requests,
 					     &set->set_requests);
 			atomic_add(atomic_read(&set->set_new_count),
@@ -370,6 +378,7 @@ static int ptlrpcd_check(struct lu_env *env, struct ptlrpcd_ctl *pc)
 
 		list_del_init(&req->rq_set_chain);
 		req->rq_set = NULL;
+		ptlrpc_set_req_unlink(set, req);
 		ptlrpc_req_finished(req);
 	}
 
@@ -2719,10 +2719,14 @@ int sptlrpc_init(void)
 	if (rc)
 		goto out_conf;
 
-	rc = sptlrpc_null_init();
+	rc = sptlrpc_crypt_init();
 	if (rc)
 		goto out_pool;
 
+	rc = sptlrpc_null_init();
+	if (rc)
+		goto out_crypt;
+
 	rc = sptlrpc_plain_init();
 	if (rc)
 		goto out_null;
@@ -2737,6 +2741,8 @@ out_plain:
 	sptlrpc_plain_fini();
 out_null:
 	sptlrpc_null_fini();
+out_crypt:
+	sptlrpc_crypt_fini();
 out_pool:
 	sptlrpc_enc_pool_fini();
 out_conf:
@@ -2752,6 +2758,7 @@ void sptlrpc_fini(void)
 	sptlrpc_lproc_fini();
 	sptlrpc_plain_fini();
 	sptlrpc_null_fini();
+	sptlrpc_crypt_fini();
 	sptlrpc_enc_pool_fini();
 	sptlrpc_conf_fini();
 	sptlrpc_gc_fini();
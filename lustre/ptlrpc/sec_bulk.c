@@ -35,6 +35,7 @@
 
 #define DEBUG_SUBSYSTEM S_SEC
 
+#include <linux/workqueue.h>
 #include <libcfs/linux/linux-mem.h>
 
 #include <obd.h>
@@ -113,11 +114,56 @@ static struct ptlrpc_enc_page_pool {
 	struct page ***epp_pools;
 } page_pools;
 
+/*
+ * Per-CPT caches of free pages in front of the global pools. Pages put back
+ * by a service thread go to the cache of its CPT until it is full, and are
+ * taken from there by the next bulk of that CPT, so a steady encrypted bulk
+ * workload only takes its own CPT lock. Pages in the caches are counted in
+ * epp_total_pages but not in epp_free_pages. The caches are drained back to
+ * the global pools when these run short, and under memory pressure.
+ */
+static unsigned int enc_pool_cpt_pages = PTLRPC_MAX_BRW_PAGES * 2;
+module_param(enc_pool_cpt_pages, uint, 0444);
+MODULE_PARM_DESC(enc_pool_cpt_pages,
+		 "Free encoding pool pages cached per CPT (0 to disable)");
+
+struct enc_pool_cpt_cache {
+	spinlock_t	  epc_lock;
+	unsigned int	  epc_count;
+	struct page	**epc_pages;
+	unsigned long	  epc_st_hits;
+};
+
+static struct enc_pool_cpt_cache **enc_cpt_caches;
+
 /*
  * /proc/fs/lustre/sptlrpc/encrypt_page_pools
  */
+static unsigned long enc_pools_cached_pages(unsigned long *hits)
+{
+	struct enc_pool_cpt_cache *epc;
+	unsigned long count = 0;
+	int i;
+
+	if (hits)
+		*hits = 0;
+	if (enc_cpt_caches == NULL)
+		return 0;
+
+	cfs_percpt_for_each(epc, i, enc_cpt_caches) {
+		count += READ_ONCE(epc->epc_count);
+		if (hits)
+			*hits += READ_ONCE(epc->epc_st_hits);
+	}
+
+	return count;
+}
+
 int sptlrpc_proc_enc_pool_seq_show(struct seq_file *m, void *v)
 {
+	unsigned long cpt_hits;
+	unsigned long cpt_cached = enc_pools_cached_pages(&cpt_hits);
+
 	spin_lock(&page_pools.epp_lock);
 
 	seq_printf(m, "physical pages:          %lu\n"
@@ -126,6 +172,8 @@ int sptlrpc_proc_enc_pool_seq_show(struct seq_file *m, void *v)
 		   "max pools:               %u\n"
 		   "total pages:             %lu\n"
 		   "total free:              %lu\n"
+		   "cpt cached:              %lu\n"
+		   "cpt cache hits:          %lu\n"
 		   "idle index:              %lu/100\n"
 		   "last shrink:             %llds\n"
 		   "last access:             %llds\n"
@@ -143,7 +191,8 @@ int sptlrpc_proc_enc_pool_seq_show(struct seq_file *m, void *v)
 		   page_pools.epp_max_pages,
 		   page_pools.epp_max_pools,
 		   page_pools.epp_total_pages,
-		   page_pools.epp_free_pages,
+		   page_pools.epp_free_pages + cpt_cached,
+		   cpt_cached, cpt_hits,
 		   page_pools.epp_idle_idx,
 		   ktime_get_seconds() - page_pools.epp_last_shrink,
 		   ktime_get_seconds() - page_pools.epp_last_access,
@@ -162,6 +211,47 @@ int sptlrpc_proc_enc_pool_seq_show(struct seq_file *m, void *v)
 	return 0;
 }
 
+/* add one free page back to the global pools, caller holds epp_lock */
+static inline void enc_pools_push_page(struct page *page)
+{
+	int p_idx = page_pools.epp_free_pages / PAGES_PER_POOL;
+	int g_idx = page_pools.epp_free_pages % PAGES_PER_POOL;
+
+	LASSERT(page_pools.epp_free_pages < page_pools.epp_total_pages);
+	LASSERT(page_pools.epp_pools[p_idx]);
+	LASSERT(page_pools.epp_pools[p_idx][g_idx] == NULL);
+
+	page_pools.epp_pools[p_idx][g_idx] = page;
+	page_pools.epp_free_pages++;
+}
+
+/*
+ * move the pages of all per-CPT caches back to the global pools, caller
+ * holds epp_lock
+ */
+static unsigned long enc_pools_drain_caches(void)
+{
+	struct enc_pool_cpt_cache *epc;
+	unsigned long drained = 0;
+	int i;
+
+	if (enc_cpt_caches == NULL)
+		return 0;
+
+	cfs_percpt_for_each(epc, i, enc_cpt_caches) {
+		spin_lock(&epc->epc_lock);
+		while (epc->epc_count > 0) {
+			epc->epc_count--;
+			enc_pools_push_page(epc->epc_pages[epc->epc_count]);
+			epc->epc_pages[epc->epc_count] = NULL;
+			drained++;
+		}
+		spin_unlock(&epc->epc_lock);
+	}
+
+	return drained;
+}
+
 static void enc_pools_release_free_pages(long npages)
 {
 	int p_idx, g_idx;
@@ -213,6 +303,8 @@ static void enc_pools_release_free_pages(long npages)
 static unsigned long enc_pools_shrink_count(struct shrinker *s,
 					    struct shrink_control *sc)
 {
+	unsigned long free;
+
 	/*
 	 * if no pool access for a long time, we consider it's fully idle.
 	 * a little race here is fine.
@@ -225,8 +317,9 @@ static unsigned long enc_pools_shrink_count(struct shrinker *s,
 	}
 
 	LASSERT(page_pools.epp_idle_idx <= IDLE_IDX_MAX);
-	return (page_pools.epp_free_pages <= PTLRPC_MAX_BRW_PAGES) ? 0 :
-		(page_pools.epp_free_pages - PTLRPC_MAX_BRW_PAGES) *
+	free = page_pools.epp_free_pages + enc_pools_cached_pages(NULL);
+	return (free <= PTLRPC_MAX_BRW_PAGES) ? 0 :
+		(free - PTLRPC_MAX_BRW_PAGES) *
 		(IDLE_IDX_MAX - page_pools.epp_idle_idx) / IDLE_IDX_MAX;
 }
 
@@ -237,6 +330,8 @@ static unsigned long enc_pools_shrink_scan(struct shrinker *s,
 					   struct shrink_control *sc)
 {
 	spin_lock(&page_pools.epp_lock);
+	/* cached pages are only reclaimable from the global pools */
+	enc_pools_drain_caches();
 	if (page_pools.epp_free_pages <= PTLRPC_MAX_BRW_PAGES)
 		sc->nr_to_scan = 0;
 	else
@@ -512,7 +607,7 @@ static int enc_pools_should_grow(int page_needed, time64_t now)
  */
 int get_free_pages_in_pool(void)
 {
-	return page_pools.epp_free_pages;
+	return page_pools.epp_free_pages + enc_pools_cached_pages(NULL);
 }
 EXPORT_SYMBOL(get_free_pages_in_pool);
 
@@ -525,6 +620,58 @@ int pool_is_at_full_capacity(void)
 }
 EXPORT_SYMBOL(pool_is_at_full_capacity);
 
+/* take the pages of \a desc from the cache of the current CPT if it can */
+static bool enc_pools_get_cached(struct ptlrpc_bulk_desc *desc)
+{
+	struct enc_pool_cpt_cache *epc;
+	int i;
+
+	if (enc_cpt_caches == NULL)
+		return false;
+
+	epc = enc_cpt_caches[cfs_cpt_current(cfs_cpt_tab, 0)];
+	spin_lock(&epc->epc_lock);
+	if (epc->epc_count < desc->bd_iov_count) {
+		spin_unlock(&epc->epc_lock);
+		return false;
+	}
+
+	for (i = 0; i < desc->bd_iov_count; i++) {
+		epc->epc_count--;
+		desc->bd_enc_vec[i].bv_page = epc->epc_pages[epc->epc_count];
+		epc->epc_pages[epc->epc_count] = NULL;
+	}
+	epc->epc_st_hits++;
+	spin_unlock(&epc->epc_lock);
+
+	return true;
+}
+
+/*
+ * put as many pages of \a desc as fit in the cache of the current CPT,
+ * return how many were cached
+ */
+static int enc_pools_put_cached(struct ptlrpc_bulk_desc *desc)
+{
+	struct enc_pool_cpt_cache *epc;
+	int i;
+
+	/* waiters are woken up by pages returned to the global pools */
+	if (enc_cpt_caches == NULL || READ_ONCE(page_pools.epp_waitqlen) > 0)
+		return 0;
+
+	epc = enc_cpt_caches[cfs_cpt_current(cfs_cpt_tab, 0)];
+	spin_lock(&epc->epc_lock);
+	for (i = 0; i < desc->bd_iov_count &&
+		    epc->epc_count < enc_pool_cpt_pages; i++) {
+		LASSERT(desc->bd_enc_vec[i].bv_page);
+		epc->epc_pages[epc->epc_count++] = desc->bd_enc_vec[i].bv_page;
+	}
+	spin_unlock(&epc->epc_lock);
+
+	return i;
+}
+
 /*
  * we allocate the requested pages atomically.
  */
@@ -549,10 +696,17 @@ int sptlrpc_enc_pool_get_pages(struct ptlrpc_bulk_desc *desc)
 	if (desc->bd_enc_vec == NULL)
 		return -ENOMEM;
 
+	if (enc_pools_get_cached(desc))
+		return 0;
+
 	spin_lock(&page_pools.epp_lock);
 
 	page_pools.epp_st_access++;
 again:
+	if (unlikely(page_pools.epp_free_pages < desc->bd_iov_count) &&
+	    enc_pools_drain_caches() > 0)
+		goto again;
+
 	if (unlikely(page_pools.epp_free_pages < desc->bd_iov_count)) {
 		if (tick_ns == 0)
 			tick_ns = ktime_get_ns();
@@ -579,17 +733,24 @@ again:
 					page_pools.epp_st_max_wqlen =
 							page_pools.epp_waitqlen;
 
-				set_current_state(TASK_UNINTERRUPTIBLE);
-				init_wait(&waitlink);
-				add_wait_queue(&page_pools.epp_waitq,
-					       &waitlink);
-
-				spin_unlock(&page_pools.epp_lock);
-				schedule();
-				remove_wait_queue(&page_pools.epp_waitq,
-						  &waitlink);
+				/*
+				 * pages cached before epp_waitqlen was seen
+				 * by sptlrpc_enc_pool_put_pages() wake no
+				 * one, take them before going to sleep
+				 */
+				if (enc_pools_drain_caches() == 0) {
+					set_current_state(TASK_UNINTERRUPTIBLE);
+					init_wait(&waitlink);
+					add_wait_queue(&page_pools.epp_waitq,
+						       &waitlink);
+
+					spin_unlock(&page_pools.epp_lock);
+					schedule();
+					remove_wait_queue(&page_pools.epp_waitq,
+							  &waitlink);
+					spin_lock(&page_pools.epp_lock);
+				}
 				LASSERT(page_pools.epp_waitqlen > 0);
-				spin_lock(&page_pools.epp_lock);
 				page_pools.epp_waitqlen--;
 			} else {
 				/*
@@ -664,7 +825,6 @@ EXPORT_SYMBOL(sptlrpc_enc_pool_get_pages);
 
 void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc)
 {
-	int p_idx, g_idx;
 	int i;
 
 	if (desc->bd_enc_vec == NULL)
@@ -672,35 +832,38 @@ void sptlrpc_enc_pool_put_pages(struct ptlrpc_bulk_desc *desc)
 
 	LASSERT(desc->bd_iov_count > 0);
 
-	spin_lock(&page_pools.epp_lock);
+	i = enc_pools_put_cached(desc);
+	if (i == desc->bd_iov_count) {
+		/*
+		 * a waiter may have queued up after enc_pools_put_cached()
+		 * checked, hand it the cached pages. Either this sees its
+		 * epp_waitqlen, or it finds the pages when it drains the
+		 * caches before sleeping, the epc_lock orders the two.
+		 */
+		if (unlikely(READ_ONCE(page_pools.epp_waitqlen) > 0)) {
+			spin_lock(&page_pools.epp_lock);
+			enc_pools_drain_caches();
+			enc_pools_wakeup();
+			spin_unlock(&page_pools.epp_lock);
+		}
+		goto out;
+	}
 
-	p_idx = page_pools.epp_free_pages / PAGES_PER_POOL;
-	g_idx = page_pools.epp_free_pages % PAGES_PER_POOL;
+	spin_lock(&page_pools.epp_lock);
 
-	LASSERT(page_pools.epp_free_pages + desc->bd_iov_count <=
+	LASSERT(page_pools.epp_free_pages + desc->bd_iov_count - i <=
 		page_pools.epp_total_pages);
-	LASSERT(page_pools.epp_pools[p_idx]);
 
-	for (i = 0; i < desc->bd_iov_count; i++) {
+	for (; i < desc->bd_iov_count; i++) {
 		LASSERT(desc->bd_enc_vec[i].bv_page);
-		LASSERT(g_idx != 0 || page_pools.epp_pools[p_idx]);
-		LASSERT(page_pools.epp_pools[p_idx][g_idx] == NULL);
-
-		page_pools.epp_pools[p_idx][g_idx] =
-			desc->bd_enc_vec[i].bv_page;
-
-		if (++g_idx == PAGES_PER_POOL) {
-			p_idx++;
-			g_idx = 0;
-		}
+		enc_pools_push_page(desc->bd_enc_vec[i].bv_page);
 	}
 
-	page_pools.epp_free_pages += desc->bd_iov_count;
-
 	enc_pools_wakeup();
 
 	spin_unlock(&page_pools.epp_lock);
 
+out:
 	OBD_FREE_LARGE(desc->bd_enc_vec,
 		 desc->bd_iov_count * sizeof(*desc->bd_enc_vec));
 	desc->bd_enc_vec = NULL;
@@ -749,6 +912,52 @@ static inline void enc_pools_alloc(void)
 			sizeof(*page_pools.epp_pools));
 }
 
+static void enc_pools_cpt_caches_free(void)
+{
+	struct enc_pool_cpt_cache *epc;
+	int i;
+
+	if (enc_cpt_caches == NULL)
+		return;
+
+	cfs_percpt_for_each(epc, i, enc_cpt_caches) {
+		LASSERT(epc->epc_count == 0);
+		if (epc->epc_pages != NULL)
+			OBD_FREE_PTR_ARRAY_LARGE(epc->epc_pages,
+						 enc_pool_cpt_pages);
+	}
+	cfs_percpt_free(enc_cpt_caches);
+	enc_cpt_caches = NULL;
+}
+
+static void enc_pools_cpt_caches_alloc(void)
+{
+	struct enc_pool_cpt_cache *epc;
+	int i;
+
+	if (enc_pool_cpt_pages == 0)
+		return;
+
+	enc_cpt_caches = cfs_percpt_alloc(cfs_cpt_tab, sizeof(*epc));
+	if (enc_cpt_caches == NULL)
+		goto fail;
+
+	cfs_percpt_for_each(epc, i, enc_cpt_caches) {
+		spin_lock_init(&epc->epc_lock);
+		OBD_CPT_ALLOC_LARGE(epc->epc_pages, cfs_cpt_tab, i,
+				    enc_pool_cpt_pages *
+				    sizeof(*epc->epc_pages));
+		if (epc->epc_pages == NULL)
+			goto fail;
+	}
+	return;
+
+fail:
+	/* the global pools still work without the caches */
+	CWARN("cannot allocate per-CPT encoding pool caches\n");
+	enc_pools_cpt_caches_free();
+}
+
 static inline void enc_pools_free(void)
 {
 	LASSERT(page_pools.epp_max_pools);
@@ -799,9 +1008,13 @@ int sptlrpc_enc_pool_init(void)
 	if (page_pools.epp_pools == NULL)
 		return -ENOMEM;
 
+	enc_pools_cpt_caches_alloc();
+
 	rc = register_shrinker(&pools_shrinker);
-	if (rc)
+	if (rc) {
+		enc_pools_cpt_caches_free();
 		enc_pools_free();
+	}
 
 	return rc;
 }
@@ -811,10 +1024,16 @@ void sptlrpc_enc_pool_fini(void)
 	unsigned long cleaned, npools;
 
 	LASSERT(page_pools.epp_pools);
-	LASSERT(page_pools.epp_total_pages == page_pools.epp_free_pages);
 
 	unregister_shrinker(&pools_shrinker);
 
+	spin_lock(&page_pools.epp_lock);
+	enc_pools_drain_caches();
+	spin_unlock(&page_pools.epp_lock);
+	enc_pools_cpt_caches_free();
+
+	LASSERT(page_pools.epp_total_pages == page_pools.epp_free_pages);
+
 	npools = npages_to_npools(page_pools.epp_total_pages);
 	cleaned = enc_pools_cleanup(page_pools.epp_pools, npools);
 	LASSERT(cleaned == page_pools.epp_total_pages);
@@ -833,6 +1052,144 @@ void sptlrpc_enc_pool_fini(void)
 	}
 }
 
+/*
+ * parallel processing of bulk pages
+ *
+ * The pages of a bulk are split in chunks, and all chunks but the first
+ * one are handed over to per-CPT workqueues. The calling thread processes
+ * the first chunk itself, then waits for the workers. This is used by the
+ * encryption of file pages in the OSC and of bulk data by GSS mechanisms.
+ */
+static struct workqueue_struct **sptlrpc_crypt_wqs;
+static int sptlrpc_crypt_ncpts;
+
+struct sptlrpc_crypt_batch {
+	sptlrpc_crypt_chunk_t	 scb_fn;
+	void			*scb_data;
+	atomic_t		 scb_pending;
+	struct completion	 scb_done;
+};
+
+struct sptlrpc_crypt_work {
+	struct work_struct		 scw_work;
+	struct sptlrpc_crypt_batch	*scw_batch;
+	u32				 scw_first;
+	u32				 scw_count;
+	int				 scw_rc;
+};
+
+static void sptlrpc_crypt_work_handler(struct work_struct *work)
+{
+	struct sptlrpc_crypt_work *scw;
+	struct sptlrpc_crypt_batch *scb;
+
+	scw = container_of(work, struct sptlrpc_crypt_work, scw_work);
+	scb = scw->scw_batch;
+	scw->scw_rc = scb->scb_fn(scb->scb_data, scw->scw_first,
+				  scw->scw_count);
+	if (atomic_dec_and_test(&scb->scb_pending))
+		complete(&scb->scb_done);
+}
+
+/**
+ * Call \a fn on each chunk of \a chunk pages out of \a count, in parallel.
+ *
+ * Every page is passed to exactly one call of \a fn. All pages are passed
+ * to a single call in the calling thread if \a chunk is 0 or not less than
+ * \a count, under memory pressure, as the workers may have to allocate
+ * pages as well, or if the work items cannot be allocated.
+ *
+ * \retval 0		success
+ * \retval other	value returned by \a fn for the first failed chunk
+ */
+int sptlrpc_crypt_parallel(sptlrpc_crypt_chunk_t fn, void *data, u32 count,
+			   unsigned int chunk)
+{
+	struct sptlrpc_crypt_batch scb = {
+		.scb_fn		= fn,
+		.scb_data	= data,
+	};
+	struct sptlrpc_crypt_work *works;
+	u32 nworks;
+	u32 i;
+	int cpt;
+	int rc;
+
+	if (chunk == 0 || count <= chunk || sptlrpc_crypt_wqs == NULL ||
+	    current->flags & PF_MEMALLOC)
+		return fn(data, 0, count);
+
+	nworks = DIV_ROUND_UP(count, chunk) - 1;
+	OBD_ALLOC_PTR_ARRAY(works, nworks);
+	if (works == NULL)
+		return fn(data, 0, count);
+
+	atomic_set(&scb.scb_pending, nworks);
+	init_completion(&scb.scb_done);
+
+	cpt = cfs_cpt_current(cfs_cpt_tab, 0);
+	for (i = 0; i < nworks; i++) {
+		struct sptlrpc_crypt_work *scw = &works[i];
+
+		scw->scw_batch = &scb;
+		scw->scw_first = (i + 1) * chunk;
+		scw->scw_count = min_t(u32, chunk, count - scw->scw_first);
+		INIT_WORK(&scw->scw_work, sptlrpc_crypt_work_handler);
+		queue_work(sptlrpc_crypt_wqs[cpt], &scw->scw_work);
+		cpt = (cpt + 1) % sptlrpc_crypt_ncpts;
+	}
+
+	rc = fn(data, 0, chunk);
+	wait_for_completion(&scb.scb_done);
+
+	for (i = 0; i < nworks && rc == 0; i++)
+		rc = works[i].scw_rc;
+
+	OBD_FREE_PTR_ARRAY(works, nworks);
+
+	return rc;
+}
+EXPORT_SYMBOL(sptlrpc_crypt_parallel);
+
+void sptlrpc_crypt_fini(void)
+{
+	int i;
+
+	if (sptlrpc_crypt_wqs == NULL)
+		return;
+
+	for (i = 0; i < sptlrpc_crypt_ncpts; i++) {
+		if (sptlrpc_crypt_wqs[i] != NULL)
+			destroy_workqueue(sptlrpc_crypt_wqs[i]);
+	}
+	OBD_FREE_PTR_ARRAY(sptlrpc_crypt_wqs, sptlrpc_crypt_ncpts);
+	sptlrpc_crypt_wqs = NULL;
+}
+
+int sptlrpc_crypt_init(void)
+{
+	struct workqueue_struct *wq;
+	int i;
+
+	sptlrpc_crypt_ncpts = cfs_cpt_number(cfs_cpt_tab);
+	OBD_ALLOC_PTR_ARRAY(sptlrpc_crypt_wqs, sptlrpc_crypt_ncpts);
+	if (sptlrpc_crypt_wqs == NULL)
+		return -ENOMEM;
+
+	for (i = 0; i < sptlrpc_crypt_ncpts; i++) {
+		/* client writeback of encrypted pages goes through these */
+		wq = cfs_cpt_bind_workqueue("sptlrpc_crypt", cfs_cpt_tab,
+					    WQ_MEM_RECLAIM, i,
+					    cfs_cpt_weight(cfs_cpt_tab, i));
+		if (IS_ERR(wq)) {
+			sptlrpc_crypt_fini();
+			return PTR_ERR(wq);
+		}
+		sptlrpc_crypt_wqs[i] = wq;
+	}
+
+	return 0;
+}
 
 static int cfs_hash_alg_id[] = {
 	[BULK_HASH_ALG_NULL]	= CFS_HASH_ALG_NULL,
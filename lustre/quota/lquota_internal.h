@@ -147,6 +147,14 @@ struct lquota_slv_entry {
 
 	/* when latest edquot set */
 	time64_t		lse_edquot_time;
+
+	/* per-CPU slices of quota space carved out of lse_pending_write once
+	 * the ID gets hot, consumed locklessly by qsd_op_begin(). NULL until
+	 * lse_acq_count reaches QSD_PCPU_RESV_HOT. */
+	atomic64_t __percpu	*lse_pcpu_resv;
+
+	/* number of acquisitions done through the locked path */
+	unsigned int		lse_acq_count;
 };
 
 /* In-memory entry for each enforced quota id
@@ -258,6 +266,8 @@ struct lquota_site {
 #define lqe_acq_rc		u.se.lse_acq_rc
 #define lqe_acq_time		u.se.lse_acq_time
 #define lqe_edquot_time		u.se.lse_edquot_time
+#define lqe_pcpu_resv		u.se.lse_pcpu_resv
+#define lqe_acq_count		u.se.lse_acq_count
 
 #define LQUOTA_BUMP_VER 0x1
 #define LQUOTA_SET_VER  0x2
@@ -275,8 +285,11 @@ static inline void lqe_putref(struct lquota_entry *lqe)
 {
 	LASSERT(lqe != NULL);
 	LASSERT(atomic_read(&lqe->lqe_ref) > 0);
-	if (atomic_dec_and_test(&lqe->lqe_ref))
+	if (atomic_dec_and_test(&lqe->lqe_ref)) {
+		if (!lqe->lqe_site->lqs_is_mst && lqe->lqe_pcpu_resv != NULL)
+			free_percpu(lqe->lqe_pcpu_resv);
 		OBD_SLAB_FREE_PTR(lqe, lqe_kmem);
+	}
 }
 
 static inline int lqe_is_master(struct lquota_entry *lqe)
@@ -50,6 +50,8 @@ static void qsd_lqe_init(struct lquota_entry *lqe, void *arg)
 	init_waitqueue_head(&lqe->lqe_waiters);
 	lqe->lqe_usage    = 0;
 	lqe->lqe_nopreacq = false;
+	lqe->lqe_pcpu_resv = NULL;
+	lqe->lqe_acq_count = 0;
 	mutex_init(&lqe->lqe_glbl_data_lock);
 }
 
@@ -347,6 +349,14 @@ int qsd_update_lqe(const struct lu_env *env, struct lquota_entry *lqe,
 	LASSERT(lqe != NULL);
 	LASSERT(!lqe_is_master(lqe));
 
+	/* limits or granted space are about to change, per-CPU reserved
+	 * slices must be returned before */
+	if (lqe->lqe_pcpu_resv != NULL) {
+		lqe_write_lock(lqe);
+		qsd_pcpu_resv_drain(lqe);
+		lqe_write_unlock(lqe);
+	}
+
 	/* updating lqe is always serialized, no locking needed. */
 	if (global) {
 		struct lquota_glb_rec *glb_rec = (struct lquota_glb_rec *)rec;
@@ -427,6 +427,115 @@ out_noadjust:
 	EXIT;
 }
 
+/**
+ * Top up the per-CPU slice of the current CPU from the spare quota space
+ * locally granted to \a lqe. The slice is accounted in lqe_pending_write
+ * so that the locked path never hands out the same space twice.
+ * Called with the lqe write lock held.
+ *
+ * Slices are only handed out when the entry is far from its limit: at most
+ * half of the spare space is spread over the online CPUs and a slice never
+ * exceeds qunit >> QSD_PCPU_RESV_SHIFT.
+ */
+static void qsd_pcpu_resv_refill(struct lquota_entry *lqe)
+{
+	atomic64_t	*avail;
+	__u64		 used, spare, slice;
+	s64		 cur;
+
+	if (lqe->lqe_pcpu_resv == NULL || lqe->lqe_edquot ||
+	    lqe->lqe_qunit == 0 || !lustre_handle_is_used(&lqe->lqe_lockh))
+		return;
+
+	used = lqe->lqe_usage + lqe->lqe_pending_write +
+	       lqe->lqe_waiting_write + lqe->lqe_pending_rel;
+	if (used >= lqe->lqe_granted)
+		return;
+	spare = lqe->lqe_granted - used;
+
+	slice = min_t(__u64, lqe->lqe_qunit >> QSD_PCPU_RESV_SHIFT,
+		      spare / (2 * num_online_cpus()));
+
+	/* preemption is disabled by the lqe spinlock */
+	avail = this_cpu_ptr(lqe->lqe_pcpu_resv);
+	cur = atomic64_read(avail);
+	if (cur >= slice)
+		return;
+
+	atomic64_add(slice - cur, avail);
+	lqe->lqe_pending_write += slice - cur;
+}
+
+/**
+ * Lockless fast path of qsd_op_begin0(): try to consume \a space from the
+ * slice reserved for the current CPU.
+ *
+ * \retval true  - \a space was taken from the per-CPU slice
+ * \retval false - not enough space reserved, the locked path must be used
+ */
+static bool qsd_pcpu_resv_get(struct lquota_entry *lqe, __u64 space)
+{
+	atomic64_t __percpu	*resv = READ_ONCE(lqe->lqe_pcpu_resv);
+	atomic64_t		*avail;
+	s64			 old, prev;
+	bool			 found = false;
+
+	if (resv == NULL)
+		return false;
+
+	/* qsd_pcpu_resv_drain() can zero the slice from any CPU at any time,
+	 * hence the cmpxchg loop */
+	avail = get_cpu_ptr(resv);
+	old = atomic64_read(avail);
+	while (old >= (s64)space) {
+		prev = atomic64_cmpxchg(avail, old, old - space);
+		if (prev == old) {
+			found = true;
+			break;
+		}
+		old = prev;
+	}
+	put_cpu_ptr(resv);
+
+	return found;
+}
+
+/**
+ * Set up per-CPU reservations for \a lqe once it has gone through the locked
+ * path QSD_PCPU_RESV_HOT times.
+ */
+static void qsd_pcpu_resv_setup(struct lquota_entry *lqe)
+{
+	atomic64_t __percpu *resv;
+	bool hot;
+
+	if (READ_ONCE(lqe->lqe_pcpu_resv) != NULL)
+		return;
+
+	/* lqe_acq_count is bumped by concurrent acquires */
+	lqe_write_lock(lqe);
+	hot = lqe->lqe_pcpu_resv == NULL &&
+	      ++lqe->lqe_acq_count >= QSD_PCPU_RESV_HOT;
+	lqe_write_unlock(lqe);
+	if (!hot)
+		return;
+
+	resv = alloc_percpu(atomic64_t);
+	if (resv == NULL)
+		return;
+
+	lqe_write_lock(lqe);
+	if (lqe->lqe_pcpu_resv == NULL) {
+		lqe->lqe_pcpu_resv = resv;
+		resv = NULL;
+		LQUOTA_DEBUG(lqe, "hot ID, enabling per-CPU reservation");
+	}
+	lqe_write_unlock(lqe);
+
+	if (resv != NULL)
+		free_percpu(resv);
+}
+
 /**
  * Try to consume local quota space.
  *
@@ -453,10 +562,18 @@ static int qsd_acquire_local(struct lquota_entry *lqe, __u64 space)
 	/* take pending write into account */
 	usage += lqe->lqe_pending_write;
 
+	if (space + usage > lqe->lqe_granted - lqe->lqe_pending_rel &&
+	    lqe->lqe_pcpu_resv != NULL) {
+		/* close to the limit, take back the per-CPU slices */
+		qsd_pcpu_resv_drain(lqe);
+		usage = lqe->lqe_usage + lqe->lqe_pending_write;
+	}
+
 	if (space + usage <= lqe->lqe_granted - lqe->lqe_pending_rel) {
 		/* Yay! we got enough space */
 		lqe->lqe_pending_write += space;
 		lqe->lqe_waiting_write -= space;
+		qsd_pcpu_resv_refill(lqe);
 		rc = 0;
 	/* lqe_edquot flag is used to avoid flooding dqacq requests when
 	 * the user is over quota, however, the lqe_edquot could be stale
@@ -740,6 +857,17 @@ static int qsd_op_begin0(const struct lu_env *env, struct qsd_qtype_info *qqi,
 		RETURN(0);
 	}
 
+	/* fast path: consume space reserved for this CPU without taking the
+	 * lqe lock. The flags don't need to be computed under the lock either
+	 * since slices are only handed out far from the limit. */
+	if (qqi->qqi_qsd->qsd_pcpu_resv && !lqe->lqe_edquot &&
+	    qsd_pcpu_resv_get(lqe, space)) {
+		qid->lqi_space += space;
+		if (local_flags != NULL)
+			*local_flags &= ~lquota_over_fl(qqi->qqi_qtype);
+		RETURN(0);
+	}
+
 	LQUOTA_DEBUG(lqe, "op_begin space:%lld", space);
 
 	lqe_write_lock(lqe);
@@ -755,6 +883,8 @@ static int qsd_op_begin0(const struct lu_env *env, struct qsd_qtype_info *qqi,
 	if (rc > 0 && ret == 0) {
 		qid->lqi_space += space;
 		rc = 0;
+		if (qqi->qqi_qsd->qsd_pcpu_resv)
+			qsd_pcpu_resv_setup(lqe);
 	} else {
 		if (rc > 0)
 			rc = ret;
@@ -955,6 +1085,12 @@ int qsd_adjust(const struct lu_env *env, struct lquota_entry *lqe)
 
 	lqe_write_lock(lqe);
 
+	/* don't hold reserved space for an ID which isn't enforced any more,
+	 * for which the per-ID lock is gone or once the fast path is off */
+	if (!lqe->lqe_enforced || !lustre_handle_is_used(&lqe->lqe_lockh) ||
+	    !qsd->qsd_pcpu_resv)
+		qsd_pcpu_resv_drain(lqe);
+
 	/* fill qb_count & qb_flags */
 	if (!qsd_calc_adjust(lqe, qbody)) {
 		lqe_write_unlock(lqe);
@@ -113,7 +113,8 @@ struct qsd_instance {
 				qsd_exp_valid:1,/* qsd_exp is now valid */
 				qsd_stopping:1, /* qsd_instance is stopping */
 				qsd_updating:1, /* qsd is updating record */
-				qsd_exclusive:1; /* upd exclusive with reint */
+				qsd_exclusive:1, /* upd exclusive with reint */
+				qsd_pcpu_resv:1; /* per-CPU reservation enabled */
 
 };
 
@@ -286,12 +287,43 @@ static inline int qsd_type_enabled(struct qsd_instance *qsd, int type)
 	return enabled & BIT(type);
 }
 
+/* number of locked acquisitions after which an ID is considered hot and gets
+ * per-CPU reservations */
+#define QSD_PCPU_RESV_HOT	64
+/* a per-CPU slice never exceeds 1/16th of qunit */
+#define QSD_PCPU_RESV_SHIFT	4
+
+/* Give back all the per-CPU reserved slices of \a lqe to lqe_pending_write.
+ * Called with the lqe write lock held whenever the entry gets close to its
+ * limit or the space distribution changes, so that the locked path sees the
+ * real amount of spare quota space. */
+static inline void qsd_pcpu_resv_drain(struct lquota_entry *lqe)
+{
+	__u64	space = 0;
+	int	cpu;
+
+	if (lqe->lqe_pcpu_resv == NULL)
+		return;
+
+	for_each_possible_cpu(cpu)
+		space += atomic64_xchg(per_cpu_ptr(lqe->lqe_pcpu_resv, cpu), 0);
+
+	if (space == 0)
+		return;
+
+	LASSERT(lqe->lqe_pending_write >= space);
+	lqe->lqe_pending_write -= space;
+	LQUOTA_DEBUG(lqe, "drained %llu of per-CPU reserved space", space);
+}
+
 /* helper function to set new qunit and compute associated qtune value */
 static inline void qsd_set_qunit(struct lquota_entry *lqe, __u64 qunit)
 {
 	if (lqe->lqe_qunit == qunit)
 		return;
 
+	/* slices were sized after the old qunit */
+	qsd_pcpu_resv_drain(lqe);
 	lqe->lqe_qunit = qunit;
 
 	/* With very large qunit support, we can't afford to have a static
@@ -319,8 +351,10 @@ static inline void qsd_set_qunit(struct lquota_entry *lqe, __u64 qunit)
 static inline void qsd_set_edquot(struct lquota_entry *lqe, bool edquot)
 {
 	lqe->lqe_edquot = edquot;
-	if (edquot)
+	if (edquot) {
 		lqe->lqe_edquot_time = ktime_get_seconds();
+		qsd_pcpu_resv_drain(lqe);
+	}
 }
 
 #define QSD_WB_INTERVAL	60 /* 60 seconds */
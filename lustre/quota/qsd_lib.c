@@ -267,6 +267,36 @@ qsd_timeout_seq_write(struct file *file, const char __user *buffer,
 }
 LPROC_SEQ_FOPS(qsd_timeout);
 
+static int qsd_pcpu_resv_seq_show(struct seq_file *m, void *data)
+{
+	struct qsd_instance *qsd = m->private;
+	LASSERT(qsd != NULL);
+
+	seq_printf(m, "%d\n", qsd->qsd_pcpu_resv);
+	return 0;
+}
+
+/* enable/disable the per-CPU quota reservation fast path of qsd_op_begin().
+ * Slices already reserved are given back on the next space adjustment */
+static ssize_t
+qsd_pcpu_resv_seq_write(struct file *file, const char __user *buffer,
+			size_t count, loff_t *off)
+{
+	struct seq_file *m = file->private_data;
+	struct qsd_instance *qsd = m->private;
+	bool val;
+	int rc;
+
+	LASSERT(qsd != NULL);
+	rc = kstrtobool_from_user(buffer, count, &val);
+	if (rc)
+		return rc;
+
+	qsd->qsd_pcpu_resv = val;
+	return count;
+}
+LPROC_SEQ_FOPS(qsd_pcpu_resv);
+
 static struct lprocfs_vars lprocfs_quota_qsd_vars[] = {
 	{ .name	=	"info",
 	  .fops	=	&qsd_state_fops		},
@@ -276,6 +306,8 @@ static struct lprocfs_vars lprocfs_quota_qsd_vars[] = {
 	  .fops	=	&qsd_force_reint_fops	},
 	{ .name	=	"timeout",
 	  .fops	=	&qsd_timeout_fops	},
+	{ .name	=	"per_cpu_resv",
+	  .fops	=	&qsd_pcpu_resv_fops	},
 	{ NULL }
 };
 
@@ -680,6 +712,7 @@ struct qsd_instance *qsd_init(const struct lu_env *env, char *svname,
 	qsd->qsd_is_md = is_md;
 	qsd->qsd_updating = false;
 	qsd->qsd_exclusive = excl;
+	qsd->qsd_pcpu_resv = true;
 
 	/* copy service name */
 	if (strlcpy(qsd->qsd_svname, svname, sizeof(qsd->qsd_svname))
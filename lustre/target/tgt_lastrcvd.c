@@ -69,40 +69,127 @@ static int tgt_bitmap_chunk_alloc(struct lu_target *lut, int chunk)
 	return 0;
 }
 
-/* Look for an available reply data slot in the bitmap
- * of the target @lut
- * Allocate bitmap chunk when first used
- * XXX algo could be improved if this routine limits performance
+/* Reserve up to @count available reply data slots in the bitmap of the
+ * target @lut, starting from the lowest slot which may be free.
+ * Allocate bitmap chunk when first used, once all the allocated chunks
+ * are full.
+ * Slots are taken in a run, so that the reply data of the RPCs using them
+ * are written to the same reply_data blocks.
+ * Return the number of slots put in @slots, or a negative error.
  */
-static int tgt_find_free_reply_slot(struct lu_target *lut)
+static int tgt_reserve_reply_slots(struct lu_target *lut, int *slots,
+				   int count, struct tgt_reply_slot_cache *st)
 {
 	unsigned long *bmp;
-	int chunk = 0;
-	int rc;
+	int start = READ_ONCE(lut->lut_reply_hint);
+	int nr = 0;
+	int chunk;
+	int rc = 0;
 	int b;
 
-	for (chunk = 0; chunk < LUT_REPLY_SLOTS_MAX_CHUNKS; chunk++) {
+again:
+	for (chunk = start / LUT_REPLY_SLOTS_PER_CHUNK;
+	     chunk < LUT_REPLY_SLOTS_MAX_CHUNKS && nr < count; chunk++) {
 		/* allocate the bitmap chunk if necessary */
 		if (unlikely(lut->lut_reply_bitmap[chunk] == NULL)) {
+			/* slots below the hint may have been freed */
+			if (start != 0 && nr == 0) {
+				start = 0;
+				goto again;
+			}
 			rc = tgt_bitmap_chunk_alloc(lut, chunk);
 			if (rc != 0)
-				return rc;
+				break;
 		}
 		bmp = lut->lut_reply_bitmap[chunk];
 
-		/* look for an available slot in this chunk */
-		do {
-			b = find_first_zero_bit(bmp, LUT_REPLY_SLOTS_PER_CHUNK);
-			if (b >= LUT_REPLY_SLOTS_PER_CHUNK)
+		/* look for available slots in this chunk */
+		b = chunk == start / LUT_REPLY_SLOTS_PER_CHUNK ?
+		    start % LUT_REPLY_SLOTS_PER_CHUNK : 0;
+		while (nr < count) {
+			int next;
+
+			next = find_next_zero_bit(bmp, LUT_REPLY_SLOTS_PER_CHUNK,
+						  b);
+			st->rsc_scanned += next - b;
+			if (next >= LUT_REPLY_SLOTS_PER_CHUNK)
 				break;
 
 			/* found one */
-			if (test_and_set_bit(b, bmp) == 0)
-				return chunk * LUT_REPLY_SLOTS_PER_CHUNK + b;
-		} while (true);
+			if (test_and_set_bit(next, bmp) == 0)
+				slots[nr++] = chunk * LUT_REPLY_SLOTS_PER_CHUNK +
+					      next;
+			else
+				st->rsc_race++;
+			b = next + 1;
+		}
+	}
+
+	if (nr == 0 && rc == 0 && start != 0) {
+		start = 0;
+		goto again;
 	}
 
-	return -ENOSPC;
+	if (nr > 0)
+		WRITE_ONCE(lut->lut_reply_hint, slots[nr - 1] + 1);
+	else if (rc == 0)
+		rc = -ENOSPC;
+
+	return nr > 0 ? nr : rc;
+}
+
+static void tgt_release_reply_slot(struct lu_target *lut, int idx)
+{
+	int chunk = idx / LUT_REPLY_SLOTS_PER_CHUNK;
+	int b = idx % LUT_REPLY_SLOTS_PER_CHUNK;
+
+	clear_bit(b, lut->lut_reply_bitmap[chunk]);
+	if (idx < READ_ONCE(lut->lut_reply_hint))
+		WRITE_ONCE(lut->lut_reply_hint, idx);
+}
+
+/* Look for an available reply data slot for the target @lut
+ * Slots are taken from the per-CPU cache first, which is refilled from the
+ * bitmap with a run of slots when empty.
+ */
+static int tgt_find_free_reply_slot(struct lu_target *lut)
+{
+	struct tgt_reply_slot_cache *cache;
+	struct tgt_reply_slot_cache st = { 0 };
+	int slots[LUT_REPLY_SLOTS_BATCH];
+	int idx = -1;
+	int nr;
+	int i;
+
+	cache = get_cpu_ptr(lut->lut_reply_cache);
+	cache->rsc_alloc++;
+	if (cache->rsc_count > 0) {
+		idx = cache->rsc_slots[--cache->rsc_count];
+		cache->rsc_hit++;
+	}
+	put_cpu_ptr(lut->lut_reply_cache);
+	if (idx >= 0)
+		return idx;
+
+	/* the bitmap chunk allocation may sleep, search with preemption
+	 * enabled */
+	nr = tgt_reserve_reply_slots(lut, slots, ARRAY_SIZE(slots), &st);
+
+	cache = get_cpu_ptr(lut->lut_reply_cache);
+	cache->rsc_search++;
+	cache->rsc_scanned += st.rsc_scanned;
+	cache->rsc_race += st.rsc_race;
+	/* keep the rest of the run for the next RPCs, lowest slot first */
+	for (i = nr - 1; i > 0 && cache->rsc_count < LUT_REPLY_SLOTS_BATCH;
+	     i--)
+		cache->rsc_slots[cache->rsc_count++] = slots[i];
+	put_cpu_ptr(lut->lut_reply_cache);
+
+	/* the cache of this CPU was refilled meanwhile */
+	for (; i > 0; i--)
+		tgt_release_reply_slot(lut, slots[i]);
+
+	return nr > 0 ? slots[0] : nr;
 }
 
 /* Mark the reply data slot @idx 'used' in the corresponding bitmap chunk
@@ -144,6 +231,7 @@ static int tgt_set_reply_slot(struct lu_target *lut, int idx)
  */
 static int tgt_clear_reply_slot(struct lu_target *lut, int idx)
 {
+	struct tgt_reply_slot_cache *cache;
 	int chunk;
 	int b;
 
@@ -166,12 +254,24 @@ static int tgt_clear_reply_slot(struct lu_target *lut, int idx)
 		return -ENOENT;
 	}
 
-	if (test_and_clear_bit(b, lut->lut_reply_bitmap[chunk]) == 0) {
+	if (test_bit(b, lut->lut_reply_bitmap[chunk]) == 0) {
 		CERROR("%s: slot %d already clear in bitmap\n",
 		       tgt_name(lut), idx);
 		return -EALREADY;
 	}
 
+	/* keep the slot in the per-CPU cache if there is room, else give it
+	 * back to the bitmap */
+	cache = get_cpu_ptr(lut->lut_reply_cache);
+	if (cache->rsc_count < LUT_REPLY_SLOTS_BATCH) {
+		cache->rsc_slots[cache->rsc_count++] = idx;
+		idx = -1;
+	}
+	put_cpu_ptr(lut->lut_reply_cache);
+
+	if (idx >= 0)
+		tgt_release_reply_slot(lut, idx);
+
 	return 0;
 }
 
@@ -245,7 +245,50 @@ static struct lustre_attr tgt_fmd_count_compat = __ATTR(client_cache_count,
 static struct lustre_attr tgt_fmd_seconds_compat = __ATTR(client_cache_seconds,
 			0644, tgt_fmd_seconds_show, tgt_fmd_seconds_store);
 
+/**
+ * Show reply data slot allocation statistics.
+ *
+ * \param[in] kobj	kobject
+ * \param[in] attr	attribute to show
+ * \param[in] buf	buffer for data
+ *
+ * \retval		0 and buffer filled with data on success
+ * \retval		negative value on error
+ */
+static ssize_t reply_slot_stats_show(struct kobject *kobj,
+				     struct attribute *attr, char *buf)
+{
+	struct obd_device *obd = container_of(kobj, struct obd_device,
+					      obd_kset.kobj);
+	struct lu_target *lut = obd->u.obt.obt_lut;
+	struct tgt_reply_slot_cache sum = { 0 };
+	int cpu;
+
+	if (lut->lut_reply_cache == NULL)
+		return -ENODATA;
+
+	for_each_possible_cpu(cpu) {
+		struct tgt_reply_slot_cache *cache;
+
+		cache = per_cpu_ptr(lut->lut_reply_cache, cpu);
+		sum.rsc_count += cache->rsc_count;
+		sum.rsc_alloc += cache->rsc_alloc;
+		sum.rsc_hit += cache->rsc_hit;
+		sum.rsc_search += cache->rsc_search;
+		sum.rsc_scanned += cache->rsc_scanned;
+		sum.rsc_race += cache->rsc_race;
+	}
+
+	return scnprintf(buf, PAGE_SIZE,
+			 "allocated: %llu\ncache_hits: %llu\ncached: %d\n"
+			 "searches: %llu\nbits_scanned: %llu\nraces: %llu\n",
+			 sum.rsc_alloc, sum.rsc_hit, sum.rsc_count,
+			 sum.rsc_search, sum.rsc_scanned, sum.rsc_race);
+}
+LUSTRE_RO_ATTR(reply_slot_stats);
+
 static const struct attribute *tgt_attrs[] = {
+	&lustre_attr_reply_slot_stats.attr,
 	&lustre_attr_sync_lock_cancel.attr,
 	&lustre_attr_tgt_fmd_count.attr,
 	&lustre_attr_tgt_fmd_seconds.attr,
@@ -492,6 +535,7 @@ int tgt_init(const struct lu_env *env, struct lu_target *lut,
 	atomic_set(&lut->lut_client_generation, 0);
 	lut->lut_reply_data = NULL;
 	lut->lut_reply_bitmap = NULL;
+	lut->lut_reply_cache = NULL;
 	obd->u.obt.obt_lut = lut;
 	obd->u.obt.obt_magic = OBT_MAGIC;
 
@@ -600,6 +644,11 @@ int tgt_init(const struct lu_env *env, struct lu_target *lut,
 	if (lut->lut_reply_bitmap == NULL)
 		GOTO(out, rc = -ENOMEM);
 
+	lut->lut_reply_cache = alloc_percpu(struct tgt_reply_slot_cache);
+	if (lut->lut_reply_cache == NULL)
+		GOTO(out, rc = -ENOMEM);
+	lut->lut_reply_hint = 0;
+
 	memset(&attr, 0, sizeof(attr));
 	attr.la_valid = LA_MODE;
 	attr.la_mode = S_IFREG | S_IRUGO | S_IWUSR;
@@ -649,6 +698,9 @@ out_put:
 			 LUT_REPLY_SLOTS_MAX_CHUNKS * sizeof(unsigned long *));
 	}
 	lut->lut_reply_bitmap = NULL;
+	if (lut->lut_reply_cache != NULL)
+		free_percpu(lut->lut_reply_cache);
+	lut->lut_reply_cache = NULL;
 	return rc;
 }
 EXPORT_SYMBOL(tgt_init);
@@ -688,6 +740,9 @@ void tgt_fini(const struct lu_env *env, struct lu_target *lut)
 			 LUT_REPLY_SLOTS_MAX_CHUNKS * sizeof(unsigned long *));
 	}
 	lut->lut_reply_bitmap = NULL;
+	if (lut->lut_reply_cache != NULL)
+		free_percpu(lut->lut_reply_cache);
+	lut->lut_reply_cache = NULL;
 	if (lut->lut_client_bitmap) {
 		OBD_FREE(lut->lut_client_bitmap, LR_MAX_CLIENTS >> 3);
 		lut->lut_client_bitmap = NULL;
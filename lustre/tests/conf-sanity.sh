@@ -10029,6 +10029,125 @@ test_133() {
 }
 run_test 133 "stripe QOS: free space balance in a pool"
 
+test_134() {
+	local param=/sys/module/osc/parameters/osc_lazy_connect
+	local imp="osc.$FSNAME-OST0000-osc-[^M]*.import"
+	local clients=${CLIENTS:-$HOSTNAME}
+	local client
+	local state
+
+	do_nodes $clients "[[ -f $param ]]" ||
+		skip "osc_lazy_connect not supported on all clients"
+
+	setup
+	stack_trap "do_nodes $clients 'echo N > $param'; cleanup"
+	zconf_umount_clients $clients $MOUNT || error "umount failed"
+
+	do_nodes $clients "echo Y > $param" || error "cannot set $param"
+	zconf_mount_clients $clients $MOUNT || error "mount failed"
+
+	do_nodes $clients "$LCTL get_param llite.*.mount_stats" ||
+		error "no mount_stats"
+
+	for client in ${clients//,/ }; do
+		state=$(do_node $client "$LCTL get_param -n $imp" |
+			awk '/state:/ { print $2; exit }')
+		[[ "$state" == "IDLE" ]] ||
+			error "$client: OST0000 import state $state, expected IDLE"
+	done
+
+	# statfs checks the OST export connect flags before any OST RPC
+	do_nodes $clients "$LFS df $MOUNT" || error "lfs df failed"
+
+	$LFS setstripe -i 0 -c 1 $MOUNT/$tfile || error "setstripe failed"
+	for client in ${clients//,/ }; do
+		do_node $client "dd if=/dev/zero of=$MOUNT/$tfile bs=1M count=1 \
+			conv=notrunc,fsync" || error "$client: write failed"
+		state=$(do_node $client "$LCTL get_param -n $imp" |
+			awk '/state:/ { print $2; exit }')
+		[[ "$state" == "FULL" ]] ||
+			error "$client: OST0000 import state $state, expected FULL"
+	done
+
+	# quotactl and fiemap go only to active LOV targets, a lazily
+	# connected OSC must be one before its first RPC
+	umount_client $MOUNT || error "umount failed"
+	echo Y > $param
+	mount_client $MOUNT || error "mount failed"
+	state=$($LCTL get_param -n $imp | awk '/state:/ { print $2; exit }')
+	[[ "$state" == "IDLE" ]] ||
+		error "OST0000 import state $state, expected IDLE"
+
+	$LFS getstripe -v $MOUNT/$tfile || error "getstripe failed"
+	local out=$($LFS quota -u $RUNAS_ID $MOUNT 2>&1)
+
+	echo "$out"
+	[[ "$out" =~ "Some errors happened" ]] && error "lfs quota failed"
+	out=$(filefrag -v $MOUNT/$tfile 2>&1) || error "fiemap failed: $out"
+	echo "$out"
+	[[ "$out" =~ "unknown" ]] && error "fiemap reported unknown extents"
+	rm -f $MOUNT/$tfile
+}
+run_test 134 "lazy OSC connect at mount"
+
+mgs_llog_cache_stat() {
+	do_facet mgs $LCTL get_param -n mgs.MGS.llog_cache |
+		awk "/^$1:/ { print \$2 }"
+}
+
+test_135() {
+	(( $MGS_VERSION >= $(version_code 2.15.51) )) ||
+		skip "Need MGS version at least 2.15.51"
+	[[ -n "$(do_facet mgs $LCTL list_param mgs.MGS.llog_cache)" ]] ||
+		skip "MGS llog cache not supported"
+
+	setup
+	stack_trap cleanup
+
+	local hits
+	local inval
+	local i
+
+	hits=$(mgs_llog_cache_stat hits)
+	for i in 1 2 3; do
+		umount_client $MOUNT || error "umount $i failed"
+		mount_client $MOUNT || error "mount $i failed"
+	done
+	(( $(mgs_llog_cache_stat hits) > hits )) ||
+		error "config log reads were not served from cache"
+
+	inval=$(mgs_llog_cache_stat invalidations)
+	set_persistent_param_and_check client \
+		"osc.$FSNAME-OST0000-osc-[^M]*.max_dirty_mb" \
+		"$FSNAME.osc.max_dirty_mb" 467
+	(( $(mgs_llog_cache_stat invalidations) > inval )) ||
+		error "config log change did not invalidate cache"
+
+	# records cancelled through the llog ioctls must drop the cache too
+	do_facet mgs $LCTL set_param -P osc.*.max_pages_per_rpc=16
+	umount_client $MOUNT || error "umount failed"
+	mount_client $MOUNT || error "mount failed"
+	(( $(mgs_llog_cache_stat entries) > 0 )) || error "nothing cached"
+
+	# - { index: 71, event: set_param, device: general,
+	#     param: osc.*.max_pages_per_rpc, value: 16 }
+	i=$(do_facet mgs $LCTL --device MGS llog_print params |
+	    tail -1 | awk '{ print $4 }' | tr -d , )
+	inval=$(mgs_llog_cache_stat invalidations)
+	do_facet mgs $LCTL --device MGS llog_cancel params --log_idx=$i ||
+		error "llog_cancel params $i failed"
+	(( $(mgs_llog_cache_stat invalidations) > inval )) ||
+		error "llog_cancel did not invalidate cache"
+
+	do_facet mgs $LCTL set_param mgs.MGS.llog_cache=0
+	stack_trap "do_facet mgs $LCTL set_param mgs.MGS.llog_cache=256"
+	(( $(mgs_llog_cache_stat entries) == 0 )) ||
+		error "cache not emptied when disabled"
+	umount_client $MOUNT || error "umount failed"
+	mount_client $MOUNT || error "mount with cache disabled failed"
+}
+run_test 135 "MGS serves repeated config log reads from cache"
+
 if ! combined_mgs_mds ; then
 	stop mgs
 fi
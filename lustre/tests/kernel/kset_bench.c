@@ -0,0 +1,202 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/*
+ * Measure the cost of ptlrpc_check_set() and ptlrpc_set_next_timeout() for
+ * a set with many requests in flight, when one request at a time gets an
+ * event. This is run once walking the whole set on every check, as sets
+ * used to be processed, and once with the set ready list and timer heap.
+ *
+ * The requests are never sent, they only sit in RQ_PHASE_RPC waiting for a
+ * reply, and each event is an early reply pushing the deadline out.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+#include <linux/ktime.h>
+
+#include <obd_support.h>
+#include <lustre_net.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+static unsigned int nreqs = 10000;
+module_param(nreqs, uint, 0644);
+MODULE_PARM_DESC(nreqs, "number of requests in flight in the set");
+
+static unsigned int nevents = 100000;
+module_param(nevents, uint, 0644);
+MODULE_PARM_DESC(nevents, "number of request events to process");
+
+#define PREFIX "lustre_kset_bench_%u:"
+
+static void kset_req_init(struct ptlrpc_request *req, time64_t now,
+			  unsigned int i)
+{
+	spin_lock_init(&req->rq_lock);
+	INIT_LIST_HEAD(&req->rq_list);
+	INIT_LIST_HEAD(&req->rq_set_chain);
+	INIT_LIST_HEAD(&req->rq_ready_chain);
+	INIT_LIST_HEAD(&req->rq_ctx_chain);
+	INIT_LIST_HEAD(&req->rq_unreplied_list);
+	init_waitqueue_head(&req->rq_reply_waitq);
+	init_waitqueue_head(&req->rq_set_waitq);
+	atomic_set(&req->rq_refcount, 1);
+
+	req->rq_phase = RQ_PHASE_RPC;
+	req->rq_receiving_reply = 1;
+	req->rq_req_unlinked = 1;
+	req->rq_sent = now;
+	/* spread deadlines so that the heap has some work to do */
+	req->rq_timeout = 100 + i % 997;
+	req->rq_deadline = req->rq_sent + req->rq_timeout;
+}
+
+/**
+ * Run \a nevents events over a set of \a nreqs requests.
+ *
+ * \retval >= 0 average nanoseconds per event
+ * \retval < 0 negated error code
+ */
+static s64 kset_bench_run(struct ptlrpc_request **reqs, bool events)
+{
+	struct ptlrpc_request_set *set;
+	struct ptlrpc_request *req;
+	time64_t now = ktime_get_real_seconds();
+	ktime_t start;
+	s64 elapsed;
+	unsigned int i;
+
+	set = ptlrpc_prep_set();
+	if (set == NULL)
+		return -ENOMEM;
+
+	set->set_scan_only = !events;
+
+	for (i = 0; i < nreqs; i++) {
+		req = reqs[i];
+		kset_req_init(req, now, i);
+
+		list_add_tail(&req->rq_set_chain, &set->set_requests);
+		req->rq_set = set;
+		atomic_inc(&set->set_remaining);
+		ptlrpc_set_req_ready(set, req);
+	}
+
+	/* first pass sets up the timer heap, if any */
+	ptlrpc_check_set(NULL, set);
+	ptlrpc_set_next_timeout(set);
+
+	start = ktime_get();
+	for (i = 0; i < nevents; i++) {
+		req = reqs[(i * 7919ULL) % nreqs];
+
+		spin_lock(&req->rq_lock);
+		req->rq_timeout++;
+		req->rq_deadline++;
+		ptlrpc_client_wake_req(req);
+		spin_unlock(&req->rq_lock);
+
+		ptlrpc_check_set(NULL, set);
+		ptlrpc_set_next_timeout(set);
+	}
+	elapsed = ktime_to_ns(ktime_sub(ktime_get(), start));
+
+	for (i = 0; i < nreqs; i++) {
+		req = reqs[i];
+
+		list_del_init(&req->rq_set_chain);
+		spin_lock(&set->set_ready_lock);
+		list_del_init(&req->rq_ready_chain);
+		spin_unlock(&set->set_ready_lock);
+		req->rq_set = NULL;
+	}
+	atomic_set(&set->set_remaining, 0);
+	ptlrpc_set_destroy(set);
+
+	return elapsed / nevents;
+}
+
+static int __init kset_bench_init(void)
+{
+	struct ptlrpc_request **reqs;
+	s64 scan_ns;
+	s64 event_ns;
+	unsigned int i;
+
+	if (nreqs == 0 || nevents == 0) {
+		pr_err(PREFIX " invalid nreqs %u or nevents %u\n",
+		       run_id, nreqs, nevents);
+		goto out;
+	}
+
+	OBD_ALLOC_PTR_ARRAY_LARGE(reqs, nreqs);
+	if (reqs == NULL) {
+		pr_err(PREFIX " cannot allocate %u requests\n", run_id, nreqs);
+		goto out;
+	}
+
+	for (i = 0; i < nreqs; i++) {
+		OBD_ALLOC_PTR(reqs[i]);
+		if (reqs[i] == NULL) {
+			pr_err(PREFIX " cannot allocate %u requests\n",
+			       run_id, nreqs);
+			goto out_free;
+		}
+	}
+
+	scan_ns = kset_bench_run(reqs, false);
+	event_ns = kset_bench_run(reqs, true);
+	if (scan_ns < 0 || event_ns < 0) {
+		pr_err(PREFIX " run failed: %lld/%lld\n",
+		       run_id, scan_ns, event_ns);
+		goto out_free;
+	}
+
+	/* below message is checked in sanity.sh test_434 */
+	pr_err(PREFIX " %u requests %u events: scan %lld ns/event, ready list %lld ns/event\n",
+	       run_id, nreqs, nevents, scan_ns, event_ns);
+
+out_free:
+	for (i = 0; i < nreqs && reqs[i] != NULL; i++)
+		OBD_FREE_PTR(reqs[i]);
+	OBD_FREE_PTR_ARRAY_LARGE(reqs, nreqs);
+out:
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit kset_bench_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre ptlrpc request set benchmark module");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(kset_bench_init);
+module_exit(kset_bench_exit);
@@ -0,0 +1,110 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+
+/*
+ * Check every T10-PI guard tag implementation against the reference one
+ * and measure its throughput, then report which one is used for each
+ * guard tag type.
+ */
+
+#include <linux/module.h>
+#include <linux/kernel.h>
+
+#include <obd_support.h>
+#include <obd_cksum.h>
+
+/* Random ID passed by userspace, and printed in messages, used to
+ * separate different runs of that module. */
+static int run_id;
+module_param(run_id, int, 0644);
+MODULE_PARM_DESC(run_id, "run ID");
+
+static unsigned int size_kb = 1024;
+module_param(size_kb, uint, 0644);
+MODULE_PARM_DESC(size_kb, "size of the checksummed buffer in KiB");
+
+static unsigned int msecs = 200;
+module_param(msecs, uint, 0644);
+MODULE_PARM_DESC(msecs, "time to run each implementation in milliseconds");
+
+#define PREFIX "lustre_t10pi_bench_%u:"
+
+static int __init t10pi_bench_init(void)
+{
+#if IS_ENABLED(CONFIG_CRC_T10DIF)
+	const struct obd_dif_impl *impl;
+	unsigned int len = size_kb << 10;
+	unsigned int failed = 0;
+	unsigned int i;
+	void *buf;
+	int rc;
+
+	if (len < 512 || msecs == 0) {
+		pr_err(PREFIX " invalid size_kb %u or msecs %u\n",
+		       run_id, size_kb, msecs);
+		goto out;
+	}
+
+	OBD_ALLOC_LARGE(buf, len);
+	if (buf == NULL) {
+		pr_err(PREFIX " cannot allocate %u KiB\n", run_id, size_kb);
+		goto out;
+	}
+	memset(buf, 0xAD, len);
+
+	for (i = 0; (impl = obd_dif_impl_get(i)) != NULL; i++) {
+		rc = obd_dif_impl_selftest(impl);
+		if (rc) {
+			pr_err(PREFIX " %s selftest failed: rc = %d\n",
+			       run_id, impl->odi_name, rc);
+			failed++;
+			continue;
+		}
+
+		pr_err(PREFIX " %s %d MB/s\n", run_id, impl->odi_name,
+		       obd_dif_impl_speed(impl, buf, len, msecs));
+	}
+	OBD_FREE_LARGE(buf, len);
+
+	/* below message is checked in sanity.sh test_438 */
+	pr_err(PREFIX " %u failed, selected %s %s\n", run_id, failed,
+	       obd_dif_impl_current(OBD_DIF_CSUM_IP),
+	       obd_dif_impl_current(OBD_DIF_CSUM_CRC));
+out:
+#else
+	pr_err(PREFIX " no CONFIG_CRC_T10DIF support\n", run_id);
+#endif
+	/* Don't load. */
+	return -EINVAL;
+}
+
+static void __exit t10pi_bench_exit(void)
+{
+}
+
+MODULE_AUTHOR("OpenSFS, Inc. <http://www.lustre.org/>");
+MODULE_DESCRIPTION("Lustre T10-PI guard tag selftest and benchmark module");
+MODULE_VERSION(LUSTRE_VERSION_STRING);
+MODULE_LICENSE("GPL");
+
+module_init(t10pi_bench_init);
+module_exit(t10pi_bench_exit);
@@ -198,6 +198,30 @@ test_smoke () {
 }
 run_test smoke "lst regression test"
 
+test_lat () {
+	lst_prepare
+
+	local log=$TMP/$tfile.log
+
+	export LST_SESSION=$$
+
+	$LST new_session --timeo 100000 lat || error "new_session failed"
+	stack_trap "lst_end_session --verbose; lst_cleanup_all"
+	$LST add_group c $(nids_list $lst_CLIENTS) || error "add_group c failed"
+	$LST add_group s $(nids_list $lst_SERVERS) || error "add_group s failed"
+	$LST add_batch b || error "add_batch failed"
+	$LST add_test --batch b --loop -1 --concurrency 8 --from c --to s \
+		brw write size=64k rate=500 || error "add_test failed"
+	$LST run b || error "run failed"
+
+	$LST stat --lat --delay 5 --count 2 c | tee $log
+	$LST stop b
+
+	grep -q "^\[LAT\] Latency of c .*p99.9:" $log ||
+		error "no latency percentiles reported"
+}
+run_test lat "fixed rate brw test with latency percentiles"
+
 complete $SECONDS
 _restore_mount
 check_and_cleanup_lustre
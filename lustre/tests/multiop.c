@@ -82,6 +82,7 @@ char usage[] =
 "	 g gid put grouplock\n"
 "	 H[num] create HSM released file with num stripes\n"
 "	 K  link path to filename\n"
+"	 k  sync_file_range(SYNC_FILE_RANGE_WRITE) of the whole file\n"
 "	 L  link\n"
 "	 l  symlink filename to path\n"
 "	 m  mknod\n"
@@ -759,6 +760,14 @@ int main(int argc, char **argv)
 				exit(save_errno);
 			}
 			break;
+		case 'k':
+			if (sync_file_range(fd, 0, 0,
+					    SYNC_FILE_RANGE_WRITE) == -1) {
+				save_errno = errno;
+				perror("sync_file_range");
+				exit(save_errno);
+			}
+			break;
 		case 'Y':
 			if (fdatasync(fd) == -1) {
 				save_errno = errno;
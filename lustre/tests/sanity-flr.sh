@@ -2880,6 +2880,49 @@ test_50d() {
 }
 run_test 50d "mirror rsync keep holes"
 
+test_50e() {
+	local file=$DIR/$tdir/$tfile
+	local out=$TMP/$tfile.out
+	local sum_1
+	local sum_2
+
+	(( $OSTCOUNT >= 2 )) || skip "need >= 2 OSTs"
+
+	mkdir -p $DIR/$tdir
+	stack_trap "rm -f $file $out" EXIT
+
+	$LFS mirror create -N -c1 -i0 -N -c1 -i1 $file ||
+		error "create mirrored file $file failed"
+	# data split into many chunks with a hole and a partial last page
+	dd if=/dev/urandom of=$file bs=1M count=20 conv=notrunc ||
+		error "write $file failed"
+	dd if=/dev/urandom of=$file bs=1000 count=100 seek=31400 ||
+		error "write $file after hole failed"
+	verify_flr_state $file "wp"
+
+	$LFS mirror resync --threads=8 --stats --stats-interval=0 $file \
+		> $out || error "resync $file failed"
+	cat $out
+	verify_flr_state $file "ro"
+	grep -q "MiB/s, 8 threads" $out || error "no resync progress reported"
+
+	sum_1=$($LFS mirror read -N 1 $file | md5sum)
+	sum_2=$($LFS mirror read -N 2 $file | md5sum)
+	[[ "$sum_1" == "$sum_2" ]] ||
+		error "resync data mismatch: '$sum_1' vs. '$sum_2'"
+
+	$LFS setstripe --comp-set -I0x20001 --comp-flags=stale $file ||
+		error "stale mirror 2 of $file failed"
+	$LFS mirror copy -i 1 -o 2 --threads=3 --stats $file ||
+		error "copy mirror 1 to mirror 2 failed"
+	sum_2=$($LFS mirror read -N 2 $file | md5sum)
+	[[ "$sum_1" == "$sum_2" ]] ||
+		error "copy data mismatch: '$sum_1' vs. '$sum_2'"
+	(( $(stat -c %s $file) == 31500000 )) ||
+		error "wrong size $(stat -c %s $file) after copy"
+}
+run_test 50e "parallel mirror resync and copy with progress stats"
+
 test_60a() {
 	$LCTL get_param osc.*.import | grep -q 'connect_flags:.*seek' ||
 		skip "OST does not support SEEK_HOLE"
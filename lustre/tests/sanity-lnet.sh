@@ -2481,6 +2481,120 @@ test_219() {
 }
 run_test 219 "Consolidate peer entries"
 
+test_220() {
+	reinit_dlc || return $?
+	add_net "tcp" "${INTERFACES[0]}" || return $?
+
+	local snap=$TMP/sanity-lnet-$testnum-peers.yaml
+
+	do_lnetctl peer add --prim_nid 1.1.1.1@tcp --nid 1.1.1.2@tcp ||
+		error "Peer add failed $?"
+	do_lnetctl peer save $snap ||
+		error "Peer save failed $?"
+	! grep -q "1.1.1.1@tcp" $snap ||
+		error "configured peer 1.1.1.1@tcp saved in snapshot"
+
+	# A snapshot with a discovered peer, and one which is now configured
+	cat > $snap <<EOF
+peer:
+    - primary nid: 2.2.2.1@tcp
+      Multi-Rail: True
+      peer ni:
+        - nid: 2.2.2.1@tcp
+        - nid: 2.2.2.2@tcp
+    - primary nid: 1.1.1.1@tcp
+      Multi-Rail: True
+      peer ni:
+        - nid: 1.1.1.1@tcp
+        - nid: 1.1.1.3@tcp
+EOF
+
+	reinit_dlc || return $?
+	add_net "tcp" "${INTERFACES[0]}" || return $?
+	do_lnetctl peer add --prim_nid 1.1.1.1@tcp --nid 1.1.1.2@tcp ||
+		error "Peer add failed $?"
+
+	do_lnetctl peer load $snap ||
+		error "Peer load failed $?"
+	$LNETCTL peer show --nid 2.2.2.1@tcp | grep -q "2.2.2.2@tcp" ||
+		error "2.2.2.2@tcp is not listed under 2.2.2.1@tcp"
+	! $LNETCTL peer show --nid 1.1.1.1@tcp | grep -q "1.1.1.3@tcp" ||
+		error "snapshot changed configured peer 1.1.1.1@tcp"
+	$LNETCTL stats show | grep -q "warm_peers: 1" ||
+		error "expected one warm peer"
+
+	# Loading the same snapshot again leaves known peers alone
+	do_lnetctl peer load $snap ||
+		error "Second peer load failed $?"
+
+	do_lnetctl ping $($LCTL list_nids | head -n 1) ||
+		error "Ping failed $?"
+	$LNETCTL stats show | grep -A 10 "discovery:" | grep -q "completed:" ||
+		error "discovery statistics missing"
+
+	rm -f $snap
+}
+run_test 220 "Warm start the peer table from a saved snapshot"
+
+# send_count of the local NI with NID $1
+ni_send_count() {
+	$LNETCTL net show -v | awk -v nid="$1" \
+		'$NF == nid { found = 1 } found && /send_count:/ { print $NF; exit }'
+}
+
+test_221() {
+	local peer=1.1.1.2@tcp
+	local sensitivity
+	local before
+	local after
+	local nid2
+	local i
+
+	cleanup_netns || error "Failed to cleanup netns before test execution"
+	cleanup_lnet || error "Failed to unload modules before test execution"
+
+	setup_fakeif || error "Failed to add fake IF"
+	stack_trap cleanup_fakeif EXIT
+	have_interface "$FAKE_IF" ||
+		error "Expect $FAKE_IF configured but not found"
+
+	reinit_dlc || return $?
+	add_net "tcp" "${INTERFACES[0]}" || return $?
+	add_net "tcp" "$FAKE_IF" || return $?
+	nid2=$($LCTL list_nids | tail -n 1)
+
+	# the peer is unreachable, keep health out of the NI selection
+	sensitivity=$($LNETCTL global show |
+		      awk '/health_sensitivity:/ { print $NF }')
+	do_lnetctl set health_sensitivity 0 ||
+		error "failed to set health_sensitivity"
+	stack_trap "$LNETCTL set health_sensitivity $sensitivity" EXIT
+
+	# both local NIs are preferred for the peer, which is tested against
+	# a compiled mask of the local NIs
+	do_lnetctl udsp add --dst $peer --src tcp ||
+		error "failed to add NID pair rule"
+
+	# compile the mask while the second NI is gone, then add it back
+	do_lnetctl net del --net tcp --if $FAKE_IF ||
+		error "failed to delete $nid2"
+	$LNETCTL ping --timeout 1 $peer > /dev/null
+	do_lnetctl net add --net tcp --if $FAKE_IF ||
+		error "failed to add $FAKE_IF back"
+	$LCTL list_nids | grep -q "^$nid2$" ||
+		error "$nid2 was not added back"
+
+	before=$(ni_send_count $nid2)
+	for ((i = 0; i < 10; i++)); do
+		$LNETCTL ping --timeout 1 $peer > /dev/null
+	done
+	after=$(ni_send_count $nid2)
+	echo "$nid2 send_count $before -> $after"
+	(( after > before )) ||
+		error "re-added $nid2 is not used as a preferred NI of $peer"
+}
+run_test 221 "Preferred local NI mask follows NI removal and re-addition"
+
 test_230() {
 	# LU-12815
 	echo "Check valid values; Should succeed"
@@ -1491,6 +1491,85 @@ test_20() {
 }
 run_test 20 "Auto attach works after the inode was once evicted from cache"
 
+test_21() {
+	local loopfile="$TMP/$tfile"
+	local mntpt="/mnt/pcc.$tdir"
+	local hsm_root="$mntpt/$tdir"
+	local heat=$(do_facet $SINGLEAGT $LCTL get_param -n \
+		     llite.*.file_heat | head -n1)
+	local i
+
+	do_facet $SINGLEAGT "[ -x $LPCC_PREFETCH ]" ||
+		skip "Need $LPCC_PREFETCH on $SINGLEAGT"
+
+	setup_loopdev $SINGLEAGT $loopfile $mntpt 50
+	copytool setup -m "$MOUNT" -a "$HSM_ARCHIVE_NUMBER"
+	setup_pcc_mapping $SINGLEAGT \
+		"projid={100}\ rwid=$HSM_ARCHIVE_NUMBER"
+
+	stack_trap "do_facet $SINGLEAGT $LCTL set_param \
+		llite.*.file_heat=$heat" EXIT
+	do_facet $SINGLEAGT $LCTL set_param llite.*.file_heat=1
+	do_facet $SINGLEAGT $LCTL set_param llite.*.pcc_stats=clear
+
+	for i in 1 2 3; do
+		do_facet $SINGLEAGT dd if=/dev/urandom of=$DIR/$tfile.$i \
+			bs=1M count=1 || error "failed to write $tfile.$i"
+	done
+	for i in {1..20}; do
+		do_facet $SINGLEAGT cat $DIR/$tfile.1 > /dev/null ||
+			error "failed to read $tfile.1"
+	done
+
+	# read-write attach must be asked for explicitly
+	do_facet $SINGLEAGT $LPCC_PREFETCH -v --once -A $HSM_ARCHIVE_NUMBER \
+		-p $hsm_root -t 10 --idle=0 $MOUNT &&
+		error "lpcc_prefetch attached files without --read-write"
+	# freshly written files are skipped
+	do_facet $SINGLEAGT $LPCC_PREFETCH -v --once -w -A $HSM_ARCHIVE_NUMBER \
+		-p $hsm_root -t 10 --idle=3600 $MOUNT ||
+		error "lpcc_prefetch failed"
+	check_lpcc_state $DIR/$tfile.1 "none"
+	# so are files open elsewhere
+	do_facet $SINGLEAGT $MULTIOP $DIR/$tfile.1 o_c &
+	local pid=$!
+
+	sleep 1
+	do_facet $SINGLEAGT $LPCC_PREFETCH -v --once -w -A $HSM_ARCHIVE_NUMBER \
+		-p $hsm_root -t 10 --idle=0 $MOUNT ||
+		error "lpcc_prefetch failed"
+	check_lpcc_state $DIR/$tfile.1 "none"
+	do_facet $SINGLEAGT pkill -USR1 -f "multiop.*$tfile.1"
+	wait $pid || error "multiop failed"
+
+	do_facet $SINGLEAGT $LPCC_PREFETCH -v --once -w -A $HSM_ARCHIVE_NUMBER \
+		-p $hsm_root -t 10 -j 2 --idle=0 $MOUNT ||
+		error "lpcc_prefetch failed"
+	check_lpcc_state $DIR/$tfile.1 "readwrite"
+	check_lpcc_state $DIR/$tfile.2 "none"
+	check_lpcc_state $DIR/$tfile.3 "none"
+
+	do_facet $SINGLEAGT cat $DIR/$tfile.1 > /dev/null ||
+		error "failed to read $tfile.1 from PCC"
+	do_facet $SINGLEAGT $LCTL get_param llite.*.pcc_stats
+	do_facet $SINGLEAGT $LCTL get_param -n llite.*.pcc_stats |
+		grep -q read_hit || error "no read served from PCC"
+
+	# tfile.2 gets hotter, and only one file fits in the cache
+	for i in {1..30}; do
+		do_facet $SINGLEAGT cat $DIR/$tfile.2 > /dev/null ||
+			error "failed to read $tfile.2"
+	done
+	do_facet $SINGLEAGT $LPCC_PREFETCH -v --once -w -A $HSM_ARCHIVE_NUMBER \
+		-p $hsm_root -t 10 -c 1 --idle=0 $MOUNT ||
+		error "lpcc_prefetch failed"
+	check_lpcc_state $DIR/$tfile.1 "none"
+	check_lpcc_state $DIR/$tfile.2 "readwrite"
+	do_facet $SINGLEAGT $LFS pcc detach $DIR/$tfile.2 ||
+		error "failed to detach $tfile.2"
+}
+run_test 21 "Heat driven PCC prefetch with bounded cache"
+
 #test 101: containers and PCC
 #LU-15170: Test mount namespaces with PCC
 #This tests the cases where the PCC mount is not present in the container by
@@ -5454,6 +5454,54 @@ test_82()
 }
 run_test 82 "verify more than 8 qids for single operation"
 
+test_83() {
+	local limit=20 # MB
+	local testfile="$DIR/$tdir/$tfile-0"
+
+	(( $OST1_VERSION >= $(version_code 2.15.51) )) ||
+		skip "need OST 2.15.51 or later"
+
+	setup_quota_test || error "setup quota failed with $?"
+
+	# enable ost quota
+	set_ost_qtype $QTYPE || error "enable ost quota failed"
+
+	local resv=$(do_facet ost1 $LCTL get_param -n \
+		osd-*.$FSNAME-OST0000.quota_slave.per_cpu_resv)
+	stack_trap "do_facet ost1 $LCTL set_param \
+		osd-*.$FSNAME-OST*.quota_slave.per_cpu_resv=$resv"
+	do_facet ost1 $LCTL set_param \
+		osd-*.$FSNAME-OST*.quota_slave.per_cpu_resv=1
+
+	log "User quota (block hardlimit:$limit MB)"
+	$LFS setquota -u $TSTUSR -b 0 -B ${limit}M -i 0 -I 0 $DIR ||
+		error "set user quota failed"
+
+	$LFS setstripe $testfile -c 1 -i 0 || error "setstripe $testfile failed"
+	chown $TSTUSR.$TSTUSR $testfile || error "chown $testfile failed"
+
+	# many small sync writes make the ID hot on the OST so that per-CPU
+	# reservations kick in
+	log "Write with small direct IOs..."
+	$RUNAS $DD of=$testfile bs=64k count=$((limit * 8)) oflag=direct ||
+		quota_error u $TSTUSR "write failure, but expect success"
+
+	# reservations must be given back once the limit is reached
+	log "Write out of block quota ..."
+	$RUNAS $DD of=$testfile bs=1M count=$limit seek=$((limit / 2)) \
+		oflag=direct &&
+		quota_error u $TSTUSR "user write success, but expect EDQUOT"
+
+	rm -f $testfile
+	wait_delete_completed || error "wait_delete_completed failed"
+	sync_all_data || true
+	local used=$(getquota -u $TSTUSR global curspace)
+	[ $used -ne 0 ] && quota_error u $TSTUSR \
+		"user quota isn't released after deletion"
+	resetquota -u $TSTUSR
+}
+run_test 83 "per-CPU quota reservation respects block hardlimit"
+
 quota_fini()
 {
 	do_nodes $(comma_list $(nodes_list)) \
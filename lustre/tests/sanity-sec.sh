@@ -4973,6 +4973,198 @@ test_60() {
 }
 run_test 60 "Subdirmount of encrypted dir"
 
+test_61() {
+	local testfile=$DIR/$tdir/$tfile
+	local tmpfile=$TMP/$tfile.ref
+	local size_mb=256
+	local pipeline
+	local mode
+	local start
+	local elapsed
+
+	$LCTL get_param mdc.*.import | grep -q client_encryption ||
+		skip "client encryption not supported"
+
+	mount.lustre --help |& grep -q "test_dummy_encryption:" ||
+		skip "need dummy encryption support"
+
+	$LCTL get_param -n osc.*.crypt_pipeline_pages &> /dev/null ||
+		skip "no crypt_pipeline_pages support"
+
+	pipeline=$($LCTL get_param -n osc.*.crypt_pipeline_pages | head -n1)
+	stack_trap "$LCTL set_param osc.*.crypt_pipeline_pages=$pipeline" EXIT
+	stack_trap cleanup_for_enc_tests EXIT
+	setup_for_enc_tests
+
+	dd if=/dev/urandom of=$tmpfile bs=1M count=$size_mb ||
+		error "create $tmpfile failed"
+	stack_trap "rm -f $tmpfile" EXIT
+
+	for mode in 0 16; do
+		$LCTL set_param osc.*.crypt_pipeline_pages=$mode
+		$LCTL set_param osc.*.crypt_stats=clear
+		rm -f $testfile
+		$LFS setstripe -c1 -i0 $testfile
+
+		start=$(date +%s%N)
+		dd if=$tmpfile of=$testfile bs=4M conv=fsync ||
+			error "write $testfile with pipeline=$mode failed"
+		elapsed=$((($(date +%s%N) - start) / 1000000 + 1))
+		echo "pipeline=$mode write: $((size_mb * 1000 / elapsed)) MB/s"
+
+		cancel_lru_locks osc
+		start=$(date +%s%N)
+		cmp $tmpfile $testfile ||
+			error "$testfile corrupted with pipeline=$mode"
+		elapsed=$((($(date +%s%N) - start) / 1000000 + 1))
+		echo "pipeline=$mode read: $((size_mb * 1000 / elapsed)) MB/s"
+
+		$LCTL get_param osc.*-OST0000-*.crypt_stats
+	done
+}
+run_test 61 "encrypted bulk IO with inline and pipelined encryption"
+
+nodemap_stat() {
+	do_facet mgs $LCTL get_param -n nodemap.stats |
+		awk '/^'$1' / { print $2 }'
+}
+
+test_62() {
+	local nm=nm62
+	local nid="$SUBNET_CHECKSUM.0.62.100@tcp"
+	local activedefault
+	local hits
+	local fs_id
+	local i
+
+	do_facet mgs $LCTL get_param -n nodemap.stats &> /dev/null ||
+		skip "no nodemap stats support"
+
+	activedefault=$(do_facet mgs $LCTL get_param -n nodemap.active)
+	do_facet mgs $LCTL nodemap_add $nm || error "nodemap_add $nm failed"
+	stack_trap "do_facet mgs $LCTL nodemap_del $nm" EXIT
+	do_facet mgs $LCTL nodemap_add_range --name $nm --range $nid ||
+		error "add range $nid failed"
+	do_facet mgs $LCTL nodemap_add_idmap --name $nm --idtype uid \
+		--idmap 600:700 || error "add idmap 600:700 failed"
+	if [ "$activedefault" != "1" ]; then
+		do_facet mgs $LCTL nodemap_activate 1
+		stack_trap cleanup_active EXIT
+	fi
+	do_facet mgs $LCTL set_param nodemap.stats=clear
+
+	for i in $(seq 10); do
+		fs_id=$(do_facet mgs $LCTL nodemap_test_id --nid $nid \
+			--idtype uid --id 600)
+		[ "$fs_id" == "700" ] || error "pass $i: expected 700, got $fs_id"
+	done
+	do_facet mgs $LCTL get_param nodemap.stats
+	hits=$(nodemap_stat idmap_cache_hit)
+	(( ${hits:-0} >= 9 )) || error "expected >= 9 cache hits, got '$hits'"
+
+	# changing the idmap must invalidate the cached mapping
+	do_facet mgs $LCTL nodemap_del_idmap --name $nm --idtype uid \
+		--idmap 600:700 || error "del idmap 600:700 failed"
+	do_facet mgs $LCTL nodemap_add_idmap --name $nm --idtype uid \
+		--idmap 600:800 || error "add idmap 600:800 failed"
+	fs_id=$(do_facet mgs $LCTL nodemap_test_id --nid $nid \
+		--idtype uid --id 600)
+	[ "$fs_id" == "800" ] || error "stale mapping: expected 800, got $fs_id"
+
+	# so must removing the range that classified the NID
+	do_facet mgs $LCTL nodemap_del_range --name $nm --range $nid ||
+		error "del range $nid failed"
+	fs_id=$(do_facet mgs $LCTL nodemap_test_id --nid $nid \
+		--idtype uid --id 600)
+	[ "$fs_id" != "800" ] || error "NID still classified into $nm"
+}
+run_test 62 "nodemap idmap cache hits and invalidation"
+
+# bytes accounted to flavor $1 and operation $2 in the OSS crypto_stats
+crypto_stats_bytes() {
+	do_facet ost1 $LCTL get_param -n sptlrpc.gss.crypto_stats |
+		awk -v flvr=$1 -v op=$2 \
+			'$1 == flvr && $2 == op { print $4; exit }' |
+		grep . || echo 0
+}
+
+test_63() {
+	local param=/sys/module/ptlrpc_gss/parameters/sk_bulk_pipeline_pages
+	local save_flvr=$SK_FLAVOR
+	local testfile=$DIR/$tdir/$tfile
+	local tmpfile=$TMP/$tfile.ref
+	local size_mb=128
+	local size=$((size_mb * 1048576))
+	local pipeline
+	local modes
+	local mode
+	local flvr
+	local wr
+	local rd
+
+	$SHARED_KEY || skip "need shared key feature for this test"
+	do_facet ost1 "[ -f $param ]" ||
+		skip "no sk_bulk_pipeline_pages support"
+
+	pipeline=$(do_facet ost1 cat $param)
+	stack_trap "do_facet ost1 'echo $pipeline > $param'" EXIT
+	stack_trap restore_to_default_flavor EXIT
+
+	dd if=/dev/urandom of=$tmpfile bs=1M count=$size_mb ||
+		error "create $tmpfile failed"
+	stack_trap "rm -f $tmpfile" EXIT
+	mkdir -p $DIR/$tdir
+
+	for flvr in skn ski skpi; do
+		SK_FLAVOR=$flvr
+		restore_to_default_flavor || error "cannot set $flvr flavor"
+		SK_FLAVOR=$save_flvr
+
+		# only skpi encrypts bulk data, on the OSS inline or in chunks
+		modes=$pipeline
+		[[ $flvr == skpi ]] && modes="0 16"
+		for mode in $modes; do
+			do_facet ost1 "echo $mode > $param"
+			do_facet ost1 $LCTL set_param \
+				sptlrpc.gss.crypto_stats=clear
+			rm -f $testfile
+			$LFS setstripe -c1 -i0 $testfile
+
+			dd if=$tmpfile of=$testfile bs=4M conv=fsync ||
+				error "write $testfile with $flvr/$mode failed"
+			cancel_lru_locks osc
+			cmp $tmpfile $testfile ||
+				error "$testfile corrupted with $flvr/$mode"
+
+			do_facet ost1 $LCTL get_param sptlrpc.gss.crypto_stats
+			case $flvr in
+			skn)
+				wr=$(do_facet ost1 $LCTL get_param -n \
+				     sptlrpc.gss.crypto_stats | grep -c "^skn ")
+				(( wr == 0 )) ||
+					error "crypto accounted to skn"
+				continue
+				;;
+			ski)
+				wr=$(crypto_stats_bytes ski verify_mic)
+				rd=$(crypto_stats_bytes ski get_mic)
+				;;
+			skpi)
+				wr=$(crypto_stats_bytes skpi unwrap_bulk)
+				rd=$(crypto_stats_bytes skpi wrap_bulk)
+				;;
+			esac
+			(( wr >= size )) ||
+				error "$flvr/$mode: $wr bytes written, not $size"
+			(( rd >= size )) ||
+				error "$flvr/$mode: $rd bytes read, not $size"
+		done
+	done
+	do_facet ost1 $LCTL get_param -n sptlrpc.encrypt_page_pools |
+		grep "cpt cache"
+}
+run_test 63 "SK flavors bulk crypto and per-flavor stats"
+
 log "cleanup: ======================================================"
 
 sec_unsetup() {
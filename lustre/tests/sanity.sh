@@ -7828,6 +7828,72 @@ test_56xg() {
 }
 run_test 56xg "lfs migrate pool support"
 
+test_56xh() {
+	[[ $OSTCOUNT -ge 2 ]] || skip "needs >= 2 OSTs"
+	check_swap_layouts_support
+
+	local dir=$DIR/$tdir
+	local file=$dir/$tfile
+	local list=$TMP/$tfile.list
+	local out=$TMP/$tfile.out
+	local sum
+	local f
+
+	test_mkdir $dir || error "creating dir $dir"
+
+	# sparse file, the data is not aligned to the old or new stripes
+	$LFS setstripe -c 1 -S 1M $file || error "setstripe $file failed"
+	dd if=/dev/urandom of=$file bs=1k count=1500 seek=300 conv=notrunc ||
+		error "write $file failed"
+	dd if=/dev/urandom of=$file bs=1k count=77 seek=9000 conv=notrunc ||
+		error "write $file failed"
+	$TRUNCATE $file $((12 * 1048576 + 123)) || error "truncate $file failed"
+	sum=$(md5sum < $file)
+
+	$LFS migrate -c 2 -S 3M --threads=8 --stats $file > $out ||
+		error "migrate $file failed"
+	cat $out
+	grep -q "copied" $out || error "no copy progress printed"
+	[[ $($LFS getstripe -c $file) == 2 ]] ||
+		error "stripe count of $file is not 2"
+	[[ "$(md5sum < $file)" == "$sum" ]] || error "$file data changed"
+	[[ $(stat -c %s $file) == $((12 * 1048576 + 123)) ]] ||
+		error "size of $file changed"
+
+	$LFS migrate -n -c 1 --threads=2 $file || error "migrate -n $file failed"
+	[[ "$(md5sum < $file)" == "$sum" ]] || error "$file data changed (-n)"
+
+	# several files, from the command line and a list
+	rm -f $list $TMP/$tfile.sum
+	for f in $(seq 1 8); do
+		dd if=/dev/urandom of=$dir/f$f bs=1k count=$((f * 300)) \
+			status=none || error "write $dir/f$f failed"
+		md5sum $dir/f$f >> $TMP/$tfile.sum
+		[[ $f -gt 2 ]] && echo $dir/f$f >> $list
+	done
+
+	$LFS migrate -c 2 --jobs=4 --files-from=$list $dir/f1 $dir/f2 ||
+		error "migrate --files-from $list failed"
+	md5sum -c $TMP/$tfile.sum || error "data changed with --jobs"
+	for f in $(seq 1 8); do
+		[[ $($LFS getstripe -c $dir/f$f) == 2 ]] ||
+			error "$dir/f$f was not migrated"
+	done
+
+	$LFS migrate -c 1 --files-from=- < $list ||
+		error "migrate --files-from stdin failed"
+	for f in $(seq 3 8); do
+		[[ $($LFS getstripe -c $dir/f$f) == 1 ]] ||
+			error "$dir/f$f was not migrated from stdin"
+	done
+
+	echo $dir/nonexistent >> $list
+	$LFS migrate -c 2 --jobs=2 --files-from=$list &&
+		error "migrate of a missing file should fail"
+	rm -f $list $out $TMP/$tfile.sum
+}
+run_test 56xh "lfs migrate parallel data copy, --files-from and --jobs"
+
 test_56y() {
 	[ $MDS1_VERSION -lt $(version_code 2.4.53) ] &&
 		skip "No HSM $(lustre_build_version $SINGLEMDS) MDS < 2.4.53"
@@ -16920,6 +16986,62 @@ test_160s() {
 }
 run_test 160s "changelog garbage collect on idle records * time"
 
+test_160t() {
+	remote_mds_nodsh && skip "remote MDS with nodsh"
+	local mdt=$(facet_svc $SINGLEMDS)
+
+	do_facet $SINGLEMDS $LCTL get_param -n \
+		mdd.$mdt.changelog_shards &> /dev/null ||
+		skip "MDS does not support changelog_shards"
+
+	local old=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		    mdd.$mdt.changelog_shards)
+
+	stack_trap "do_facet $SINGLEMDS $LCTL set_param \
+		    mdd.$mdt.changelog_shards=$old" EXIT
+	do_facet $SINGLEMDS $LCTL set_param mdd.$mdt.changelog_shards=4 ||
+		error "unable to set changelog_shards=4"
+
+	changelog_register || error "changelog_register failed"
+
+	test_mkdir -i 0 -c 1 $DIR/$tdir || error "mkdir $tdir failed"
+	# create from several processes so records land on several shards
+	local i
+	for ((i = 0; i < 8; i++)); do
+		createmany -o $DIR/$tdir/f$i- 200 > /dev/null &
+	done
+	wait
+
+	local nbcl=$($LFS changelog $mdt | grep -c " 01CREAT ")
+	(( nbcl == 1600 )) || error "found $nbcl CREAT records, expected 1600"
+
+	# records must come back in strictly increasing index order
+	$LFS changelog $mdt | awk '{ idx = $1 + 0;
+		if (NR > 1 && idx <= last) { print "out of order: " last, idx;
+					     exit 1 }
+		last = idx }' || error "changelog records not in index order"
+
+	changelog_clear 0 || error "changelog_clear failed"
+
+	# the lowered count must survive a restart, drained shards are retired
+	do_facet $SINGLEMDS $LCTL set_param mdd.$mdt.changelog_shards=$old ||
+		error "unable to set changelog_shards=$old"
+	fail $SINGLEMDS
+
+	local shards=$(do_facet $SINGLEMDS $LCTL get_param -n \
+		       mdd.$mdt.changelog_shards)
+	(( shards == old )) ||
+		error "changelog_shards is $shards after restart, not $old"
+
+	[[ "$mds1_FSTYPE" == ldiskfs ]] || return 0
+	for ((i = old; i < 4; i++)); do
+		do_facet $SINGLEMDS "$DEBUGFS -c -R 'stat changelog_catalog.$i' \
+			$(mdsdevname 1)" 2>&1 | grep -q "File not found" ||
+			error "changelog_catalog.$i not retired"
+	done
+}
+run_test 160t "sharded changelog is read in index order"
+
 test_161a() {
 	[ $PARALLEL == "yes" ] && skip "skip parallel run"
 
@@ -17802,6 +17924,45 @@ test_180c() { # LU-2598
 }
 run_test 180c "test huge bulk I/O size on obdfilter, don't LASSERT"
 
+test_180d() {
+	[ $PARALLEL == "yes" ] && skip "skip parallel run"
+	remote_ost_nodsh && skip "remote OST with nodsh"
+	do_facet ost1 $LCTL help echo_bench 2>&1 | grep -q usage ||
+		skip "lctl echo_bench is not supported"
+
+	do_rpc_nodes $(facet_active_host ost1) load_module obdecho/obdecho &&
+		stack_trap "do_facet ost1 rmmod obdecho" EXIT ||
+		error "failed to load module obdecho"
+
+	local target=$(do_facet ost1 $LCTL dl |
+		       awk '/obdfilter/ { print $4; exit; }')
+
+	[ -n "$target" ] || error "there is no obdfilter target on ost1"
+
+	do_facet ost1 "$LCTL attach echo_client ec ec_uuid" ||
+		error "attach echo_client failed"
+	stack_trap "do_facet ost1 $LCTL --device ec detach" EXIT
+	do_facet ost1 "$LCTL --device ec setup $target" ||
+		error "setup echo_client on $target failed"
+	stack_trap "do_facet ost1 $LCTL --device ec cleanup" EXIT
+
+	local out=$(do_facet ost1 "$LCTL echo_bench -d ec -t 4 -o 2 -s 64k \
+		    -S 4M -n 200 --mix read=2,write=2,getattr,setattr,create")
+
+	echo "$out"
+	[ -n "$out" ] || error "echo_bench failed"
+	# 4 threads x 200 ops, each create also records a destroy
+	local ops=$(echo "$out" | awk '/"total"/ { t = 1 }
+		t && /"count":/ && !/"destroy"/ {
+			sub(/.*"count": /, ""); sub(/,.*/, ""); n += $0 }
+		END { print n }')
+
+	(( ops == 800 )) || error "expected 800 ops in total, got $ops"
+	echo "$out" | grep -q '"p99.9"' || error "no latency percentiles"
+	echo "$out" | grep -q '"device": "ec"' || error "no per-device stats"
+}
+run_test 180d "echo_bench reports throughput and latency percentiles"
+
 test_181() { # bug 22177
 	test_mkdir $DIR/$tdir
 	# create enough files to index the directory
@@ -22627,6 +22788,67 @@ test_271d() {
 }
 run_test 271d "DoM: read on open (1K file in reply buffer)"
 
+test_271e() {
+	local dom=$DIR/$tdir/dom
+	local tmp=$TMP/$tfile
+	local mdtidx
+	local facet
+	local old_max
+
+	mkdir -p $DIR/$tdir
+	$LFS setstripe -E 1024K -L mdt $DIR/$tdir
+	mdtidx=$($LFS getstripe --mdt-index $DIR/$tdir)
+	facet=mds$((mdtidx + 1))
+
+	old_max=$(do_facet $facet $LCTL get_param -n \
+		  mdt.*MDT$(printf %04x $mdtidx).dom_read_open_max_size) ||
+		skip "MDS does not support dom_read_open_max_size"
+	stack_trap "do_facet $facet $LCTL set_param -n \
+		mdt.*.dom_read_open_max_size=$old_max" EXIT
+	stack_trap "rm -f $tmp" EXIT
+	# the default client reply buffer and MDT limit return it whole
+	(( old_max >= 49152 )) ||
+		error "dom_read_open_max_size $old_max below 48K by default"
+	$LCTL get_param mdc.*.mdc_dom_min_repsize
+
+	dd if=/dev/urandom of=$tmp bs=48K count=1
+	dd if=$tmp of=$dom bs=48K count=1 || error "write $dom failed"
+	cancel_lru_locks mdc
+	$LCTL set_param -n mdc.*.stats=clear llite.*.stats=clear
+	do_facet $facet $LCTL set_param -n mdt.*.md_stats=clear
+
+	echo "Open and read whole 48K file"
+	cat $dom > /dev/null
+	local num=$(get_mdc_stats $mdtidx ost_read)
+	[ -z $num ] || error "$num READ RPC occured"
+	cmp $tmp $dom || error "file miscompare"
+
+	local served=$(do_facet $facet $LCTL get_param -n \
+		       mdt.*MDT$(printf %04x $mdtidx).md_stats |
+		       awk '/read_open_bytes/ { print $7 }')
+	local inline=$($LCTL get_param -n llite.*.stats |
+		       awk '/inline_read_bytes/ { sum += $7 } END { print sum }')
+
+	echo "MDT served $served bytes, client installed $inline bytes"
+	# counted once, no truncated reply was resent
+	(( ${served:-0} == 49152 )) ||
+		error "MDT returned ${served:-0} bytes, expected 49152"
+	(( ${inline:-0} >= 49152 )) ||
+		error "client used ${inline:-0} inline bytes, expected 49152"
+
+	# with the limit below the file size only the tail can be returned
+	do_facet $facet $LCTL set_param -n mdt.*.dom_read_open_max_size=0
+	cancel_lru_locks mdc
+	$LCTL set_param -n mdc.*.stats=clear
+
+	echo "Open and read with whole-file return disabled"
+	cat $dom > /dev/null
+	num=$(get_mdc_stats $mdtidx ost_read)
+	(( ${num:-0} >= 1 )) || error "expect READ RPC, none occured"
+	cmp $tmp $dom || error "file miscompare"
+}
+run_test 271e "DoM: read on open (48K file returned whole)"
+
 test_271f() {
 	[ $MDS1_VERSION -lt $(version_code 2.10.57) ] &&
 		skip "Need MDS version at least 2.10.57"
@@ -26925,6 +27147,455 @@ test_433() {
 }
 run_test 433 "ldlm lock cancel releases dentries and inodes"
 
+test_434() {
+	[ -f $LUSTRE/tests/kernel/kset_bench.ko ] ||
+		skip "Need MODULES build"
+
+	local run_id=$RANDOM
+
+	# The module runs the benchmark on load and then refuses to load.
+	insmod $LUSTRE/tests/kernel/kset_bench.ko run_id=$run_id \
+		nreqs=10000 nevents=20000 &> /dev/null
+
+	local line=$(dmesg | grep "lustre_kset_bench_$run_id:" | tail -1)
+
+	echo "$line"
+	[[ "$line" =~ "ready list" ]] || error "benchmark did not complete"
+
+	local scan=$(awk '{ for (i = 1; i < NF; i++)
+				if ($i == "scan") print $(i + 1) }' <<< "$line")
+	local ready=$(awk '{ for (i = 1; i < NF; i++)
+				if ($i == "list") print $(i + 1) }' <<< "$line")
+
+	# checking one ready request must beat walking 10000 of them
+	(( ready < scan )) ||
+		error "ready list $ready ns/event not faster than scan $scan"
+}
+run_test 434 "ptlrpc request set ready list vs full scan at 10k RPCs"
+
+test_435() {
+	(( OSTCOUNT >= 2 )) || skip_env "needs >= 2 OSTs"
+	$LCTL get_param osc.*.osc_stats | grep -q fsync_overlap ||
+		skip "Need client with fsync overlap stats"
+
+	$LFS setstripe -c $OSTCOUNT -S 1M $DIR/$tfile ||
+		error "setstripe $DIR/$tfile failed"
+
+	clear_stats osc.*.osc_stats
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=$((OSTCOUNT * 4)) \
+		conv=fsync || error "dd $DIR/$tfile failed"
+	$LCTL get_param osc.*.osc_stats | grep fsync
+
+	local syncs=$(calc_stats osc.*.osc_stats fsync_count)
+	local wait=$(calc_stats osc.*.osc_stats fsync_wait_usec)
+	local rpc=$(calc_stats osc.*.osc_stats fsync_rpc_usec)
+	local overlap=$(calc_stats osc.*.osc_stats fsync_overlap)
+
+	echo "writeback wait ${wait}us, OST_SYNC ${rpc}us for $syncs stripes"
+	(( syncs == OSTCOUNT )) ||
+		error "$syncs OST_SYNC RPCs for $OSTCOUNT stripes"
+	# every stripe but the first starts waiting for its writeback while
+	# the OST_SYNC of the previous ones is in flight, a serial fsync
+	# only sends the next OST_SYNC once the previous one is replied
+	(( overlap >= OSTCOUNT - 1 )) ||
+		error "only $overlap of $OSTCOUNT writeback waits overlap OST_SYNC"
+	cmp -n $((OSTCOUNT * 4 << 20)) /dev/zero $DIR/$tfile ||
+		error "$DIR/$tfile data mismatch"
+
+	# sync_file_range(SYNC_FILE_RANGE_WRITE) only starts writeback, it
+	# returns while the delayed BRW RPCs are still in flight
+	#define OBD_FAIL_OST_BRW_PAUSE_BULK	0x214
+	stack_trap "do_facet ost1 $LCTL set_param fail_loc=0 fail_val=0"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=$((OSTCOUNT * 4)) \
+		conv=notrunc || error "dd $DIR/$tfile failed"
+	do_facet ost1 $LCTL set_param fail_val=5 fail_loc=0x214
+
+	local start=$(date +%s%N)
+	local elapsed
+	local inflight
+
+	$MULTIOP $DIR/$tfile Ok || error "sync_file_range failed"
+	elapsed=$((($(date +%s%N) - start) / 1000000))
+	inflight=$($LCTL get_param -n osc.*-OST0000-osc-[^M]*.rpc_stats |
+		   awk '/write RPCs in flight:/ { print $NF }')
+	echo "sync_file_range returned after ${elapsed}ms, $inflight in flight"
+	(( elapsed < 5000 )) ||
+		error "sync_file_range waited ${elapsed}ms for the writeback"
+	(( inflight > 0 )) ||
+		error "no write RPC in flight after sync_file_range"
+
+	do_facet ost1 $LCTL set_param fail_loc=0 fail_val=0
+	$MULTIOP $DIR/$tfile oy || error "fsync failed"
+	cmp -n $((OSTCOUNT * 4 << 20)) /dev/zero $DIR/$tfile ||
+		error "$DIR/$tfile data mismatch after sync_file_range"
+}
+run_test 435 "fsync overlaps writeback and OST_SYNC of all stripes"
+
+test_436() {
+	local mdt=$(facet_svc mds1)
+	local param=mdt.$mdt.reply_slot_stats
+
+	do_facet mds1 $LCTL get_param -n $param &> /dev/null ||
+		skip "Need MDS with reply_slot_stats"
+
+	local before=$(do_facet mds1 $LCTL get_param -n $param |
+		       awk '/^allocated:/ { print $2 }')
+
+	test_mkdir -i 0 $DIR/$tdir
+	createmany -o $DIR/$tdir/f- 1000 || error "createmany failed"
+	do_facet mds1 $LCTL get_param $param
+
+	local after=$(do_facet mds1 $LCTL get_param -n $param |
+		      awk '/^allocated:/ { print $2 }')
+	local hits=$(do_facet mds1 $LCTL get_param -n $param |
+		     awk '/^cache_hits:/ { print $2 }')
+
+	(( after - before >= 1000 )) ||
+		error "only $((after - before)) reply slots for 1000 creates"
+	(( hits > 0 )) || error "no reply slot taken from the per-CPU cache"
+}
+run_test 436 "reply data slots are served from the per-CPU cache"
+
+test_437() {
+	local param=llite.*.read_ahead_fault_kb
+
+	$LCTL get_param -n $param &> /dev/null ||
+		skip "Need client with read_ahead_fault_kb"
+
+	local old=$($LCTL get_param -n $param | head -n 1)
+
+	stack_trap "$LCTL set_param $param=$old" EXIT
+	$LCTL set_param $param=1024
+
+	$LFS setstripe -c 1 -i 0 $DIR/$tfile || error "setstripe failed"
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=4 ||
+		error "dd failed"
+	cancel_lru_locks osc
+
+	$LCTL set_param llite.*.stats=clear llite.*.read_ahead_stats=clear
+	$MULTIOP $DIR/$tfile OSMRUc || error "$MULTIOP $DIR/$tfile failed"
+	$LCTL get_param llite.*.stats | grep -E "page_fault|fault_"
+	$LCTL get_param llite.*.read_ahead_stats
+
+	local reads=$($LCTL get_param -n llite.*.read_ahead_stats |
+		      awk '/mmap_fault_read/ { sum += $2 } END { print sum+0 }')
+	# fault_pages: samples are faults that did I/O, sum is pages read
+	local faults=$($LCTL get_param -n llite.*.stats |
+		       awk '/fault_pages/ { sum += $2 } END { print sum+0 }')
+	local pages=$($LCTL get_param -n llite.*.stats |
+		      awk '/fault_pages/ { sum += $7 } END { print sum+0 }')
+	local file_pages=$((4 * 1048576 / PAGE_SIZE))
+
+	(( reads > 0 )) || error "no fault read-around was issued"
+	(( faults > 0 )) || error "no page fault read from the OST"
+	# faults read at least the minimum read-around window on average
+	(( pages >= faults * 16 )) ||
+		error "$pages pages read by $faults faults, expect >= 16 per fault"
+	(( pages <= file_pages )) ||
+		error "$pages pages read by faults, file has $file_pages"
+}
+run_test 437 "page faults read around under a single lock"
+
+test_438() {
+	[ -f $LUSTRE/tests/kernel/t10pi_bench.ko ] ||
+		skip "Need MODULES build"
+
+	local run_id=$RANDOM
+
+	# The module runs the benchmark on load and then refuses to load.
+	insmod $LUSTRE/tests/kernel/t10pi_bench.ko run_id=$run_id \
+		size_kb=1024 msecs=100 &> /dev/null
+
+	dmesg | grep "lustre_t10pi_bench_$run_id:"
+
+	local line=$(dmesg | grep "lustre_t10pi_bench_$run_id:" | tail -1)
+
+	[[ "$line" =~ "CONFIG_CRC_T10DIF" ]] && skip "Need CONFIG_CRC_T10DIF"
+	[[ "$line" =~ "selected" ]] || error "benchmark did not complete"
+	[[ "$line" =~ " 0 failed" ]] || error "guard tag selftest failed"
+
+	$LCTL get_param -n t10pi_kernels ||
+		error "reading t10pi_kernels failed"
+	(( $($LCTL get_param -n t10pi_kernels | grep -c selected) == 2 )) ||
+		error "no implementation selected for each guard type"
+}
+run_test 438 "T10-PI guard tag implementations selftest and speed"
+
+test_439() {
+	local heat=$($LCTL get_param -n llite.*.file_heat | head -n1)
+	local count=$($LCTL get_param -n llite.*.heat_top_count | head -n1)
+
+	stack_trap "$LCTL set_param -n llite.*.file_heat=$heat" EXIT
+	stack_trap "$LCTL set_param -n llite.*.heat_top_count=$count" EXIT
+	$LCTL set_param -n llite.*.file_heat=1
+	# resizing empties the table, so only this test's files are listed
+	$LCTL set_param -n llite.*.heat_top_count=4
+
+	local i
+
+	for i in {1..6}; do
+		dd if=/dev/zero of=$DIR/$tfile.$i bs=4k count=$i conv=fsync \
+			2>/dev/null || error "write $DIR/$tfile.$i failed"
+	done
+	for i in {1..20}; do
+		cat $DIR/$tfile.6 > /dev/null || error "read $tfile.6 failed"
+	done
+
+	local out=$($LFS heat_get --top 10 $MOUNT)
+
+	echo "$out"
+	(( $(echo "$out" | grep -c "^\[") == 4 )) ||
+		error "expect 4 files listed, table holds 4"
+
+	local fid=$($LFS path2fid $DIR/$tfile.6)
+
+	[[ "$(echo "$out" | awk 'NR == 2 { print $1 }')" == "$fid" ]] ||
+		error "hottest file $fid is not listed first"
+	$LCTL get_param llite.*.heat_top | grep -q "$fid" ||
+		error "$fid not in llite.*.heat_top"
+	echo "$out" | grep -q $($LFS path2fid $DIR/$tfile.1) &&
+		error "coldest file $tfile.1 should have been evicted"
+
+	$LFS heat_set -c $DIR/$tfile.6
+	$LFS heat_get --top 10 $MOUNT | grep -q "$fid" &&
+		error "$fid still listed after its heat was cleared"
+	return 0
+}
+run_test 439 "client top-N hot file table"
+
+test_440() {
+	local file=$DIR/$tfile
+	local windows
+	local misses
+	local t0
+
+	$LFS setstripe -c $OSTCOUNT $file || error "setstripe $file failed"
+	dd if=/dev/urandom of=$file bs=1M count=64 ||
+		error "failed to write $file"
+	stack_trap "rm -f $file $file.copy" EXIT
+
+	# cold cache: pages come through cl_io, sized by the splice length
+	cancel_lru_locks osc
+	$LCTL set_param -n llite.*.read_ahead_stats=0
+	t0=$SECONDS
+	sendfile $file $file.copy || error "cold sendfile wrong"
+	echo "cold sendfile took $((SECONDS - t0))s"
+	windows=$($LCTL get_param -n llite.*.read_ahead_stats |
+		  get_named_value 'splice_window' | calc_total)
+	(( windows > 0 )) || {
+		$LCTL get_param llite.*.read_ahead_stats
+		error "readahead window not opened by sendfile"
+	}
+
+	# warm cache: every page is handed to the pipe from the page cache
+	$LCTL set_param -n llite.*.read_ahead_stats=0
+	t0=$SECONDS
+	sendfile $file $file.copy || error "warm sendfile wrong"
+	echo "warm sendfile took $((SECONDS - t0))s"
+	misses=$($LCTL get_param -n llite.*.read_ahead_stats |
+		 get_named_value 'misses' | calc_total)
+	(( misses == 0 )) || {
+		$LCTL get_param llite.*.read_ahead_stats
+		error "$misses cache misses on a cached file"
+	}
+
+	splice-test -rd $file || error "splice read failed"
+}
+run_test 440 "sendfile from cached and uncached Lustre files"
+
+readdir_stats_count() {
+	$LCTL get_param -n lmv.*.readdir_stats |
+		awk -v name=$1 '$1 == name { sum += $2 } END { print sum + 0 }'
+}
+
+test_441() {
+	(( MDSCOUNT >= 2 )) || skip "needs >= 2 MDTs"
+
+	local prefetch=$($LCTL get_param -n lmv.*.readdir_prefetch | head -n1)
+	local count=2000
+	local window=4
+	local loads
+	local pages
+	local last
+	local nr
+
+	$LFS mkdir -i 0 -c $MDSCOUNT $DIR/$tdir || error "mkdir $tdir failed"
+	createmany -o $DIR/$tdir/f $count || error "createmany failed"
+	stack_trap "$LCTL set_param lmv.*.readdir_prefetch=$prefetch" EXIT
+
+	$LCTL set_param lmv.*.readdir_prefetch=$window
+	cancel_lru_locks mdc
+	$LCTL set_param -n lmv.*.readdir_stats=clear
+	nr=$(ls -U $DIR/$tdir | wc -l)
+	(( nr == count )) || error "listed $nr entries, expect $count"
+
+	# lookahead completes in the background, wait for it to settle
+	last=-1
+	pages=$(readdir_stats_count prefetch)
+	while (( pages != last )); do
+		last=$pages
+		sleep 1
+		pages=$(readdir_stats_count prefetch)
+	done
+	$LCTL get_param lmv.*.readdir_stats
+	loads=$(readdir_stats_count stripe_wait)
+	(( pages > 0 )) || error "no stripe page was read ahead"
+	# one window per stripe at start, then a refill of window + 1 pages
+	# every window / 2 + 1 stripe pages consumed
+	(( pages <= 2 * loads + MDSCOUNT * window )) ||
+		error "$pages pages read ahead for $loads stripe pages"
+
+	$LCTL set_param lmv.*.readdir_prefetch=0
+	cancel_lru_locks mdc
+	$LCTL set_param -n lmv.*.readdir_stats=clear
+	nr=$(ls -U $DIR/$tdir | wc -l)
+	(( nr == count )) || error "listed $nr entries without lookahead"
+	pages=$(readdir_stats_count prefetch)
+	(( pages == 0 )) || error "$pages pages read ahead while disabled"
+}
+run_test 441 "striped directory readdir lookahead"
+
+test_442() {
+	[[ -f /sys/module/libcfs/parameters/libcfs_trace_binary ]] ||
+		skip "need binary debug tracing"
+
+	local old_binary=$($LCTL get_param -n trace_binary)
+	local old_debug="$($LCTL get_param -n debug)"
+	local dk=$TMP/$tfile.dk
+	local before
+	local after
+
+	stack_trap "$LCTL set_param trace_binary=$old_binary debug='$old_debug'"
+	$LCTL set_param debug="+rpctrace +info +vfstrace"
+
+	# text records, no binary record is formatted
+	$LCTL set_param trace_binary=0
+	$LCTL clear
+	before=$($LCTL get_param -n trace_binary_records)
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=4 conv=fsync ||
+		error "dd text failed"
+	$LCTL dk > $dk
+	after=$($LCTL get_param -n trace_binary_records)
+	(( after == before )) ||
+		error "$((after - before)) binary records without trace_binary"
+
+	# binary records, formatted by debug_kernel. "Sending RPC" is a
+	# plain CDEBUG(), "refcount now" a DEBUG_REQ() passing it as %pV.
+	# The foreign directory value is longer than a record and is cut.
+	local value=$(printf "%01000d" 0)
+	local nrpc
+	local nreq
+
+	$LCTL set_param trace_binary=1
+	$LCTL clear
+	$LCTL mark "binary trace $tfile"
+	before=$($LCTL get_param -n trace_binary_records)
+	dd if=/dev/zero of=$DIR/$tfile bs=1M count=4 conv=fsync ||
+		error "dd binary failed"
+	$LFS mkdir --foreign=none --xattr=$value --flags=0xda05 $DIR/$tdir ||
+		error "foreign mkdir failed"
+	$LCTL dk > $dk
+	after=$($LCTL get_param -n trace_binary_records)
+	nrpc=$(grep -c "Sending RPC" $dk)
+	nreq=$(grep -c "refcount now" $dk)
+	echo "binary records formatted: $((after - before)), sent $nrpc, put $nreq"
+
+	grep -q "DEBUG MARKER: binary trace $tfile" $dk ||
+		error "console message missing from binary trace"
+	(( after > before )) || error "no binary trace records"
+	(( nrpc > 0 && nreq > 0 )) || error "no RPC trace records"
+	(( after - before >= nrpc + nreq )) ||
+		error "DEBUG_REQ() messages not recorded as binary"
+	grep "Sending RPC" $dk | grep -q "req@.*pname:cluuid:pid:xid:nid" ||
+		error "binary RPC trace record badly formatted"
+	grep "refcount now [0-9]* req@.* job:'.*'" $dk | grep -q "x[0-9]*/t" ||
+		error "binary DEBUG_REQ() record badly formatted"
+	grep -E "Sending RPC|refcount now" $dk | grep -q "%" &&
+		error "unformatted conversion in binary trace record"
+	grep -q "foreign, length 1000, value '0*\[\.\.\.\]'" $dk ||
+		error "cut string not marked in binary trace record"
+	rm -f $dk
+	rmdir $DIR/$tdir
+}
+run_test 442 "binary debug trace records are formatted by debug_kernel"
+
+llite_cached_mb() {
+	$LCTL get_param -n llite.*.max_cached_mb |
+		awk "/^$1:/ { print \$2; exit }"
+}
+
+osc_cached_sum() {
+	$LCTL get_param -n osc.*-osc-[^M]*.osc_cached_mb |
+		awk "/^$1:/ { sum += \$2 } END { print sum + 0 }"
+}
+
+check_443_accounting() {
+	local max=$(llite_cached_mb max_cached_mb)
+	local used=$(llite_cached_mb used_mb)
+	local unused=$(llite_cached_mb unused_mb)
+	local osc_used=$(osc_cached_sum used_mb)
+	local busy=$(osc_cached_sum busy_cnt)
+
+	echo "$1: max $max used $used unused $unused osc used $osc_used busy $busy"
+	(( unused >= 0 && used <= max )) ||
+		error "$1: used $used unused $unused out of max $max"
+	# each OSC rounds its pages down to whole MiB
+	(( used >= osc_used && used <= osc_used + OSTCOUNT )) ||
+		error "$1: llite used $used, OSCs hold $osc_used MiB"
+	(( busy == 0 )) || error "$1: $busy pages left busy after IO"
+}
+
+test_443() {
+	local ncpus=$(nproc)
+	local old_max=$(llite_cached_mb max_cached_mb)
+	local cpu
+	local used
+
+	(( ncpus > 1 )) || skip "needs more than one CPU"
+	which taskset > /dev/null || skip_env "taskset is not installed"
+	(( ncpus * 8 < old_max )) || skip "max_cached_mb $old_max too small"
+
+	stack_trap "$LCTL set_param llite.*.max_cached_mb=$old_max"
+	test_mkdir $DIR/$tdir
+	$LFS setstripe -c -1 $DIR/$tdir || error "setstripe failed"
+	cancel_lru_locks osc
+
+	# fill the LRU partitions of every CPT from writers on every CPU
+	for ((cpu = 0; cpu < ncpus; cpu++)); do
+		taskset -c $cpu dd if=/dev/zero of=$DIR/$tdir/$tfile.$cpu \
+			bs=1M count=8 conv=fsync 2> /dev/null &
+	done
+	wait
+	check_443_accounting "write"
+	used=$(llite_cached_mb used_mb)
+	(( used >= ncpus * 8 - OSTCOUNT )) ||
+		error "used_mb $used after writing $((ncpus * 8)) MiB"
+
+	# redirty the cached pages from another CPU, so they are taken off
+	# the LRU partitions of other CPTs and put back after the write
+	for ((cpu = 0; cpu < ncpus; cpu++)); do
+		taskset -c $(((cpu + 1) % ncpus)) dd if=/dev/zero \
+			of=$DIR/$tdir/$tfile.$cpu bs=1M count=8 \
+			conv=notrunc,fsync 2> /dev/null &
+	done
+	wait
+	check_443_accounting "rewrite"
+
+	# shrink below the cached pages
+	$LCTL set_param llite.*.max_cached_mb=$((used / 2)) ||
+		error "cannot set max_cached_mb"
+	check_443_accounting "shrink"
+
+	# memory reclaim frees pages of every partition
+	$LCTL set_param llite.*.max_cached_mb=$old_max
+	echo 3 > /proc/sys/vm/drop_caches
+	check_443_accounting "reclaim"
+	(( $(llite_cached_mb used_mb) <= OSTCOUNT )) ||
+		error "$(llite_cached_mb used_mb) MiB still cached after reclaim"
+	rm -rf $DIR/$tdir
+}
+run_test 443 "page LRU accounting across CPT partitions"
+
 prep_801() {
 	[[ $MDS1_VERSION -lt $(version_code 2.9.55) ]] ||
 	[[ $OST1_VERSION -lt $(version_code 2.9.55) ]] &&
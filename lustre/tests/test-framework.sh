@@ -340,6 +340,10 @@ init_test_env() {
 	[ ! -f "$LSOM_SYNC" ] &&
 		export LSOM_SYNC=$(which llsom_sync 2> /dev/null)
 	[ -z "$LSOM_SYNC" ] && export LSOM_SYNC="/usr/sbin/llsom_sync"
+	export LPCC_PREFETCH=${LPCC_PREFETCH:-"$LUSTRE/utils/lpcc_prefetch"}
+	[ ! -f "$LPCC_PREFETCH" ] &&
+		export LPCC_PREFETCH=$(which lpcc_prefetch 2> /dev/null)
+	[ -z "$LPCC_PREFETCH" ] && export LPCC_PREFETCH="/usr/sbin/lpcc_prefetch"
 	export NAME=${NAME:-local}
 	export LGSSD=${LGSSD:-"$LUSTRE/utils/gss/lgssd"}
 	[ "$GSS_PIPEFS" = "true" ] && [ ! -f "$LGSSD" ] &&
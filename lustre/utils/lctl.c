@@ -581,6 +581,13 @@ command_t cmdlist[] = {
 	{"test_brw", jt_obd_test_brw, 0,
 	 "do <num> bulk read/writes (<npages> per I/O, on OST object <objid>)\n"
 	 "usage: test_brw [t]<num> [write [verbose [npages [[t]objid]]]]"},
+	{"echo_bench", jt_obd_echo_bench, 0,
+	 "run a threaded I/O and attribute op mix through echo_client devices\n"
+	 "and print throughput and latency percentiles as JSON\n"
+	 "usage: echo_bench [--device DEV[,DEV...]] [--threads N] "
+	 "[--objects N] [--size BYTES] [--object-size BYTES] "
+	 "[--count N | --time SECONDS] [--random] "
+	 "[--mix OP[=WEIGHT][,...]] [--keep]"},
 	{"getobjversion", jt_get_obj_version, 0,
 	 "get the version of an object on servers\n"
 	 "usage: getobjversion <fid>\n"
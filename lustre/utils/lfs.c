@@ -57,6 +57,7 @@
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <sys/param.h>
+#include <sys/wait.h>
 #include <sys/xattr.h>
 #include <fcntl.h>
 #include <dirent.h>
@@ -216,7 +217,10 @@ static inline int lfs_mirror_delete(int argc, char **argv)
 	SSM_CMD_COMMON("migrate  ")					\
 	"                 [--block|-b] [--non-block|-n]\n"		\
 	"                 [--non-direct|-D] [--verbose|-v]\n"		\
-	"                 FILENAME\n"
+	"                 [--threads=COUNT] [--stats]\n"		\
+	"                 [--stats-interval=SECONDS]\n"			\
+	"                 [--files-from=LIST] [--jobs=COUNT]\n"		\
+	"                 FILENAME ...\n"
 
 #define SETDIRSTRIPE_USAGE						\
 	"		[--mdt-count|-c stripe_count>\n"		\
@@ -264,10 +268,13 @@ command_t mirror_cmdlist[] = {
 	{ .pc_name = "copy", .pc_func = lfs_mirror_copy,
 	  .pc_help = "Copy a specified mirror to other mirror(s) of a file.\n"
 		"usage: lfs mirror copy {--read-mirror|-i MIRROR_ID0}\n"
-		"\t\t{--write-mirror|-o MIRROR_ID1[,...]} <mirrored_file>\n" },
+		"\t\t{--write-mirror|-o MIRROR_ID1[,...]}\n"
+		"\t\t[--threads=COUNT] [--stats [--stats-interval=SECONDS]]\n"
+		"\t\t<mirrored_file>\n" },
 	{ .pc_name = "resync", .pc_func = lfs_mirror_resync,
 	  .pc_help = "Resynchronizes out-of-sync mirrored file(s).\n"
 		"usage: lfs mirror resync [--only MIRROR_ID[,...]>]\n"
+		"\t\t[--threads=COUNT] [--stats [--stats-interval=SECONDS]]\n"
 		"\t\t<mirrored_file> [<mirrored_file2>...]\n" },
 	{ .pc_name = "verify", .pc_func = lfs_mirror_verify,
 	  .pc_help = "Verify mirrored file(s).\n"
@@ -561,8 +568,10 @@ command_t cmdlist[] = {
 	 "\t-b: Only show the blocks value of the SOM data for a given file\n"
 	 "\t-f: Only show the flags value of the SOM data for a given file\n"},
 	{"heat_get", lfs_heat_get, 0,
-	 "To get heat of files.\n"
-	 "usage: heat_get <file> ...\n"},
+	 "To get heat of files, or the hottest files of a client mount.\n"
+	 "usage: heat_get <file> ...\n"
+	 "       heat_get --top|-t COUNT <mountpoint>\n"
+	 "\t--top|-t:	List the COUNT hottest files seen by this client\n"},
 	{"heat_set", lfs_heat_set, 0,
 	 "To set heat flags of files.\n"
 	 "usage: heat_set [--clear|-c] [--off|-o] [--on|-O] <file> ...\n"
@@ -775,100 +784,90 @@ out:
 	return rc;
 }
 
-static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int))
+/* progress of the mirror copy and migrate commands, printed with --stats */
+struct lfs_copy_progress {
+	const char	*lcp_fname;
+	time_t		 lcp_interval;	/* seconds between reports */
+	time_t		 lcp_last;
+};
+
+static int lfs_copy_progress_cb(const struct llapi_mirror_copy_stats *stats,
+				void *cbdata)
 {
-	struct llapi_layout *layout;
-	size_t buf_size = 4 * 1024 * 1024;
-	void *buf = NULL;
-	off_t pos = 0;
-	off_t data_end = 0;
-	size_t page_size = sysconf(_SC_PAGESIZE);
-	bool sparse;
-	int rc;
+	struct lfs_copy_progress *lcp = cbdata;
+	time_t now = time(NULL);
+	double secs;
 
-	layout = llapi_layout_get_by_fd(fd_src, 0);
-	if (layout) {
-		uint64_t stripe_size;
+	if (now < lcp->lcp_last + lcp->lcp_interval &&
+	    stats->mcs_pos < stats->mcs_size)
+		return 0;
+	lcp->lcp_last = now;
+
+	secs = stats->mcs_elapsed_ms ? stats->mcs_elapsed_ms / 1000.0 : 0.001;
+	printf("%s: %llu/%llu MiB copied, %llu MiB sparse, %.1f MiB/s, %u threads, %u targets\n",
+	       lcp->lcp_fname,
+	       (unsigned long long)stats->mcs_pos >> 20,
+	       (unsigned long long)stats->mcs_size >> 20,
+	       (unsigned long long)stats->mcs_hole_bytes >> 20,
+	       stats->mcs_read_bytes / 1048576.0 / secs,
+	       stats->mcs_threads, stats->mcs_targets);
+	fflush(stdout);
 
-		rc = llapi_layout_stripe_size_get(layout, &stripe_size);
-		if (rc == 0)
-			buf_size = stripe_size;
+	return 0;
+}
 
-		llapi_layout_free(layout);
-	}
+/* copy threads and --stats of lfs migrate */
+static struct llapi_mirror_copy_param migrate_copy_param;
+static struct lfs_copy_progress migrate_copy_progress = {
+	.lcp_interval = 5,
+};
 
-	/* Use a page-aligned buffer for direct I/O */
-	rc = posix_memalign(&buf, page_size, buf_size);
-	if (rc != 0)
-		return -rc;
+struct migrate_copy_check {
+	int			(*mcc_check_file)(int fd);
+	int			  mcc_fd;
+	llapi_mirror_copy_cb	  mcc_progress;
+	void			 *mcc_cbdata;
+};
 
-	sparse = llapi_file_is_sparse(fd_src);
-	if (sparse) {
-		rc = ftruncate(fd_dst, pos);
-		if (rc < 0) {
-			rc = -errno;
+/* called after each batch of the data copy */
+static int migrate_copy_cb(const struct llapi_mirror_copy_stats *stats,
+			   void *cbdata)
+{
+	struct migrate_copy_check *check = cbdata;
+	int rc;
+
+	if (check->mcc_check_file) {
+		rc = check->mcc_check_file(check->mcc_fd);
+		if (rc < 0)
 			return rc;
-		}
 	}
 
-	while (1) {
-		off_t data_off;
-		size_t to_read, to_write;
-		ssize_t rsize;
+	if (check->mcc_progress)
+		return check->mcc_progress(stats, check->mcc_cbdata);
 
-		if (sparse && pos >= data_end) {
-			size_t data_size;
-
-			data_off = llapi_data_seek(fd_src, pos, &data_size);
-			if (data_off < 0) {
-				/* Non-fatal, switch to full copy */
-				sparse = false;
-				continue;
-			}
-			/* hole at the end of file, truncate up to it */
-			if (!data_size) {
-				rc = ftruncate(fd_dst, data_off);
-				if (rc < 0)
-					goto out;
-			}
-			pos = data_off & ~(page_size - 1);
-			data_end = data_off + data_size;
-			to_read = ((data_end - pos - 1) | (page_size - 1)) + 1;
-			to_read = MIN(to_read, buf_size);
-		} else {
-			to_read = buf_size;
-		}
-
-		if (check_file) {
-			rc = check_file(fd_src);
-			if (rc < 0)
-				goto out;
-		}
+	return 0;
+}
 
-		rsize = pread(fd_src, buf, to_read, pos);
-		if (rsize < 0) {
-			rc = -errno;
-			goto out;
-		}
-		/* EOF */
-		if (rsize == 0)
-			break;
+static int migrate_copy_data(int fd_src, int fd_dst, int (*check_file)(int))
+{
+	struct llapi_mirror_copy_param param = migrate_copy_param;
+	struct migrate_copy_check check = {
+		.mcc_check_file = check_file,
+		.mcc_fd = fd_src,
+		.mcc_progress = migrate_copy_param.mcp_cb,
+		.mcc_cbdata = migrate_copy_param.mcp_cbdata,
+	};
+	int rc;
 
-		to_write = rsize;
-		while (to_write > 0) {
-			ssize_t written;
+	param.mcp_cb = migrate_copy_cb;
+	param.mcp_cbdata = &check;
 
-			written = pwrite(fd_dst, buf, to_write, pos);
-			if (written < 0) {
-				rc = -errno;
-				goto out;
-			}
-			pos += written;
-			to_write -= written;
-		}
-		if (rc || rsize < to_read)
-			break;
-	}
+	/* data is copied in parallel, in chunks aligned to the stripes of
+	 * both files, and holes of a sparse source file are skipped
+	 */
+	rc = llapi_file_copy_data(fd_src, fd_dst, &param);
+	if (rc < 0)
+		goto out;
 
 	rc = fsync(fd_dst);
 	if (rc < 0)
@@ -878,7 +877,6 @@ out:
 	(void)posix_fadvise(fd_src, 0, 0, POSIX_FADV_DONTNEED);
 	(void)posix_fadvise(fd_dst, 0, 0, POSIX_FADV_DONTNEED);
 
-	free(buf);
 	return rc;
 }
 
@@ -1219,6 +1217,9 @@ static int lfs_migrate(char *name, __u64 migration_flags,
 	int fdv = -1;
 	int rc;
 
+	migrate_copy_progress.lcp_fname = name;
+	migrate_copy_progress.lcp_last = 0;
+
 	rc = migrate_open_files(name, migration_flags, param, layout,
 				&fd, &fdv);
 	if (rc < 0)
@@ -1304,6 +1305,158 @@ out_closed:
 	return rc;
 }
 
+/* upper limit of lfs migrate --jobs */
+#define LFS_MIGRATE_JOBS_MAX	256
+
+/* next file to migrate, from the command line then from the --files-from list */
+static char *lfs_migrate_next(char ***names, FILE *list, char **line,
+			      size_t *line_size)
+{
+	ssize_t len;
+
+	if (**names)
+		return *(*names)++;
+
+	if (!list)
+		return NULL;
+
+	while ((len = getline(line, line_size, list)) != -1) {
+		if (len > 0 && (*line)[len - 1] == '\n')
+			(*line)[--len] = '\0';
+		if (len > 0)
+			return *line;
+	}
+
+	return NULL;
+}
+
+static int lfs_migrate_one(char *name, __u64 migration_flags,
+			   struct llapi_stripe_param *param,
+			   struct llapi_layout *layout, bool from_copy,
+			   const char *template)
+{
+	int rc;
+
+	if (from_copy) {
+		layout = llapi_layout_get_by_path(template ?: name, 0);
+		if (!layout) {
+			rc = -errno;
+			fprintf(stderr,
+				"%s: can't create composite layout from file %s: %s\n",
+				progname, template ?: name, strerror(-rc));
+			return rc;
+		}
+	}
+
+	rc = lfs_migrate(name, migration_flags, param, layout);
+
+	if (from_copy)
+		llapi_layout_free(layout);
+
+	return rc;
+}
+
+/* reap one migration child, return its result */
+static int lfs_migrate_wait(void)
+{
+	int status;
+	pid_t pid;
+
+	do
+		pid = wait(&status);
+	while (pid < 0 && errno == EINTR);
+
+	if (pid < 0)
+		return -errno;
+	if (!WIFEXITED(status))
+		return -EINTR;
+
+	return -WEXITSTATUS(status);
+}
+
+/**
+ * Migrate the files given on the command line and those listed in the file
+ * \a files_from, one name per line, "-" for standard input. Up to \a jobs
+ * files are migrated at the same time, each one by a child process, so
+ * that every migration keeps its own lease, group lock and error state.
+ *
+ * \retval 0       all files were migrated.
+ * \retval -errno  the first error, the other files are still migrated.
+ */
+static int lfs_migrate_many(char **names, const char *files_from,
+			    unsigned int jobs, __u64 migration_flags,
+			    struct llapi_stripe_param *param,
+			    struct llapi_layout *layout, bool from_copy,
+			    const char *template)
+{
+	unsigned int running = 0;
+	size_t line_size = 0;
+	char *line = NULL;
+	FILE *list = NULL;
+	char *name;
+	int rc = 0;
+	int rc2;
+
+	if (files_from) {
+		list = strcmp(files_from, "-") ? fopen(files_from, "r") : stdin;
+		if (!list) {
+			rc = -errno;
+			fprintf(stderr, "%s: cannot open '%s': %s\n",
+				progname, files_from, strerror(-rc));
+			return rc;
+		}
+	}
+
+	while ((name = lfs_migrate_next(&names, list, &line,
+					&line_size)) != NULL) {
+		pid_t pid = -1;
+
+		if (jobs > 1) {
+			if (running == jobs) {
+				rc2 = lfs_migrate_wait();
+				running--;
+				if (rc2 && !rc)
+					rc = rc2;
+			}
+
+			/* don't let the child flush the parent buffers */
+			fflush(stdout);
+			fflush(stderr);
+			pid = fork();
+			if (pid > 0) {
+				running++;
+				continue;
+			}
+			if (pid < 0)
+				fprintf(stderr,
+					"%s: cannot fork, migrating '%s' in foreground: %s\n",
+					progname, name, strerror(errno));
+		}
+
+		rc2 = lfs_migrate_one(name, migration_flags, param, layout,
+				      from_copy, template);
+		if (pid == 0) {
+			fflush(stdout);
+			_exit(rc2 < 0 ? -rc2 : 0);
+		}
+		if (rc2 && !rc)
+			rc = rc2;
+	}
+
+	while (running > 0) {
+		rc2 = lfs_migrate_wait();
+		running--;
+		if (rc2 && !rc)
+			rc = rc2;
+	}
+
+	free(line);
+	if (list && list != stdin)
+		fclose(list);
+
+	return rc;
+}
+
 static int comp_str2flags(char *string, __u32 *flags, __u32 *neg_flags)
 {
 	char *name;
@@ -2357,7 +2510,8 @@ free_layout:
 
 static inline
 int lfs_mirror_resync_file(const char *fname, struct ll_ioc_lease *ioc,
-			   __u16 *mirror_ids, int ids_nr);
+			   __u16 *mirror_ids, int ids_nr,
+			   const struct llapi_mirror_copy_param *param);
 
 static int lfs_migrate_to_dom(int fd, int fdv, char *name,
 			      __u64 migration_flags)
@@ -2397,7 +2551,7 @@ static int lfs_migrate_to_dom(int fd, int fdv, char *name,
 	close(fd);
 	close(fdv);
 
-	rc = lfs_mirror_resync_file(name, data, NULL, 0);
+	rc = lfs_mirror_resync_file(name, data, NULL, 0, NULL);
 	if (rc) {
 		error_loc = "cannot resync file";
 		goto out;
@@ -3352,8 +3506,52 @@ enum {
 	LFS_INHERIT_RR_OPT,
 	LFS_FIND_PERM,
 	LFS_PRINTF_OPT,
+	LFS_STATS_OPT,
+	LFS_STATS_INTERVAL_OPT,
+	LFS_THREADS_OPT,
+	LFS_FILES_FROM_OPT,
+	LFS_JOBS_OPT,
 };
 
+/* handle --threads, --stats and --stats-interval of data copy commands */
+static int lfs_copy_param_parse(int c, char *arg,
+				struct llapi_mirror_copy_param *param,
+				struct lfs_copy_progress *lcp)
+{
+	unsigned long val;
+	char *end;
+
+	switch (c) {
+	case LFS_THREADS_OPT:
+		errno = 0;
+		val = strtoul(arg, &end, 0);
+		if (errno != 0 || *end != '\0' || val == 0 ||
+		    val > LLAPI_MIRROR_COPY_THREADS_MAX) {
+			fprintf(stderr, "%s: invalid thread count '%s'\n",
+				progname, arg);
+			return -EINVAL;
+		}
+		param->mcp_threads = val;
+		break;
+	case LFS_STATS_INTERVAL_OPT:
+		errno = 0;
+		val = strtoul(arg, &end, 0);
+		if (errno != 0 || *end != '\0') {
+			fprintf(stderr, "%s: invalid stats interval '%s'\n",
+				progname, arg);
+			return -EINVAL;
+		}
+		lcp->lcp_interval = val;
+		fallthrough;
+	case LFS_STATS_OPT:
+		param->mcp_cb = lfs_copy_progress_cb;
+		param->mcp_cbdata = lcp;
+		break;
+	}
+
+	return 0;
+}
+
 #ifndef LCME_USER_MIRROR_FLAGS
 /* The mirror flags can be set by users at creation time. */
 #define LCME_USER_MIRROR_FLAGS  (LCME_FL_PREF_RW)
@@ -3381,6 +3579,8 @@ static int lfs_setstripe_internal(int argc, char **argv,
 	bool				 setstripe_mode = false;
 	bool				 migration_block = false;
 	__u64				 migration_flags = 0;
+	char				*migrate_files_from = NULL;
+	unsigned long			 migrate_jobs = 1;
 	__u32				 tgts[LOV_MAX_STRIPE_COUNT] = { 0 };
 	int				 comp_del = 0, comp_set = 0;
 	int				 comp_add = 0;
@@ -3442,6 +3642,17 @@ static int lfs_setstripe_internal(int argc, char **argv,
 			.name = "mode",		.has_arg = required_argument},
 	{ .val = LFS_LAYOUT_COPY,
 			.name = "copy",		.has_arg = required_argument},
+	/* the following are only valid in migrate mode */
+	{ .val = LFS_FILES_FROM_OPT,
+			.name = "files-from",	.has_arg = required_argument},
+	{ .val = LFS_JOBS_OPT,
+			.name = "jobs",		.has_arg = required_argument},
+	{ .val = LFS_STATS_OPT,
+			.name = "stats",	.has_arg = no_argument},
+	{ .val = LFS_STATS_INTERVAL_OPT,
+			.name = "stats-interval", .has_arg = required_argument},
+	{ .val = LFS_THREADS_OPT,
+			.name = "threads",	.has_arg = required_argument},
 	{ .val = 'c',	.name = "stripe-count",	.has_arg = required_argument},
 	{ .val = 'c',	.name = "stripe_count",	.has_arg = required_argument},
 	{ .val = 'c',	.name = "mdt-count",	.has_arg = required_argument},
@@ -3857,6 +4068,46 @@ static int lfs_setstripe_internal(int argc, char **argv,
 			}
 			migration_flags |= LLAPI_MIGRATION_NONBLOCK;
 			break;
+		case LFS_FILES_FROM_OPT:
+			if (!migrate_mode) {
+				fprintf(stderr,
+					"%s %s: --files-from valid only for migrate command\n",
+					progname, argv[0]);
+				goto usage_error;
+			}
+			migrate_files_from = optarg;
+			break;
+		case LFS_JOBS_OPT:
+			if (!migrate_mode) {
+				fprintf(stderr,
+					"%s %s: --jobs valid only for migrate command\n",
+					progname, argv[0]);
+				goto usage_error;
+			}
+			errno = 0;
+			migrate_jobs = strtoul(optarg, &end, 0);
+			if (errno != 0 || *end != '\0' || migrate_jobs == 0 ||
+			    migrate_jobs > LFS_MIGRATE_JOBS_MAX) {
+				fprintf(stderr,
+					"%s %s: invalid number of jobs '%s'\n",
+					progname, argv[0], optarg);
+				goto usage_error;
+			}
+			break;
+		case LFS_STATS_OPT:
+		case LFS_STATS_INTERVAL_OPT:
+		case LFS_THREADS_OPT:
+			if (!migrate_mode) {
+				fprintf(stderr,
+					"%s %s: --%s valid only for migrate command\n",
+					progname, argv[0],
+					c == LFS_THREADS_OPT ? "threads" : "stats");
+				goto usage_error;
+			}
+			if (lfs_copy_param_parse(c, optarg, &migrate_copy_param,
+						 &migrate_copy_progress))
+				goto usage_error;
+			break;
 		case 'N':
 			if (opc == SO_SETSTRIPE) {
 				opc = SO_MIRROR_CREATE;
@@ -4001,7 +4252,7 @@ static int lfs_setstripe_internal(int argc, char **argv,
 
 	fname = argv[optind];
 
-	if (optind == argc) {
+	if (optind == argc && (!migrate_files_from || comp_add)) {
 		fprintf(stderr, "%s %s: FILE must be specified\n",
 			progname, argv[0]);
 		goto usage_error;
@@ -4164,6 +4415,13 @@ static int lfs_setstripe_internal(int argc, char **argv,
 		goto usage_error;
 	}
 
+	if (migrate_mdt_mode && (migrate_files_from || migrate_jobs > 1)) {
+		fprintf(stderr,
+			"%s %s: options --files-from and --jobs are not valid with -m\n",
+			progname, argv[0]);
+		goto usage_error;
+	}
+
 	if (!comp_del && !comp_set && opc != SO_MIRROR_SPLIT &&
 	    opc != SO_MIRROR_DELETE && comp_id != 0) {
 		fprintf(stderr,
@@ -4301,6 +4559,14 @@ static int lfs_setstripe_internal(int argc, char **argv,
 		}
 	}
 
+	if (migrate_mode && !migrate_mdt_mode &&
+	    (migrate_files_from || migrate_jobs > 1)) {
+		result2 = lfs_migrate_many(argv + optind, migrate_files_from,
+					   migrate_jobs, migration_flags,
+					   param, layout, from_copy, template);
+		goto out;
+	}
+
 	for (fname = argv[optind]; fname != NULL; fname = argv[++optind]) {
 		if (from_copy) {
 			layout = llapi_layout_get_by_path(template ?: fname, 0);
@@ -4389,6 +4655,7 @@ static int lfs_setstripe_internal(int argc, char **argv,
 		}
 	}
 
+out:
 	if (mode_opt)
 		umask(previous_umask);
 
@@ -10299,24 +10566,120 @@ next:
 
 static const char *const heat_names[] = LU_HEAT_NAMES;
 
+static int lfs_heat_top(char *path, unsigned int count)
+{
+	struct lu_heat_top *top;
+	int rc;
+	int fd;
+	int i;
+
+	top = calloc(1, offsetof(struct lu_heat_top, lht_entries[count]));
+	if (!top) {
+		fprintf(stderr, "%s heat_get: memory allocation failed\n",
+			progname);
+		return -ENOMEM;
+	}
+
+	fd = open(path, O_RDONLY | O_DIRECTORY);
+	if (fd < 0) {
+		rc = -errno;
+		fprintf(stderr, "%s heat_get: cannot open '%s': %s\n",
+			progname, path, strerror(errno));
+		goto out_free;
+	}
+
+	top->lht_count = count;
+	rc = llapi_heat_top_get(fd, top);
+	close(fd);
+	if (rc < 0) {
+		fprintf(stderr,
+			"%s heat_get: cannot get hot files of '%s': %s\n",
+			progname, path, strerror(-rc));
+		goto out_free;
+	}
+
+	printf("%-*s %12s %12s %16s %16s\n", FID_LEN, "fid",
+	       heat_names[OBD_HEAT_READSAMPLE],
+	       heat_names[OBD_HEAT_WRITESAMPLE],
+	       heat_names[OBD_HEAT_READBYTE], heat_names[OBD_HEAT_WRITEBYTE]);
+	for (i = 0; i < top->lht_count; i++)
+		printf(DFID" %12llu %12llu %16llu %16llu\n",
+		       PFID(&top->lht_entries[i].lhte_fid),
+		       (unsigned long long)
+		       top->lht_entries[i].lhte_heat[OBD_HEAT_READSAMPLE],
+		       (unsigned long long)
+		       top->lht_entries[i].lhte_heat[OBD_HEAT_WRITESAMPLE],
+		       (unsigned long long)
+		       top->lht_entries[i].lhte_heat[OBD_HEAT_READBYTE],
+		       (unsigned long long)
+		       top->lht_entries[i].lhte_heat[OBD_HEAT_WRITEBYTE]);
+out_free:
+	free(top);
+	return rc;
+}
+
 static int lfs_heat_get(int argc, char **argv)
 {
+	struct option long_opts[] = {
+	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
+	{ .val = 't',	.name = "top",		.has_arg = required_argument },
+	{ .name = NULL } };
 	struct lu_heat *heat;
+	unsigned long top = 0;
 	int rc = 0, rc2;
 	char *path;
+	char *end;
 	int fd;
 	int i;
+	int c;
 
 	if (argc <= 1)
 		return CMD_HELP;
 
+	optind = 0;
+	while ((c = getopt_long(argc, argv, "ht:", long_opts, NULL)) != -1) {
+		switch (c) {
+		case 't':
+			errno = 0;
+			top = strtoul(optarg, &end, 0);
+			if (errno != 0 || *end != '\0' || top == 0 ||
+			    top > UINT_MAX) {
+				fprintf(stderr,
+					"%s %s: invalid file count '%s'\n",
+					progname, argv[0], optarg);
+				return CMD_HELP;
+			}
+			break;
+		default:
+			fprintf(stderr, "%s: unrecognized option '%s'\n",
+				progname, argv[optind - 1]);
+			fallthrough;
+		case 'h':
+			return CMD_HELP;
+		}
+	}
+
+	if (argc <= optind) {
+		fprintf(stderr, "%s: please give one or more file names\n",
+			argv[0]);
+		return CMD_HELP;
+	}
+
+	if (top) {
+		while (optind < argc) {
+			rc2 = lfs_heat_top(argv[optind++], top);
+			if (rc == 0 && rc2 < 0)
+				rc = rc2;
+		}
+		return rc;
+	}
+
 	heat = calloc(sizeof(*heat) + sizeof(__u64) * OBD_HEAT_COUNT, 1);
 	if (!heat) {
 		fprintf(stderr, "%s: memory allocation failed\n", argv[0]);
 		return -ENOMEM;
 	}
 
-	optind = 1;
 	while (optind < argc) {
 		path = argv[optind++];
 
@@ -10658,7 +11021,8 @@ error:
 
 static inline
 int lfs_mirror_resync_file(const char *fname, struct ll_ioc_lease *ioc,
-			   __u16 *mirror_ids, int ids_nr)
+			   __u16 *mirror_ids, int ids_nr,
+			   const struct llapi_mirror_copy_param *param)
 {
 	struct llapi_resync_comp comp_array[1024] = { { 0 } };
 	struct llapi_layout *layout;
@@ -10757,8 +11121,8 @@ int lfs_mirror_resync_file(const char *fname, struct ll_ioc_lease *ioc,
 		goto free_layout;
 	}
 
-	rc = llapi_mirror_resync_many(fd, layout, comp_array, comp_size,
-				      start, end);
+	rc = llapi_mirror_resync_many_ext(fd, layout, comp_array, comp_size,
+					  start, end, param);
 	if (rc < 0)
 		fprintf(stderr, "%s: '%s' llapi_mirror_resync_many: %s.\n",
 			progname, fname, strerror(-rc));
@@ -10813,7 +11177,16 @@ static inline int lfs_mirror_resync(int argc, char **argv)
 	struct option long_opts[] = {
 	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
 	{ .val = 'o',	.name = "only",		.has_arg = required_argument },
+	{ .val = LFS_STATS_OPT,
+			.name = "stats",	.has_arg = no_argument },
+	{ .val = LFS_STATS_INTERVAL_OPT,
+			.name = "stats-interval",
+						.has_arg = required_argument },
+	{ .val = LFS_THREADS_OPT,
+			.name = "threads",	.has_arg = required_argument },
 	{ .name = NULL } };
+	struct llapi_mirror_copy_param param = { 0 };
+	struct lfs_copy_progress progress = { .lcp_interval = 5 };
 	struct ll_ioc_lease *ioc = NULL;
 	__u16 mirror_ids[128] = { 0 };
 	int ids_nr = 0;
@@ -10822,6 +11195,14 @@ static inline int lfs_mirror_resync(int argc, char **argv)
 
 	while ((c = getopt_long(argc, argv, "ho:", long_opts, NULL)) >= 0) {
 		switch (c) {
+		case LFS_STATS_OPT:
+		case LFS_STATS_INTERVAL_OPT:
+		case LFS_THREADS_OPT:
+			if (lfs_copy_param_parse(c, optarg, &param, &progress)) {
+				rc = CMD_HELP;
+				goto error;
+			}
+			break;
 		case 'o':
 			rc = parse_mirror_ids(mirror_ids,
 					sizeof(mirror_ids) / sizeof(__u16),
@@ -10874,8 +11255,10 @@ static inline int lfs_mirror_resync(int argc, char **argv)
 	}
 
 	for (; optind < argc; optind++) {
+		progress.lcp_fname = argv[optind];
+		progress.lcp_last = 0;
 		rc = lfs_mirror_resync_file(argv[optind], ioc,
-					    mirror_ids, ids_nr);
+					    mirror_ids, ids_nr, &param);
 		/* ignore previous file's error, continue with next file */
 
 		/* reset ioc */
@@ -11357,7 +11740,16 @@ static inline int lfs_mirror_copy(int argc, char **argv)
 	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
 	{ .val = 'i',	.name = "read-mirror",	.has_arg = required_argument },
 	{ .val = 'o',	.name = "write-mirror",	.has_arg = required_argument },
+	{ .val = LFS_STATS_OPT,
+			.name = "stats",	.has_arg = no_argument },
+	{ .val = LFS_STATS_INTERVAL_OPT,
+			.name = "stats-interval",
+						.has_arg = required_argument },
+	{ .val = LFS_THREADS_OPT,
+			.name = "threads",	.has_arg = required_argument },
 	{ .name = NULL } };
+	struct llapi_mirror_copy_param param = { 0 };
+	struct lfs_copy_progress progress = { .lcp_interval = 5 };
 	char cmd[PATH_MAX];
 
 	snprintf(cmd, sizeof(cmd), "%s %s", progname, argv[0]);
@@ -11395,6 +11787,12 @@ static inline int lfs_mirror_copy(int argc, char **argv)
 					return rc;
 			}
 			break;
+		case LFS_STATS_OPT:
+		case LFS_STATS_INTERVAL_OPT:
+		case LFS_THREADS_OPT:
+			if (lfs_copy_param_parse(c, optarg, &param, &progress))
+				return rc;
+			break;
 		default:
 			fprintf(stderr, "%s: unrecognized option '%s'\n",
 				progname, argv[optind - 1]);
@@ -11519,7 +11917,9 @@ static inline int lfs_mirror_copy(int argc, char **argv)
 		goto free_ioc;
 	}
 
-	copied = llapi_mirror_copy_many(fd, read_mirror_id, ids, count);
+	progress.lcp_fname = fname;
+	copied = llapi_mirror_copy_many_ext(fd, read_mirror_id, ids, count,
+					    &param);
 	if (copied < 0) {
 		rc = copied;
 		fprintf(stderr, "%s %s: copy error: %d\n",
@@ -76,3 +76,25 @@ int llapi_heat_set(int fd, __u64 flags)
 	}
 	return 0;
 }
+
+/*
+ * Get the hottest files seen by a client mount
+ *
+ * \param fd       File or directory on the mount.
+ * \param top      Buffer to save the files, top->lht_count gives the number
+ *                 of entries on input and is set to the number filled.
+ *
+ * \retval 0 on success.
+ * \retval -errno on failure.
+ */
+int llapi_heat_top_get(int fd, struct lu_heat_top *top)
+{
+	int rc;
+
+	rc = ioctl(fd, LL_IOC_HEAT_TOP, top);
+	if (rc < 0) {
+		llapi_error(LLAPI_MSG_ERROR, -errno, "cannot get hot files");
+		return -errno;
+	}
+	return 0;
+}
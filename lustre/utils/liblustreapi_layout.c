@@ -37,6 +37,7 @@
 #include <assert.h>
 #include <sys/xattr.h>
 #include <sys/param.h>
+#include <sys/stat.h>
 
 #include <libcfs/util/list.h>
 #include <lustre/lustreapi.h>
@@ -2923,29 +2924,59 @@ int llapi_mirror_find(struct llapi_layout *layout, uint64_t file_start,
 	return mirror_id;
 }
 
-int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
-			     struct llapi_resync_comp *comp_array,
-			     int comp_size,  uint64_t start, uint64_t end)
+/**
+ * Resync stale components \a comp_array from the in-sync mirrors covering
+ * [\a start, \a end), copying data in parallel as described by \a param.
+ * Holes in the source mirror are punched in the stale components instead
+ * of being copied.
+ *
+ * \retval	0 on success, lrc_synced tells which components were synced
+ * \retval	-errno of the first error seen
+ */
+int llapi_mirror_resync_many_ext(int fd, struct llapi_layout *layout,
+				 struct llapi_resync_comp *comp_array,
+				 int comp_size, uint64_t start, uint64_t end,
+				 const struct llapi_mirror_copy_param *param)
 {
 	size_t page_size = sysconf(_SC_PAGESIZE);
-	const size_t buflen = 4 << 20; /* 4M */
-	void *buf;
+	struct mirror_copy_target *targets;
+	struct mirror_copy_ctx *ctx;
+	struct stat st;
 	uint64_t pos = start;
 	uint64_t data_off = pos, data_end = pos;
+	uint64_t mirror_end = 0;
+	uint64_t size, file_end;
 	uint32_t src = 0;
 	int i;
 	int rc;
 	int rc2 = 0;
 
-	rc = posix_memalign(&buf, page_size, buflen);
-	if (rc)
-		return -rc;
+	if (fstat(fd, &st) < 0)
+		return -errno;
+
+	targets = calloc(comp_size, sizeof(*targets));
+	if (!targets)
+		return -ENOMEM;
+
+	for (i = 0; i < comp_size; i++) {
+		targets[i].mct_fd = fd;
+		targets[i].mct_mirror_id = comp_array[i].lrc_mirror_id;
+		targets[i].mct_start = comp_array[i].lrc_start;
+		targets[i].mct_end = comp_array[i].lrc_end;
+	}
+
+	/* no data past the last page of the file, reads return 0 there */
+	file_end = ((st.st_size + page_size - 1) & ~(page_size - 1));
+	size = MIN(end, (uint64_t)st.st_size);
+	rc = mirror_copy_init(&ctx, fd, targets, comp_size,
+			      size > start ? size - start : 0, param);
+	if (rc < 0) {
+		free(targets);
+		return rc;
+	}
 
 	while (pos < end) {
-		uint64_t mirror_end;
-		ssize_t bytes_read;
 		size_t to_read;
-		size_t to_write;
 
 		if (pos >= data_end) {
 			off_t tmp_off;
@@ -2955,8 +2986,9 @@ int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
 				rc = llapi_mirror_find(layout, pos, end,
 							&mirror_end);
 				if (rc < 0)
-					return rc;
+					break;
 				src = rc;
+				rc = 0;
 				/* restrict mirror end by resync end */
 				mirror_end = MIN(end, mirror_end);
 			}
@@ -2980,6 +3012,11 @@ int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
 		}
 
 		if (pos < data_off) {
+			/* queued data must be written before punching */
+			rc = mirror_copy_flush(ctx);
+			if (rc)
+				break;
+
 			for (i = 0; i < comp_size; i++) {
 				uint64_t cur_pos;
 				size_t to_punch;
@@ -3029,80 +3066,56 @@ int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
 					goto do_read;
 				}
 			}
+			mirror_copy_skip(ctx, data_off - pos);
 			pos = data_off;
 		}
 		if (pos == mirror_end)
 			continue;
 		to_read = data_end - pos;
 do_read:
-		if (!to_read)
+		if (!to_read || pos >= file_end)
 			break;
 
 		assert(data_end <= mirror_end);
 
-		to_read = MIN(buflen, to_read);
+		to_read = MIN(to_read, file_end - pos);
+
+		/* round up to page align to make direct IO happy. */
 		to_read = ((to_read - 1) | (page_size - 1)) + 1;
-		bytes_read = llapi_mirror_read(fd, src, buf, to_read, pos);
-		if (bytes_read == 0) {
-			/* end of file */
-			break;
-		}
-		if (bytes_read < 0) {
-			rc = bytes_read;
+		rc = mirror_copy_queue(ctx, src, pos, to_read);
+		if (rc)
 			break;
-		}
+		pos += to_read;
+	}
 
-		/* round up to page align to make direct IO happy. */
-		to_write = ((bytes_read - 1) | (page_size - 1)) + 1;
-
-		for (i = 0; i < comp_size; i++) {
-			ssize_t written;
-			off_t pos2 = pos;
-			size_t to_write2 = to_write;
-
-			/* skip non-overlapped component */
-			if (pos >= comp_array[i].lrc_end ||
-			    pos + to_write <= comp_array[i].lrc_start)
-				continue;
-
-			if (pos < comp_array[i].lrc_start)
-				pos2 = comp_array[i].lrc_start;
-
-			to_write2 -= pos2 - pos;
-
-			if ((pos + to_write) > comp_array[i].lrc_end)
-				to_write2 -= pos + to_write -
-					     comp_array[i].lrc_end;
-
-			written = llapi_mirror_write(fd,
-					comp_array[i].lrc_mirror_id,
-					buf + pos2 - pos,
-					to_write2, pos2);
-			if (written < 0) {
-				/**
-				 * this component is not written successfully,
-				 * mark it using its lrc_synced, it is supposed
-				 * to be false before getting here.
-				 *
-				 * And before this function returns, all
-				 * elements of comp_array will reverse their
-				 * lrc_synced flag to reflect their true
-				 * meanings.
-				 */
-				comp_array[i].lrc_synced = true;
-				llapi_error(LLAPI_MSG_ERROR, written,
-					    "component %u not synced",
-					    comp_array[i].lrc_id);
-				if (rc2 == 0)
-					rc2 = (int)written;
-				continue;
-			}
-			assert(written == to_write2);
-		}
-		pos += bytes_read;
+	if (!rc)
+		rc = mirror_copy_flush(ctx);
+	if (rc > 0) {
+		/* end of file, the last chunk may be partial */
+		pos = mirror_copy_pos(ctx);
+		rc = 0;
 	}
+	mirror_copy_fini(ctx);
 
-	free(buf);
+	for (i = 0; i < comp_size; i++) {
+		if (targets[i].mct_rc == 0)
+			continue;
+		/**
+		 * this component is not written successfully, mark it using
+		 * its lrc_synced, it is supposed to be false before getting
+		 * here.
+		 *
+		 * And before this function returns, all elements of
+		 * comp_array will reverse their lrc_synced flag to reflect
+		 * their true meanings.
+		 */
+		comp_array[i].lrc_synced = true;
+		llapi_error(LLAPI_MSG_ERROR, targets[i].mct_rc,
+			    "component %u not synced", comp_array[i].lrc_id);
+		if (rc2 == 0)
+			rc2 = targets[i].mct_rc;
+	}
+	free(targets);
 
 	if (rc < 0) {
 		/* fatal error happens */
@@ -3137,6 +3150,14 @@ do_read:
 	return rc2;
 }
 
+int llapi_mirror_resync_many(int fd, struct llapi_layout *layout,
+			     struct llapi_resync_comp *comp_array,
+			     int comp_size,  uint64_t start, uint64_t end)
+{
+	return llapi_mirror_resync_many_ext(fd, layout, comp_array, comp_size,
+					    start, end, NULL);
+}
+
 enum llapi_layout_comp_sanity_error {
 	LSE_OK,
 	LSE_INCOMPLETE_MIRROR,
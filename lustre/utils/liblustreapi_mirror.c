@@ -41,10 +41,15 @@
 #include <sys/xattr.h>
 #include <assert.h>
 #include <sys/param.h>
+#include <time.h>
+#if HAVE_LIBPTHREAD
+#include <pthread.h>
+#endif
 
 #include <libcfs/util/ioctl.h>
 #include <lustre/lustreapi.h>
 #include <linux/lustre/lustre_ioctl.h>
+#include "lustreapi_internal.h"
 
 /**
  * Set the mirror id for the opening file pointed by @fd, once the mirror
@@ -259,6 +264,505 @@ off_t llapi_mirror_data_seek(int fd, unsigned int id, off_t pos, size_t *size)
 	return data_off;
 }
 
+/*
+ * Parallel copy engine.
+ *
+ * The mirror used for I/O is a property of the open file (see
+ * llapi_mirror_set()), and a new open of the file would break the resync
+ * lease, so all I/O in flight has to target the same mirror. Data is
+ * therefore copied in batches: up to mcc_depth chunks are read from the
+ * source mirror in parallel by the I/O threads, then written in parallel to
+ * each target in turn.
+ */
+struct mirror_copy_chunk {
+	off_t		mch_pos;
+	size_t		mch_len;
+	ssize_t		mch_bytes;	/* bytes read */
+};
+
+struct mirror_copy_io {
+	int		 mci_fd;
+	off_t		 mci_pos;
+	size_t		 mci_len;
+	char		*mci_buf;
+	ssize_t		 mci_rc;	/* bytes transferred or -errno */
+};
+
+struct mirror_copy_ctx {
+	int				 mcc_fd;
+	size_t				 mcc_chunk_size;
+	int				 mcc_depth;	/* chunks per batch */
+	char				*mcc_buf;
+	struct mirror_copy_target	*mcc_targets;
+	int				 mcc_nr_targets;
+	/* chunks of the next batch, all read from mirror mcc_src */
+	struct mirror_copy_chunk	*mcc_chunks;
+	int				 mcc_nr_chunks;
+	__u32				 mcc_src;
+	off_t				 mcc_pos;	/* end of data read */
+	bool				 mcc_eof;
+	struct mirror_copy_io		*mcc_io;
+	struct llapi_mirror_copy_stats	 mcc_stats;
+	const struct llapi_mirror_copy_param *mcc_param;
+	struct timespec			 mcc_start;
+#if HAVE_LIBPTHREAD
+	pthread_t			*mcc_threads;
+	int				 mcc_nr_threads;
+	pthread_mutex_t			 mcc_lock;
+	pthread_cond_t			 mcc_work_cond;
+	pthread_cond_t			 mcc_done_cond;
+	int				 mcc_nr_io;
+	int				 mcc_next_io;
+	int				 mcc_done_io;
+	bool				 mcc_write;
+	bool				 mcc_stop;
+#endif
+};
+
+static void mirror_copy_do_io(struct mirror_copy_io *io, bool write)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	char *buf = io->mci_buf;
+	off_t pos = io->mci_pos;
+	size_t count = io->mci_len;
+	ssize_t result = 0;
+
+	while (count > 0) {
+		ssize_t bytes;
+
+		if (write)
+			bytes = pwrite(io->mci_fd, buf, count, pos);
+		else
+			bytes = pread(io->mci_fd, buf, count, pos);
+		if (bytes < 0) {
+			result = -errno;
+			break;
+		}
+		if (!bytes) /* end of file */
+			break;
+
+		result += bytes;
+		pos += bytes;
+		buf += bytes;
+		count -= bytes;
+
+		if (!write && bytes & (page_size - 1)) /* end of file */
+			break;
+	}
+
+	io->mci_rc = result;
+}
+
+#if HAVE_LIBPTHREAD
+static void *mirror_copy_thread(void *arg)
+{
+	struct mirror_copy_ctx *ctx = arg;
+
+	pthread_mutex_lock(&ctx->mcc_lock);
+	while (!ctx->mcc_stop) {
+		struct mirror_copy_io *io;
+
+		if (ctx->mcc_next_io >= ctx->mcc_nr_io) {
+			pthread_cond_wait(&ctx->mcc_work_cond, &ctx->mcc_lock);
+			continue;
+		}
+		io = &ctx->mcc_io[ctx->mcc_next_io++];
+		pthread_mutex_unlock(&ctx->mcc_lock);
+
+		mirror_copy_do_io(io, ctx->mcc_write);
+
+		pthread_mutex_lock(&ctx->mcc_lock);
+		if (++ctx->mcc_done_io == ctx->mcc_nr_io)
+			pthread_cond_signal(&ctx->mcc_done_cond);
+	}
+	pthread_mutex_unlock(&ctx->mcc_lock);
+
+	return NULL;
+}
+#endif
+
+/* do @nr I/Os prepared in mcc_io[] and wait for all of them to complete */
+static void mirror_copy_run(struct mirror_copy_ctx *ctx, int nr, bool write)
+{
+	int i;
+
+#if HAVE_LIBPTHREAD
+	if (ctx->mcc_nr_threads > 1 && nr > 1) {
+		pthread_mutex_lock(&ctx->mcc_lock);
+		ctx->mcc_write = write;
+		ctx->mcc_nr_io = nr;
+		ctx->mcc_next_io = 0;
+		ctx->mcc_done_io = 0;
+		pthread_cond_broadcast(&ctx->mcc_work_cond);
+		while (ctx->mcc_done_io < nr)
+			pthread_cond_wait(&ctx->mcc_done_cond, &ctx->mcc_lock);
+		pthread_mutex_unlock(&ctx->mcc_lock);
+		return;
+	}
+#endif
+	for (i = 0; i < nr; i++)
+		mirror_copy_do_io(&ctx->mcc_io[i], write);
+}
+
+/* publish the stats for pollers and call the progress callback */
+static int mirror_copy_progress(struct mirror_copy_ctx *ctx)
+{
+	const struct llapi_mirror_copy_param *param = ctx->mcc_param;
+	struct llapi_mirror_copy_stats *stats = &ctx->mcc_stats;
+	struct llapi_mirror_copy_stats *pub;
+	struct timespec now;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	stats->mcs_elapsed_ms = (now.tv_sec - ctx->mcc_start.tv_sec) * 1000 +
+		(now.tv_nsec - ctx->mcc_start.tv_nsec) / 1000000;
+
+	if (!param)
+		return 0;
+
+	pub = param->mcp_stats;
+	if (pub) {
+		__atomic_store_n(&pub->mcs_size, stats->mcs_size,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_pos, stats->mcs_pos,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_read_bytes, stats->mcs_read_bytes,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_write_bytes, stats->mcs_write_bytes,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_hole_bytes, stats->mcs_hole_bytes,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_threads, stats->mcs_threads,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_targets, stats->mcs_targets,
+				 __ATOMIC_RELAXED);
+		__atomic_store_n(&pub->mcs_elapsed_ms, stats->mcs_elapsed_ms,
+				 __ATOMIC_RELEASE);
+	}
+
+	if (param->mcp_cb)
+		return param->mcp_cb(stats, param->mcp_cbdata);
+
+	return 0;
+}
+
+/**
+ * Set up a parallel copy from the file @fd to @targets.
+ *
+ * \param ctxp		new copy context
+ * \param fd		source file descriptor, should be opened with O_DIRECT
+ * \param targets	targets to write data to, owned by the caller
+ * \param nr_targets	number of elements in array @targets
+ * \param size		number of bytes expected to be copied, for progress
+ * \param param		threads, chunk size and progress reporting, or NULL
+ *
+ * \retval	0 on success.
+ * \retval	-errno on failure.
+ */
+int mirror_copy_init(struct mirror_copy_ctx **ctxp, int fd,
+		     struct mirror_copy_target *targets, int nr_targets,
+		     uint64_t size, const struct llapi_mirror_copy_param *param)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	unsigned int threads = LLAPI_MIRROR_COPY_THREADS_DEF;
+	size_t chunk_size = LLAPI_MIRROR_COPY_CHUNK_DEF;
+	struct mirror_copy_ctx *ctx;
+	int rc;
+
+	if (param && param->mcp_threads)
+		threads = MIN(param->mcp_threads,
+			      LLAPI_MIRROR_COPY_THREADS_MAX);
+	if (param && param->mcp_chunk_size)
+		chunk_size = ((param->mcp_chunk_size - 1) |
+			      (page_size - 1)) + 1;
+
+	ctx = calloc(1, sizeof(*ctx));
+	if (!ctx)
+		return -ENOMEM;
+
+	ctx->mcc_fd = fd;
+	ctx->mcc_chunk_size = chunk_size;
+	ctx->mcc_depth = threads;
+	ctx->mcc_targets = targets;
+	ctx->mcc_nr_targets = nr_targets;
+	ctx->mcc_param = param;
+	ctx->mcc_chunks = calloc(threads, sizeof(*ctx->mcc_chunks));
+	ctx->mcc_io = calloc(threads, sizeof(*ctx->mcc_io));
+	if (!ctx->mcc_chunks || !ctx->mcc_io) {
+		rc = -ENOMEM;
+		goto out_free;
+	}
+
+	rc = posix_memalign((void **)&ctx->mcc_buf, page_size,
+			    threads * chunk_size);
+	if (rc) { /* error code is returned directly */
+		ctx->mcc_buf = NULL;
+		rc = -rc;
+		goto out_free;
+	}
+
+	ctx->mcc_stats.mcs_size = size;
+	ctx->mcc_stats.mcs_targets = nr_targets;
+	ctx->mcc_stats.mcs_threads = 1;
+	clock_gettime(CLOCK_MONOTONIC, &ctx->mcc_start);
+
+#if HAVE_LIBPTHREAD
+	pthread_mutex_init(&ctx->mcc_lock, NULL);
+	pthread_cond_init(&ctx->mcc_work_cond, NULL);
+	pthread_cond_init(&ctx->mcc_done_cond, NULL);
+
+	if (threads > 1) {
+		unsigned int i;
+
+		ctx->mcc_threads = calloc(threads, sizeof(*ctx->mcc_threads));
+		for (i = 0; ctx->mcc_threads && i < threads; i++) {
+			rc = pthread_create(&ctx->mcc_threads[i], NULL,
+					    mirror_copy_thread, ctx);
+			if (rc) {
+				/* copy with the threads we have */
+				llapi_error(LLAPI_MSG_WARN, -rc,
+					    "cannot start copy thread %u", i);
+				break;
+			}
+			ctx->mcc_nr_threads++;
+		}
+		if (ctx->mcc_nr_threads > 1)
+			ctx->mcc_stats.mcs_threads = ctx->mcc_nr_threads;
+	}
+#endif
+	(void) mirror_copy_progress(ctx);
+	*ctxp = ctx;
+
+	return 0;
+
+out_free:
+	free(ctx->mcc_io);
+	free(ctx->mcc_chunks);
+	free(ctx);
+
+	return rc;
+}
+
+void mirror_copy_fini(struct mirror_copy_ctx *ctx)
+{
+#if HAVE_LIBPTHREAD
+	int i;
+
+	pthread_mutex_lock(&ctx->mcc_lock);
+	ctx->mcc_stop = true;
+	pthread_cond_broadcast(&ctx->mcc_work_cond);
+	pthread_mutex_unlock(&ctx->mcc_lock);
+
+	for (i = 0; i < ctx->mcc_nr_threads; i++)
+		pthread_join(ctx->mcc_threads[i], NULL);
+	free(ctx->mcc_threads);
+
+	pthread_cond_destroy(&ctx->mcc_done_cond);
+	pthread_cond_destroy(&ctx->mcc_work_cond);
+	pthread_mutex_destroy(&ctx->mcc_lock);
+#endif
+	free(ctx->mcc_buf);
+	free(ctx->mcc_io);
+	free(ctx->mcc_chunks);
+	free(ctx);
+}
+
+static void mirror_copy_target_fail(struct mirror_copy_ctx *ctx,
+				    struct mirror_copy_target *tgt, int rc)
+{
+	tgt->mct_rc = rc;
+	ctx->mcc_stats.mcs_targets--;
+}
+
+/* write the chunks of the current batch to @tgt, clipped to its range */
+static void mirror_copy_write(struct mirror_copy_ctx *ctx,
+			      struct mirror_copy_target *tgt, int nr_chunks)
+{
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	int nr = 0;
+	int rc;
+	int i;
+
+	for (i = 0; i < nr_chunks; i++) {
+		struct mirror_copy_chunk *chunk = &ctx->mcc_chunks[i];
+		struct mirror_copy_io *io;
+		uint64_t start, end;
+
+		if (chunk->mch_bytes <= 0)
+			continue;
+
+		/* round up to page align to make direct IO happy.
+		 * this implies the last segment to write. */
+		end = chunk->mch_pos +
+		      (((chunk->mch_bytes - 1) | (page_size - 1)) + 1);
+		start = MAX((uint64_t)chunk->mch_pos, tgt->mct_start);
+		end = MIN(end, tgt->mct_end);
+		if (start >= end)
+			continue;
+
+		io = &ctx->mcc_io[nr++];
+		io->mci_fd = tgt->mct_fd;
+		io->mci_pos = start;
+		io->mci_len = end - start;
+		io->mci_buf = ctx->mcc_buf + i * ctx->mcc_chunk_size +
+			      (start - chunk->mch_pos);
+		io->mci_rc = 0;
+	}
+	if (!nr)
+		return;
+
+	if (tgt->mct_mirror_id) {
+		rc = llapi_mirror_set(tgt->mct_fd, tgt->mct_mirror_id);
+		if (rc < 0) {
+			mirror_copy_target_fail(ctx, tgt, rc);
+			return;
+		}
+	}
+
+	mirror_copy_run(ctx, nr, true);
+
+	if (tgt->mct_mirror_id)
+		(void) llapi_mirror_clear(tgt->mct_fd);
+
+	for (i = 0; i < nr; i++) {
+		struct mirror_copy_io *io = &ctx->mcc_io[i];
+
+		if (io->mci_rc != (ssize_t)io->mci_len) {
+			mirror_copy_target_fail(ctx, tgt,
+					io->mci_rc < 0 ? io->mci_rc : -EIO);
+			return;
+		}
+		ctx->mcc_stats.mcs_write_bytes += io->mci_rc;
+	}
+}
+
+/**
+ * Copy the queued chunks: read them from the source mirror, then write them
+ * to every target which has not failed yet.
+ *
+ * \retval	0 on success
+ * \retval	1 if end of file was reached
+ * \retval	-errno on read error or if the progress callback aborted
+ */
+int mirror_copy_flush(struct mirror_copy_ctx *ctx)
+{
+	int nr = ctx->mcc_nr_chunks;
+	int rc;
+	int i;
+
+	if (!nr)
+		return ctx->mcc_eof;
+	ctx->mcc_nr_chunks = 0;
+
+	for (i = 0; i < nr; i++) {
+		struct mirror_copy_io *io = &ctx->mcc_io[i];
+
+		io->mci_fd = ctx->mcc_fd;
+		io->mci_pos = ctx->mcc_chunks[i].mch_pos;
+		io->mci_len = ctx->mcc_chunks[i].mch_len;
+		io->mci_buf = ctx->mcc_buf + i * ctx->mcc_chunk_size;
+		io->mci_rc = 0;
+	}
+
+	if (ctx->mcc_src) {
+		rc = llapi_mirror_set(ctx->mcc_fd, ctx->mcc_src);
+		if (rc < 0)
+			return rc;
+	}
+
+	mirror_copy_run(ctx, nr, false);
+
+	if (ctx->mcc_src)
+		(void) llapi_mirror_clear(ctx->mcc_fd);
+
+	for (i = 0; i < nr; i++) {
+		struct mirror_copy_chunk *chunk = &ctx->mcc_chunks[i];
+		ssize_t bytes = ctx->mcc_io[i].mci_rc;
+
+		if (bytes < 0)
+			return bytes;
+
+		chunk->mch_bytes = bytes;
+		ctx->mcc_stats.mcs_read_bytes += bytes;
+		ctx->mcc_pos = chunk->mch_pos + bytes;
+		if ((size_t)bytes < chunk->mch_len) {
+			/* short read, the rest of the batch is past EOF */
+			ctx->mcc_eof = true;
+			nr = i + 1;
+			break;
+		}
+	}
+
+	for (i = 0; i < ctx->mcc_nr_targets; i++) {
+		if (ctx->mcc_targets[i].mct_rc == 0)
+			mirror_copy_write(ctx, &ctx->mcc_targets[i], nr);
+	}
+
+	ctx->mcc_stats.mcs_pos = ctx->mcc_pos;
+	rc = mirror_copy_progress(ctx);
+	if (rc < 0)
+		return rc;
+
+	return ctx->mcc_eof;
+}
+
+/**
+ * Queue [@pos, @pos + @len) of mirror @src to be copied, @pos and @len must
+ * be page aligned, @src is 0 to read without selecting a mirror. The range
+ * is split into chunks and a batch is copied once it is full or the source
+ * mirror changes.
+ *
+ * \retval	0 on success
+ * \retval	1 if end of file was reached
+ * \retval	-errno on failure
+ */
+int mirror_copy_queue(struct mirror_copy_ctx *ctx, __u32 src, off_t pos,
+		      size_t len)
+{
+	int rc;
+
+	if (ctx->mcc_eof)
+		return 1;
+
+	while (len > 0) {
+		struct mirror_copy_chunk *chunk;
+
+		if (ctx->mcc_nr_chunks == ctx->mcc_depth ||
+		    (ctx->mcc_nr_chunks && ctx->mcc_src != src)) {
+			rc = mirror_copy_flush(ctx);
+			if (rc)
+				return rc;
+		}
+
+		chunk = &ctx->mcc_chunks[ctx->mcc_nr_chunks++];
+		chunk->mch_pos = pos;
+		/* end chunks on chunk size boundaries, which are also
+		 * stripe boundaries when the chunk size is picked from the
+		 * layout
+		 */
+		chunk->mch_len = MIN(len, ctx->mcc_chunk_size -
+				     pos % ctx->mcc_chunk_size);
+		chunk->mch_bytes = 0;
+		ctx->mcc_src = src;
+
+		pos += chunk->mch_len;
+		len -= chunk->mch_len;
+	}
+
+	return 0;
+}
+
+/* account @bytes of source hole which is not copied */
+void mirror_copy_skip(struct mirror_copy_ctx *ctx, uint64_t bytes)
+{
+	ctx->mcc_stats.mcs_hole_bytes += bytes;
+}
+
+/* end of the data copied so far, the file size once EOF was reached */
+off_t mirror_copy_pos(struct mirror_copy_ctx *ctx)
+{
+	return ctx->mcc_pos;
+}
+
 /**
  * Copy data contents from source mirror @src to multiple destinations
  * pointed by @dst. The destination array @dst will be altered to store
@@ -268,19 +772,21 @@ off_t llapi_mirror_data_seek(int fd, unsigned int id, off_t pos, size_t *size)
  * \param src	source mirror id, usually a valid mirror
  * \param dst	an array of destination mirror ids
  * \param count	number of elements in array @dst
+ * \param param	copy threads and progress reporting, NULL for defaults
  *
  * \result > 0	Number of mirrors successfully copied
  * \result < 0	The last seen error
  */
-ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
+ssize_t llapi_mirror_copy_many_ext(int fd, __u16 src, __u16 *dst, size_t count,
+				   const struct llapi_mirror_copy_param *param)
 {
-	const size_t buflen = 4 * 1024 * 1024; /* 4M */
-	void *buf;
-	off_t pos = 0;
-	off_t data_end = 0;
+	struct mirror_copy_target *targets;
+	struct mirror_copy_ctx *ctx;
 	size_t page_size = sysconf(_SC_PAGESIZE);
+	struct stat stbuf;
+	off_t pos = 0;
+	off_t file_end;
 	ssize_t result = 0;
-	bool eof = false;
 	bool sparse;
 	int nr;
 	int i;
@@ -289,9 +795,13 @@ ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
 	if (!count)
 		return 0;
 
-	rc = posix_memalign(&buf, page_size, buflen);
-	if (rc) /* error code is returned directly */
-		return -rc;
+	if (fstat(fd, &stbuf) < 0)
+		return -errno;
+	file_end = (stbuf.st_size + page_size - 1) & ~(page_size - 1);
+
+	targets = calloc(count, sizeof(*targets));
+	if (!targets)
+		return -ENOMEM;
 
 	sparse = llapi_mirror_is_sparse(fd, src);
 
@@ -311,16 +821,30 @@ ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
 			}
 		}
 		if (!nr)
-			return result;
+			goto out_free;
 	}
 
-	while (!eof) {
-		off_t data_off;
-		ssize_t bytes_read;
-		size_t to_write, to_read;
+	for (i = 0; i < nr; i++) {
+		targets[i].mct_fd = fd;
+		targets[i].mct_mirror_id = dst[i];
+		targets[i].mct_start = 0;
+		targets[i].mct_end = OBD_OBJECT_EOF;
+	}
+
+	rc = mirror_copy_init(&ctx, fd, targets, nr, stbuf.st_size, param);
+	if (rc < 0) {
+		result = rc;
+		nr = 0;
+		goto out_free;
+	}
 
-		if (sparse && pos >= data_end) {
+	while (!rc) {
+		size_t len;
+
+		if (sparse) {
+			off_t data_off;
 			size_t data_size;
+			off_t data_end;
 
 			data_off = llapi_mirror_data_seek(fd, src, pos,
 							  &data_size);
@@ -334,71 +858,78 @@ ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
 				 * data_off, so truncate block at the end
 				 * will set final dst size.
 				 */
+				mirror_copy_skip(ctx, data_off - pos);
 				pos = data_off;
 				break;
 			}
 
 			data_end = data_off + data_size;
 			/* align by page */
-			pos = data_off & ~(page_size - 1);
+			data_off &= ~(page_size - 1);
 			data_end = ((data_end - 1) | (page_size - 1)) + 1;
-			to_read = MIN(data_end - pos, buflen);
+			mirror_copy_skip(ctx, data_off - pos);
+			pos = data_off;
+			len = data_end - pos;
 		} else {
-			to_read = buflen;
-		}
-
-		bytes_read = llapi_mirror_read(fd, src, buf, to_read, pos);
-		if (!bytes_read) { /* end of file */
-			break;
-		} else if (bytes_read < 0) {
-			result = bytes_read;
-			nr = 0;
-			break;
+			if (pos >= file_end)
+				break;
+			len = file_end - pos;
 		}
 
-		/* round up to page align to make direct IO happy.
-		 * this implies the last segment to write. */
-		to_write = ((bytes_read - 1) | (page_size - 1)) + 1;
-
-		for (i = 0; i < nr; i++) {
-			ssize_t written;
+		rc = mirror_copy_queue(ctx, src, pos, len);
+		pos += len;
+	}
 
-			written = llapi_mirror_write(fd, dst[i], buf,
-						      to_write, pos);
-			if (written < 0) {
-				result = written;
+	if (!rc)
+		rc = mirror_copy_flush(ctx);
+	if (rc > 0) {
+		/* end of file, the last chunk may be partial */
+		pos = mirror_copy_pos(ctx);
+		rc = 0;
+	}
+	mirror_copy_fini(ctx);
 
-				/* this mirror is not written succesfully,
-				 * get rid of it from the array */
-				dst[i] = dst[--nr];
-				i--;
-				continue;
-			}
-			assert(written == to_write);
-		}
-		pos += bytes_read;
-		eof = bytes_read < to_read;
+	if (rc < 0) {
+		result = rc;
+		nr = 0;
 	}
 
-	free(buf);
+	for (i = 0; i < nr; i++) {
+		if (targets[i].mct_rc == 0)
+			continue;
+
+		result = targets[i].mct_rc;
+		/* this mirror is not written succesfully,
+		 * get rid of it from the array */
+		nr--;
+		dst[i] = dst[nr];
+		targets[i] = targets[nr];
+		i--;
+	}
 
-	if (nr > 0) {
-		for (i = 0; i < nr; i++) {
-			rc = llapi_mirror_truncate(fd, dst[i], pos);
-			if (rc < 0) {
-				result = rc;
+	for (i = 0; i < nr; i++) {
+		rc = llapi_mirror_truncate(fd, dst[i], pos);
+		if (rc < 0) {
+			result = rc;
 
-				/* exclude the failed one */
-				dst[i] = dst[--nr];
-				--i;
-				continue;
-			}
+			/* exclude the failed one */
+			dst[i] = dst[--nr];
+			--i;
+			continue;
 		}
 	}
 
+out_free:
+	free(targets);
+
 	return nr > 0 ? nr : result;
 }
 
+ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
+{
+	return llapi_mirror_copy_many_ext(fd, src, dst, count, NULL);
+}
+
 /**
  * Copy data contents from source mirror @src to target mirror @dst.
  *
@@ -407,17 +938,21 @@ ssize_t llapi_mirror_copy_many(int fd, __u16 src, __u16 *dst, size_t count)
  * \param dst	mirror id of copy destination
  * \param pos   start file pos
  * \param count	number of bytes to be copied
+ * \param param	copy threads and progress reporting, NULL for defaults
  *
- * \result > 0	Number of mirrors successfully copied
+ * \result > 0	Number of bytes successfully copied
  * \result < 0	The last seen error
  */
-int llapi_mirror_copy(int fd, unsigned int src, unsigned int dst, off_t pos,
-		      size_t count)
+int llapi_mirror_copy_ext(int fd, unsigned int src, unsigned int dst,
+			  off_t pos, size_t count,
+			  const struct llapi_mirror_copy_param *param)
 {
-	const size_t buflen = 4 * 1024 * 1024; /* 4M */
-	void *buf;
+	struct mirror_copy_target target = { 0 };
+	struct mirror_copy_ctx *ctx;
 	size_t page_size = sysconf(_SC_PAGESIZE);
-	ssize_t result = 0;
+	struct stat stbuf;
+	off_t end;
+	ssize_t result;
 	int rc;
 
 	if (!count)
@@ -429,54 +964,47 @@ int llapi_mirror_copy(int fd, unsigned int src, unsigned int dst, off_t pos,
 	if (count != OBD_OBJECT_EOF && count & (page_size - 1))
 		return -EINVAL;
 
-	rc = posix_memalign(&buf, page_size, buflen);
-	if (rc) /* error code is returned directly */
-		return -rc;
-
-	while (result < count) {
-		ssize_t bytes_read, bytes_written;
-		size_t to_read, to_write;
-
-		to_read = MIN(buflen, count - result);
-		if (src == 0)
-			bytes_read = pread(fd, buf, to_read, pos);
-		else
-			bytes_read = llapi_mirror_read(fd, src, buf, to_read,
-							pos);
-		if (!bytes_read) { /* end of file */
-			break;
-		} else if (bytes_read < 0) {
-			result = bytes_read;
-			break;
-		}
-
-		/* round up to page align to make direct IO happy.
-		 * this implies the last segment to write. */
-		to_write = (bytes_read + page_size - 1) & ~(page_size - 1);
-
-		bytes_written = llapi_mirror_write(fd, dst, buf, to_write,
-						    pos);
-		if (bytes_written < 0) {
-			result = bytes_written;
-			break;
-		}
+	if (count == OBD_OBJECT_EOF) {
+		if (fstat(fd, &stbuf) < 0)
+			return -errno;
+		end = (stbuf.st_size + page_size - 1) & ~(page_size - 1);
+		if (end <= pos)
+			return 0;
+		count = end - pos;
+	}
 
-		assert(bytes_written == to_write);
+	target.mct_fd = fd;
+	target.mct_mirror_id = dst;
+	target.mct_start = pos;
+	target.mct_end = OBD_OBJECT_EOF;
 
-		pos += bytes_read;
-		result += bytes_read;
+	rc = mirror_copy_init(&ctx, fd, &target, 1, count, param);
+	if (rc < 0)
+		return rc;
 
-		if (bytes_read < to_read) /* short read occurred */
-			break;
-	}
+	rc = mirror_copy_queue(ctx, src, pos, count);
+	if (!rc)
+		rc = mirror_copy_flush(ctx);
+	end = rc > 0 ? mirror_copy_pos(ctx) : pos + count;
+	mirror_copy_fini(ctx);
 
-	free(buf);
+	if (rc < 0)
+		return rc;
+	if (target.mct_rc < 0)
+		return target.mct_rc;
 
-	if (result > 0 && pos & (page_size - 1)) {
-		rc = llapi_mirror_truncate(fd, dst, pos);
+	result = end - pos;
+	if (result > 0 && end & (page_size - 1)) {
+		rc = llapi_mirror_truncate(fd, dst, end);
 		if (rc < 0)
 			result = rc;
 	}
 
 	return result;
 }
+
+int llapi_mirror_copy(int fd, unsigned int src, unsigned int dst, off_t pos,
+		      size_t count)
+{
+	return llapi_mirror_copy_ext(fd, src, dst, pos, count, NULL);
+}
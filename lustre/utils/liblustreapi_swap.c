@@ -30,12 +30,15 @@
 
 #include <stdlib.h>
 #include <errno.h>
+#include <unistd.h>
+#include <sys/param.h>
 #include <sys/time.h>
 #include <sys/ioctl.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <fcntl.h>
 #include <lustre/lustreapi.h>
+#include "lustreapi_internal.h"
 
 /**
  * Get a 64-bit value representing the version of file data pointed by fd.
@@ -327,6 +330,213 @@ out:
 	return rc;
 }
 
+/* bigger stripes are copied in chunks of the default size */
+#define FILE_COPY_CHUNK_MAX	(64UL << 20)
+
+static uint64_t file_copy_lcm(uint64_t a, uint64_t b)
+{
+	uint64_t x = a;
+	uint64_t y = b;
+
+	while (y) {
+		uint64_t t = x % y;
+
+		x = y;
+		y = t;
+	}
+
+	return a / x * b;
+}
+
+/*
+ * Return the least common multiple of the stripe sizes of all components of
+ * the file layout, so that a chunk covers whole stripes whichever component
+ * of a PFL or FLR file it falls into. DoM components are not striped and are
+ * skipped. 0 is returned if the layout cannot be read or the result is too
+ * big to be used as a chunk size.
+ */
+static uint64_t file_copy_stripe_size(int fd)
+{
+	struct llapi_layout *layout;
+	uint64_t stripe_size = 0;
+	int rc;
+
+	layout = llapi_layout_get_by_fd(fd, 0);
+	if (!layout)
+		return 0;
+
+	rc = llapi_layout_comp_use(layout, LLAPI_LAYOUT_COMP_USE_FIRST);
+	while (rc == 0) {
+		uint64_t pattern;
+		uint64_t size;
+
+		if (llapi_layout_pattern_get(layout, &pattern) < 0 ||
+		    llapi_layout_stripe_size_get(layout, &size) < 0 ||
+		    size > FILE_COPY_CHUNK_MAX) {
+			stripe_size = 0;
+			break;
+		}
+
+		if (pattern != LLAPI_LAYOUT_MDT && size) {
+			stripe_size = stripe_size ?
+				      file_copy_lcm(stripe_size, size) : size;
+			if (stripe_size > FILE_COPY_CHUNK_MAX) {
+				stripe_size = 0;
+				break;
+			}
+		}
+		rc = llapi_layout_comp_use(layout, LLAPI_LAYOUT_COMP_USE_NEXT);
+	}
+	if (rc < 0)
+		stripe_size = 0;
+	llapi_layout_free(layout);
+
+	return stripe_size;
+}
+
+/*
+ * Pick a chunk size which is a multiple of the stripe size of both files,
+ * so that every chunk covers whole stripes of the source and the target.
+ */
+static size_t file_copy_chunk_size(int fd_src, int fd_dst)
+{
+	uint64_t src_size = file_copy_stripe_size(fd_src);
+	uint64_t dst_size = file_copy_stripe_size(fd_dst);
+	uint64_t chunk;
+
+	if (!src_size || !dst_size)
+		return LLAPI_MIRROR_COPY_CHUNK_DEF;
+
+	chunk = file_copy_lcm(src_size, dst_size);
+	if (chunk > FILE_COPY_CHUNK_MAX)
+		return LLAPI_MIRROR_COPY_CHUNK_DEF;
+
+	/* small stripes, keep enough data in flight per I/O */
+	if (chunk < LLAPI_MIRROR_COPY_CHUNK_DEF)
+		chunk *= (LLAPI_MIRROR_COPY_CHUNK_DEF + chunk - 1) / chunk;
+
+	return chunk;
+}
+
+/**
+ * Copy the data of file \a fd_src to \a fd_dst, usually a volatile file
+ * whose layout is swapped with the source afterwards, e.g. for migration.
+ *
+ * The copy is done in parallel by the mirror copy threads, in chunks aligned
+ * to the stripes of both files unless \a param sets the chunk size. Holes
+ * of a sparse source are not copied. The progress callback of \a param is
+ * called after each batch of chunks, and can abort the copy, e.g. if the
+ * lease on the source file was broken.
+ *
+ * \param fd_src	source file descriptor, should be opened with O_DIRECT
+ * \param fd_dst	target file descriptor, should be opened with O_DIRECT
+ * \param param		threads, chunk size and progress reporting, or NULL
+ *
+ * \retval	0 on success.
+ * \retval	-errno on failure, or the error returned by the callback.
+ */
+int llapi_file_copy_data(int fd_src, int fd_dst,
+			 const struct llapi_mirror_copy_param *param)
+{
+	struct llapi_mirror_copy_param copy_param = { 0 };
+	struct mirror_copy_target target = { 0 };
+	struct mirror_copy_ctx *ctx;
+	size_t page_size = sysconf(_SC_PAGESIZE);
+	struct stat stbuf;
+	off_t pos = 0;
+	off_t file_end;
+	bool sparse;
+	int rc;
+
+	if (fstat(fd_src, &stbuf) < 0)
+		return -errno;
+	file_end = (stbuf.st_size + page_size - 1) & ~(page_size - 1);
+
+	if (param)
+		copy_param = *param;
+	if (!copy_param.mcp_chunk_size)
+		copy_param.mcp_chunk_size = file_copy_chunk_size(fd_src,
+								 fd_dst);
+
+	sparse = llapi_file_is_sparse(fd_src);
+	if (sparse) {
+		/* the target must have no data in the source holes */
+		rc = ftruncate(fd_dst, 0);
+		if (rc < 0)
+			return -errno;
+	}
+
+	target.mct_fd = fd_dst;
+	target.mct_start = 0;
+	target.mct_end = OBD_OBJECT_EOF;
+
+	rc = mirror_copy_init(&ctx, fd_src, &target, 1, stbuf.st_size,
+			      &copy_param);
+	if (rc < 0)
+		return rc;
+
+	while (!rc) {
+		size_t len;
+
+		if (sparse) {
+			off_t data_off;
+			size_t data_size;
+			off_t data_end;
+
+			data_off = llapi_data_seek(fd_src, pos, &data_size);
+			if (data_off < 0) {
+				/* Non-fatal, switch to full copy */
+				sparse = false;
+				continue;
+			}
+			if (!data_size) {
+				/* hole at the end of file, it is set by the
+				 * truncate below
+				 */
+				mirror_copy_skip(ctx, data_off - pos);
+				pos = data_off;
+				break;
+			}
+
+			data_end = data_off + data_size;
+			/* align by page */
+			data_off &= ~(page_size - 1);
+			data_end = ((data_end - 1) | (page_size - 1)) + 1;
+			mirror_copy_skip(ctx, data_off - pos);
+			pos = data_off;
+			len = data_end - pos;
+		} else {
+			if (pos >= file_end)
+				break;
+			len = file_end - pos;
+		}
+
+		rc = mirror_copy_queue(ctx, 0, pos, len);
+		pos += len;
+	}
+
+	if (!rc)
+		rc = mirror_copy_flush(ctx);
+	if (rc > 0) {
+		/* end of file, the last chunk may be partial */
+		pos = mirror_copy_pos(ctx);
+		rc = 0;
+	}
+	mirror_copy_fini(ctx);
+
+	if (rc < 0)
+		return rc;
+	if (target.mct_rc < 0)
+		return target.mct_rc;
+
+	/* the last write is rounded up to a page, set the real size */
+	rc = ftruncate(fd_dst, pos);
+	if (rc < 0)
+		return -errno;
+
+	return 0;
+}
+
 /**
  * Take group lock.
  *
@@ -0,0 +1,879 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * lustre/utils/lpcc_prefetch.c
+ *
+ * Heat driven PCC prefetch daemon.
+ *
+ * The daemon polls the hottest files of a client mount (LL_IOC_HEAT_TOP),
+ * and attaches the files whose heat crosses a threshold into a PCC backend
+ * from a pool of copy-in threads, with an optional bandwidth limit. Only
+ * read-write PCC exists, which releases the Lustre copy of the attached
+ * files, so attaching needs an explicit opt-in and skips the files that
+ * are open or were recently modified, possibly on other clients. The
+ * space used in the PCC backend is bounded: when it is exceeded, the least
+ * recently accessed cached files, according to the atime of their PCC copy,
+ * are detached and removed from the cache.
+ */
+
+#ifndef _GNU_SOURCE
+#define _GNU_SOURCE
+#endif
+#include <errno.h>
+#include <fcntl.h>
+#include <ftw.h>
+#include <getopt.h>
+#include <limits.h>
+#include <pthread.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include <libcfs/util/hash.h>
+#include <libcfs/util/list.h>
+#include <linux/lustre/lustre_fid.h>
+#include <lustre/lustreapi.h>
+#include "lstddef.h"
+
+#define PF_INTERVAL_DEFAULT	10
+#define PF_THREADS_DEFAULT	4
+#define PF_THRESHOLD_DEFAULT	100
+#define PF_TOP_DEFAULT		256
+/* Seconds since the last modification of a file before it is attached */
+#define PF_IDLE_DEFAULT		60
+/* Queued files per copy-in thread, more candidates wait for a next scan */
+#define PF_QUEUE_PER_THREAD	4
+/* Number of scans to wait before trying to attach a file again */
+#define PF_RETRY_SCANS		6
+
+#define ONE_MB 0x100000
+
+#define PF_HASH_SHIFT		10
+#define PF_HASH_ENTRIES		(1 << PF_HASH_SHIFT)
+
+struct options {
+	char			*o_mnt;
+	char			*o_pcc_root;
+	__u32			 o_archive_id;
+	__u64			 o_threshold;
+	unsigned int		 o_threads;
+	unsigned int		 o_top;
+	unsigned int		 o_interval;
+	unsigned int		 o_idle;
+	unsigned long long	 o_bandwidth;	/* bytes per second */
+	unsigned long long	 o_cache_size;	/* bytes, 0 for no limit */
+	int			 o_daemonize;
+	int			 o_once;
+	int			 o_verbose;
+	int			 o_read_write;
+};
+
+/* everything else is zeroed */
+static struct options opt = {
+	.o_threshold	= PF_THRESHOLD_DEFAULT,
+	.o_threads	= PF_THREADS_DEFAULT,
+	.o_top		= PF_TOP_DEFAULT,
+	.o_interval	= PF_INTERVAL_DEFAULT,
+	.o_idle		= PF_IDLE_DEFAULT,
+	.o_verbose	= LLAPI_MSG_INFO,
+};
+
+enum pf_state {
+	PF_QUEUED,
+	PF_ATTACHING,
+	PF_CACHED,
+	PF_DETACHING,
+	PF_FAILED,
+};
+
+struct pf_file {
+	struct hlist_node	pf_node;
+	/* on pf_queue when queued, on pf_cached when cached */
+	struct list_head	pf_link;
+	struct lu_fid		pf_fid;
+	enum pf_state		pf_state;
+	unsigned long long	pf_size;
+	/* atime of the PCC copy */
+	time_t			pf_atime;
+	/* scan after which a failed attach may be tried again */
+	unsigned long		pf_retry_scan;
+};
+
+struct pf_stats {
+	unsigned long		ps_attached;
+	unsigned long long	ps_attached_bytes;
+	unsigned long		ps_attach_failed;
+	unsigned long		ps_busy;
+	unsigned long		ps_dropped;
+	unsigned long		ps_evicted;
+	unsigned long long	ps_evicted_bytes;
+};
+
+static pthread_mutex_t pf_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pf_cond = PTHREAD_COND_INITIALIZER;
+static struct hlist_head pf_hash[PF_HASH_ENTRIES];
+static struct list_head pf_queue = LIST_HEAD_INIT(pf_queue);
+static struct list_head pf_cached = LIST_HEAD_INIT(pf_cached);
+static unsigned int pf_queued_count;
+static unsigned long long pf_queued_bytes;
+static unsigned long long pf_cached_bytes;
+static unsigned long pf_scan;
+static struct pf_stats pf_stats;
+static volatile sig_atomic_t pf_stop;
+
+static pthread_mutex_t pf_throttle_lock = PTHREAD_MUTEX_INITIALIZER;
+static double pf_throttle_next;
+
+static char cmd_name[PATH_MAX];
+
+#define PF_ERROR(_rc, _format, ...)					\
+	llapi_error(LLAPI_MSG_ERROR, _rc, "%s: "_format,		\
+		    cmd_name, ## __VA_ARGS__)
+
+#define PF_TRACE(_format, ...)						\
+	llapi_error(LLAPI_MSG_INFO | LLAPI_MSG_NO_ERRNO, 0,		\
+		    "%s: "_format, cmd_name, ## __VA_ARGS__)
+
+#define PF_DEBUG(_format, ...)						\
+	llapi_error(LLAPI_MSG_DEBUG | LLAPI_MSG_NO_ERRNO, 0,		\
+		    "%s: "_format, cmd_name, ## __VA_ARGS__)
+
+static void usage(int rc)
+{
+	fprintf(stdout,
+	"Usage: %s [options] -w -A <archive_id> -p <pcc_root> <lustre_mount_point>\n"
+	"Attach the hottest files of a Lustre client mount into a PCC backend.\n"
+	"Files are attached into read-write PCC, which releases their Lustre\n"
+	"copy, --read-write is required to confirm it.\n"
+	"Options:\n"
+	"   -A, --archive-id <#>      Archive ID of the PCC backend\n"
+	"   -b, --bandwidth <bw>      Limit copy-in bandwidth (unit can be\n"
+	"                             used, default is MB)\n"
+	"   -c, --cache-size <sz>     Limit space used in the PCC backend,\n"
+	"                             detach least recently used files above\n"
+	"                             (unit can be used, default is MB)\n"
+	"   -d, --daemon              Daemon mode, run in background\n"
+	"   -i, --interval <s>        Interval between scans (default %u)\n"
+	"   -I, --idle <s>            Skip files modified less than <s>\n"
+	"                             seconds ago (default %u)\n"
+	"   -j, --threads <#>         Number of copy-in threads (default %u)\n"
+	"   -n, --top <#>             Hottest files checked per scan\n"
+	"                             (default %u)\n"
+	"   -o, --once                Scan once, wait for copy-in and exit\n"
+	"   -p, --pcc-root <path>     Root directory of the PCC backend\n"
+	"   -q, --quiet               Produce less verbose output\n"
+	"   -t, --threshold <heat>    Read and write sample heat needed to\n"
+	"                             attach a file (default %u)\n"
+	"   -v, --verbose             Produce more verbose output\n"
+	"   -w, --read-write          Attach files into read-write PCC\n",
+	cmd_name, PF_INTERVAL_DEFAULT, PF_IDLE_DEFAULT, PF_THREADS_DEFAULT,
+	PF_TOP_DEFAULT, PF_THRESHOLD_DEFAULT);
+	exit(rc);
+}
+
+static int pf_parse_size(const char *arg, unsigned long long *size)
+{
+	unsigned long long unit = ONE_MB;
+
+	if (llapi_parse_size(arg, size, &unit, 0) < 0)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int pf_parse_uint(const char *arg, unsigned long long max,
+			 unsigned long long *val)
+{
+	char *end;
+
+	errno = 0;
+	*val = strtoull(arg, &end, 0);
+	if (errno != 0 || *end != '\0' || *val > max)
+		return -EINVAL;
+
+	return 0;
+}
+
+static int pf_parseopts(int argc, char **argv)
+{
+	struct option long_opts[] = {
+	{ .val = 'A',	.name = "archive-id",	.has_arg = required_argument },
+	{ .val = 'b',	.name = "bandwidth",	.has_arg = required_argument },
+	{ .val = 'c',	.name = "cache-size",	.has_arg = required_argument },
+	{ .val = 'd',	.name = "daemon",	.has_arg = no_argument },
+	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
+	{ .val = 'i',	.name = "interval",	.has_arg = required_argument },
+	{ .val = 'I',	.name = "idle",		.has_arg = required_argument },
+	{ .val = 'j',	.name = "threads",	.has_arg = required_argument },
+	{ .val = 'n',	.name = "top",		.has_arg = required_argument },
+	{ .val = 'o',	.name = "once",		.has_arg = no_argument },
+	{ .val = 'p',	.name = "pcc-root",	.has_arg = required_argument },
+	{ .val = 'q',	.name = "quiet",	.has_arg = no_argument },
+	{ .val = 't',	.name = "threshold",	.has_arg = required_argument },
+	{ .val = 'v',	.name = "verbose",	.has_arg = no_argument },
+	{ .val = 'w',	.name = "read-write",	.has_arg = no_argument },
+	{ .name = NULL } };
+	unsigned long long val;
+	int c;
+
+	optind = 0;
+	while ((c = getopt_long(argc, argv, "A:b:c:dhi:I:j:n:op:qt:vw",
+				long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'A':
+			if (pf_parse_uint(optarg, UINT_MAX, &val) || val == 0) {
+				PF_ERROR(-EINVAL, "bad archive ID '%s'",
+					 optarg);
+				return -EINVAL;
+			}
+			opt.o_archive_id = val;
+			break;
+		case 'b':
+			if (pf_parse_size(optarg, &opt.o_bandwidth)) {
+				PF_ERROR(-EINVAL, "bad bandwidth '%s'", optarg);
+				return -EINVAL;
+			}
+			break;
+		case 'c':
+			if (pf_parse_size(optarg, &opt.o_cache_size)) {
+				PF_ERROR(-EINVAL, "bad cache size '%s'",
+					 optarg);
+				return -EINVAL;
+			}
+			break;
+		case 'd':
+			opt.o_daemonize = 1;
+			break;
+		case 'h':
+			usage(0);
+			break;
+		case 'i':
+			if (pf_parse_uint(optarg, INT_MAX, &val) || val == 0) {
+				PF_ERROR(-EINVAL, "bad interval '%s'", optarg);
+				return -EINVAL;
+			}
+			opt.o_interval = val;
+			break;
+		case 'I':
+			if (pf_parse_uint(optarg, INT_MAX, &val)) {
+				PF_ERROR(-EINVAL, "bad idle time '%s'", optarg);
+				return -EINVAL;
+			}
+			opt.o_idle = val;
+			break;
+		case 'j':
+			if (pf_parse_uint(optarg, 1024, &val) || val == 0) {
+				PF_ERROR(-EINVAL, "bad thread count '%s'",
+					 optarg);
+				return -EINVAL;
+			}
+			opt.o_threads = val;
+			break;
+		case 'n':
+			if (pf_parse_uint(optarg, 16384, &val) || val == 0) {
+				PF_ERROR(-EINVAL, "bad file count '%s'",
+					 optarg);
+				return -EINVAL;
+			}
+			opt.o_top = val;
+			break;
+		case 'o':
+			opt.o_once = 1;
+			break;
+		case 'p':
+			opt.o_pcc_root = optarg;
+			break;
+		case 'q':
+			opt.o_verbose--;
+			break;
+		case 't':
+			if (pf_parse_uint(optarg, ULLONG_MAX, &val)) {
+				PF_ERROR(-EINVAL, "bad threshold '%s'", optarg);
+				return -EINVAL;
+			}
+			opt.o_threshold = val;
+			break;
+		case 'v':
+			opt.o_verbose++;
+			break;
+		case 'w':
+			opt.o_read_write = 1;
+			break;
+		default:
+			return -EINVAL;
+		}
+	}
+
+	if (argc != optind + 1) {
+		PF_ERROR(-EINVAL, "no Lustre mount point specified");
+		return -EINVAL;
+	}
+	opt.o_mnt = argv[optind];
+
+	if (opt.o_archive_id == 0 || opt.o_pcc_root == NULL) {
+		PF_ERROR(-EINVAL, "archive ID and PCC root are required");
+		return -EINVAL;
+	}
+
+	/* read-write PCC moves the data of the files out of Lustre, other
+	 * clients reading them need a copytool restore */
+	if (!opt.o_read_write) {
+		PF_ERROR(-EOPNOTSUPP,
+			 "only read-write PCC is available, --read-write is needed to attach files into it");
+		return -EOPNOTSUPP;
+	}
+
+	return 0;
+}
+
+static inline double pf_now(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+
+	return ts.tv_sec + 1e-9 * ts.tv_nsec;
+}
+
+/* Same hashed layout as the PCC copy of a file, see pcc_fid2dataset_path() */
+static void pf_pcc_path(char *buf, size_t size, const struct lu_fid *fid)
+{
+	snprintf(buf, size, "%s/%04x/%04x/%04x/%04x/%04x/%04x/"DFID_NOBRACE,
+		 opt.o_pcc_root,
+		 fid->f_oid & 0xFFFF, fid->f_oid >> 16 & 0xFFFF,
+		 (unsigned int)(fid->f_seq & 0xFFFF),
+		 (unsigned int)(fid->f_seq >> 16 & 0xFFFF),
+		 (unsigned int)(fid->f_seq >> 32 & 0xFFFF),
+		 (unsigned int)(fid->f_seq >> 48 & 0xFFFF),
+		 PFID(fid));
+}
+
+static inline unsigned int pf_hash_fn(const struct lu_fid *fid)
+{
+	return hash_long(fid->f_seq ^ ((__u64)fid->f_oid << 32 | fid->f_ver),
+			 PF_HASH_SHIFT);
+}
+
+/* called with pf_lock held */
+static struct pf_file *pf_find(const struct lu_fid *fid)
+{
+	struct hlist_node *entry;
+	struct pf_file *f;
+
+	hlist_for_each_entry(f, entry, &pf_hash[pf_hash_fn(fid)], pf_node) {
+		if (lu_fid_eq(&f->pf_fid, fid))
+			return f;
+	}
+
+	return NULL;
+}
+
+/* called with pf_lock held */
+static struct pf_file *pf_add(const struct lu_fid *fid)
+{
+	struct pf_file *f;
+
+	f = calloc(1, sizeof(*f));
+	if (f == NULL)
+		return NULL;
+
+	f->pf_fid = *fid;
+	INIT_LIST_HEAD(&f->pf_link);
+	hlist_add_head(&f->pf_node, &pf_hash[pf_hash_fn(fid)]);
+
+	return f;
+}
+
+/* called with pf_lock held */
+static void pf_del(struct pf_file *f)
+{
+	if (f->pf_state == PF_CACHED || f->pf_state == PF_DETACHING)
+		pf_cached_bytes -= f->pf_size;
+	list_del(&f->pf_link);
+	hlist_del(&f->pf_node);
+	free(f);
+}
+
+/* called with pf_lock held */
+static void pf_cache(struct pf_file *f, time_t atime)
+{
+	f->pf_state = PF_CACHED;
+	f->pf_atime = atime;
+	list_add_tail(&f->pf_link, &pf_cached);
+	pf_cached_bytes += f->pf_size;
+}
+
+/* Rebuild the list of cached files from the PCC backend at startup. */
+static int pf_load_one(const char *path, const struct stat *st, int flag,
+		       struct FTW *ftwbuf)
+{
+	struct lu_fid fid;
+	struct pf_file *f;
+	char *end;
+
+	if (flag != FTW_F || !S_ISREG(st->st_mode))
+		return 0;
+
+	if (llapi_fid_parse(path + ftwbuf->base, &fid, &end) != 0 ||
+	    *end != '\0')
+		return 0;
+
+	f = pf_add(&fid);
+	if (f == NULL)
+		return -ENOMEM;
+
+	f->pf_size = st->st_size;
+	pf_cache(f, st->st_atime);
+
+	return 0;
+}
+
+static int pf_load(void)
+{
+	int rc;
+
+	pthread_mutex_lock(&pf_lock);
+	rc = nftw(opt.o_pcc_root, pf_load_one, 64, FTW_PHYS | FTW_MOUNT);
+	pthread_mutex_unlock(&pf_lock);
+	if (rc < 0) {
+		rc = -errno;
+		PF_ERROR(rc, "cannot scan PCC root '%s'", opt.o_pcc_root);
+		return rc;
+	}
+	if (rc > 0)
+		return -rc;
+
+	PF_TRACE("%llu bytes cached in '%s'", pf_cached_bytes,
+		 opt.o_pcc_root);
+
+	return 0;
+}
+
+/* Limit the copy-in bandwidth of all the threads together. */
+static void pf_throttle(unsigned long long size)
+{
+	struct timespec delay;
+	double now;
+	double start;
+
+	if (opt.o_bandwidth == 0)
+		return;
+
+	pthread_mutex_lock(&pf_throttle_lock);
+	now = pf_now();
+	if (pf_throttle_next < now)
+		pf_throttle_next = now;
+	start = pf_throttle_next;
+	pf_throttle_next += (double)size / opt.o_bandwidth;
+	pthread_mutex_unlock(&pf_throttle_lock);
+
+	if (start <= now)
+		return;
+
+	delay.tv_sec = start - now;
+	delay.tv_nsec = (start - now - delay.tv_sec) * 1e9;
+	PF_DEBUG("bandwidth control: wait %ld.%09ld s", delay.tv_sec,
+		 delay.tv_nsec);
+	while (nanosleep(&delay, &delay) == -1 && errno == EINTR && !pf_stop)
+		;
+}
+
+/*
+ * Check that nobody else, on this client or another one, has the file open.
+ * A write lease is only granted to the only opener of a file.
+ */
+static int pf_check_unused(const struct lu_fid *fid)
+{
+	char path[PATH_MAX];
+	int fd;
+	int rc;
+
+	snprintf(path, sizeof(path), "%s/.lustre/fid/"DFID, opt.o_mnt,
+		 PFID(fid));
+	fd = open(path, O_RDWR | O_NONBLOCK);
+	if (fd < 0)
+		return -errno;
+
+	rc = llapi_lease_acquire(fd, LL_LEASE_WRLCK);
+	if (rc >= 0) {
+		llapi_lease_release(fd);
+		rc = 0;
+	}
+	close(fd);
+
+	return rc;
+}
+
+static void *pf_thread(void *arg)
+{
+	struct stat st;
+	struct pf_file *f;
+	char path[PATH_MAX];
+	struct lu_fid fid;
+	int rc;
+
+	pthread_mutex_lock(&pf_lock);
+	while (1) {
+		while (!pf_stop && list_empty(&pf_queue))
+			pthread_cond_wait(&pf_cond, &pf_lock);
+		if (pf_stop)
+			break;
+
+		f = list_entry(pf_queue.next, struct pf_file, pf_link);
+		list_del_init(&f->pf_link);
+		f->pf_state = PF_ATTACHING;
+		fid = f->pf_fid;
+		pthread_mutex_unlock(&pf_lock);
+
+		rc = pf_check_unused(&fid);
+		if (rc == 0) {
+			pf_throttle(f->pf_size);
+			rc = llapi_pcc_attach_fid(opt.o_mnt, &fid,
+						  opt.o_archive_id,
+						  LU_PCC_READWRITE);
+		}
+		if (rc == 0 || rc == -EEXIST) {
+			pf_pcc_path(path, sizeof(path), &fid);
+			if (stat(path, &st) < 0)
+				rc = -errno;
+		}
+
+		pthread_mutex_lock(&pf_lock);
+		pf_queued_count--;
+		pf_queued_bytes -= f->pf_size;
+		if (rc == 0 || rc == -EEXIST) {
+			f->pf_size = st.st_size;
+			pf_cache(f, st.st_atime);
+			pf_stats.ps_attached++;
+			pf_stats.ps_attached_bytes += st.st_size;
+			PF_DEBUG("attached "DFID", %llu bytes", PFID(&fid),
+				 (unsigned long long)st.st_size);
+		} else {
+			/* busy or opened elsewhere, try later */
+			f->pf_state = PF_FAILED;
+			f->pf_retry_scan = pf_scan + PF_RETRY_SCANS;
+			if (rc == -EBUSY)
+				pf_stats.ps_busy++;
+			else
+				pf_stats.ps_attach_failed++;
+			PF_DEBUG("cannot attach "DFID": %s", PFID(&fid),
+				 strerror(-rc));
+		}
+		pthread_cond_broadcast(&pf_cond);
+	}
+	pthread_mutex_unlock(&pf_lock);
+
+	return NULL;
+}
+
+/* Queue a hot file for copy-in, called with pf_lock held */
+static void pf_queue_file(const struct lu_fid *fid)
+{
+	struct hsm_user_state hus;
+	struct pf_file *f;
+	char path[PATH_MAX];
+	struct stat st;
+	time_t now;
+	int rc;
+
+	f = pf_find(fid);
+	if (f != NULL && (f->pf_state != PF_FAILED ||
+			  f->pf_retry_scan > pf_scan))
+		return;
+
+	if (pf_queued_count >= opt.o_threads * PF_QUEUE_PER_THREAD) {
+		pf_stats.ps_dropped++;
+		return;
+	}
+
+	snprintf(path, sizeof(path), "%s/.lustre/fid/"DFID, opt.o_mnt,
+		 PFID(fid));
+	if (stat(path, &st) < 0 || !S_ISREG(st.st_mode))
+		return;
+
+	if (opt.o_cache_size && st.st_size > opt.o_cache_size)
+		return;
+
+	/* still being written, maybe by another client */
+	now = time(NULL);
+	if (st.st_mtime + opt.o_idle > now || st.st_ctime + opt.o_idle > now) {
+		pf_stats.ps_busy++;
+		return;
+	}
+
+	/* A released file is already cached in PCC, or archived elsewhere */
+	rc = llapi_hsm_state_get(path, &hus);
+	if (rc < 0 || hus.hus_states & HS_RELEASED)
+		return;
+
+	if (f == NULL) {
+		f = pf_add(fid);
+		if (f == NULL)
+			return;
+	}
+
+	f->pf_state = PF_QUEUED;
+	f->pf_size = st.st_size;
+	list_add_tail(&f->pf_link, &pf_queue);
+	pf_queued_count++;
+	pf_queued_bytes += st.st_size;
+	pthread_cond_signal(&pf_cond);
+}
+
+/* Queue the files hotter than the threshold, hottest first. */
+static int pf_scan_heat(int mnt_fd, struct lu_heat_top *top)
+{
+	__u64 heat;
+	int rc;
+	int i;
+
+	top->lht_count = opt.o_top;
+	rc = llapi_heat_top_get(mnt_fd, top);
+	if (rc < 0)
+		return rc;
+
+	pthread_mutex_lock(&pf_lock);
+	pf_scan++;
+	for (i = 0; i < top->lht_count && !pf_stop; i++) {
+		heat = top->lht_entries[i].lhte_heat[OBD_HEAT_READSAMPLE] +
+		       top->lht_entries[i].lhte_heat[OBD_HEAT_WRITESAMPLE];
+		if (heat < opt.o_threshold)
+			break;
+
+		pf_queue_file(&top->lht_entries[i].lhte_fid);
+	}
+	pthread_mutex_unlock(&pf_lock);
+
+	return 0;
+}
+
+/*
+ * Update the atime of the cached files from their PCC copy, and forget the
+ * files that were detached by someone else, called with pf_lock held.
+ */
+static void pf_cached_refresh(void)
+{
+	struct pf_file *f;
+	struct pf_file *tmp;
+	char path[PATH_MAX];
+	struct stat st;
+
+	list_for_each_entry_safe(f, tmp, &pf_cached, pf_link) {
+		pf_pcc_path(path, sizeof(path), &f->pf_fid);
+		if (stat(path, &st) < 0) {
+			if (errno == ENOENT)
+				pf_del(f);
+			continue;
+		}
+
+		f->pf_atime = st.st_atime;
+		pf_cached_bytes += st.st_size - f->pf_size;
+		f->pf_size = st.st_size;
+	}
+}
+
+/* Detach the least recently used files until the queued ones fit. */
+static void pf_shrink(void)
+{
+	struct pf_file *victim;
+	struct pf_file *f;
+	struct lu_fid fid;
+	unsigned long long size;
+	char path[PATH_MAX];
+	struct list_head busy = LIST_HEAD_INIT(busy);
+	int fd;
+	int rc;
+
+	if (opt.o_cache_size == 0)
+		return;
+
+	pthread_mutex_lock(&pf_lock);
+	pf_cached_refresh();
+	while (!pf_stop &&
+	       pf_cached_bytes + pf_queued_bytes > opt.o_cache_size) {
+		victim = NULL;
+		list_for_each_entry(f, &pf_cached, pf_link) {
+			if (victim == NULL || f->pf_atime < victim->pf_atime)
+				victim = f;
+		}
+		if (victim == NULL)
+			break;
+
+		/* it stays charged to the cache until it is detached */
+		fid = victim->pf_fid;
+		size = victim->pf_size;
+		victim->pf_state = PF_DETACHING;
+		list_del_init(&victim->pf_link);
+		pthread_mutex_unlock(&pf_lock);
+
+		/* the open attaches the PCC copy again if it was not */
+		snprintf(path, sizeof(path), "%s/.lustre/fid/"DFID, opt.o_mnt,
+			 PFID(&fid));
+		fd = open(path, O_RDWR | O_NONBLOCK);
+		if (fd < 0) {
+			rc = -errno;
+		} else {
+			rc = llapi_pcc_detach_fd(fd, PCC_DETACH_OPT_UNCACHE);
+			if (rc < 0)
+				rc = -errno;
+			close(fd);
+		}
+
+		pthread_mutex_lock(&pf_lock);
+		if (rc < 0 && rc != -ENOENT) {
+			PF_ERROR(rc, "cannot detach "DFID, PFID(&fid));
+			/* still cached, not picked again by this pass */
+			victim->pf_state = PF_CACHED;
+			list_add_tail(&victim->pf_link, &busy);
+			continue;
+		}
+		pf_del(victim);
+		pf_stats.ps_evicted++;
+		pf_stats.ps_evicted_bytes += size;
+		PF_DEBUG("detached "DFID", %llu bytes", PFID(&fid), size);
+	}
+	list_splice_tail(&busy, &pf_cached);
+	pthread_mutex_unlock(&pf_lock);
+}
+
+static void pf_report(void)
+{
+	PF_TRACE("cached %llu bytes, attached %lu files (%llu bytes), "
+		 "%lu failed, %lu busy, %lu dropped, "
+		 "detached %lu files (%llu bytes)",
+		 pf_cached_bytes, pf_stats.ps_attached,
+		 pf_stats.ps_attached_bytes, pf_stats.ps_attach_failed,
+		 pf_stats.ps_busy, pf_stats.ps_dropped, pf_stats.ps_evicted,
+		 pf_stats.ps_evicted_bytes);
+}
+
+static void handler(int signal)
+{
+	pf_stop = 1;
+}
+
+static int pf_run(void)
+{
+	struct sigaction stop_sigaction = { .sa_handler = handler };
+	struct lu_heat_top *top;
+	pthread_t *threads;
+	unsigned int i;
+	int mnt_fd;
+	int rc;
+
+	top = calloc(1, offsetof(struct lu_heat_top,
+				 lht_entries[opt.o_top]));
+	threads = calloc(opt.o_threads, sizeof(*threads));
+	if (top == NULL || threads == NULL) {
+		rc = -ENOMEM;
+		PF_ERROR(rc, "cannot allocate memory");
+		goto out_free;
+	}
+
+	mnt_fd = open(opt.o_mnt, O_RDONLY | O_DIRECTORY);
+	if (mnt_fd < 0) {
+		rc = -errno;
+		PF_ERROR(rc, "cannot open mount point '%s'", opt.o_mnt);
+		goto out_free;
+	}
+
+	rc = pf_load();
+	if (rc < 0)
+		goto out_close;
+
+	if (opt.o_daemonize && daemon(1, 1) < 0) {
+		rc = -errno;
+		PF_ERROR(rc, "cannot daemonize");
+		goto out_close;
+	}
+
+	sigemptyset(&stop_sigaction.sa_mask);
+	sigaction(SIGINT, &stop_sigaction, NULL);
+	sigaction(SIGTERM, &stop_sigaction, NULL);
+
+	for (i = 0; i < opt.o_threads; i++) {
+		rc = pthread_create(&threads[i], NULL, pf_thread, NULL);
+		if (rc) {
+			rc = -rc;
+			PF_ERROR(rc, "cannot start copy-in thread");
+			pf_stop = 1;
+			break;
+		}
+	}
+
+	while (!pf_stop) {
+		rc = pf_scan_heat(mnt_fd, top);
+		if (rc < 0)
+			break;
+
+		pf_shrink();
+		if (opt.o_once) {
+			pthread_mutex_lock(&pf_lock);
+			while (!pf_stop && pf_queued_count > 0)
+				pthread_cond_wait(&pf_cond, &pf_lock);
+			pthread_mutex_unlock(&pf_lock);
+			pf_shrink();
+			break;
+		}
+
+		if (opt.o_verbose > LLAPI_MSG_INFO)
+			pf_report();
+		sleep(opt.o_interval);
+	}
+
+	pthread_mutex_lock(&pf_lock);
+	pf_stop = 1;
+	pthread_cond_broadcast(&pf_cond);
+	pthread_mutex_unlock(&pf_lock);
+	while (i-- > 0)
+		pthread_join(threads[i], NULL);
+
+	pf_report();
+out_close:
+	close(mnt_fd);
+out_free:
+	free(threads);
+	free(top);
+
+	return rc;
+}
+
+int main(int argc, char **argv)
+{
+	int rc;
+
+	snprintf(cmd_name, sizeof(cmd_name), "%s", basename(argv[0]));
+	rc = pf_parseopts(argc, argv);
+	if (rc < 0)
+		usage(EXIT_FAILURE);
+
+	llapi_msg_set_level(opt.o_verbose);
+
+	rc = pf_run();
+
+	return rc < 0 ? -rc : 0;
+}
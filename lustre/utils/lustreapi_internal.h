@@ -188,4 +188,28 @@ int get_lmd_info_fd(const char *path, int parentfd, int dirfd,
 		    void *lmd_buf, int lmd_len, enum get_lmd_info_type type);
 
 int lov_comp_md_size(struct lov_comp_md_v1 *lcm);
+
+/*
+ * Parallel copy engine used by the mirror copy and resync APIs.
+ */
+struct mirror_copy_target {
+	int		mct_fd;
+	__u32		mct_mirror_id;	/* 0 to write without setting mirror */
+	uint64_t	mct_start;	/* range written to this target */
+	uint64_t	mct_end;
+	int		mct_rc;		/* first write error */
+};
+
+struct mirror_copy_ctx;
+struct llapi_mirror_copy_param;
+
+int mirror_copy_init(struct mirror_copy_ctx **ctxp, int fd,
+		     struct mirror_copy_target *targets, int nr_targets,
+		     uint64_t size, const struct llapi_mirror_copy_param *param);
+void mirror_copy_fini(struct mirror_copy_ctx *ctx);
+int mirror_copy_queue(struct mirror_copy_ctx *ctx, __u32 src, off_t pos,
+		      size_t len);
+int mirror_copy_flush(struct mirror_copy_ctx *ctx);
+void mirror_copy_skip(struct mirror_copy_ctx *ctx, uint64_t bytes);
+off_t mirror_copy_pos(struct mirror_copy_ctx *ctx);
 #endif /* _LUSTREAPI_INTERNAL_H_ */
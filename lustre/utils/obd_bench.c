@@ -0,0 +1,903 @@
+/*
+ * GPL HEADER START
+ *
+ * DO NOT ALTER OR REMOVE COPYRIGHT NOTICES OR THIS FILE HEADER.
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License version 2 only,
+ * as published by the Free Software Foundation.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License version 2 for more details (a copy is included
+ * in the LICENSE file that accompanied this code).
+ *
+ * You should have received a copy of the GNU General Public License
+ * version 2 along with this program; If not, see
+ * http://www.gnu.org/licenses/gpl-2.0.html
+ *
+ * GPL HEADER END
+ */
+/*
+ * This file is part of Lustre, http://www.lustre.org/
+ *
+ * lustre/utils/obd_bench.c
+ *
+ * Native I/O benchmark engine driven through echo_client devices.
+ *
+ * Unlike obdfilter-survey, which forks one "lctl test_brw" per thread and
+ * only reports aggregate bandwidth, "lctl echo_bench" runs all workers as
+ * threads of a single process against one or more echo_client devices
+ * (normally one per OST), mixes bulk and attribute operations according to
+ * a weighted op mix, and records a latency histogram for every operation
+ * type of every thread.  Results are printed as a single JSON document with
+ * throughput and latency percentiles per thread, per device and in total.
+ */
+
+#include <errno.h>
+#include <getopt.h>
+#include <limits.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/stat.h>
+
+#include <libcfs/util/ioctl.h>
+#include <libcfs/util/parser.h>
+#include <libcfs/util/string.h>
+#include <linux/lustre/lustre_ioctl.h>
+#include <linux/lustre/lustre_ostid.h>
+#include <lustre/lustreapi.h>
+
+#include "obdctl.h"
+#include "lustreapi_internal.h"
+
+#if HAVE_LIBPTHREAD
+#include <pthread.h>
+
+enum eb_op {
+	EB_READ		= 0,
+	EB_WRITE,
+	EB_GETATTR,
+	EB_SETATTR,
+	EB_CREATE,
+	EB_DESTROY,
+	EB_OP_MAX
+};
+
+static const char * const eb_op_names[EB_OP_MAX] = {
+	[EB_READ]	= "read",
+	[EB_WRITE]	= "write",
+	[EB_GETATTR]	= "getattr",
+	[EB_SETATTR]	= "setattr",
+	[EB_CREATE]	= "create",
+	[EB_DESTROY]	= "destroy",
+};
+
+/*
+ * Log-linear latency histogram in nanoseconds: values below EB_HIST_SUB are
+ * counted exactly, above that every power of two is split into EB_HIST_SUB
+ * linear sub-buckets, so the relative error of a percentile is below 1/16.
+ */
+#define EB_HIST_SUB_BITS	4
+#define EB_HIST_SUB		(1 << EB_HIST_SUB_BITS)
+#define EB_HIST_BUCKETS		((64 - EB_HIST_SUB_BITS + 1) * EB_HIST_SUB)
+
+struct eb_stats {
+	__u64	es_count;
+	__u64	es_errors;
+	__u64	es_bytes;
+	__u64	es_sum_ns;
+	__u64	es_min_ns;
+	__u64	es_max_ns;
+	__u64	es_hist[EB_HIST_BUCKETS];
+};
+
+struct eb_config {
+	unsigned int	ec_threads;	/* threads per device */
+	unsigned int	ec_objects;	/* objects per device */
+	__u64		ec_io_size;	/* bytes per bulk I/O */
+	__u64		ec_obj_size;	/* bytes of each object to cycle */
+	__u64		ec_count;	/* operations per thread, 0 = no limit */
+	unsigned int	ec_duration;	/* seconds, 0 = no limit */
+	unsigned int	ec_mix[EB_OP_MAX];
+	unsigned int	ec_mix_total;
+	bool		ec_random;
+	bool		ec_keep;
+};
+
+struct eb_target {
+	char		*et_name;
+	int		 et_dev;
+	__u64		*et_objids;
+	unsigned int	 et_nobjs;
+};
+
+struct eb_thread {
+	pthread_t		 eth_thread;
+	struct eb_target	*eth_target;
+	const struct eb_config	*eth_cfg;
+	unsigned int		 eth_index;	/* index within the target */
+	unsigned int		 eth_seed;
+	__u64			 eth_offset;
+	__u64			 eth_stride;
+	int			 eth_rc;
+	struct eb_stats		 eth_stats[EB_OP_MAX];
+};
+
+static pthread_mutex_t eb_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t eb_cond = PTHREAD_COND_INITIALIZER;
+static bool eb_started;
+static struct timespec eb_deadline;
+static volatile int eb_stopping;
+
+static inline __u64 eb_ts_ns(const struct timespec *ts)
+{
+	return (__u64)ts->tv_sec * 1000000000ULL + ts->tv_nsec;
+}
+
+static unsigned int eb_hist_index(__u64 ns)
+{
+	unsigned int shift;
+
+	if (ns < EB_HIST_SUB)
+		return ns;
+
+	shift = 63 - __builtin_clzll(ns) - EB_HIST_SUB_BITS;
+	return (shift + 1) * EB_HIST_SUB +
+	       ((ns >> shift) & (EB_HIST_SUB - 1));
+}
+
+/* midpoint of the range of latencies counted by bucket @idx */
+static __u64 eb_hist_value(unsigned int idx)
+{
+	unsigned int shift;
+
+	if (idx < EB_HIST_SUB)
+		return idx;
+
+	shift = idx / EB_HIST_SUB - 1;
+	return ((__u64)(EB_HIST_SUB + idx % EB_HIST_SUB) << shift) +
+	       ((1ULL << shift) >> 1);
+}
+
+static void eb_stats_record(struct eb_stats *es, __u64 ns, __u64 bytes)
+{
+	if (es->es_count == 0 || ns < es->es_min_ns)
+		es->es_min_ns = ns;
+	if (ns > es->es_max_ns)
+		es->es_max_ns = ns;
+	es->es_count++;
+	es->es_bytes += bytes;
+	es->es_sum_ns += ns;
+	es->es_hist[eb_hist_index(ns)]++;
+}
+
+static void eb_stats_add(struct eb_stats *dst, const struct eb_stats *src)
+{
+	int i;
+
+	if (src->es_count == 0) {
+		dst->es_errors += src->es_errors;
+		return;
+	}
+
+	if (dst->es_count == 0 || src->es_min_ns < dst->es_min_ns)
+		dst->es_min_ns = src->es_min_ns;
+	if (src->es_max_ns > dst->es_max_ns)
+		dst->es_max_ns = src->es_max_ns;
+	dst->es_count += src->es_count;
+	dst->es_errors += src->es_errors;
+	dst->es_bytes += src->es_bytes;
+	dst->es_sum_ns += src->es_sum_ns;
+	for (i = 0; i < EB_HIST_BUCKETS; i++)
+		dst->es_hist[i] += src->es_hist[i];
+}
+
+static __u64 eb_stats_percentile(const struct eb_stats *es, double pct)
+{
+	__u64 target;
+	__u64 seen = 0;
+	int i;
+
+	if (es->es_count == 0)
+		return 0;
+
+	target = (__u64)(es->es_count * pct / 100.0 + 0.5);
+	if (target == 0)
+		target = 1;
+
+	for (i = 0; i < EB_HIST_BUCKETS; i++) {
+		seen += es->es_hist[i];
+		if (seen >= target) {
+			__u64 val = eb_hist_value(i);
+
+			/* never report beyond the observed extremes */
+			if (val < es->es_min_ns)
+				val = es->es_min_ns;
+			if (val > es->es_max_ns)
+				val = es->es_max_ns;
+			return val;
+		}
+	}
+
+	return es->es_max_ns;
+}
+
+static void eb_print_stats(FILE *fp, const struct eb_stats *stats,
+			   double elapsed, int indent)
+{
+	bool first = true;
+	int op;
+
+	fprintf(fp, "{");
+	for (op = 0; op < EB_OP_MAX; op++) {
+		const struct eb_stats *es = &stats[op];
+
+		if (es->es_count == 0 && es->es_errors == 0)
+			continue;
+
+		fprintf(fp, "%s\n%*s\"%s\": {", first ? "" : ",",
+			indent + 2, "", eb_op_names[op]);
+		first = false;
+		fprintf(fp, "\"count\": %llu, \"errors\": %llu, ",
+			(unsigned long long)es->es_count,
+			(unsigned long long)es->es_errors);
+		fprintf(fp, "\"ops_per_sec\": %.2f",
+			elapsed > 0 ? es->es_count / elapsed : 0.0);
+		if (op == EB_READ || op == EB_WRITE)
+			fprintf(fp, ", \"bytes\": %llu, \"mib_per_sec\": %.2f",
+				(unsigned long long)es->es_bytes,
+				elapsed > 0 ?
+				es->es_bytes / elapsed / 1048576.0 : 0.0);
+		fprintf(fp,
+			",\n%*s\"latency_usec\": {\"min\": %.1f, \"mean\": %.1f, \"p50\": %.1f, \"p90\": %.1f, \"p99\": %.1f, \"p99.9\": %.1f, \"max\": %.1f}}",
+			indent + 4, "",
+			es->es_min_ns / 1000.0,
+			es->es_count ?
+			es->es_sum_ns / 1000.0 / es->es_count : 0.0,
+			eb_stats_percentile(es, 50) / 1000.0,
+			eb_stats_percentile(es, 90) / 1000.0,
+			eb_stats_percentile(es, 99) / 1000.0,
+			eb_stats_percentile(es, 99.9) / 1000.0,
+			es->es_max_ns / 1000.0);
+	}
+	fprintf(fp, "%s%*s}", first ? "" : "\n", first ? 0 : indent, "");
+}
+
+/*
+ * Pack @data, issue @cmd on the echo device and, if @es is given, account
+ * the call latency to it.  The reply is unpacked back into @data.
+ */
+static int eb_ioctl(unsigned int cmd, struct obd_ioctl_data *data,
+		    struct eb_stats *es, __u64 bytes)
+{
+	char rawbuf[MAX_IOC_BUFLEN], *buf = rawbuf;
+	struct timespec start, end;
+	int rc;
+
+	memset(buf, 0, sizeof(rawbuf));
+	rc = llapi_ioctl_pack(data, &buf, sizeof(rawbuf));
+	if (rc)
+		return rc;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	rc = l_ioctl(OBD_DEV_ID, cmd, buf);
+	clock_gettime(CLOCK_MONOTONIC, &end);
+	if (rc < 0) {
+		rc = -errno;
+		if (es)
+			es->es_errors++;
+		return rc;
+	}
+
+	llapi_ioctl_unpack(data, buf, sizeof(rawbuf));
+	if (es)
+		eb_stats_record(es, eb_ts_ns(&end) - eb_ts_ns(&start), bytes);
+
+	return 0;
+}
+
+static void eb_init_obdo(struct obd_ioctl_data *data, int dev, __u64 objid)
+{
+	memset(data, 0, sizeof(*data));
+	data->ioc_dev = dev;
+	ostid_set_seq_echo(&data->ioc_obdo1.o_oi);
+	data->ioc_obdo1.o_oi.oi_fid.f_oid = objid;
+	data->ioc_obdo1.o_mode = S_IFREG | 0644;
+}
+
+static int eb_create(int dev, __u64 *objid, struct eb_stats *es)
+{
+	struct obd_ioctl_data data;
+	int rc;
+
+	/* same as "lctl create", OFD assigns the object id */
+	eb_init_obdo(&data, dev, 1);
+	data.ioc_obdo1.o_valid = OBD_MD_FLTYPE | OBD_MD_FLMODE |
+				 OBD_MD_FLID | OBD_MD_FLUID |
+				 OBD_MD_FLGID | OBD_MD_FLGROUP |
+				 OBD_MD_FLPROJID;
+
+	rc = eb_ioctl(OBD_IOC_CREATE, &data, es, 0);
+	if (rc)
+		return rc;
+
+	if (!(data.ioc_obdo1.o_valid & OBD_MD_FLID))
+		return -EINVAL;
+
+	*objid = ostid_id(&data.ioc_obdo1.o_oi);
+	return 0;
+}
+
+static int eb_destroy(int dev, __u64 objid, struct eb_stats *es)
+{
+	struct obd_ioctl_data data;
+
+	eb_init_obdo(&data, dev, objid);
+	data.ioc_obdo1.o_valid = OBD_MD_FLID | OBD_MD_FLMODE;
+
+	return eb_ioctl(OBD_IOC_DESTROY, &data, es, 0);
+}
+
+static enum eb_op eb_pick_op(struct eb_thread *eth)
+{
+	const struct eb_config *cfg = eth->eth_cfg;
+	unsigned int r;
+	int op;
+
+	r = rand_r(&eth->eth_seed) % cfg->ec_mix_total;
+	for (op = 0; op < EB_OP_MAX; op++) {
+		if (r < cfg->ec_mix[op])
+			break;
+		r -= cfg->ec_mix[op];
+	}
+
+	return op;
+}
+
+static int eb_do_op(struct eb_thread *eth, enum eb_op op)
+{
+	const struct eb_config *cfg = eth->eth_cfg;
+	struct eb_target *tgt = eth->eth_target;
+	struct obd_ioctl_data data;
+	__u64 objid;
+	__u64 offset;
+	int rc;
+
+	if (cfg->ec_random)
+		objid = tgt->et_objids[rand_r(&eth->eth_seed) % tgt->et_nobjs];
+	else
+		objid = tgt->et_objids[eth->eth_index % tgt->et_nobjs];
+
+	switch (op) {
+	case EB_READ:
+	case EB_WRITE:
+		if (cfg->ec_random) {
+			offset = (rand_r(&eth->eth_seed) %
+				  (cfg->ec_obj_size / cfg->ec_io_size)) *
+				 cfg->ec_io_size;
+		} else {
+			offset = eth->eth_offset;
+			eth->eth_offset += eth->eth_stride;
+			if (eth->eth_offset + cfg->ec_io_size >
+			    cfg->ec_obj_size)
+				eth->eth_offset %= eth->eth_stride;
+		}
+
+		eb_init_obdo(&data, tgt->et_dev, objid);
+		data.ioc_obdo1.o_mode = S_IFREG;
+		data.ioc_obdo1.o_valid = OBD_MD_FLID | OBD_MD_FLTYPE |
+					 OBD_MD_FLMODE | OBD_MD_FLFLAGS |
+					 OBD_MD_FLGROUP;
+		data.ioc_count = cfg->ec_io_size;
+		data.ioc_offset = offset;
+		/* prep/commit mode, whole I/O in a single batch */
+		data.ioc_pbuf1 = (void *)3;
+		data.ioc_plen1 = cfg->ec_io_size;
+		rc = eb_ioctl(op == EB_WRITE ? OBD_IOC_BRW_WRITE :
+					       OBD_IOC_BRW_READ,
+			      &data, &eth->eth_stats[op], cfg->ec_io_size);
+		break;
+	case EB_GETATTR:
+		eb_init_obdo(&data, tgt->et_dev, objid);
+		data.ioc_obdo1.o_valid = OBD_MD_FLID | OBD_MD_FLGROUP;
+		rc = eb_ioctl(OBD_IOC_GETATTR, &data, &eth->eth_stats[op], 0);
+		break;
+	case EB_SETATTR:
+		eb_init_obdo(&data, tgt->et_dev, objid);
+		data.ioc_obdo1.o_valid = OBD_MD_FLID | OBD_MD_FLTYPE |
+					 OBD_MD_FLMODE | OBD_MD_FLGROUP;
+		rc = eb_ioctl(OBD_IOC_SETATTR, &data, &eth->eth_stats[op], 0);
+		break;
+	case EB_CREATE:
+		/* each create is paired with a destroy to keep the OST clean */
+		rc = eb_create(tgt->et_dev, &objid, &eth->eth_stats[EB_CREATE]);
+		if (rc == 0)
+			rc = eb_destroy(tgt->et_dev, objid,
+					&eth->eth_stats[EB_DESTROY]);
+		break;
+	default:
+		rc = -EINVAL;
+		break;
+	}
+
+	return rc;
+}
+
+static bool eb_expired(const struct eb_config *cfg)
+{
+	struct timespec now;
+
+	if (cfg->ec_duration == 0)
+		return false;
+
+	clock_gettime(CLOCK_MONOTONIC, &now);
+	return eb_ts_ns(&now) >= eb_ts_ns(&eb_deadline);
+}
+
+static void *eb_thread_main(void *arg)
+{
+	struct eb_thread *eth = arg;
+	const struct eb_config *cfg = eth->eth_cfg;
+	__u64 i;
+	int rc;
+
+	pthread_mutex_lock(&eb_mutex);
+	while (!eb_started)
+		pthread_cond_wait(&eb_cond, &eb_mutex);
+	pthread_mutex_unlock(&eb_mutex);
+
+	for (i = 0; cfg->ec_count == 0 || i < cfg->ec_count; i++) {
+		enum eb_op op;
+
+		if (eb_stopping || eb_expired(cfg))
+			break;
+
+		op = eb_pick_op(eth);
+		rc = eb_do_op(eth, op);
+		if (rc) {
+			fprintf(stderr,
+				"error: echo_bench: %s thread %u: %s failed: %s\n",
+				eth->eth_target->et_name, eth->eth_index,
+				eb_op_names[op], strerror(-rc));
+			eth->eth_rc = rc;
+			eb_stopping = 1;
+			break;
+		}
+	}
+
+	return NULL;
+}
+
+static int eb_parse_mix(struct eb_config *cfg, char *arg)
+{
+	char *tok;
+	int op;
+
+	memset(cfg->ec_mix, 0, sizeof(cfg->ec_mix));
+	cfg->ec_mix_total = 0;
+
+	while ((tok = strsep(&arg, ",")) != NULL) {
+		char *val = strchr(tok, '=');
+		unsigned long weight = 1;
+		char *end;
+
+		if (val) {
+			*val++ = '\0';
+			weight = strtoul(val, &end, 0);
+			if (*end || weight > 10000)
+				return -EINVAL;
+		}
+
+		for (op = 0; op < EB_OP_MAX; op++)
+			if (op != EB_DESTROY && strcmp(tok, eb_op_names[op]) == 0)
+				break;
+		if (op == EB_OP_MAX)
+			return -EINVAL;
+
+		cfg->ec_mix[op] += weight;
+		cfg->ec_mix_total += weight;
+	}
+
+	return cfg->ec_mix_total ? 0 : -EINVAL;
+}
+
+static int eb_add_target(struct eb_target **targets, int *ntargets,
+			 char *name, int dev)
+{
+	struct eb_target *tmp;
+
+	if (dev < 0)
+		dev = parse_devname("echo_bench", name);
+	if (dev < 0)
+		return -ENODEV;
+
+	tmp = realloc(*targets, sizeof(*tmp) * (*ntargets + 1));
+	if (!tmp)
+		return -ENOMEM;
+
+	*targets = tmp;
+	tmp = &(*targets)[*ntargets];
+	memset(tmp, 0, sizeof(*tmp));
+	tmp->et_dev = dev;
+	tmp->et_name = strdup(name);
+	if (!tmp->et_name)
+		return -ENOMEM;
+	(*ntargets)++;
+
+	return 0;
+}
+
+static void eb_print_config(FILE *fp, const struct eb_config *cfg)
+{
+	bool first = true;
+	int op;
+
+	fprintf(fp, "  \"config\": {\"threads_per_device\": %u, \"objects_per_device\": %u, ",
+		cfg->ec_threads, cfg->ec_objects);
+	fprintf(fp, "\"io_size\": %llu, \"object_size\": %llu, ",
+		(unsigned long long)cfg->ec_io_size,
+		(unsigned long long)cfg->ec_obj_size);
+	fprintf(fp, "\"count\": %llu, \"duration\": %u, \"random\": %s, ",
+		(unsigned long long)cfg->ec_count, cfg->ec_duration,
+		cfg->ec_random ? "true" : "false");
+	fprintf(fp, "\"mix\": {");
+	for (op = 0; op < EB_OP_MAX; op++) {
+		if (cfg->ec_mix[op] == 0)
+			continue;
+		fprintf(fp, "%s\"%s\": %u", first ? "" : ", ",
+			eb_op_names[op], cfg->ec_mix[op]);
+		first = false;
+	}
+	fprintf(fp, "}},\n");
+}
+
+static void eb_report(FILE *fp, const struct eb_config *cfg,
+		      struct eb_target *targets, int ntargets,
+		      struct eb_thread *threads, double elapsed)
+{
+	struct eb_stats *total;
+	struct eb_stats *tstats;
+	int t, i, op;
+
+	total = calloc(2 * EB_OP_MAX, sizeof(*total));
+	if (!total) {
+		fprintf(stderr, "error: echo_bench: no memory for report\n");
+		return;
+	}
+	tstats = total + EB_OP_MAX;
+
+	fprintf(fp, "{\n");
+	eb_print_config(fp, cfg);
+	fprintf(fp, "  \"elapsed_sec\": %.3f,\n", elapsed);
+	fprintf(fp, "  \"devices\": [");
+
+	for (t = 0; t < ntargets; t++) {
+		struct eb_thread *eth = &threads[t * cfg->ec_threads];
+
+		memset(tstats, 0, sizeof(*tstats) * EB_OP_MAX);
+		for (i = 0; i < cfg->ec_threads; i++)
+			for (op = 0; op < EB_OP_MAX; op++)
+				eb_stats_add(&tstats[op],
+					     &eth[i].eth_stats[op]);
+		for (op = 0; op < EB_OP_MAX; op++)
+			eb_stats_add(&total[op], &tstats[op]);
+
+		fprintf(fp, "%s\n    {\"device\": \"%s\", \"ops\": ",
+			t ? "," : "", targets[t].et_name);
+		eb_print_stats(fp, tstats, elapsed, 6);
+		fprintf(fp, ",\n      \"threads\": [");
+		for (i = 0; i < cfg->ec_threads; i++) {
+			fprintf(fp, "%s\n        {\"thread\": %d, \"ops\": ",
+				i ? "," : "", i);
+			eb_print_stats(fp, eth[i].eth_stats, elapsed, 10);
+			fprintf(fp, "}");
+		}
+		fprintf(fp, "\n      ]}");
+	}
+
+	fprintf(fp, "\n  ],\n  \"total\": ");
+	eb_print_stats(fp, total, elapsed, 2);
+	fprintf(fp, "\n}\n");
+
+	free(total);
+}
+
+static void eb_usage(void)
+{
+	fprintf(stderr,
+		"usage: echo_bench [--device DEV[,DEV...]] [--threads N] [--objects N]\n"
+		"                  [--size BYTES] [--object-size BYTES]\n"
+		"                  [--count N | --time SECONDS] [--random]\n"
+		"                  [--mix OP[=WEIGHT][,OP[=WEIGHT]...]] [--keep]\n"
+		"\tOP is one of read, write, getattr, setattr or create\n");
+}
+
+/*
+ * echo_bench [options]
+ *
+ * Create objects on every echo_client device given, run the requested op
+ * mix from --threads threads per device and print JSON results to stdout.
+ */
+int jt_obd_echo_bench(int argc, char **argv)
+{
+	struct option long_opts[] = {
+	{ .val = 'd',	.name = "device",	.has_arg = required_argument },
+	{ .val = 'h',	.name = "help",		.has_arg = no_argument },
+	{ .val = 'k',	.name = "keep",		.has_arg = no_argument },
+	{ .val = 'm',	.name = "mix",		.has_arg = required_argument },
+	{ .val = 'n',	.name = "count",	.has_arg = required_argument },
+	{ .val = 'o',	.name = "objects",	.has_arg = required_argument },
+	{ .val = 'r',	.name = "random",	.has_arg = no_argument },
+	{ .val = 's',	.name = "size",		.has_arg = required_argument },
+	{ .val = 'S',	.name = "object-size",	.has_arg = required_argument },
+	{ .val = 't',	.name = "threads",	.has_arg = required_argument },
+	{ .val = 'T',	.name = "time",		.has_arg = required_argument },
+	{ .name = NULL } };
+	struct eb_config cfg = {
+		.ec_threads	= 1,
+		.ec_io_size	= 1048576,
+		.ec_obj_size	= 64 * 1048576ULL,
+	};
+	struct eb_target *targets = NULL;
+	struct eb_thread *threads = NULL;
+	struct timespec start, end;
+	unsigned long long size, units;
+	int ntargets = 0;
+	int nthreads = 0;
+	int started = 0;
+	char *devices = NULL;
+	char *name;
+	char *end_ptr;
+	int rc = 0;
+	int c, t, i;
+
+	cfg.ec_mix[EB_WRITE] = cfg.ec_mix_total = 1;
+
+	optind = 0;
+	while ((c = getopt_long(argc, argv, "d:hkm:n:o:rs:S:t:T:",
+				long_opts, NULL)) != -1) {
+		switch (c) {
+		case 'd':
+			devices = optarg;
+			break;
+		case 'k':
+			cfg.ec_keep = true;
+			break;
+		case 'm':
+			if (eb_parse_mix(&cfg, optarg)) {
+				fprintf(stderr,
+					"error: %s: bad op mix '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			break;
+		case 'n':
+			cfg.ec_count = strtoull(optarg, &end_ptr, 0);
+			if (*end_ptr) {
+				fprintf(stderr,
+					"error: %s: bad count '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			break;
+		case 'o':
+			cfg.ec_objects = strtoul(optarg, &end_ptr, 0);
+			if (*end_ptr || cfg.ec_objects == 0) {
+				fprintf(stderr,
+					"error: %s: bad object count '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			break;
+		case 'r':
+			cfg.ec_random = true;
+			break;
+		case 's':
+		case 'S':
+			units = 1;
+			if (llapi_parse_size(optarg, &size, &units, 0) < 0 ||
+			    size == 0) {
+				fprintf(stderr, "error: %s: bad size '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			if (c == 's')
+				cfg.ec_io_size = size;
+			else
+				cfg.ec_obj_size = size;
+			break;
+		case 't':
+			cfg.ec_threads = strtoul(optarg, &end_ptr, 0);
+			if (*end_ptr || cfg.ec_threads == 0) {
+				fprintf(stderr,
+					"error: %s: bad thread count '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			break;
+		case 'T':
+			cfg.ec_duration = strtoul(optarg, &end_ptr, 0);
+			if (*end_ptr) {
+				fprintf(stderr,
+					"error: %s: bad time '%s'\n",
+					jt_cmdname(argv[0]), optarg);
+				return CMD_HELP;
+			}
+			break;
+		case 'h':
+		default:
+			eb_usage();
+			return CMD_HELP;
+		}
+	}
+
+	if (optind != argc) {
+		eb_usage();
+		return CMD_HELP;
+	}
+
+	if (cfg.ec_io_size % getpagesize() != 0 ||
+	    cfg.ec_obj_size < cfg.ec_io_size) {
+		fprintf(stderr,
+			"error: %s: I/O size %llu must be page aligned and not larger than object size %llu\n",
+			jt_cmdname(argv[0]),
+			(unsigned long long)cfg.ec_io_size,
+			(unsigned long long)cfg.ec_obj_size);
+		return CMD_HELP;
+	}
+
+	if (cfg.ec_count == 0 && cfg.ec_duration == 0)
+		cfg.ec_duration = 10;
+	if (cfg.ec_objects == 0)
+		cfg.ec_objects = cfg.ec_threads;
+
+	if (devices) {
+		while ((name = strsep(&devices, ",")) != NULL) {
+			if (*name == '\0')
+				continue;
+			rc = eb_add_target(&targets, &ntargets, name, -1);
+			if (rc)
+				goto out;
+		}
+	} else if (jt_obd_get_device() >= 0) {
+		/* fall back to the device set with "lctl --device" */
+		name = lcfg_get_devname();
+		rc = eb_add_target(&targets, &ntargets, name ? name : "current",
+				   jt_obd_get_device());
+		if (rc)
+			goto out;
+	}
+
+	if (ntargets == 0) {
+		fprintf(stderr, "error: %s: no echo_client device given\n",
+			jt_cmdname(argv[0]));
+		return CMD_HELP;
+	}
+
+	/* create the working set before any timing starts */
+	for (t = 0; t < ntargets; t++) {
+		struct eb_target *tgt = &targets[t];
+
+		tgt->et_objids = calloc(cfg.ec_objects,
+					sizeof(*tgt->et_objids));
+		if (!tgt->et_objids) {
+			rc = -ENOMEM;
+			goto out;
+		}
+
+		for (i = 0; i < cfg.ec_objects; i++) {
+			rc = eb_create(tgt->et_dev, &tgt->et_objids[i], NULL);
+			if (rc) {
+				fprintf(stderr,
+					"error: %s: %s: cannot create object: %s\n",
+					jt_cmdname(argv[0]), tgt->et_name,
+					strerror(-rc));
+				goto out;
+			}
+			tgt->et_nobjs++;
+		}
+	}
+
+	nthreads = ntargets * cfg.ec_threads;
+	threads = calloc(nthreads, sizeof(*threads));
+	if (!threads) {
+		rc = -ENOMEM;
+		goto out;
+	}
+
+	eb_started = false;
+	eb_stopping = 0;
+	for (i = 0; i < nthreads; i++) {
+		struct eb_thread *eth = &threads[i];
+		unsigned int sharers;
+
+		eth->eth_target = &targets[i / cfg.ec_threads];
+		eth->eth_cfg = &cfg;
+		eth->eth_index = i % cfg.ec_threads;
+		eth->eth_seed = time(NULL) ^ (i * 2654435761U);
+
+		/* threads sharing one object interleave their I/O on it */
+		sharers = (cfg.ec_threads + cfg.ec_objects - 1) /
+			  cfg.ec_objects;
+		eth->eth_stride = sharers * cfg.ec_io_size;
+		eth->eth_offset = (eth->eth_index / cfg.ec_objects) *
+				  cfg.ec_io_size;
+		if (eth->eth_offset + cfg.ec_io_size > cfg.ec_obj_size)
+			eth->eth_offset = 0;
+		if (eth->eth_stride > cfg.ec_obj_size)
+			eth->eth_stride = cfg.ec_io_size;
+
+		rc = pthread_create(&eth->eth_thread, NULL, eb_thread_main,
+				    eth);
+		if (rc) {
+			fprintf(stderr,
+				"error: %s: cannot start thread %d: %s\n",
+				jt_cmdname(argv[0]), i, strerror(rc));
+			rc = -rc;
+			break;
+		}
+		started++;
+	}
+
+	/* if not all threads started, release the others just to exit */
+	if (started < nthreads)
+		eb_stopping = 1;
+
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	eb_deadline = start;
+	eb_deadline.tv_sec += cfg.ec_duration;
+	pthread_mutex_lock(&eb_mutex);
+	eb_started = true;
+	pthread_cond_broadcast(&eb_cond);
+	pthread_mutex_unlock(&eb_mutex);
+
+	for (i = 0; i < started; i++) {
+		pthread_join(threads[i].eth_thread, NULL);
+		if (threads[i].eth_rc && rc == 0)
+			rc = threads[i].eth_rc;
+	}
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	if (started == nthreads)
+		eb_report(stdout, &cfg, targets, ntargets, threads,
+			  (eb_ts_ns(&end) - eb_ts_ns(&start)) / 1e9);
+
+out:
+	for (t = 0; t < ntargets; t++) {
+		struct eb_target *tgt = &targets[t];
+		int rc2;
+
+		for (i = 0; i < tgt->et_nobjs && !cfg.ec_keep; i++) {
+			rc2 = eb_destroy(tgt->et_dev, tgt->et_objids[i], NULL);
+			if (rc2) {
+				fprintf(stderr,
+					"error: %s: %s: cannot destroy object %#llx: %s\n",
+					jt_cmdname(argv[0]), tgt->et_name,
+					(unsigned long long)tgt->et_objids[i],
+					strerror(-rc2));
+				if (rc == 0)
+					rc = rc2;
+			}
+		}
+		free(tgt->et_objids);
+		free(tgt->et_name);
+	}
+	free(targets);
+	free(threads);
+
+	return rc;
+}
+#else /* !HAVE_LIBPTHREAD */
+int jt_obd_echo_bench(int argc, char **argv)
+{
+	fprintf(stderr, "error: %s: lctl was built without pthread support\n",
+		jt_cmdname(argv[0]));
+	return -EOPNOTSUPP;
+}
+#endif /* HAVE_LIBPTHREAD */